@@ -59,4 +59,18 @@ def IsFileName(obj, name):
 def RemoveSuffix(str, suffix):
     if str.endswith(suffix):
         return str[:-len(suffix)]
-    return str
\ No newline at end of file
+    return str
+
+
+def MkfsFatArguments(filesystem: str, reserved_sectors=0):
+    """The mkfs.fat options of the images, for sh: the boot sector, and
+    FAT32's FSInfo sector, come on top of reserved_sectors"""
+    reserved_sectors += 1
+    if filesystem == 'fat32':
+        reserved_sectors += 1
+
+    return {
+        'F': filesystem[3:],            # fat size (12, 16, or 32)
+        'n': 'NBOS',                    # label
+        'R': reserved_sectors,          # reserved sectors
+    }
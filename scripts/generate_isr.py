@@ -5,10 +5,36 @@ MAIN_PATH = Path(__file__.replace("generate_isr.py","")).parent.absolute()
 
 PATH = f"{MAIN_PATH}/src/kernel/arch/i686"
 
-ISRS_GEN_C = f"{PATH}/isrs_gen.c"
+TABLES_GEN_LD = f"{PATH}/tables_gen.ld"
 ISRS_GEN_ASM = f"{PATH}/isrs_gen.inc"
 ISRS_WITH_ERROR_CODE=[8,10,11,12,13,14,17,21,30]
 
+# Kept in sync by hand with interrupts/gdt.h, interrupts/gdt.c, interrupts/irq.c
+# and smp/percpu.h
+CPU_MAX = 8
+TSS_SIZE = 104
+GDT_ENTRY_COUNT = 5
+GDT_CODE_SEGMENT = 0x08
+
+GDT_ACCESS_CODE_READABLE = 0x02
+GDT_ACCESS_DATA_WRITABLE = 0x02
+GDT_ACCESS_DATA_SEGMENT = 0x10
+GDT_ACCESS_CODE_SEGMENT = 0x18
+GDT_ACCESS_TSS_32BIT_AVAILABLE = 0x09
+GDT_ACCESS_RING0 = 0x00
+GDT_ACCESS_PRESENT = 0x80
+
+GDT_FLAG_32BIT = 0x40
+GDT_FLAG_GRANULARITY_1B = 0x00
+GDT_FLAG_GRANULARITY_4K = 0x80
+
+# present, ring 0, 32-bit interrupt gate
+IDT_GATE_FLAGS = 0x80 | 0x0E
+
+# the PIC lines are remapped here and all go through i686_IRQ_Handler
+PIC_REMAP_OFFSET = 0x20
+PIC_IRQ_COUNT = 16
+
 def generate_inc():
 
     inc = Path(ISRS_GEN_ASM)
@@ -24,28 +50,77 @@ def generate_inc():
         f.close()
     return
 
-def generate_h():
+def gdt_entry(base, limit, access, flags):
+    # base and limit are numbers or linker expressions, ld splits the latter
+    if isinstance(limit, int):
+        limit_low, limit_high = f"{limit & 0xFFFF:#x}", f"{(limit >> 16) & 0xF | flags:#x}"
+    else:
+        limit_low, limit_high = f"({limit}) & 0xFFFF", f"((({limit}) >> 16) & 0xF) | {flags:#x}"
+    if isinstance(base, int):
+        base_low, base_middle, base_high = f"{base & 0xFFFF:#x}", f"{(base >> 16) & 0xFF:#x}", f"{(base >> 24) & 0xFF:#x}"
+    else:
+        base_low, base_middle, base_high = f"({base}) & 0xFFFF", f"(({base}) >> 16) & 0xFF", f"(({base}) >> 24) & 0xFF"
+    return (f"SHORT({limit_low}) SHORT({base_low}) BYTE({base_middle}) "
+            f"BYTE({access:#x}) BYTE({limit_high}) BYTE({base_high})")
+
+def generate_ld():
 
-    c = Path(ISRS_GEN_C)
-    if c.is_file():
-        os.remove(c.absolute())
+    ld = Path(TABLES_GEN_LD)
+    if ld.is_file():
+       os.remove(ld.absolute())
 
-    with open(ISRS_GEN_C, 'w') as f:
-        f.write( "// !!!! THIS FILE IS AUTOGENERATED !!!!\r\n")
-        f.write("#include <arch/i686/interrupts/idt.h>\r\n")
-        f.write("#include <arch/i686/interrupts/gdt.h>\r\n")
+    flat_code = GDT_ACCESS_PRESENT | GDT_ACCESS_RING0 | GDT_ACCESS_CODE_SEGMENT | GDT_ACCESS_CODE_READABLE
+    flat_data = GDT_ACCESS_PRESENT | GDT_ACCESS_RING0 | GDT_ACCESS_DATA_SEGMENT | GDT_ACCESS_DATA_WRITABLE
+    tss = GDT_ACCESS_PRESENT | GDT_ACCESS_RING0 | GDT_ACCESS_TSS_32BIT_AVAILABLE
 
+    with open(TABLES_GEN_LD, 'w') as f:
+        f.write("/* !!!! THIS FILE IS AUTOGENERATED !!!! */\r\n")
+        f.write("/* Included in .data by linker.ld: the IDT and GDTs, with addresses the linker fills in */\r\n")
+        f.write("\r\n")
+
+        # every gate present, the ISR stubs of isr_asm.asm
+        f.write(". = ALIGN(8);\r\n")
+        f.write("g_IDT = .;\r\n")
         for i in range(0, 256):
-            f.write(f"void __attribute__((cdecl)) i686_ISR{i}();\r\n")
+            f.write(f"SHORT(i686_ISR{i} & 0xFFFF) SHORT({GDT_CODE_SEGMENT:#x}) BYTE(0) BYTE({IDT_GATE_FLAGS:#x}) SHORT(i686_ISR{i} >> 16)\r\n")
+        f.write("\r\n")
 
-        f.write("\n\r")
-        f.write("void i686_ISR_InitializeGates(){\r\n")
+        # the C handler for each vector; only the IRQ dispatcher is fixed, the
+        # rest are registered by the code that sets up their device
+        f.write(". = ALIGN(4);\r\n")
+        f.write("g_ISRHandler = .;\r\n")
         for i in range(0, 256):
-            f.write(f"\ti686_IDT_SetGate({i}, i686_ISR{i}, i686_GDT_CODE_SEGMENT, IDT_FLAG_RING0 | IDI_FLAG_GATE_32BIT_INT);\r\n")
-        f.write("}\r\n")
-        f.write("// !!!!! THIS FILE IS AUTOGENERATED !!!!!\r\n")
+            if PIC_REMAP_OFFSET <= i < PIC_REMAP_OFFSET + PIC_IRQ_COUNT:
+                f.write(f"LONG(i686_IRQ_Handler) /* {i:#x} */\r\n")
+            else:
+                f.write("LONG(0)\r\n")
+        f.write("\r\n")
+
+        # the constants above are copies, the real layout has to match them
+        f.write(f"ASSERT((__percpu_end - __percpu_start) % {CPU_MAX} == 0, \"the .percpu section does not split into {CPU_MAX} CPUs\");\r\n")
+        f.write(f"ASSERT(__tss_end - __tss_start == {CPU_MAX * TSS_SIZE}, \"g_TSS is not {CPU_MAX} TSSs of {TSS_SIZE} bytes\");\r\n")
+        f.write("\r\n")
+
+        # one GDT per CPU, they differ in the TSS and the per-CPU segment base
+        f.write(f"PERCPU_SIZE = ABSOLUTE((__percpu_end - __percpu_start) / {CPU_MAX});\r\n")
+        f.write(". = ALIGN(8);\r\n")
+        f.write("g_GDT = .;\r\n")
+        for cpu in range(0, CPU_MAX):
+            f.write(f"/* CPU {cpu} */\r\n")
+            f.write(gdt_entry(0, 0, 0, 0) + "\r\n")
+            f.write(gdt_entry(0, 0xFFFFF, flat_code, GDT_FLAG_32BIT | GDT_FLAG_GRANULARITY_4K) + "\r\n")
+            f.write(gdt_entry(0, 0xFFFFF, flat_data, GDT_FLAG_32BIT | GDT_FLAG_GRANULARITY_4K) + "\r\n")
+            f.write(gdt_entry(f"g_TSS + {cpu * TSS_SIZE}", TSS_SIZE - 1, tss, GDT_FLAG_GRANULARITY_1B) + "\r\n")
+            f.write(gdt_entry(f"__percpu_start + {cpu} * PERCPU_SIZE", "PERCPU_SIZE - 1", flat_data,
+                              GDT_FLAG_32BIT | GDT_FLAG_GRANULARITY_1B) + "\r\n")
+        f.write("\r\n")
+
+        f.write("g_GDTDescriptor = .;\r\n")
+        for cpu in range(0, CPU_MAX):
+            f.write(f"SHORT({GDT_ENTRY_COUNT * 8 - 1}) LONG(g_GDT + {cpu * GDT_ENTRY_COUNT * 8})\r\n")
+        f.write("/* !!!!! THIS FILE IS AUTOGENERATED !!!!! */\r\n")
         f.close()
     return
 
-generate_h()
+generate_ld()
 generate_inc()
\ No newline at end of file
@@ -0,0 +1,102 @@
+import argparse
+import bisect
+import re
+import sys
+from collections import Counter
+
+# Turns the samples printed by Profiler_Dump (src/kernel/util/profiler.c)
+# into folded stacks for flamegraph.pl / speedscope, or a flat profile.
+#
+#   scons run-direct | tee debugcon.log
+#   python3 scripts/profile.py build/i686_debug/kernel/kernel.map debugcon.log > kernel.folded
+#
+# Symbols come from the linker map, which only lists global symbols: a
+# static function is reported as the global one before it in its file, or
+# as [file.o] if there is none.
+
+SAMPLES_BEGIN = "===== PROFILER SAMPLES ====="
+SAMPLES_END = "============================"
+
+MAP_SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$")
+MAP_SECTION = re.compile(r"^\s*\.(?:text|entry)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)\s*$")
+
+def read_map(map_file: str):
+    """Sorted (address, name) pairs of the code in the kernel map"""
+    symbols = {}
+    with open(map_file, 'r') as f:
+        for line in f:
+            section = MAP_SECTION.match(line)
+            if section:
+                address = int(section.group(1), 16)
+                if int(section.group(2), 16) != 0:
+                    symbols.setdefault(address, f"[{section.group(3).split('/')[-1]}]")
+                continue
+
+            symbol = MAP_SYMBOL.match(line)
+            if symbol:
+                # a global symbol wins over its file's section start
+                symbols[int(symbol.group(1), 16)] = symbol.group(2)
+
+    entries = sorted(symbols.items())
+    return [address for address, _ in entries], [name for _, name in entries]
+
+def symbolize(addresses, names, address: int):
+    index = bisect.bisect_right(addresses, address) - 1
+    return names[index] if index >= 0 else f"{address:#x}"
+
+def read_samples(log_file: str):
+    """(cpu, [eip, return addresses...]) for every sample of the last dump"""
+    samples = []
+    inside = False
+    with open(log_file, 'r', errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if line == SAMPLES_BEGIN:
+                samples = []
+                inside = True
+            elif line == SAMPLES_END:
+                inside = False
+            elif inside and line and not line.startswith('period='):
+                fields = line.split()
+                samples.append((int(fields[0]), [int(field, 16) for field in fields[1:]]))
+    return samples
+
+def main():
+    parser = argparse.ArgumentParser(description="Symbolize kernel profiler samples")
+    parser.add_argument('map', help="kernel.map from the kernel build")
+    parser.add_argument('log', help="debugcon output holding a Profiler_Dump")
+    parser.add_argument('--flat', action='store_true', help="samples per function instead of folded stacks")
+    parser.add_argument('--per-cpu', action='store_true', help="put the CPU at the root of every stack")
+    args = parser.parse_args()
+
+    addresses, names = read_map(args.map)
+    samples = read_samples(args.log)
+    if not samples:
+        print(f"no profiler samples in {args.log}", file=sys.stderr)
+        return 1
+
+    counts = Counter()
+    for cpu, frames in samples:
+        # return addresses point after the call, look up the call itself
+        stack = [symbolize(addresses, names, frames[0])]
+        stack += [symbolize(addresses, names, address - 1) for address in frames[1:]]
+
+        if args.flat:
+            counts[stack[0]] += 1
+            continue
+
+        stack.reverse()
+        if args.per_cpu:
+            stack.insert(0, f"cpu{cpu}")
+        counts[';'.join(stack)] += 1
+
+    if args.flat:
+        for name, count in counts.most_common():
+            print(f"{count * 100 / len(samples):6.2f}% {count:8} {name}")
+    else:
+        for stack, count in sorted(counts.items()):
+            print(f"{stack} {count}")
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,9 +1,10 @@
 #!/usr/bin/sh
 
-QEMU_ARGS='-debugcon stdio -m 32'
+QEMU_ARGS='-debugcon stdio -m 32 -smp 4'
 
 if [ "$#" -le 1 ]; then
     echo "Usage: ./run.sh <image_type> <image>"
+    echo "       ./run.sh direct <kernel> [initrd]"
     exit 1
 fi
 
@@ -12,8 +13,24 @@ case "$1" in
     ;;
     "disk")     QEMU_ARGS="${QEMU_ARGS} -hda $2"
     ;;
+    # Multiboot straight into the kernel, the initrd as its module
+    "direct")   QEMU_ARGS="${QEMU_ARGS} -kernel $2"
+                if [ -n "$3" ]; then
+                    QEMU_ARGS="${QEMU_ARGS} -initrd $3"
+                fi
+    ;;
     *)          echo "Unknown image type $1."
                 exit 2
 esac
 
+# optional second disk behind an AHCI controller
+if [ -n "$AHCI_DISK" ]; then
+    QEMU_ARGS="${QEMU_ARGS} -device ahci,id=ahci -drive id=sata0,file=${AHCI_DISK},if=none,format=raw -device ide-hd,drive=sata0,bus=ahci.0"
+fi
+
+# the boot image once more as a virtio-blk disk, read-only next to the IDE one
+if [ -n "$VIRTIO" ] && [ "$1" = "disk" ]; then
+    QEMU_ARGS="${QEMU_ARGS} -drive file=$2,if=virtio,format=raw,readonly=on,file.locking=off"
+fi
+
 qemu-system-i386 $QEMU_ARGS
@@ -0,0 +1,85 @@
+import argparse
+import json
+import sys
+
+# Turns the records printed by Trace_Dump (src/kernel/util/trace.c) into
+# the Chrome trace event format, which Perfetto (ui.perfetto.dev) and
+# chrome://tracing open directly.
+#
+#   scons run-direct | tee debugcon.log
+#   python3 scripts/trace2json.py debugcon.log > trace.json
+#
+# Every CPU becomes a thread of one process. Records are TSC stamped; the
+# TSCs of different CPUs are assumed to be in sync.
+
+RECORDS_BEGIN = "===== TRACE RECORDS ====="
+RECORDS_END = "========================="
+
+def read_records(log_file: str):
+    """tsc_khz and the records of the last dump, as (cpu, tsc, phase, category, name, args)"""
+    records = []
+    tsc_khz = 0
+    inside = False
+    with open(log_file, 'r', errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if line == RECORDS_BEGIN:
+                records = []
+                inside = True
+            elif line == RECORDS_END:
+                inside = False
+            elif inside and line.startswith('tsc_khz='):
+                tsc_khz = int(line.split('=')[1])
+            elif inside and line:
+                cpu, tsc, phase, category, name, *fields = line.split()
+                args = {}
+                for field in fields:
+                    key, value = field.split('=')
+                    args[key] = int(value, 16)
+                records.append((int(cpu), int(tsc, 16), phase, category, name, args))
+    return tsc_khz, records
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a kernel trace dump to Chrome trace JSON")
+    parser.add_argument('log', help="debugcon output holding a Trace_Dump")
+    parser.add_argument('--tsc-khz', type=int, default=0, help="TSC frequency, if the kernel did not know it")
+    args = parser.parse_args()
+
+    tsc_khz, records = read_records(args.log)
+    if not records:
+        print(f"no trace records in {args.log}", file=sys.stderr)
+        return 1
+
+    tsc_khz = args.tsc_khz or tsc_khz
+    if tsc_khz == 0:
+        print("TSC frequency unknown, timestamps are in cycles", file=sys.stderr)
+        tsc_khz = 1000
+
+    records.sort(key=lambda record: record[1])
+    start = records[0][1]
+
+    events = []
+    for cpu in sorted({record[0] for record in records}):
+        events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': cpu, 'args': {'name': f'CPU {cpu}'}})
+
+    for cpu, tsc, phase, category, name, record_args in records:
+        event = {
+            'name': name,
+            'cat': category,
+            'ph': phase,
+            'ts': (tsc - start) * 1000 / tsc_khz,           # microseconds
+            'pid': 0,
+            'tid': cpu,
+            'args': record_args,
+        }
+
+        # async slices pair up by their first argument
+        if phase in ('b', 'e'):
+            event['id'] = hex(next(iter(record_args.values())))
+        events.append(event)
+
+    json.dump({'traceEvents': events, 'displayTimeUnit': 'ns'}, sys.stdout)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -5,7 +5,7 @@ bits 16
 %define fat12 1
 %define fat16 2
 %define fat32 3
-%define ext2  4                                     ; Unimplemented
+%define ext2  4
 
 ;
 ; FAT12 header
@@ -54,12 +54,22 @@ section .fsheaders
     ebr_volume_label:           db 'NEO  OS    '        ; 11 bytes, padded with spaces
     ebr_system_id:              db 'FAT12   '           ; 8 bytes
 
+%else
+
+section .data
+
+    ; no BPB to take the geometry from: the usual hard disk one, only
+    ; used when the BIOS lacks the extensions
+    bdb_sectors_per_track:      dw 63
+    bdb_heads:                  dw 255
+    ebr_drive_number:           db 0
 
 %endif
 
 section .entry
 global start
 start:
+    cld
 
     ; move partition entry from MBR to a different location so we
     ; don't overwrite it (which is passed through DS:SI)
@@ -69,17 +79,26 @@ start:
     mov cx, 16
     rep movsb
 
-    ; setup data segments
-    mov ax, 0           ; can't set ds/es directly
+    ; stage2 loads at 0x500 and may reach past 0x7C00, so move out of its
+    ; way: the same offsets, in a higher segment
+    xor ax, ax          ; can't set ds/es directly
     mov ds, ax
+    mov ax, STAGE1_SEGMENT
     mov es, ax
+    mov si, 0x7C00
+    mov di, si
+    mov cx, 256
+    rep movsw
+
+    ; setup data segments
+    mov ds, ax
 
     ; setup stack
     mov ss, ax
     mov sp, 0x7C00              ; stack grows downwards from where we are loaded in memory
 
-    ; some BIOSes might start us at 07C0:0000 instead of 0000:7C00, make sure we are in the
-    ; expected location
+    ; some BIOSes might start us at 07C0:0000 instead of 0000:7C00, the
+    ; far jump sets cs either way
     push es
     push word .after
     retf
@@ -108,32 +127,22 @@ start:
     mov byte [have_extensions], 0
 
 .after_disk_extensions_check:
-    ;load stage2
+    ; load stage2, extent by extent, each in as few calls as the BIOS allows
     mov si, stage2_location
 
-    mov ax, STAGE2_LOAD_SEGMENT         ; set segment registers
-    mov es, ax
-
-    mov bx, STAGE2_LOAD_OFFSET
-
-.loop:
-    mov eax, [si]
-    add si, 4
-    mov cl, [si]
-    inc si
+    mov ax, STAGE2_LOAD_SEGMENT + STAGE2_LOAD_OFFSET / 16
+    mov es, ax                          ; reads go to es:0
 
-    cmp eax, 0
-    je .read_finish
+.next_extent:
+    mov eax, [si]                       ; LBA
+    mov cx, [si + 4]                    ; sectors, 0 ends the list
+    add si, 6
+    jcxz .read_finish
 
+.next_chunk:
     call disk_read
-
-    xor ch, ch
-    shl cx, 5
-    mov di, es
-    add di, cx
-    mov es, di
-
-    jmp .loop
+    jcxz .next_extent
+    jmp .next_chunk
 
 
 .read_finish:
@@ -196,40 +205,69 @@ lba_to_chs:
     ret
 
 ;
-; Read sectors from a disk
+; Read the next piece of an extent, as much as one BIOS call takes
 ;   Parameters:
 ;       -   eax:    LBA address
-;       -   cl:     number of sectors to read (up to 128)
+;       -   cx:     sectors left in the extent
 ;       -   dl:     drive number
-;       -   es:bx:  memory address where to store read data
+;       -   es:0:   memory address where to store read data
+;   Returns:
+;       -   eax, cx and es moved past the sectors read
 disk_read:
 
-    push eax
     push bx
-    push cx
-    push dx
     push si
     push di
 
-    cmp byte [have_extensions], 1
-    jne .no_disk_extensions
-
     mov [extensions_dap.lba], eax
     mov [extensions_dap.segment], es
-    mov [extensions_dap.offset], bx
-    mov [extensions_dap.count], cl
+
+    ; the extensions take up to 127 sectors, which also keeps the buffer
+    ; within es; CHS reads must stop at the end of the track
+    mov bx, MAX_EXTENSIONS_SECTORS
+    cmp byte [have_extensions], 1
+    je .clamp
+
+    push dx
+    xor dx, dx
+    div word [bdb_sectors_per_track]        ; dx = sector within the track (floppies are small)
+    mov bx, [bdb_sectors_per_track]
+    sub bx, dx
+    pop dx
+
+    ; and before the next 64 KiB boundary, the floppy DMA can't cross it
+    mov ax, es
+    and ax, 0FFFh
+    sub ax, 1000h
+    neg ax                                  ; ax = paragraphs up to the boundary
+    shr ax, 5                               ; whole sectors
+    jnz .dma_ok
+    inc ax                                  ; one sector straddles it, never in stage2 (image/SConscript)
+.dma_ok:
+    cmp bx, ax
+    jbe .clamp
+    mov bx, ax
+
+.clamp:
+    cmp bx, cx
+    jbe .count_ok
+    mov bx, cx
+.count_ok:
+    mov [extensions_dap.count], bx
+    push cx
 
     mov ah, 42h
     mov si, extensions_dap
-    mov di, 3                               ; Retry counter
-    jmp .retry
+    cmp byte [have_extensions], 1
+    je .read
 
-.no_disk_extensions:
-    push cx                                 ; Save CL (number of sectors to read)
+    mov ax, [extensions_dap.lba]
     call lba_to_chs                         ; compute CHS
-    pop ax                                  ; AL = number of sector to read
-
+    mov al, bl                              ; AL = number of sectors to read
     mov ah, 02h
+    xor bx, bx
+
+.read:
     mov di, 3                               ; Retry counter
 
 .retry:
@@ -242,22 +280,28 @@ disk_read:
     call disk_reset
 
     dec di
-    test di, di
     jnz .retry
 
-.fail:
     ; All 3 attempts failed!
     jmp floppy_error
 
 .done:
     popa                                    ; restore registers
+    pop cx
+
+    ; step past what was read
+    movzx ebx, word [extensions_dap.count]
+    mov eax, [extensions_dap.lba]
+    add eax, ebx
+    sub cx, bx
+    shl bx, 5                               ; sectors to paragraphs
+    mov di, es
+    add di, bx
+    mov es, di
 
     pop di
     pop si
-    pop dx
-    pop cx
     pop bx
-    pop eax
     ret
 
 ;
@@ -269,13 +313,10 @@ disk_reset:
     mov ah, 0
     stc
     int 13h
-    jnc floppy_error
+    jc floppy_error
     popa
     ret
 
-section .rodata
-    file_stage2_bin:        db 'STAGE2  BIN'
-
 section .data
 
     have_extensions:        db 0
@@ -294,9 +335,15 @@ section .data
     PARTITION_ENTRY_SEGMENT equ 0x2000
     PARTITION_ENTRY_OFFSET  equ 0x0
 
+    STAGE1_SEGMENT          equ 0x2000      ; 0x27C00, past the biggest stage2
+    MAX_EXTENSIONS_SECTORS  equ 127         ; what every EDD BIOS takes at once
+
 section .data
+    ; where stage2 is on the disk, filled in by install_stage1 in
+    ; image/SConscript: up to 4 extents of (dd LBA, dw sectors), then a
+    ; zero count
     global stage2_location
-    stage2_location:        times 30 db 0
+    stage2_location:        times 5 * 6 db 0
 
 section .bss
     buffer:
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+
+// What the kernel entry point gets; the layout is shared with
+// src/kernel/boot/bootinfo.h
+
+#define BOOTINFO_MAGIC              0x4F464E49      // "INFO"
+#define BOOTINFO_MAX_MEMORY_REGIONS 32
+
+// Behind the jump at the start of kernel.bin
+#define KERNEL_HEADER_OFFSET        8
+#define KERNEL_HEADER_MAGIC         0x4C4E524B      // "KRNL"
+
+typedef struct{
+    uint32_t Magic;
+    uint32_t End;                           // first byte after the BSS
+} __attribute__((packed)) KernelHeader;
+
+// The BIOS (E820) region types
+enum{
+    BOOTINFO_MEMORY_AVAILABLE       = 1,
+    BOOTINFO_MEMORY_RESERVED        = 2,
+    BOOTINFO_MEMORY_ACPI            = 3,
+    BOOTINFO_MEMORY_NVS             = 4,
+    BOOTINFO_MEMORY_BAD             = 5,
+};
+
+typedef struct{
+    uint64_t Base;
+    uint64_t Length;
+    uint32_t Type;
+} __attribute__((packed)) BootMemoryRegion;
+
+typedef struct{
+    uint32_t Magic;
+    uint32_t BootDrive;                     // BIOS number
+    uint32_t InitrdAddress;                 // page aligned, after the kernel
+    uint32_t InitrdSize;                    // 0: no initrd
+    uint32_t MemoryRegionCount;             // 0: unknown, stage2 does not ask the BIOS
+    BootMemoryRegion MemoryRegions[BOOTINFO_MAX_MEMORY_REGIONS];
+} __attribute__((packed)) BootInfo;
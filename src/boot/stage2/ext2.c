@@ -0,0 +1,419 @@
+#include "ext2.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define SECTOR_SIZE 512
+#define MAX_FILE_HANDLES 4
+
+#define EXT2_MAGIC 0xEF53
+#define EXT2_ROOT_INODE 2
+#define EXT2_MAX_BLOCK_SIZE 4096
+#define EXT2_CACHED_GROUPS 512              // descriptors kept in memory, the rest is read when needed
+#define EXT2_MAX_READ_SECTORS 64            // per BIOS call
+
+#define EXT2_DIRECT_BLOCKS 12
+#define EXT2_BLOCK_POINTERS 15
+#define EXT2_S_IFMT 0xF000
+#define EXT2_S_IFDIR 0x4000
+
+typedef struct{
+    uint32_t InodesCount;
+    uint32_t BlocksCount;
+    uint32_t ReservedBlocksCount;
+    uint32_t FreeBlocksCount;
+    uint32_t FreeInodesCount;
+    uint32_t FirstDataBlock;
+    uint32_t LogBlockSize;
+    uint32_t LogFragmentSize;
+    uint32_t BlocksPerGroup;
+    uint32_t FragmentsPerGroup;
+    uint32_t InodesPerGroup;
+    uint32_t MountTime;
+    uint32_t WriteTime;
+    uint16_t MountCount;
+    uint16_t MaxMountCount;
+    uint16_t Magic;
+    uint16_t State;
+    uint16_t Errors;
+    uint16_t MinorRevision;
+    uint32_t LastCheck;
+    uint32_t CheckInterval;
+    uint32_t CreatorOS;
+    uint32_t Revision;
+    uint16_t ReservedUid;
+    uint16_t ReservedGid;
+    uint32_t FirstInode;
+    uint16_t InodeSize;
+} __attribute__((packed)) EXT2_Superblock;
+
+typedef struct{
+    uint32_t BlockBitmap;
+    uint32_t InodeBitmap;
+    uint32_t InodeTable;
+    uint16_t FreeBlocksCount;
+    uint16_t FreeInodesCount;
+    uint16_t UsedDirsCount;
+    uint16_t _Pad;
+    uint8_t  _Reserved[12];
+} __attribute__((packed)) EXT2_GroupDescriptor;
+
+typedef struct{
+    uint16_t Mode;
+    uint16_t Uid;
+    uint32_t Size;
+    uint32_t AccessTime;
+    uint32_t ChangeTime;
+    uint32_t ModifyTime;
+    uint32_t DeleteTime;
+    uint16_t Gid;
+    uint16_t LinksCount;
+    uint32_t Sectors;
+    uint32_t Flags;
+    uint32_t _Os1;
+    uint32_t Block[EXT2_BLOCK_POINTERS];
+} __attribute__((packed)) EXT2_Inode;
+
+typedef struct{
+    uint32_t Inode;
+    uint16_t RecordLength;
+    uint8_t  NameLength;
+    uint8_t  FileType;
+    char     Name[];
+} __attribute__((packed)) EXT2_DirectoryEntry;
+
+struct EXT2_FileData{
+    EXT2_File Public;
+    bool      Opened;
+    uint32_t  Block[EXT2_BLOCK_POINTERS];
+};
+
+typedef struct EXT2_FileData EXT2_FileData;
+
+struct EXT2_Data
+{
+    union{
+        EXT2_Superblock Superblock;
+        uint8_t         SuperblockBytes[2 * SECTOR_SIZE];
+    } SB;
+
+    EXT2_GroupDescriptor Groups[EXT2_CACHED_GROUPS];
+    EXT2_FileData OpenedFiles[MAX_FILE_HANDLES];
+
+    // pointer blocks by level, 0 holding data block numbers; kept while a
+    // file is read in order so each is read once
+    uint8_t  Pointers[3][EXT2_MAX_BLOCK_SIZE];
+    uint32_t PointersBlock[3];
+
+    uint8_t  Block[EXT2_MAX_BLOCK_SIZE];    // partial blocks and directories
+    uint8_t  Sector[SECTOR_SIZE];
+};
+
+typedef struct EXT2_Data EXT2_Data;
+
+static EXT2_Data* g_Data;
+static uint32_t   g_BlockSize;
+static uint32_t   g_SectorsPerBlock;
+static uint32_t   g_PointersPerBlock;
+static uint32_t   g_InodeSize;
+static uint32_t   g_GroupCount;
+
+static bool EXT2_ReadBlocks(Partition* disk, uint32_t block, uint32_t count, void* dataOut){
+    uint32_t lba = block * g_SectorsPerBlock;
+    uint32_t sectors = count * g_SectorsPerBlock;
+    uint8_t* u8dataOut = (uint8_t*)dataOut;
+
+    while(sectors > 0){
+        uint32_t take = min(sectors, EXT2_MAX_READ_SECTORS);
+        if(!Partition_ReadSectors(disk, lba, take, u8dataOut)){
+            printf("[EXT2] [EXT2_ReadBlocks] Read error!\r\n");
+            return false;
+        }
+        lba += take;
+        sectors -= take;
+        u8dataOut += take * SECTOR_SIZE;
+    }
+    return true;
+}
+
+bool EXT2_Initialize(Partition* disk){
+    g_Data = (EXT2_Data*)MEMORY_EXT2_ADDR;
+
+    // the superblock is 1024 bytes in, whatever the block size
+    if(!Partition_ReadSectors(disk, 2, 2, g_Data->SB.SuperblockBytes))
+        return false;
+
+    EXT2_Superblock* sb = &g_Data->SB.Superblock;
+    if(sb->Magic != EXT2_MAGIC)
+        return false;
+
+    g_BlockSize = 1024u << sb->LogBlockSize;
+    if(g_BlockSize > EXT2_MAX_BLOCK_SIZE || sb->BlocksPerGroup == 0 || sb->InodesPerGroup == 0){
+        printf("[EXT2] [EXT2_Initialize] Unsupported file system!\r\n");
+        return false;
+    }
+
+    g_SectorsPerBlock = g_BlockSize / SECTOR_SIZE;
+    g_PointersPerBlock = g_BlockSize / sizeof(uint32_t);
+    g_InodeSize = sb->Revision >= 1 ? sb->InodeSize : 128;
+    g_GroupCount = (sb->BlocksCount - sb->FirstDataBlock + sb->BlocksPerGroup - 1) / sb->BlocksPerGroup;
+
+    // cache the block group descriptors, every inode lookup needs one
+    uint32_t cached = min(g_GroupCount, EXT2_CACHED_GROUPS);
+    uint32_t tableSectors = (cached * sizeof(EXT2_GroupDescriptor) + SECTOR_SIZE - 1) / SECTOR_SIZE;
+    uint32_t tableLba = (sb->FirstDataBlock + 1) * g_SectorsPerBlock;
+    for(uint32_t i = 0; i < tableSectors; i += EXT2_MAX_READ_SECTORS){
+        if(!Partition_ReadSectors(disk, tableLba + i, min(tableSectors - i, EXT2_MAX_READ_SECTORS),
+                                  (uint8_t*)g_Data->Groups + i * SECTOR_SIZE)){
+            printf("[EXT2] [EXT2_Initialize] Read group descriptors failed!\r\n");
+            return false;
+        }
+    }
+
+    for(int i = 0; i < 3; i++)
+        g_Data->PointersBlock[i] = 0;
+    for(int i = 0; i < MAX_FILE_HANDLES; i++)
+        g_Data->OpenedFiles[i].Opened = false;
+
+    printf("[EXT2] %u blocks of %u bytes, %u groups\r\n", sb->BlocksCount, g_BlockSize, g_GroupCount);
+    return true;
+}
+
+static bool EXT2_GetGroup(Partition* disk, uint32_t group, EXT2_GroupDescriptor* groupOut){
+    if(group < EXT2_CACHED_GROUPS){
+        *groupOut = g_Data->Groups[group];
+        return true;
+    }
+
+    uint32_t offset = group * sizeof(EXT2_GroupDescriptor);
+    uint32_t lba = (g_Data->SB.Superblock.FirstDataBlock + 1) * g_SectorsPerBlock + offset / SECTOR_SIZE;
+    if(!Partition_ReadSectors(disk, lba, 1, g_Data->Sector))
+        return false;
+
+    memcpy(groupOut, g_Data->Sector + offset % SECTOR_SIZE, sizeof(EXT2_GroupDescriptor));
+    return true;
+}
+
+static bool EXT2_ReadInode(Partition* disk, uint32_t inode, EXT2_Inode* inodeOut){
+    EXT2_Superblock* sb = &g_Data->SB.Superblock;
+    if(inode == 0 || inode > sb->InodesCount)
+        return false;
+
+    EXT2_GroupDescriptor group;
+    if(!EXT2_GetGroup(disk, (inode - 1) / sb->InodesPerGroup, &group))
+        return false;
+
+    // inodes are aligned to their size, none crosses a sector
+    uint32_t offset = ((inode - 1) % sb->InodesPerGroup) * g_InodeSize;
+    uint32_t lba = group.InodeTable * g_SectorsPerBlock + offset / SECTOR_SIZE;
+    if(!Partition_ReadSectors(disk, lba, 1, g_Data->Sector)){
+        printf("[EXT2] [EXT2_ReadInode] Read error!\r\n");
+        return false;
+    }
+
+    memcpy(inodeOut, g_Data->Sector + offset % SECTOR_SIZE, sizeof(EXT2_Inode));
+    return true;
+}
+
+static const uint32_t* EXT2_LoadPointers(Partition* disk, uint32_t level, uint32_t block){
+    if(g_Data->PointersBlock[level] != block){
+        if(!EXT2_ReadBlocks(disk, block, 1, g_Data->Pointers[level]))
+            return NULL;
+        g_Data->PointersBlock[level] = block;
+    }
+    return (const uint32_t*)g_Data->Pointers[level];
+}
+
+// The block holding logical block index of the file (0 for a hole) and in
+// blocksOut how many of the next ones, at most max, follow it on disk
+static bool EXT2_Run(Partition* disk, const uint32_t* pointers, uint32_t index, uint32_t max, uint32_t* blockOut, uint32_t* blocksOut){
+    const uint32_t* array = pointers;
+    uint32_t position = index;
+    uint32_t count = EXT2_DIRECT_BLOCKS;
+
+    if(index >= EXT2_DIRECT_BLOCKS){
+        // find the indirection level, then walk down to the data pointers
+        uint32_t level = 1;
+        uint32_t span = g_PointersPerBlock;
+        index -= EXT2_DIRECT_BLOCKS;
+        while(index >= span){
+            index -= span;
+            if(++level > 3)
+                return false;
+            span *= g_PointersPerBlock;
+        }
+
+        uint32_t block = pointers[EXT2_DIRECT_BLOCKS + level - 1];
+        for(;;){
+            if(block == 0){
+                *blockOut = 0;
+                *blocksOut = min(max, span - index);
+                return true;
+            }
+
+            const uint32_t* loaded = EXT2_LoadPointers(disk, --level, block);
+            if(loaded == NULL)
+                return false;
+
+            span /= g_PointersPerBlock;
+            if(span == 1){
+                array = loaded;
+                position = index;
+                count = g_PointersPerBlock;
+                break;
+            }
+            block = loaded[index / span];
+            index %= span;
+        }
+    }
+
+    uint32_t available = min(count - position, max);
+    uint32_t first = array[position];
+    uint32_t run = 1;
+    while(run < available && array[position + run] == (first != 0 ? first + run : 0))
+        run++;
+
+    *blockOut = first;
+    *blocksOut = run;
+    return true;
+}
+
+// Looks name up in the directory, scanning its records in place a block at
+// a time
+static bool EXT2_FindEntry(Partition* disk, const EXT2_Inode* dir, const char* name, uint32_t* inodeOut){
+    uint32_t length = strlen(name);
+    uint32_t blocks = (dir->Size + g_BlockSize - 1) / g_BlockSize;
+    const uint32_t* pointers = (const uint32_t*)((const uint8_t*)dir + offsetof(EXT2_Inode, Block));
+
+    for(uint32_t index = 0; index < blocks; index++){
+        uint32_t block, run;
+        if(!EXT2_Run(disk, pointers, index, 1, &block, &run))
+            return false;
+        if(block == 0)
+            continue;
+        if(!EXT2_ReadBlocks(disk, block, 1, g_Data->Block))
+            return false;
+
+        for(uint32_t offset = 0; offset + 8 <= g_BlockSize; ){
+            EXT2_DirectoryEntry* entry = (EXT2_DirectoryEntry*)(g_Data->Block + offset);
+
+            // a corrupt record must not send the compare past the block
+            if(entry->RecordLength < 8 || entry->RecordLength > g_BlockSize - offset)
+                break;
+            if(entry->NameLength > entry->RecordLength - 8)
+                break;
+
+            if(entry->Inode != 0 && entry->NameLength == length && memcmp(entry->Name, name, length) == 0){
+                *inodeOut = entry->Inode;
+                return true;
+            }
+            offset += entry->RecordLength;
+        }
+    }
+
+    return false;
+}
+
+static EXT2_File* EXT2_OpenInode(const EXT2_Inode* inode){
+    int handle = -1;
+
+    for (int i = 0; i < MAX_FILE_HANDLES && handle < 0; i++){
+        if(!g_Data->OpenedFiles[i].Opened){
+            handle = i;
+        }
+    }
+    if(handle < 0){
+        printf("[EXT2] [EXT2_OpenInode] Run out of HANDLES!\r\n");
+        return NULL;
+    }
+
+    EXT2_FileData* fd = &g_Data->OpenedFiles[handle];
+    fd->Public.Handle = handle;
+    fd->Public.IsDirectory = (inode->Mode & EXT2_S_IFMT) == EXT2_S_IFDIR;
+    fd->Public.Position = 0;
+    fd->Public.Size = inode->Size;
+    memcpy(fd->Block, inode->Block, sizeof(fd->Block));
+    fd->Opened = true;
+    return &fd->Public;
+}
+
+EXT2_File* EXT2_Open(Partition* disk, const char* path){
+    char name[256];
+    EXT2_Inode inode;
+
+    if(!EXT2_ReadInode(disk, EXT2_ROOT_INODE, &inode))
+        return NULL;
+
+    while(*path){
+        // skip slashes, then take the next component
+        while(*path == '/')
+            path++;
+        if(*path == '\0')
+            break;
+
+        uint32_t length = 0;
+        while(path[length] && path[length] != '/' && length < sizeof(name) - 1){
+            name[length] = path[length];
+            length++;
+        }
+        name[length] = '\0';
+        path += length;
+
+        if((inode.Mode & EXT2_S_IFMT) != EXT2_S_IFDIR){
+            printf("EXT2: %s not a directory\r\n", name);
+            return NULL;
+        }
+
+        uint32_t number;
+        if(!EXT2_FindEntry(disk, &inode, name, &number) || !EXT2_ReadInode(disk, number, &inode)){
+            printf("EXT2: %s not found\r\n", name);
+            return NULL;
+        }
+    }
+
+    return EXT2_OpenInode(&inode);
+}
+
+uint32_t EXT2_Read(Partition* disk, EXT2_File* file, uint32_t byteCount, void* dataOut){
+    EXT2_FileData* fd = &g_Data->OpenedFiles[file->Handle];
+    uint8_t* u8dataOut = (uint8_t*)dataOut;
+
+    // don't read past the end of the file
+    byteCount = min(byteCount, fd->Public.Size - fd->Public.Position);
+
+    while(byteCount > 0){
+        uint32_t inBlock = fd->Public.Position % g_BlockSize;
+        uint32_t maxBlocks = (inBlock + byteCount + g_BlockSize - 1) / g_BlockSize;
+        uint32_t block, blocks;
+        if(!EXT2_Run(disk, fd->Block, fd->Public.Position / g_BlockSize, maxBlocks, &block, &blocks))
+            break;
+
+        uint32_t take;
+        if(inBlock == 0 && byteCount >= g_BlockSize){
+            // whole blocks go straight to the caller, a run per read
+            blocks = min(blocks, byteCount / g_BlockSize);
+            take = blocks * g_BlockSize;
+            if(block == 0)
+                memset(u8dataOut, 0, take);
+            else if(!EXT2_ReadBlocks(disk, block, blocks, u8dataOut))
+                break;
+        } else {
+            // the ends of the range through the block buffer
+            if(block == 0)
+                memset(g_Data->Block, 0, g_BlockSize);
+            else if(!EXT2_ReadBlocks(disk, block, 1, g_Data->Block))
+                break;
+            take = min(g_BlockSize - inBlock, byteCount);
+            memcpy(u8dataOut, g_Data->Block + inBlock, take);
+        }
+
+        u8dataOut += take;
+        fd->Public.Position += take;
+        byteCount -= take;
+    }
+
+    return u8dataOut - (uint8_t*)dataOut;
+}
+
+void EXT2_Close(EXT2_File* file){
+    g_Data->OpenedFiles[file->Handle].Opened = false;
+}
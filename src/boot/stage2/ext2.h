@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "mbr.h"
+
+#include "memdefs.h"
+#include "memory.h"
+#include "stdio.h"
+#include "string.h"
+#include "minmax.h"
+
+typedef struct
+{
+    int Handle;
+    bool IsDirectory;
+    uint32_t Position;
+    uint32_t Size;
+} EXT2_File;
+
+// false if the partition holds no ext2 file system
+bool EXT2_Initialize(Partition* disk);
+EXT2_File * EXT2_Open(Partition* disk, const char* path);
+uint32_t EXT2_Read(Partition* disk, EXT2_File * file, uint32_t byteCount, void* dataOut);
+void EXT2_Close(EXT2_File * file);
@@ -172,7 +172,11 @@ uint32_t FAT_NextCluster(Partition* disk, uint32_t currentCluster){
         }
 
     } else /*if (g_FatType == 32)*/ {
-        nextCluster = *(uint32_t *)(g_Data->FatCache + fatIndex);
+        nextCluster = *(uint32_t *)(g_Data->FatCache + fatIndex) & 0x0FFFFFFF;
+
+        if (nextCluster >= 0x0FFFFFF8) {
+            nextCluster |= 0xF0000000;
+        }
     }
 
     return nextCluster;
@@ -279,6 +283,35 @@ FAT_File* FAT_OpenEntry(Partition* disk, FAT_DirectoryEntry* entry){
 
 
 
+// Loads the sector following the one in the buffer, false past the end of
+// the cluster chain or on read errors
+static bool FAT_NextSector(Partition* disk, FAT_FileData* fd){
+    if(fd->Public.Handle == ROOT_DIRECTORY_HANDLE){
+        ++fd->CurrentCluster;
+        if(!Partition_ReadSectors(disk, fd->CurrentCluster, 1, fd->Buffer)){
+            printf("[FAT] [FAT_NextSector] Read error!\r\n");
+            return false;
+        }
+        return true;
+    }
+
+    if(++fd->CurrentSectorInCluster >= g_Data->BS.BootSector.SectorsPerCluster){
+        fd->CurrentSectorInCluster = 0;
+        fd->CurrentCluster = FAT_NextCluster(disk, fd->CurrentCluster);
+    }
+
+    if(fd->CurrentCluster >= 0xFFFFFFF8){
+        fd->Public.Size = fd->Public.Position;
+        return false;
+    }
+
+    if(!Partition_ReadSectors(disk, FAT_ClusterToLba(fd->CurrentCluster) + fd->CurrentSectorInCluster, 1, fd->Buffer)){
+        printf("[FAT] [FAT_NextSector] Read error!\r\n");
+        return false;
+    }
+    return true;
+}
+
 uint32_t FAT_Read(Partition* disk, FAT_File * file, uint32_t byteCount, void* dataOut){
     FAT_FileData * fd = (file->Handle == ROOT_DIRECTORY_HANDLE)
                                 ? &g_Data->RootDirectory
@@ -298,30 +331,8 @@ uint32_t FAT_Read(Partition* disk, FAT_File * file, uint32_t byteCount, void* da
         u8dataOut += take;
         fd->Public.Position += take;
         byteCount -= take;
-        if(leftInBuffer == take){
-            if(fd->Public.Handle == ROOT_DIRECTORY_HANDLE){
-                ++fd->CurrentCluster;
-                if(!Partition_ReadSectors(disk, fd->CurrentCluster, 1, fd->Buffer)){
-                    printf("[FAT] [FAT_Read] Read error!\r\n");
-                    break;
-                }
-            } else {
-                if(++fd->CurrentSectorInCluster >= g_Data->BS.BootSector.SectorsPerCluster){
-                    fd->CurrentSectorInCluster = 0;
-                    fd->CurrentCluster = FAT_NextCluster(disk, fd->CurrentCluster);
-                }
-
-                if(fd->CurrentCluster >= 0xFFFFFFF8){
-                    fd->Public.Size = fd->Public.Position;
-                    break;
-                }
-
-                if(!Partition_ReadSectors(disk, FAT_ClusterToLba(fd->CurrentCluster) + fd->CurrentSectorInCluster, 1, fd->Buffer)){
-                    printf("[FAT] [FAT_Read] Read error!\r\n");
-                    break;
-                }
-            }
-        }
+        if(leftInBuffer == take && !FAT_NextSector(disk, fd))
+            break;
     }
 
     return u8dataOut - (uint8_t*) dataOut;
@@ -343,7 +354,6 @@ void FAT_Close(FAT_File * file){
 bool FAT_FindFile(Partition* disk, FAT_File * file, const char* name, FAT_DirectoryEntry* entryOut)
 {
     char fatName[12];
-    FAT_DirectoryEntry entry;
 
     // convert from name to fat name
     memset(fatName, ' ', sizeof(fatName));
@@ -362,18 +372,48 @@ bool FAT_FindFile(Partition* disk, FAT_File * file, const char* name, FAT_Direct
             fatName[i + 8] = toUpper(ext[i + 1]);
     }
 
-    while (FAT_ReadEntry(disk, file, &entry))
-    {
-        // printf("FAT name: %s\r\n", fatName);
-        // printf("Entry name: %s\r\n", entry.Name);
-        if (memcmp(fatName, entry.Name, 11) == 0)
-        {
-            *entryOut = entry;
-            return true;
+    FAT_FileData* fd = (file->Handle == ROOT_DIRECTORY_HANDLE)
+                                ? &g_Data->RootDirectory
+                                : &g_Data->OpenedFiles[file->Handle];
+
+    // the 11 bytes of the name are compared as two words, a half word and a byte
+    uint32_t name0 = *(const uint32_t*)fatName;
+    uint32_t name1 = *(const uint32_t*)(fatName + 4);
+    uint16_t name2 = *(const uint16_t*)(fatName + 8);
+
+    // entries are scanned in place in the sector buffer, a sector at a time
+    bool bounded = fd->Public.Size != 0;
+    for(;;){
+        uint32_t start = fd->Public.Position % SECTOR_SIZE;
+        uint32_t end = SECTOR_SIZE;
+        if(bounded)
+            end = min(end, start + fd->Public.Size - fd->Public.Position);
+
+        for(uint32_t offset = start; offset + sizeof(FAT_DirectoryEntry) <= end; offset += sizeof(FAT_DirectoryEntry)){
+            const uint8_t* raw = fd->Buffer + offset;
+
+            // end of directory
+            if(raw[0] == 0x00)
+                return false;
+
+            // deleted entries and long file name pieces
+            if(raw[0] == 0xE5 || (raw[11] & FAT_ATTRIBUTE_LFN) == FAT_ATTRIBUTE_LFN)
+                continue;
+
+            if(*(const uint32_t*)raw == name0
+                && *(const uint32_t*)(raw + 4) == name1
+                && *(const uint16_t*)(raw + 8) == name2
+                && raw[10] == (uint8_t)fatName[10]){
+                fd->Public.Position += offset + sizeof(FAT_DirectoryEntry) - start;
+                memcpy(entryOut, raw, sizeof(FAT_DirectoryEntry));
+                return true;
+            }
         }
-    }
 
-    return false;
+        fd->Public.Position += end - start;
+        if(end != SECTOR_SIZE || !FAT_NextSector(disk, fd))
+            return false;
+    }
 }
 
 
@@ -400,13 +440,11 @@ FAT_File * FAT_Open(Partition* disk, const char* path){
         {
             unsigned len = strlen(path);
             memcpy(name, path, len);
-            name[len + 1] = '\0';
+            name[len] = '\0';
             path += len;
             isLast = true;
         }
 
-        printf("Searching for: %s\r\n", name);
-
         // find directory entry in current directory
         FAT_DirectoryEntry entry;
         if (FAT_FindFile(disk, current, name, &entry))
@@ -2,12 +2,49 @@
 #include "stdio.h"
 #include "disk.h"
 #include "fat.h"
+#include "ext2.h"
 #include "mbr.h"
+#include "x86.h"
+#include "bootinfo.h"
 
 uint8_t* KernelLoadBuffer = (uint8_t*)MEMORY_LOAD_KERNEL;
 uint8_t* Kernel = (uint8_t*)MEMORY_KERNEL_ADDR;
 
-typedef void (*KernelStart)();
+typedef void (*KernelStart)(const BootInfo* bootInfo);
+
+static bool g_Ext2;
+static BootInfo g_BootInfo;
+
+// Reads a whole file to destination through the low memory load buffer,
+// the BIOS can't reach higher; false if it is not found
+static bool LoadFile(Partition* part, const char* path, uint8_t* destination, uint32_t* sizeOut){
+    uint32_t read;
+    *sizeOut = 0;
+
+    if(g_Ext2){
+        EXT2_File* fd = EXT2_Open(part, path);
+        if(fd == NULL)
+            return false;
+        while((read = EXT2_Read(part, fd, MEMORY_LOAD_SIZE, KernelLoadBuffer))){
+            memcpy(destination + *sizeOut, KernelLoadBuffer, read);
+            *sizeOut += read;
+        }
+        EXT2_Close(fd);
+    } else {
+        // the directory walk alone, the number the FAT lookup is tuned on
+        uint64_t start = x86_ReadTSC();
+        FAT_File* fd = FAT_Open(part, path);
+        printf("[BOOT] FAT lookup of %s: %llu TSC cycles\r\n", path, x86_ReadTSC() - start);
+        if(fd == NULL)
+            return false;
+        while((read = FAT_Read(part, fd, MEMORY_LOAD_SIZE, KernelLoadBuffer))){
+            memcpy(destination + *sizeOut, KernelLoadBuffer, read);
+            *sizeOut += read;
+        }
+        FAT_Close(fd);
+    }
+    return true;
+}
 
 void __attribute__((cdecl)) start(uint16_t bootDrive,void* partition){
     clrscr();
@@ -22,26 +59,41 @@ void __attribute__((cdecl)) start(uint16_t bootDrive,void* partition){
     Partition part;
     MBR_DetectPartition(&part, &disk, partition);
 
-    if(!FAT_Initialize(&part)){
-        printf("[BOOT] FAT init error!\r\n");
+    // ext2 first: its boot block holds no BPB for the FAT code to trip over
+    g_Ext2 = EXT2_Initialize(&part);
+    if(!g_Ext2 && !FAT_Initialize(&part)){
+        printf("[BOOT] File system init error!\r\n");
         goto end;
     }
 
     //Load kernel
-    FAT_File * fd = FAT_Open(&part, "/boot/kernel.bin");
-    uint32_t read;
-    uint8_t* KernelBuffer = Kernel;
-    while((read = FAT_Read(&part, fd, MEMORY_LOAD_SIZE, KernelLoadBuffer))){
-        memcpy(KernelBuffer, KernelLoadBuffer, read);
-        KernelBuffer += read;
+    uint32_t kernelSize;
+    if(!LoadFile(&part, "/boot/kernel.bin", Kernel, &kernelSize)){
+        printf("[BOOT] Can't load /boot/kernel.bin!\r\n");
+        goto end;
+    }
+
+    // the initrd goes on the first page after the kernel's BSS, which only
+    // the kernel header knows about
+    g_BootInfo.Magic = BOOTINFO_MAGIC;
+    g_BootInfo.BootDrive = bootDrive;
+    KernelHeader* header = (KernelHeader*)(Kernel + KERNEL_HEADER_OFFSET);
+    if(header->Magic == KERNEL_HEADER_MAGIC){
+        uint8_t* initrd = (uint8_t*)((header->End + 0xFFF) & ~0xFFF);
+        uint32_t initrdSize;
+        if(LoadFile(&part, "/boot/initrd.tar", initrd, &initrdSize)){
+            g_BootInfo.InitrdAddress = (uint32_t)initrd;
+            g_BootInfo.InitrdSize = initrdSize;
+            printf("[BOOT] initrd at 0x%x, %u bytes\r\n", g_BootInfo.InitrdAddress, g_BootInfo.InitrdSize);
+        }
     }
-    FAT_Close(fd);
 
     //Kernel start
     KernelStart kernelstart = (KernelStart)Kernel;
-    kernelstart();
+    kernelstart(&g_BootInfo);
 
     end:
-        for(;;);
+        for(;;)
+            x86_Halt();
 
 }
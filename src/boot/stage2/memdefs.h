@@ -10,6 +10,10 @@
 #define MEMORY_FAT_ADDR  ((void *) 0x20000)
 #define MEMORY_FAT_SIZE 0x00010000
 
+// EXT2 Driver - same area, only one file system is in use
+#define MEMORY_EXT2_ADDR ((void *) 0x20000)
+#define MEMORY_EXT2_SIZE 0x00010000
+
 #define MEMORY_LOAD_KERNEL ((void*) 0x30000)
 #define MEMORY_LOAD_SIZE 0x00010000
 
@@ -21,4 +25,6 @@
 // 0x000A0000 - 0x000C7FFF - Video
 // 0x000C8000 - 0x000FFFFF - BIOS
 
-#define MEMORY_KERNEL_ADDR ((void*) 0x100000)
\ No newline at end of file
+#define MEMORY_KERNEL_ADDR ((void*) 0x100000)
+
+// initrd - the first page after the kernel BSS, see bootinfo.h
\ No newline at end of file
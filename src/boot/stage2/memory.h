@@ -1,8 +1,9 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 
-void * memcpy( void * dst, const void * src, uint16_t num);
-void * memset(void * ptr, int value, uint16_t num);
-int memcmp(const void * ptr1, const void * ptr2, uint16_t num);
+void * memcpy( void * dst, const void * src, size_t num);
+void * memset(void * ptr, int value, size_t num);
+int memcmp(const void * ptr1, const void * ptr2, size_t num);
 
 void* segmentoffset_to_linear(void* address);
\ No newline at end of file
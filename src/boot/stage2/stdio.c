@@ -198,7 +198,7 @@ void printf(const char* fmt, ...){
                     case 'd':
                     case 'i': radix = 10; sign = true; number = true;
                               break;
-                    case 'u': radix = 10; sign = false;
+                    case 'u': radix = 10; sign = false; number = true;
                               break;
                     case 'X':
                     case 'x':
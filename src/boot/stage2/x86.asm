@@ -78,6 +78,22 @@ x86_inb:
     in al, dx
     ret
 
+; uint64_t _cdecl x86_ReadTSC();
+global x86_ReadTSC
+x86_ReadTSC:
+    [bits 32]
+    rdtsc
+    ret
+
+; void _cdecl x86_Halt();
+; no IDT is loaded in protected mode, so halt with interrupts disabled
+global x86_Halt
+x86_Halt:
+    [bits 32]
+    cli
+    hlt
+    ret
+
 
 ; bool _cdecl x86_Disk_GetDriveParams(uint8_t drive, uint8_t* driveTypeOut, uint16_t* cylindersOut, uint16_t* sectorsOut, uint16_t* headsOut);
 
@@ -71,4 +71,5 @@ enum {
     CPUID_FEAT_EDX_IA64         = 1 << 30,
     CPUID_FEAT_EDX_PBE          = 1 << 31
 };
+int check_apic(void);
 void print_cpu_info();
@@ -0,0 +1,66 @@
+#include <arch/i686/apic/lapic.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/io.h>
+#include <arch/generic/cpu.h>
+#include <stddef.h>
+
+#define IA32_APIC_BASE_MSR          0x1B
+#define IA32_APIC_BASE_ENABLE       0x800
+#define IA32_APIC_BASE_ADDR_MASK    0xFFFFF000
+
+#define LAPIC_SVR_ENABLE            0x100
+
+static volatile uint8_t* g_LAPIC = NULL;
+
+uint32_t i686_LAPIC_Read(uint32_t reg){
+    return *(volatile uint32_t*)(g_LAPIC + reg);
+}
+
+void i686_LAPIC_Write(uint32_t reg, uint32_t value){
+    *(volatile uint32_t*)(g_LAPIC + reg) = value;
+}
+
+void i686_LAPIC_SendEOI(){
+    i686_LAPIC_Write(LAPIC_REG_EOI, 0);
+}
+
+void i686_LAPIC_SendIPI(uint8_t apicId, uint32_t command){
+    // writing the low half sends it, wait for the previous one to leave first
+    while(i686_LAPIC_Read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING);
+
+    i686_LAPIC_Write(LAPIC_REG_ICR_HIGH, (uint32_t)apicId << 24);
+    i686_LAPIC_Write(LAPIC_REG_ICR_LOW, command);
+
+    while(i686_LAPIC_Read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING);
+}
+
+uint8_t i686_LAPIC_GetID(){
+    return i686_LAPIC_Read(LAPIC_REG_ID) >> 24;
+}
+
+bool i686_LAPIC_IsEnabled(){
+    return g_LAPIC != NULL;
+}
+
+static void i686_LAPIC_SpuriousHandler(Registers* regs){
+    // spurious interrupts must not be acknowledged
+}
+
+bool i686_LAPIC_Initialize(){
+    if(!check_apic()){
+        return false;
+    }
+
+    // The BIOS leaves the LAPIC in virtual wire mode (LINT0 = ExtINT), so the
+    // i8259 keeps delivering legacy IRQs once the LAPIC is software enabled.
+    uint64_t base = i686_rdmsr(IA32_APIC_BASE_MSR);
+    i686_wrmsr(IA32_APIC_BASE_MSR, base | IA32_APIC_BASE_ENABLE);
+    g_LAPIC = (volatile uint8_t*)(uint32_t)(base & IA32_APIC_BASE_ADDR_MASK);
+
+    i686_ISR_RegisterHandler(LAPIC_VECTOR_SPURIOUS, i686_LAPIC_SpuriousHandler);
+
+    i686_LAPIC_Write(LAPIC_REG_TPR, 0);
+    i686_LAPIC_Write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    i686_LAPIC_Write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_VECTOR_SPURIOUS);
+    return true;
+}
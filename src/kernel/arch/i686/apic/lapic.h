@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LAPIC_VECTOR_TIMER          0x40
+#define LAPIC_VECTOR_CALL           0x41
+#define LAPIC_VECTOR_PROFILE        0x42
+#define LAPIC_VECTOR_MSI_FIRST      0x50        // handed out to MSI capable devices
+#define LAPIC_VECTOR_MSI_LAST       0xEF
+#define LAPIC_VECTOR_SPURIOUS       0xFF
+
+enum {
+    LAPIC_REG_ID                = 0x020,
+    LAPIC_REG_VERSION           = 0x030,
+    LAPIC_REG_TPR               = 0x080,
+    LAPIC_REG_EOI               = 0x0B0,
+    LAPIC_REG_SVR               = 0x0F0,
+    LAPIC_REG_ESR               = 0x280,
+    LAPIC_REG_ICR_LOW           = 0x300,
+    LAPIC_REG_ICR_HIGH          = 0x310,
+    LAPIC_REG_LVT_TIMER         = 0x320,
+    LAPIC_REG_LVT_LINT0         = 0x350,
+    LAPIC_REG_LVT_LINT1         = 0x360,
+    LAPIC_REG_LVT_ERROR         = 0x370,
+    LAPIC_REG_TIMER_INITIAL     = 0x380,
+    LAPIC_REG_TIMER_CURRENT     = 0x390,
+    LAPIC_REG_TIMER_DIVIDE      = 0x3E0,
+};
+
+enum {
+    LAPIC_LVT_MASKED            = 0x10000,
+    LAPIC_LVT_TIMER_ONESHOT     = 0x00000,
+    LAPIC_LVT_TIMER_PERIODIC    = 0x20000,
+    LAPIC_LVT_TIMER_TSCDEADLINE = 0x40000,
+};
+
+enum {
+    LAPIC_ICR_FIXED             = 0x00000,
+    LAPIC_ICR_INIT              = 0x00500,
+    LAPIC_ICR_STARTUP           = 0x00600,
+    LAPIC_ICR_PENDING           = 0x01000,
+    LAPIC_ICR_ASSERT            = 0x04000,
+    LAPIC_ICR_LEVEL             = 0x08000,
+};
+
+bool i686_LAPIC_Initialize();
+bool i686_LAPIC_IsEnabled();
+uint8_t i686_LAPIC_GetID();
+uint32_t i686_LAPIC_Read(uint32_t reg);
+void i686_LAPIC_Write(uint32_t reg, uint32_t value);
+void i686_LAPIC_SendEOI();
+void i686_LAPIC_SendIPI(uint8_t apicId, uint32_t command);
@@ -0,0 +1,16 @@
+#include <arch/i686/context.h>
+
+void __attribute__((cdecl)) i686_Context_Trampoline();
+
+// Builds the frame i686_Context_Switch pops when switching to a new context
+uint32_t* i686_Context_Initialize(void* stackTop, ContextEntry entry, void* arg){
+    uint32_t* stack = (uint32_t*)((uint32_t)stackTop & ~0xF);
+
+    *--stack = (uint32_t)i686_Context_Trampoline;   // return address
+    *--stack = 0;                                   // ebp, ends stack traces
+    *--stack = (uint32_t)entry;                     // ebx
+    *--stack = (uint32_t)arg;                       // esi
+    *--stack = 0;                                   // edi
+
+    return stack;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+
+typedef void (*ContextEntry)(void* arg);
+
+uint32_t* i686_Context_Initialize(void* stackTop, ContextEntry entry, void* arg);
+void __attribute__((cdecl)) i686_Context_Switch(uint32_t** oldStack, uint32_t* newStack);
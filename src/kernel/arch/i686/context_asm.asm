@@ -0,0 +1,33 @@
+[bits 32]
+
+; void __attribute__((cdecl)) i686_Context_Switch(uint32_t** oldStack, uint32_t* newStack);
+; Only the callee-saved registers need to survive, everything else was
+; already spilled by the C caller.
+
+global i686_Context_Switch
+i686_Context_Switch:
+    mov eax, [esp + 4]  ; where to save the old stack pointer
+    mov edx, [esp + 8]  ; stack pointer to switch to
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+
+    mov [eax], esp
+    mov esp, edx
+
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
+; First return target of a new context (see i686_Context_Initialize):
+; ebx = entry point, esi = argument. The entry point must never return.
+
+global i686_Context_Trampoline
+i686_Context_Trampoline:
+    push esi
+    call ebx
+    ud2
@@ -0,0 +1,149 @@
+#include <arch/i686/fpu.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/io.h>
+#include <arch/generic/cpu.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+#define FPU_VECTOR_DEVICE_NOT_AVAILABLE 7
+
+enum {
+    CR0_MP                       = 0x02,
+    CR0_EM                       = 0x04,
+    CR0_TS                       = 0x08,
+    CR0_NE                       = 0x20,
+};
+
+enum {
+    CR4_OSFXSR                   = 0x200,
+    CR4_OSXMMEXCPT               = 0x400,
+};
+
+void __attribute__((cdecl)) i686_fxsave(void* area);
+void __attribute__((cdecl)) i686_fxrstor(const void* area);
+void __attribute__((cdecl)) i686_fninit();
+
+// Lazy switching: the registers keep belonging to g_Owner until some other
+// context touches the FPU. CR0.TS makes that first touch raise #NM, and only
+// then is the owner's state saved and the new one loaded.
+static bool g_Enabled = false;
+static FPUContext* g_Owner = NULL;
+static FPUContext* g_Current = NULL;
+static FPUContext g_DefaultContext;
+static FPUContext g_BootContext;            // until the scheduler takes over
+static uint32_t g_KernelFlags;
+static FPUStats g_Stats;
+
+static void i686_FPU_SetTS(){
+    i686_write_cr0(i686_read_cr0() | CR0_TS);
+}
+
+static void i686_FPU_DeviceNotAvailable(Registers* regs){
+    i686_clts();
+    g_Stats.Traps++;
+
+    if(g_Owner == g_Current)
+        return;
+
+    if(g_Owner != NULL){
+        i686_fxsave(g_Owner->Area);
+        g_Stats.Saves++;
+    }
+
+    i686_fxrstor(g_Current->Area);
+    g_Stats.Restores++;
+    g_Owner = g_Current;
+}
+
+void i686_FPU_Initialize(){
+    unsigned int eax, ebx, ecx, edx;
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+
+    if(!(edx & CPUID_FEAT_EDX_FPU) || !(edx & CPUID_FEAT_EDX_FXSR)){
+        printf("[FPU] No FXSAVE support, FPU state is shared by all threads!\r\n");
+        return;
+    }
+
+    uint32_t cr0 = i686_read_cr0();
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    i686_write_cr0(cr0);
+
+    uint32_t cr4 = i686_read_cr4() | CR4_OSFXSR;
+    if(edx & CPUID_FEAT_EDX_SSE)
+        cr4 |= CR4_OSXMMEXCPT;
+    i686_write_cr4(cr4);
+
+    // every context starts from a freshly initialized FPU
+    i686_fninit();
+    i686_fxsave(g_DefaultContext.Area);
+    i686_FPU_InitializeContext(&g_BootContext);
+
+    i686_ISR_RegisterHandler(FPU_VECTOR_DEVICE_NOT_AVAILABLE, i686_FPU_DeviceNotAvailable);
+
+    g_Owner = NULL;
+    g_Current = &g_BootContext;
+    g_Enabled = true;
+    i686_FPU_SetTS();
+}
+
+void i686_FPU_InitializeContext(FPUContext* context){
+    memcpy(context->Area, g_DefaultContext.Area, FPU_STATE_SIZE);
+}
+
+void i686_FPU_SwitchTo(FPUContext* next){
+    if(!g_Enabled)
+        return;
+
+    g_Current = next;
+    g_Stats.Switches++;
+
+    // switching back to the owner: its state never left the registers
+    if(next == g_Owner)
+        i686_clts();
+    else
+        i686_FPU_SetTS();
+}
+
+void i686_FPU_Release(FPUContext* context){
+    if(g_Owner == context)
+        g_Owner = NULL;
+}
+
+void i686_FPU_KernelBegin(){
+    g_KernelFlags = i686_irqsave();
+    if(!g_Enabled)
+        return;
+
+    i686_clts();
+    if(g_Owner != NULL){
+        i686_fxsave(g_Owner->Area);
+        g_Stats.Saves++;
+        g_Owner = NULL;
+    }
+}
+
+void i686_FPU_KernelEnd(){
+    // the registers now hold kernel garbage, whoever is next has to reload
+    if(g_Enabled)
+        i686_FPU_SetTS();
+
+    i686_irqrestore(g_KernelFlags);
+}
+
+void i686_FPU_GetStats(FPUStats* stats){
+    uint32_t flags = i686_irqsave();
+    *stats = g_Stats;
+    i686_irqrestore(flags);
+}
+
+void i686_FPU_PrintStats(){
+    FPUStats stats;
+    i686_FPU_GetStats(&stats);
+
+    printf("===== FPU STATS =====\r\n");
+    printf("switches=%llu traps=%llu\r\n", stats.Switches, stats.Traps);
+    printf("saves=%llu restores=%llu\r\n", stats.Saves, stats.Restores);
+    printf("=====================\r\n");
+}
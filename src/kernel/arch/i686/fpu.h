@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FPU_STATE_SIZE              512
+
+// FXSAVE image of one execution context
+typedef struct{
+    uint8_t Area[FPU_STATE_SIZE];
+} __attribute__((aligned(16))) FPUContext;
+
+typedef struct{
+    uint64_t Switches;              // context switches seen
+    uint64_t Traps;                 // #NM exceptions taken
+    uint64_t Saves;                 // FXSAVEs actually done
+    uint64_t Restores;              // FXRSTORs actually done
+} FPUStats;
+
+void i686_FPU_Initialize();
+void i686_FPU_InitializeContext(FPUContext* context);
+void i686_FPU_SwitchTo(FPUContext* next);
+void i686_FPU_Release(FPUContext* context);
+
+// Brackets in-kernel SIMD code; interrupts stay disabled in between and the
+// sections must not nest.
+void i686_FPU_KernelBegin();
+void i686_FPU_KernelEnd();
+
+void i686_FPU_GetStats(FPUStats* stats);
+void i686_FPU_PrintStats();
@@ -0,0 +1,21 @@
+[bits 32]
+
+; void __attribute__((cdecl)) i686_fxsave(void* area);
+global i686_fxsave
+i686_fxsave:
+    mov eax, [esp + 4]  ; 512 bytes, 16 byte aligned
+    fxsave [eax]
+    ret
+
+; void __attribute__((cdecl)) i686_fxrstor(const void* area);
+global i686_fxrstor
+i686_fxrstor:
+    mov eax, [esp + 4]
+    fxrstor [eax]
+    ret
+
+; void __attribute__((cdecl)) i686_fninit();
+global i686_fninit
+i686_fninit:
+    fninit
+    ret
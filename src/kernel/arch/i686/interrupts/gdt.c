@@ -1,4 +1,5 @@
 #include <arch/i686/interrupts/gdt.h>
+#include <arch/i686/smp/percpu.h>
 #include <stdint.h>
 
 typedef struct{
@@ -15,77 +16,60 @@ typedef struct{
     GDTEntry* ptr;
 } __attribute__((packed)) GDTDescriptor;
 
-
-typedef enum{
-    GDT_ACCESS_CODE_READABLE                    = 0x02,
-    GDT_ACCESS_CODE_WRITABLE                    = 0x02,
-
-    GDT_ACCESS_CODE_CONFORMING                  = 0x04,
-    GDT_ACCESS_CODE_DIRECTION_NORMAL            = 0x00,
-    GDT_ACCESS_CODE_DIRECTION_DOWN              = 0x04,
-
-    GDT_ACCESS_DATA_SEGMENT                     = 0x10,
-    GDT_ACCESS_CODE_SEGMENT                     = 0x18,
-
-    GDT_ACCESS_DESCRIPTOR_TSS                   = 0x00,
-
-    GDT_ACCESS_RING0                            = 0x00,
-    GDT_ACCESS_RING1                            = 0x20,
-    GDT_ACCESS_RING2                            = 0x40,
-    GDT_ACCESS_RING3                            = 0x60,
-
-    GDT_ACCESS_PRESENT                          = 0x80,
-
-} GDT_ACCESS;
-
-
-typedef enum{
-
-    GDT_FLAG_64BIT                              = 0x20,
-    GDT_FLAG_32BIT                              = 0x40,
-    GDT_FLAG_16BIT                              = 0x00,
-
-    GDT_FLAG_GRANULARITY_1B                     = 0x00,
-    GDT_FLAG_GRANULARITY_4K                     = 0x80,
-
-} GDT_FLAGS;
-
-#define GDT_LIMIT_LOW(limit)                    (limit & 0xFFFF)
-#define GDT_BASE_LOW(base)                      (base  & 0xFFFF)
-#define GDT_BASE_MIDDLE(base)                   ((base >> 16)  & 0xFF)
-#define GDT_FLAGS_LIMIT_HI(limit, flags)        ((limit >> 16) & 0xF | (flags & 0xF0))
-#define GDT_BASE_HIGH(base)                     ((base >> 24) & 0xFF)
-
-#define GDT_ENTRY(base, limit, access, flags) { \
-    GDT_LIMIT_LOW(limit),                       \
-    GDT_BASE_LOW(base),                         \
-    GDT_BASE_MIDDLE(base),                      \
-    access,                                     \
-    GDT_FLAGS_LIMIT_HI(limit, flags),           \
-    GDT_BASE_HIGH(base)                         \
-}
-
-GDTEntry g_GDT[] = {
-    // NULL
-    GDT_ENTRY(0,0,0,0),
-    // Kernel 32-bit code segment                        
-    GDT_ENTRY(0,
-              0xFFFFF,
-              GDT_ACCESS_PRESENT | GDT_ACCESS_RING0 | GDT_ACCESS_CODE_SEGMENT | GDT_ACCESS_CODE_READABLE,
-              GDT_FLAG_32BIT | GDT_FLAG_GRANULARITY_4K),
-    // Kernel 32-bit data segment                        
-    GDT_ENTRY(0,
-              0xFFFFF,
-              GDT_ACCESS_PRESENT | GDT_ACCESS_RING0 | GDT_ACCESS_DATA_SEGMENT | GDT_ACCESS_CODE_WRITABLE,
-              GDT_FLAG_32BIT | GDT_FLAG_GRANULARITY_4K),
+// Task state segment, only the ring 0 stack is used
+typedef struct{
+    uint32_t PrevTask;
+    uint32_t Esp0;
+    uint32_t Ss0;
+    uint32_t Esp1;
+    uint32_t Ss1;
+    uint32_t Esp2;
+    uint32_t Ss2;
+    uint32_t Cr3;
+    uint32_t Eip;
+    uint32_t Eflags;
+    uint32_t Eax, Ecx, Edx, Ebx;
+    uint32_t Esp, Ebp, Esi, Edi;
+    uint32_t Es, Cs, Ss, Ds, Fs, Gs;
+    uint32_t Ldt;
+    uint16_t Trap;
+    uint16_t IOMapBase;
+} __attribute__((packed)) TSS;
+
+// NULL, kernel code, kernel data, TSS, per-CPU data
+#define GDT_ENTRY_COUNT 5
+
+// scripts/generate_isr.py has its own copies of these, the linker checks
+// the layout they describe (see arch/i686/tables_gen.ld)
+_Static_assert(sizeof(TSS) == 104, "TSS_SIZE in scripts/generate_isr.py");
+_Static_assert(GDT_ENTRY_COUNT == 5, "GDT_ENTRY_COUNT in scripts/generate_isr.py");
+_Static_assert(CPU_MAX == 8, "CPU_MAX in scripts/generate_isr.py");
+
+// Every CPU has its own table: they differ in the TSS and per-CPU segment
+// base. scripts/generate_isr.py writes them out, descriptors included, in
+// arch/i686/tables_gen.ld and the linker fills in the bases, so nothing is
+// left to build at boot.
+extern GDTEntry g_GDT[CPU_MAX][GDT_ENTRY_COUNT];
+extern GDTDescriptor g_GDTDescriptor[CPU_MAX];
+
+// The generated tables take the TSS addresses from here. In a section of
+// its own, so the linker can check its size.
+TSS g_TSS[CPU_MAX] __attribute__((section(".tss"))) = {
+    [0 ... CPU_MAX - 1] = {
+        .Ss0 = i686_GDT_DATA_SEGMENT,
+        .IOMapBase = sizeof(TSS),
+    },
 };
 
-GDTDescriptor g_GDTDescriptor = {sizeof(g_GDT) - 1, g_GDT};
-
 
 void __attribute__((cdecl)) i686_GDT_Load(GDTDescriptor* descriptor, uint16_t codeSegment, uint16_t dataSegment);
+void __attribute__((cdecl)) i686_GDT_LoadTSS(uint16_t tssSegment);
+void __attribute__((cdecl)) i686_GDT_LoadPerCPU(uint16_t perCPUSegment);
 
+void i686_GDT_Initialize(uint32_t cpu, void* stackTop){
+    g_TSS[cpu].Esp0 = (uint32_t)stackTop;
 
-void i686_GDT_Initialize(){
-    i686_GDT_Load(&g_GDTDescriptor, i686_GDT_CODE_SEGMENT, i686_GDT_DATA_SEGMENT);
-}
\ No newline at end of file
+    i686_GDT_Load(&g_GDTDescriptor[cpu], i686_GDT_CODE_SEGMENT, i686_GDT_DATA_SEGMENT);
+    i686_GDT_LoadTSS(i686_GDT_TSS_SEGMENT);
+    i686_GDT_LoadPerCPU(i686_GDT_PERCPU_SEGMENT);
+}
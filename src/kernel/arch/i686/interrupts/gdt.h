@@ -1,5 +1,11 @@
 #pragma once
+#include <stdint.h>
 
 #define i686_GDT_CODE_SEGMENT 0x08
 #define i686_GDT_DATA_SEGMENT 0x10
-void i686_GDT_Initialize();
\ No newline at end of file
+#define i686_GDT_TSS_SEGMENT 0x18
+#define i686_GDT_PERCPU_SEGMENT 0x20
+
+// Loads the GDT of one CPU. %gs is left pointing at the CPU's PerCPU entry
+// and is not touched again by the kernel.
+void i686_GDT_Initialize(uint32_t cpu, void* stackTop);
\ No newline at end of file
@@ -28,4 +28,18 @@ i686_GDT_Load:
 
     mov esp, ebp
     pop ebp
+    ret
+
+; void __attribute__((cdecl)) i686_GDT_LoadTSS(uint16_t tssSegment);
+global i686_GDT_LoadTSS
+i686_GDT_LoadTSS:
+    mov ax, [esp + 4]
+    ltr ax
+    ret
+
+; void __attribute__((cdecl)) i686_GDT_LoadPerCPU(uint16_t perCPUSegment);
+global i686_GDT_LoadPerCPU
+i686_GDT_LoadPerCPU:
+    mov ax, [esp + 4]
+    mov gs, ax
     ret
\ No newline at end of file
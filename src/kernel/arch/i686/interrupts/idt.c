@@ -17,7 +17,9 @@ typedef struct {
 
 
 
-IDTEntry g_IDT[256];
+// Generated by scripts/generate_isr.py into arch/i686/tables_gen.ld: every
+// gate points at its stub in isr_asm.asm and is present from the start
+extern IDTEntry g_IDT[256];
 IDTDescriptor g_IDTDescriptor = {sizeof(g_IDT) - 1, g_IDT};
 
 void __attribute__((cdecl)) i686_IDT_Load(IDTDescriptor* idtDescriptor);
@@ -2,6 +2,7 @@
 #include <arch/i686/io.h>
 #include "stdio.h"
 #include <util/arrays.h>
+#include <util/trace.h>
 #include <stddef.h>
 
 #define PIC_REMAP_OFFSET 0x20
@@ -11,12 +12,14 @@ static const PICDriver* g_Driver = NULL;
 
 void i686_IRQ_Handler(Registers* regs){
     int irq = regs->interrupt - PIC_REMAP_OFFSET;
+    TRACE(TRACE_IRQ_ENTRY, irq, 0);
     if(g_IRQHandlers[irq] != NULL){
         g_IRQHandlers[irq](regs);
     }else{
         printf("Unhandled IRQ %d ...\n", irq);
     }
     g_Driver->SendEOI(irq);
+    TRACE(TRACE_IRQ_EXIT, irq, 0);
 }
 
 void i686_IRQ_Initialize(){
@@ -39,12 +42,19 @@ void i686_IRQ_Initialize(){
     printf("Found %s\n\r", g_Driver->Name);
     g_Driver->Initialize(PIC_REMAP_OFFSET, PIC_REMAP_OFFSET + 8,false);
 
-    for(int i = 0; i < 16; i++){
-        i686_ISR_RegisterHandler(PIC_REMAP_OFFSET + i, i686_IRQ_Handler);
-    }
+    // the ISR table comes with i686_IRQ_Handler on these vectors, see
+    // scripts/generate_isr.py
     i686_sti();
 }
 
 void i686_IRQ_RegisterHandler(int irq, IRQHandler handler){
     g_IRQHandlers[irq] = handler;
+}
+
+void i686_IRQ_Mask(int irq){
+    g_Driver->Mask(irq);
+}
+
+void i686_IRQ_Unmask(int irq){
+    g_Driver->Unmask(irq);
 }
\ No newline at end of file
@@ -7,4 +7,6 @@
 typedef void (*IRQHandler) (Registers* regs);
 
 void i686_IRQ_Initialize();
-void i686_IRQ_RegisterHandler(int irq, IRQHandler handler);
\ No newline at end of file
+void i686_IRQ_RegisterHandler(int irq, IRQHandler handler);
+void i686_IRQ_Mask(int irq);
+void i686_IRQ_Unmask(int irq);
\ No newline at end of file
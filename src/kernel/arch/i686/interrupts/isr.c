@@ -2,10 +2,18 @@
 #include <arch/i686/interrupts/idt.h>
 #include <arch/i686/interrupts/gdt.h>
 #include <arch/i686/io.h>
+#include <arch/i686/smp/percpu.h>
+#include <util/trace.h>
 #include <stdio.h>
 #include <stddef.h>
 
-ISRHandler g_ISRHandler[256];
+// Generated by scripts/generate_isr.py into arch/i686/tables_gen.ld, with
+// the PIC vectors already pointing at i686_IRQ_Handler
+extern ISRHandler g_ISRHandler[256];
+#define ISR_MAX_EXIT_HANDLERS 4
+
+static ISRExitHandler g_ExitHandlers[ISR_MAX_EXIT_HANDLERS];
+static int g_ExitHandlerCount = 0;
 
 static const char* const g_Exceptions[] = {
     "Divide by zero error",
@@ -42,16 +50,11 @@ static const char* const g_Exceptions[] = {
     ""
 };
 
-void i686_ISR_InitializeGates();
-
-void i686_ISR_Initialize(){
-    i686_ISR_InitializeGates();
-    for (int i = 0; i < 256; i++){
-        i686_IDT_EnableGate(i);
-    }
-}
-
 void __attribute__((cdecl)) i686_ISR_Handler(Registers* regs){
+    PerCPU* cpu = i686_PerCPU_Get();
+    cpu->InterruptDepth++;
+    TRACE(TRACE_ISR_ENTRY, regs->interrupt, 0);
+
     if(g_ISRHandler[regs->interrupt] != NULL){
         g_ISRHandler[regs->interrupt](regs);
     }else if(regs->interrupt >= 32){
@@ -80,9 +83,30 @@ void __attribute__((cdecl)) i686_ISR_Handler(Registers* regs){
         printf("========================\r\n");
         i686_panic();
     }
+
+    // the exit handler may switch to another thread, which must not
+    // believe it is running inside an interrupt
+    TRACE(TRACE_ISR_EXIT, regs->interrupt, 0);
+    cpu->InterruptDepth--;
+    for(int i = 0; i < g_ExitHandlerCount && cpu->InterruptDepth == 0; i++)
+        g_ExitHandlers[i]();
 }
 void i686_ISR_RegisterHandler(int interrupt, ISRHandler handler)
 {
     g_ISRHandler[interrupt] = handler;
     i686_IDT_EnableGate(interrupt);
+}
+
+// Exit handlers run in registration order
+void i686_ISR_RegisterExitHandler(ISRExitHandler handler)
+{
+    if(g_ExitHandlerCount < ISR_MAX_EXIT_HANDLERS)
+        g_ExitHandlers[g_ExitHandlerCount++] = handler;
+    else
+        printf("Too many interrupt exit handlers!\r\n");
+}
+
+bool i686_ISR_InInterrupt()
+{
+    return i686_PerCPU_Get()->InterruptDepth != 0;
 }
\ No newline at end of file
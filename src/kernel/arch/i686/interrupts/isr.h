@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 
 
 typedef struct{
@@ -10,6 +11,8 @@ typedef struct{
 }__attribute__((packed)) Registers;
 
 typedef void (*ISRHandler)(Registers* regs);
+typedef void (*ISRExitHandler)();
 
-void i686_ISR_Initialize();
-void i686_ISR_RegisterHandler(int interrupt, ISRHandler handler);
\ No newline at end of file
+void i686_ISR_RegisterHandler(int interrupt, ISRHandler handler);
+void i686_ISR_RegisterExitHandler(ISRExitHandler handler);
+bool i686_ISR_InInterrupt();
\ No newline at end of file
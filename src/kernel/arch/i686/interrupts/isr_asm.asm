@@ -30,8 +30,7 @@ isr_common:
     mov ax, 0x10        ; use kernel data segment
     mov ds, ax
     mov es, ax
-    mov fs, ax
-    mov gs, ax
+    mov fs, ax          ; gs always holds the per-CPU segment
 
     push esp            ; pass pointer to stack to C
 
@@ -42,7 +41,6 @@ isr_common:
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
 
     popa                ; restore what we pushed
     add esp, 8          ; remove error code and interrupt number
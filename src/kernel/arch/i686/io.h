@@ -4,10 +4,35 @@
 void __attribute__((cdecl)) i686_outb(uint16_t port, uint8_t value);
 uint8_t __attribute__((cdecl)) i686_inb(uint16_t port);
 
+void __attribute__((cdecl)) i686_outw(uint16_t port, uint16_t value);
+uint16_t __attribute__((cdecl)) i686_inw(uint16_t port);
+
 void __attribute__((cdecl))  i686_outl(uint16_t port, uint32_t value);
-uint8_t __attribute__((cdecl)) i686_inl(uint16_t port);
+uint32_t __attribute__((cdecl)) i686_inl(uint16_t port);
+
+// rep insw / rep outsw, count in words
+void __attribute__((cdecl)) i686_insw(uint16_t port, void* buffer, uint32_t count);
+void __attribute__((cdecl)) i686_outsw(uint16_t port, const void* buffer, uint32_t count);
 
 void __attribute__((cdecl)) i686_cli();
 void __attribute__((cdecl)) i686_sti();
 void i686_iowait();
-void __attribute__((cdecl)) i686_panic();
\ No newline at end of file
+void __attribute__((cdecl)) i686_panic();
+
+uint64_t __attribute__((cdecl)) i686_rdtsc();
+uint64_t __attribute__((cdecl)) i686_rdmsr(uint32_t msr);
+void __attribute__((cdecl)) i686_wrmsr(uint32_t msr, uint64_t value);
+
+uint32_t __attribute__((cdecl)) i686_irqsave();
+void __attribute__((cdecl)) i686_irqrestore(uint32_t flags);
+
+void __attribute__((cdecl)) i686_pause();
+void __attribute__((cdecl)) i686_sti_hlt();
+void __attribute__((cdecl)) i686_monitor(const volatile void* address);
+void __attribute__((cdecl)) i686_sti_mwait(uint32_t hints, uint32_t extensions);
+
+uint32_t __attribute__((cdecl)) i686_read_cr0();
+void __attribute__((cdecl)) i686_write_cr0(uint32_t value);
+uint32_t __attribute__((cdecl)) i686_read_cr4();
+void __attribute__((cdecl)) i686_write_cr4(uint32_t value);
+void __attribute__((cdecl)) i686_clts();
\ No newline at end of file
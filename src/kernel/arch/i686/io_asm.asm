@@ -14,6 +14,22 @@ i686_inb:
     in al, dx
     ret
 
+global i686_outw
+i686_outw:
+    [bits 32]
+    mov dx, [esp + 4]
+    mov ax, [esp + 8]
+    out dx, ax
+    ret
+
+global i686_inw
+i686_inw:
+    [bits 32]
+    mov dx, [esp + 4]
+    xor eax, eax
+    in ax, dx
+    ret
+
 global i686_outl
 i686_outl:
     ; Stack layout (cdecl):
@@ -33,6 +49,30 @@ i686_inl:
     in eax, dx
     ret
 
+global i686_insw ; void i686_insw(uint16_t port, void* buffer, uint32_t count)
+i686_insw:
+    [bits 32]
+    push edi
+    mov dx, [esp + 8]
+    mov edi, [esp + 12]
+    mov ecx, [esp + 16]
+    cld
+    rep insw
+    pop edi
+    ret
+
+global i686_outsw ; void i686_outsw(uint16_t port, const void* buffer, uint32_t count)
+i686_outsw:
+    [bits 32]
+    push esi
+    mov dx, [esp + 8]
+    mov esi, [esp + 12]
+    mov ecx, [esp + 16]
+    cld
+    rep outsw
+    pop esi
+    ret
+
 global i686_cli ; Disable Interrupts
 i686_cli:
     cli
@@ -47,3 +87,103 @@ global i686_panic
 i686_panic:
     cli
     hlt
+
+global i686_rdtsc ; Read Time-Stamp Counter (edx:eax)
+i686_rdtsc:
+    [bits 32]
+    rdtsc
+    ret
+
+global i686_rdmsr
+i686_rdmsr:
+    [bits 32]
+    mov ecx, [esp + 4]  ; msr index
+    rdmsr               ; value → edx:eax
+    ret
+
+global i686_wrmsr
+i686_wrmsr:
+    [bits 32]
+    mov ecx, [esp + 4]  ; msr index
+    mov eax, [esp + 8]  ; value (low 32 bit)
+    mov edx, [esp + 12] ; value (high 32 bit)
+    wrmsr
+    ret
+
+global i686_irqsave ; Disable Interrupts, returns previous EFLAGS
+i686_irqsave:
+    [bits 32]
+    pushfd
+    pop eax
+    cli
+    ret
+
+global i686_irqrestore ; Restore EFLAGS saved by i686_irqsave
+i686_irqrestore:
+    [bits 32]
+    push dword [esp + 4]
+    popfd
+    ret
+
+global i686_pause ; Spin-wait hint, also backs off the other hyperthread
+i686_pause:
+    [bits 32]
+    pause
+    ret
+
+global i686_sti_hlt ; Enable Interrupts and halt until the next one
+i686_sti_hlt:
+    [bits 32]
+    sti                 ; sti only takes effect after the next instruction,
+    hlt                 ; so no interrupt can slip in before the hlt
+    ret
+
+global i686_monitor
+i686_monitor:
+    [bits 32]
+    mov eax, [esp + 4]  ; address to monitor
+    xor ecx, ecx        ; no extensions
+    xor edx, edx        ; no hints
+    monitor
+    ret
+
+global i686_sti_mwait ; Enable Interrupts and wait for a store to the monitored line
+i686_sti_mwait:
+    [bits 32]
+    mov eax, [esp + 4]  ; hints (target C-state)
+    mov ecx, [esp + 8]  ; extensions
+    sti
+    mwait
+    ret
+
+global i686_read_cr0
+i686_read_cr0:
+    [bits 32]
+    mov eax, cr0
+    ret
+
+global i686_write_cr0
+i686_write_cr0:
+    [bits 32]
+    mov eax, [esp + 4]
+    mov cr0, eax
+    ret
+
+global i686_read_cr4
+i686_read_cr4:
+    [bits 32]
+    mov eax, cr4
+    ret
+
+global i686_write_cr4
+i686_write_cr4:
+    [bits 32]
+    mov eax, [esp + 4]
+    mov cr4, eax
+    ret
+
+global i686_clts ; Clear CR0.TS
+i686_clts:
+    [bits 32]
+    clts
+    ret
@@ -0,0 +1,110 @@
+#include <arch/i686/smp/madt.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "memory.h"
+
+#define BDA_EBDA_SEGMENT            ((const uint16_t*)0x40E)
+#define BIOS_ROM_START              0xE0000
+#define BIOS_ROM_END                0x100000
+
+#define MADT_ENTRY_LOCAL_APIC       0
+#define MADT_LOCAL_APIC_ENABLED     0x01
+
+typedef struct{
+    char        Signature[8];
+    uint8_t     Checksum;
+    char        OEMID[6];
+    uint8_t     Revision;
+    uint32_t    RsdtAddress;
+} __attribute__((packed)) RSDP;
+
+typedef struct{
+    char        Signature[4];
+    uint32_t    Length;
+    uint8_t     Revision;
+    uint8_t     Checksum;
+    char        OEMID[6];
+    char        OEMTableID[8];
+    uint32_t    OEMRevision;
+    uint32_t    CreatorID;
+    uint32_t    CreatorRevision;
+} __attribute__((packed)) SDTHeader;
+
+typedef struct{
+    SDTHeader   Header;
+    uint32_t    LocalAPICAddress;
+    uint32_t    Flags;
+    uint8_t     Entries[];
+} __attribute__((packed)) MADT;
+
+typedef struct{
+    uint8_t     Type;
+    uint8_t     Length;
+    uint8_t     ProcessorId;
+    uint8_t     ApicId;
+    uint32_t    Flags;
+} __attribute__((packed)) MADTLocalAPIC;
+
+static bool i686_MADT_Checksum(const void* data, uint32_t length){
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint8_t sum = 0;
+    for(uint32_t i = 0; i < length; i++)
+        sum += bytes[i];
+    return sum == 0;
+}
+
+// The RSDP sits on a 16 byte boundary in the first KiB of the EBDA or in
+// the BIOS ROM area
+static const RSDP* i686_MADT_SearchRSDP(uint32_t start, uint32_t end){
+    for(uint32_t address = start; address < end; address += 16){
+        const RSDP* rsdp = (const RSDP*)address;
+        if(memcmp(rsdp->Signature, "RSD PTR ", 8) == 0 && i686_MADT_Checksum(rsdp, sizeof(RSDP)))
+            return rsdp;
+    }
+    return NULL;
+}
+
+static const MADT* i686_MADT_Find(){
+    uint32_t ebda = (uint32_t)*BDA_EBDA_SEGMENT << 4;
+
+    const RSDP* rsdp = NULL;
+    if(ebda != 0)
+        rsdp = i686_MADT_SearchRSDP(ebda, ebda + 1024);
+    if(rsdp == NULL)
+        rsdp = i686_MADT_SearchRSDP(BIOS_ROM_START, BIOS_ROM_END);
+    if(rsdp == NULL)
+        return NULL;
+
+    const SDTHeader* rsdt = (const SDTHeader*)rsdp->RsdtAddress;
+    if(memcmp(rsdt->Signature, "RSDT", 4) != 0 || !i686_MADT_Checksum(rsdt, rsdt->Length))
+        return NULL;
+
+    const uint32_t* tables = (const uint32_t*)(rsdt + 1);
+    uint32_t count = (rsdt->Length - sizeof(SDTHeader)) / sizeof(uint32_t);
+
+    for(uint32_t i = 0; i < count; i++){
+        const SDTHeader* table = (const SDTHeader*)tables[i];
+        if(memcmp(table->Signature, "APIC", 4) == 0 && i686_MADT_Checksum(table, table->Length))
+            return (const MADT*)table;
+    }
+    return NULL;
+}
+
+uint32_t i686_MADT_FindProcessors(uint8_t* apicIds, uint32_t max){
+    const MADT* madt = i686_MADT_Find();
+    if(madt == NULL)
+        return 0;
+
+    uint32_t count = 0;
+    const uint8_t* entry = madt->Entries;
+    const uint8_t* end = (const uint8_t*)madt + madt->Header.Length;
+
+    while(entry + 2 <= end && entry[1] >= 2 && count < max){
+        const MADTLocalAPIC* lapic = (const MADTLocalAPIC*)entry;
+        if(lapic->Type == MADT_ENTRY_LOCAL_APIC && (lapic->Flags & MADT_LOCAL_APIC_ENABLED))
+            apicIds[count++] = lapic->ApicId;
+
+        entry += lapic->Length;
+    }
+    return count;
+}
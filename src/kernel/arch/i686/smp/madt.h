@@ -0,0 +1,6 @@
+#pragma once
+#include <stdint.h>
+
+// Fills apicIds with the local APIC id of every enabled processor listed in
+// the ACPI MADT. Returns the number of processors, 0 if there is no MADT.
+uint32_t i686_MADT_FindProcessors(uint8_t* apicIds, uint32_t max);
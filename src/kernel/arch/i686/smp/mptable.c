@@ -0,0 +1,111 @@
+#include <arch/i686/smp/mptable.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "memory.h"
+
+#define BDA_EBDA_SEGMENT            ((const uint16_t*)0x40E)
+#define BDA_BASE_MEMORY_KB          ((const uint16_t*)0x413)
+#define BIOS_ROM_START              0xF0000
+#define BIOS_ROM_END                0x100000
+
+#define MP_ENTRY_PROCESSOR          0
+#define MP_ENTRY_PROCESSOR_SIZE     20
+#define MP_ENTRY_OTHER_SIZE         8
+#define MP_PROCESSOR_ENABLED        0x01
+
+typedef struct{
+    char        Signature[4];
+    uint32_t    ConfigTable;
+    uint8_t     Length;             // in 16 byte units
+    uint8_t     Revision;
+    uint8_t     Checksum;
+    uint8_t     Features[5];
+} __attribute__((packed)) MPFloatingPointer;
+
+typedef struct{
+    char        Signature[4];
+    uint16_t    Length;
+    uint8_t     Revision;
+    uint8_t     Checksum;
+    char        OEMID[8];
+    char        ProductID[12];
+    uint32_t    OEMTable;
+    uint16_t    OEMTableSize;
+    uint16_t    EntryCount;
+    uint32_t    LocalAPICAddress;
+    uint16_t    ExtendedLength;
+    uint8_t     ExtendedChecksum;
+    uint8_t     Reserved;
+} __attribute__((packed)) MPConfigTable;
+
+typedef struct{
+    uint8_t     Type;
+    uint8_t     ApicId;
+    uint8_t     ApicVersion;
+    uint8_t     Flags;
+    uint32_t    Signature;
+    uint32_t    Features;
+    uint32_t    Reserved[2];
+} __attribute__((packed)) MPProcessorEntry;
+
+static bool i686_MPTable_Checksum(const void* data, uint32_t length){
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint8_t sum = 0;
+    for(uint32_t i = 0; i < length; i++)
+        sum += bytes[i];
+    return sum == 0;
+}
+
+static const MPFloatingPointer* i686_MPTable_Search(uint32_t start, uint32_t end){
+    for(uint32_t address = start; address < end; address += 16){
+        const MPFloatingPointer* mp = (const MPFloatingPointer*)address;
+        if(memcmp(mp->Signature, "_MP_", 4) == 0 && i686_MPTable_Checksum(mp, mp->Length * 16))
+            return mp;
+    }
+    return NULL;
+}
+
+// Searched in the first KiB of the EBDA, the last KiB of base memory and the
+// BIOS ROM, in this order
+static const MPFloatingPointer* i686_MPTable_Find(){
+    uint32_t ebda = (uint32_t)*BDA_EBDA_SEGMENT << 4;
+    uint32_t baseEnd = (uint32_t)*BDA_BASE_MEMORY_KB * 1024;
+
+    const MPFloatingPointer* mp = NULL;
+    if(ebda != 0)
+        mp = i686_MPTable_Search(ebda, ebda + 1024);
+    if(mp == NULL && baseEnd >= 1024)
+        mp = i686_MPTable_Search(baseEnd - 1024, baseEnd);
+    if(mp == NULL)
+        mp = i686_MPTable_Search(BIOS_ROM_START, BIOS_ROM_END);
+    return mp;
+}
+
+uint32_t i686_MPTable_FindProcessors(uint8_t* apicIds, uint32_t max){
+    const MPFloatingPointer* mp = i686_MPTable_Find();
+
+    // a zero pointer means one of the default configurations: two CPUs
+    // with ids 0 and 1, which we do not bother supporting
+    if(mp == NULL || mp->ConfigTable == 0)
+        return 0;
+
+    const MPConfigTable* config = (const MPConfigTable*)mp->ConfigTable;
+    if(memcmp(config->Signature, "PCMP", 4) != 0 || !i686_MPTable_Checksum(config, config->Length))
+        return 0;
+
+    uint32_t count = 0;
+    const uint8_t* entry = (const uint8_t*)(config + 1);
+
+    for(uint16_t i = 0; i < config->EntryCount && count < max; i++){
+        if(entry[0] != MP_ENTRY_PROCESSOR){
+            entry += MP_ENTRY_OTHER_SIZE;
+            continue;
+        }
+
+        const MPProcessorEntry* cpu = (const MPProcessorEntry*)entry;
+        if(cpu->Flags & MP_PROCESSOR_ENABLED)
+            apicIds[count++] = cpu->ApicId;
+        entry += MP_ENTRY_PROCESSOR_SIZE;
+    }
+    return count;
+}
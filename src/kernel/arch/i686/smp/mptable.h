@@ -0,0 +1,6 @@
+#pragma once
+#include <stdint.h>
+
+// Same as i686_MADT_FindProcessors, using the older Intel MultiProcessor
+// Specification tables for machines without ACPI.
+uint32_t i686_MPTable_FindProcessors(uint8_t* apicIds, uint32_t max);
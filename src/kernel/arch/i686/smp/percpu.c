@@ -0,0 +1,25 @@
+#include <arch/i686/smp/percpu.h>
+#include <arch/i686/interrupts/gdt.h>
+#include <stddef.h>
+
+// In a section of its own: the generated GDTs (see interrupts/gdt.c) take
+// the per-CPU segment bases and limit from where the linker put it
+PerCPU g_PerCPU[CPU_MAX] __attribute__((section(".percpu")));
+
+PerCPU* i686_PerCPU_Initialize(uint32_t id, void* stackTop){
+    PerCPU* cpu = &g_PerCPU[id];
+
+    cpu->Self = cpu;
+    cpu->Id = id;
+    cpu->InterruptDepth = 0;
+    cpu->StackTop = stackTop;
+    cpu->Work = NULL;
+    cpu->WorkArg = NULL;
+
+    i686_GDT_Initialize(id, stackTop);
+    return cpu;
+}
+
+PerCPU* i686_PerCPU_GetById(uint32_t id){
+    return id < CPU_MAX ? &g_PerCPU[id] : NULL;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CPU_MAX                     8
+#define CPU_STACK_SIZE              8192
+#define CACHE_LINE_SIZE             64
+
+typedef void (*CPUWorkFunction)(void* arg);
+
+typedef struct PerCPU PerCPU;
+
+// Reached through %gs, whose segment base is the CPU's own entry.
+// Self must stay the first field, i686_PerCPU_Get reads it at %gs:0.
+struct PerCPU{
+    PerCPU*                     Self;
+    uint32_t                    Id;             // logical id, 0 = bootstrap processor
+    uint8_t                     ApicId;
+    volatile bool               Online;
+    volatile int                InterruptDepth;
+    void*                       StackTop;
+
+    // work handed over by i686_SMP_Call, run by the CPU's idle loop
+    volatile CPUWorkFunction    Work;
+    void* volatile              WorkArg;
+};
+
+// Builds and loads the GDT, TSS and per-CPU segment of the calling CPU
+PerCPU* i686_PerCPU_Initialize(uint32_t id, void* stackTop);
+PerCPU* i686_PerCPU_GetById(uint32_t id);
+
+PerCPU* __attribute__((cdecl)) i686_PerCPU_Get();
+uint32_t __attribute__((cdecl)) i686_PerCPU_GetId();
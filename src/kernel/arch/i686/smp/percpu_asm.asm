@@ -0,0 +1,13 @@
+[bits 32]
+
+; PerCPU* __attribute__((cdecl)) i686_PerCPU_Get();
+global i686_PerCPU_Get
+i686_PerCPU_Get:
+    mov eax, [gs:0]     ; PerCPU.Self
+    ret
+
+; uint32_t __attribute__((cdecl)) i686_PerCPU_GetId();
+global i686_PerCPU_GetId
+i686_PerCPU_GetId:
+    mov eax, [gs:4]     ; PerCPU.Id
+    ret
@@ -0,0 +1,170 @@
+#include <arch/i686/smp/smp.h>
+#include <arch/i686/smp/madt.h>
+#include <arch/i686/smp/mptable.h>
+#include <arch/i686/apic/lapic.h>
+#include <arch/i686/interrupts/idt.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/io.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+// Must match TRAMPOLINE_ADDRESS in trampoline_asm.asm. The STARTUP IPI takes
+// the page number, so it has to be page aligned and below 1 MiB.
+#define SMP_TRAMPOLINE_ADDRESS      0x7000
+
+#define SMP_INIT_DELAY_NS           (10 * NS_PER_MS)
+#define SMP_STARTUP_DELAY_NS        (200 * NS_PER_US)
+#define SMP_ONLINE_TIMEOUT_NS       (100 * NS_PER_MS)
+
+extern uint8_t i686_SMP_TrampolineStart;
+extern uint8_t i686_SMP_TrampolineEnd;
+extern uint8_t i686_SMP_TrampolineStack;
+extern uint8_t i686_SMP_TrampolineEntry;
+
+static uint8_t g_Stacks[CPU_MAX][CPU_STACK_SIZE] __attribute__((aligned(16)));
+static uint32_t g_CPUCount = 1;
+static volatile uint32_t g_BootingCPU;
+
+// Address of a trampoline variable in the copy the APs run
+static volatile uint32_t* i686_SMP_TrampolineVariable(uint8_t* variable){
+    return (volatile uint32_t*)(SMP_TRAMPOLINE_ADDRESS + (variable - &i686_SMP_TrampolineStart));
+}
+
+static void i686_SMP_Delay(uint64_t ns){
+    uint64_t end = Clock_NowNs() + ns;
+    while(Clock_NowNs() < end);
+}
+
+static void i686_SMP_CallHandler(Registers* regs){
+    // only wakes the CPU up, the idle loop picks the work up
+    i686_LAPIC_SendEOI();
+}
+
+static void __attribute__((noreturn)) i686_SMP_IdleLoop(PerCPU* cpu){
+    for(;;){
+        // checking and halting must not be split by the wakeup IPI
+        i686_cli();
+        CPUWorkFunction work = cpu->Work;
+        if(work == NULL){
+            i686_sti_hlt();
+            continue;
+        }
+
+        i686_sti();
+        work(cpu->WorkArg);
+        cpu->Work = NULL;
+    }
+}
+
+// First C code run by an application processor, on its own stack
+static void i686_SMP_Entry(){
+    uint32_t id = g_BootingCPU;
+    PerCPU* cpu = i686_PerCPU_Initialize(id, g_Stacks[id] + CPU_STACK_SIZE);
+
+    i686_IDT_Initialize();
+    i686_LAPIC_Initialize();
+    cpu->ApicId = i686_LAPIC_GetID();
+
+    printf("[SMP] CPU %u (APIC id %u) online\r\n", id, cpu->ApicId);
+    cpu->Online = true;
+
+    i686_SMP_IdleLoop(cpu);
+}
+
+static bool i686_SMP_StartCPU(uint32_t id, uint8_t apicId){
+    PerCPU* cpu = i686_PerCPU_GetById(id);
+    cpu->Online = false;
+
+    g_BootingCPU = id;
+    *i686_SMP_TrampolineVariable(&i686_SMP_TrampolineStack) = (uint32_t)(g_Stacks[id] + CPU_STACK_SIZE);
+
+    // INIT-SIPI-SIPI as in the MultiProcessor Specification
+    i686_LAPIC_SendIPI(apicId, LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+    i686_LAPIC_SendIPI(apicId, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL);
+    i686_SMP_Delay(SMP_INIT_DELAY_NS);
+
+    for(int i = 0; i < 2; i++){
+        i686_LAPIC_SendIPI(apicId, LAPIC_ICR_STARTUP | (SMP_TRAMPOLINE_ADDRESS >> 12));
+        i686_SMP_Delay(SMP_STARTUP_DELAY_NS);
+    }
+
+    // APs come up one at a time, they share the trampoline
+    uint64_t timeout = Clock_NowNs() + SMP_ONLINE_TIMEOUT_NS;
+    while(!cpu->Online && Clock_NowNs() < timeout);
+
+    if(!cpu->Online){
+        printf("[SMP] CPU with APIC id %u did not start!\r\n", apicId);
+        return false;
+    }
+    return true;
+}
+
+void i686_SMP_Initialize(){
+    PerCPU* bsp = i686_PerCPU_Get();
+    bsp->Online = true;
+
+    if(!i686_LAPIC_IsEnabled())
+        return;
+    bsp->ApicId = i686_LAPIC_GetID();
+
+    uint8_t apicIds[CPU_MAX];
+    const char* source = "ACPI MADT";
+    uint32_t count = i686_MADT_FindProcessors(apicIds, CPU_MAX);
+    if(count == 0){
+        source = "MP tables";
+        count = i686_MPTable_FindProcessors(apicIds, CPU_MAX);
+    }
+
+    if(count == 0){
+        printf("[SMP] No processor tables, running on the BSP only\r\n");
+        return;
+    }
+    printf("[SMP] %u processors in the %s\r\n", count, source);
+
+    i686_ISR_RegisterHandler(LAPIC_VECTOR_CALL, i686_SMP_CallHandler);
+
+    memcpy((void*)SMP_TRAMPOLINE_ADDRESS, &i686_SMP_TrampolineStart,
+           &i686_SMP_TrampolineEnd - &i686_SMP_TrampolineStart);
+    *i686_SMP_TrampolineVariable(&i686_SMP_TrampolineEntry) = (uint32_t)i686_SMP_Entry;
+
+    for(uint32_t i = 0; i < count && g_CPUCount < CPU_MAX; i++){
+        if(apicIds[i] == bsp->ApicId)
+            continue;
+
+        if(i686_SMP_StartCPU(g_CPUCount, apicIds[i]))
+            g_CPUCount++;
+    }
+
+    printf("[SMP] %u CPUs online\r\n", g_CPUCount);
+}
+
+uint32_t i686_SMP_GetCPUCount(){
+    return g_CPUCount;
+}
+
+bool i686_SMP_Call(uint32_t id, CPUWorkFunction work, void* arg){
+    PerCPU* cpu = i686_PerCPU_GetById(id);
+    if(cpu == NULL || id == 0 || !cpu->Online || cpu->Work != NULL)
+        return false;
+
+    cpu->WorkArg = arg;
+    cpu->Work = work;
+    i686_LAPIC_SendIPI(cpu->ApicId, LAPIC_ICR_FIXED | LAPIC_ICR_ASSERT | LAPIC_VECTOR_CALL);
+    return true;
+}
+
+void i686_SMP_Wait(uint32_t id){
+    PerCPU* cpu = i686_PerCPU_GetById(id);
+    while(cpu != NULL && cpu->Work != NULL);
+}
+
+bool i686_SMP_SendInterrupt(uint32_t id, uint8_t vector){
+    PerCPU* cpu = i686_PerCPU_GetById(id);
+    if(cpu == NULL || id == 0 || !cpu->Online)
+        return false;
+
+    i686_LAPIC_SendIPI(cpu->ApicId, LAPIC_ICR_FIXED | LAPIC_ICR_ASSERT | vector);
+    return true;
+}
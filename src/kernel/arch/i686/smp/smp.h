@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch/i686/smp/percpu.h>
+
+// Finds the other processors and starts them. They come up with the shared
+// IDT and their own GDT, TSS and stack, then wait for work.
+void i686_SMP_Initialize();
+uint32_t i686_SMP_GetCPUCount();
+
+// Runs work(arg) on an application processor. Only the bootstrap processor
+// hands out work; fails if the CPU is offline or still busy.
+bool i686_SMP_Call(uint32_t cpu, CPUWorkFunction work, void* arg);
+// Waits until the CPU has finished the work it was given
+void i686_SMP_Wait(uint32_t cpu);
+// Raises 'vector' on an online application processor, whose handler must
+// send the EOI
+bool i686_SMP_SendInterrupt(uint32_t cpu, uint8_t vector);
@@ -0,0 +1,72 @@
+[bits 16]
+
+; Must match SMP_TRAMPOLINE_ADDRESS in smp.c
+TRAMPOLINE_ADDRESS equ 0x7000
+
+; the code runs from the copy, so every absolute address is rebased on it
+%define TRAMPOLINE(label) (TRAMPOLINE_ADDRESS + (label) - i686_SMP_TrampolineStart)
+
+CR0_PE              equ 0x00000001
+CR0_CACHE_DISABLE   equ 0x60000000      ; CD | NW, both set after INIT
+
+;
+; Copied below 1 MiB and started by each application processor in real mode
+; through the STARTUP IPI. Switches to protected mode with a flat GDT, takes
+; the stack prepared by the BSP and calls into C.
+;
+global i686_SMP_TrampolineStart
+i686_SMP_TrampolineStart:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+
+    o32 lgdt [TRAMPOLINE(trampoline_gdt_descriptor)]
+
+    mov eax, cr0
+    and eax, ~CR0_CACHE_DISABLE
+    or eax, CR0_PE
+    mov cr0, eax
+
+    jmp dword 0x08:TRAMPOLINE(.pmode)
+
+[bits 32]
+.pmode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    mov esp, [TRAMPOLINE(i686_SMP_TrampolineStack)]
+    mov eax, [TRAMPOLINE(i686_SMP_TrampolineEntry)]
+    call eax
+
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+align 8
+trampoline_gdt:
+    dq 0                                ; NULL
+    dq 0x00CF9A000000FFFF               ; 32-bit code, flat
+    dq 0x00CF92000000FFFF               ; 32-bit data, flat
+
+trampoline_gdt_descriptor:
+    dw trampoline_gdt_descriptor - trampoline_gdt - 1
+    dd TRAMPOLINE(trampoline_gdt)
+
+; filled in by the BSP before every STARTUP IPI
+align 4
+global i686_SMP_TrampolineStack
+i686_SMP_TrampolineStack:
+    dd 0
+
+global i686_SMP_TrampolineEntry
+i686_SMP_TrampolineEntry:
+    dd 0
+
+global i686_SMP_TrampolineEnd
+i686_SMP_TrampolineEnd:
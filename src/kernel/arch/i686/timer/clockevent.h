@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch/i686/interrupts/isr.h>
+
+typedef void (*ClockEventHandler)(Registers* regs);
+
+// A one-shot interrupt source; it is only ever armed for the next timer expiry.
+typedef struct{
+    const char* Name;
+    bool (*Probe)();
+    void (*Initialize)(ClockEventHandler handler);
+    void (*SetNextEvent)(uint64_t deltaNs);
+    uint64_t (*MaxDeltaNs)();
+} ClockEventDriver;
@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <arch/i686/timer/i8254.h>
+#include <arch/i686/interrupts/irq.h>
+#include <arch/i686/io.h>
+
+#define PIT_CHANNEL0_PORT           0x40
+#define PIT_CHANNEL2_PORT           0x42
+#define PIT_COMMAND_PORT            0x43
+#define PIT_GATE_PORT               0x61
+
+#define PIT_IRQ                     0
+
+enum {
+    PIT_CMD_CHANNEL0             = 0x00,
+    PIT_CMD_CHANNEL2             = 0x80,
+    PIT_CMD_ACCESS_LOHI          = 0x30,
+    PIT_CMD_MODE_TERMINAL_COUNT  = 0x00,
+};
+
+enum {
+    PIT_GATE_CHANNEL2            = 0x01,
+    PIT_GATE_SPEAKER             = 0x02,
+    PIT_GATE_OUT2                = 0x20,
+};
+
+static ClockEventHandler g_Handler = NULL;
+
+// Busy waits 'ticks' PIT periods using channel 2, which is not wired to an IRQ.
+// Used to calibrate the TSC and the LAPIC timer.
+void i8254_PollDelay(uint16_t ticks){
+    uint8_t gate = i686_inb(PIT_GATE_PORT);
+    i686_outb(PIT_GATE_PORT, (gate & ~PIT_GATE_SPEAKER) | PIT_GATE_CHANNEL2);
+
+    i686_outb(PIT_COMMAND_PORT, PIT_CMD_CHANNEL2 | PIT_CMD_ACCESS_LOHI | PIT_CMD_MODE_TERMINAL_COUNT);
+    i686_outb(PIT_CHANNEL2_PORT, ticks & 0xFF);
+    i686_outb(PIT_CHANNEL2_PORT, ticks >> 8);
+
+    while((i686_inb(PIT_GATE_PORT) & PIT_GATE_OUT2) == 0);
+}
+
+static void i8254_IRQ(Registers* regs){
+    g_Handler(regs);
+}
+
+bool i8254_Probe(){
+    return true;
+}
+
+void i8254_Initialize(ClockEventHandler handler){
+    g_Handler = handler;
+
+    // writing the control word alone stops channel 0 until a count is loaded,
+    // which turns off the periodic tick programmed by the BIOS
+    i686_outb(PIT_COMMAND_PORT, PIT_CMD_CHANNEL0 | PIT_CMD_ACCESS_LOHI | PIT_CMD_MODE_TERMINAL_COUNT);
+
+    i686_IRQ_RegisterHandler(PIT_IRQ, i8254_IRQ);
+    i686_IRQ_Unmask(PIT_IRQ);
+}
+
+void i8254_SetNextEvent(uint64_t deltaNs){
+    uint64_t ticks = deltaNs * PIT_FREQUENCY / 1000000000ULL;
+    if(ticks == 0)
+        ticks = 1;
+    if(ticks > 0xFFFF)
+        ticks = 0xFFFF;
+
+    i686_outb(PIT_COMMAND_PORT, PIT_CMD_CHANNEL0 | PIT_CMD_ACCESS_LOHI | PIT_CMD_MODE_TERMINAL_COUNT);
+    i686_outb(PIT_CHANNEL0_PORT, ticks & 0xFF);
+    i686_outb(PIT_CHANNEL0_PORT, ticks >> 8);
+}
+
+uint64_t i8254_MaxDeltaNs(){
+    return 0xFFFFULL * 1000000000ULL / PIT_FREQUENCY;
+}
+
+static const ClockEventDriver g_PitDriver = {
+    .Name = "i8254_PIT",
+    .Probe = &i8254_Probe,
+    .Initialize = &i8254_Initialize,
+    .SetNextEvent = &i8254_SetNextEvent,
+    .MaxDeltaNs = &i8254_MaxDeltaNs
+};
+
+const ClockEventDriver* i8254_GetDriver(){
+    return &g_PitDriver;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include <arch/i686/timer/clockevent.h>
+
+#define PIT_FREQUENCY               1193182
+
+void i8254_PollDelay(uint16_t ticks);
+const ClockEventDriver* i8254_GetDriver();
@@ -0,0 +1,98 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <arch/i686/timer/lapic_timer.h>
+#include <arch/i686/timer/i8254.h>
+#include <arch/i686/apic/lapic.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/io.h>
+#include <arch/generic/cpu.h>
+#include <timer/clock.h>
+
+#define IA32_TSC_DEADLINE_MSR       0x6E0
+
+#define LAPIC_TIMER_DIVIDE_16       0x3
+#define LAPIC_CALIBRATION_MS        10
+
+static ClockEventHandler g_Handler = NULL;
+static bool g_TscDeadline = false;
+static uint32_t g_CountKhz;
+
+static void i686_LAPICTimer_Interrupt(Registers* regs){
+    // acknowledge first, the handler may arm the next event
+    i686_LAPIC_SendEOI();
+    g_Handler(regs);
+}
+
+// Measures how many LAPIC timer counts elapse per millisecond at divide-by-16
+static uint32_t i686_LAPICTimer_Calibrate(){
+    i686_LAPIC_Write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    i686_LAPIC_Write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    i686_LAPIC_Write(LAPIC_REG_TIMER_INITIAL, 0xFFFFFFFF);
+
+    i8254_PollDelay(PIT_FREQUENCY / 1000 * LAPIC_CALIBRATION_MS);
+
+    uint32_t elapsed = 0xFFFFFFFF - i686_LAPIC_Read(LAPIC_REG_TIMER_CURRENT);
+    i686_LAPIC_Write(LAPIC_REG_TIMER_INITIAL, 0);
+    return elapsed / LAPIC_CALIBRATION_MS;
+}
+
+bool i686_LAPICTimer_Probe(){
+    return i686_LAPIC_IsEnabled();
+}
+
+void i686_LAPICTimer_Initialize(ClockEventHandler handler){
+    g_Handler = handler;
+
+    unsigned int eax, ebx, ecx, edx;
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+
+    // CPUID.1:ECX[24] advertises TSC-deadline mode
+    g_TscDeadline = (ecx & CPUID_FEAT_ECX_TSC) && Clock_GetTscKhz() != 0;
+    if(!g_TscDeadline)
+        g_CountKhz = i686_LAPICTimer_Calibrate();
+
+    i686_ISR_RegisterHandler(LAPIC_VECTOR_TIMER, i686_LAPICTimer_Interrupt);
+
+    if(g_TscDeadline){
+        i686_LAPIC_Write(LAPIC_REG_LVT_TIMER, LAPIC_VECTOR_TIMER | LAPIC_LVT_TIMER_TSCDEADLINE);
+    } else {
+        i686_LAPIC_Write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+        i686_LAPIC_Write(LAPIC_REG_LVT_TIMER, LAPIC_VECTOR_TIMER | LAPIC_LVT_TIMER_ONESHOT);
+    }
+}
+
+void i686_LAPICTimer_SetNextEvent(uint64_t deltaNs){
+    if(g_TscDeadline){
+        i686_wrmsr(IA32_TSC_DEADLINE_MSR, i686_rdtsc() + Clock_NsToCycles(deltaNs));
+        return;
+    }
+
+    uint64_t count = deltaNs * g_CountKhz / NS_PER_MS;
+    if(count == 0)
+        count = 1;
+    if(count > 0xFFFFFFFF)
+        count = 0xFFFFFFFF;
+
+    i686_LAPIC_Write(LAPIC_REG_TIMER_INITIAL, (uint32_t)count);
+}
+
+uint64_t i686_LAPICTimer_MaxDeltaNs(){
+    if(g_TscDeadline)
+        return 10 * NS_PER_SEC;
+
+    return 0xFFFFFFFFULL * NS_PER_MS / g_CountKhz;
+}
+
+static const ClockEventDriver g_LAPICTimerDriver = {
+    .Name = "LAPIC_Timer",
+    .Probe = &i686_LAPICTimer_Probe,
+    .Initialize = &i686_LAPICTimer_Initialize,
+    .SetNextEvent = &i686_LAPICTimer_SetNextEvent,
+    .MaxDeltaNs = &i686_LAPICTimer_MaxDeltaNs
+};
+
+const ClockEventDriver* i686_LAPICTimer_GetDriver(){
+    return &g_LAPICTimerDriver;
+}
@@ -0,0 +1,4 @@
+#pragma once
+#include <arch/i686/timer/clockevent.h>
+
+const ClockEventDriver* i686_LAPICTimer_GetDriver();
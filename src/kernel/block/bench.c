@@ -0,0 +1,172 @@
+#include "block.h"
+#include "buffer_cache.h"
+#include "readahead.h"
+#include <fs/vfs.h>
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define BENCH_BLOCK_SIZE            4096
+#define BENCH_REQUESTS              64          // in flight at once
+#define BENCH_SEQUENTIAL_ROUNDS     16
+#define BENCH_RANDOM_ROUNDS         16
+#define BENCH_CACHE_BYTES           (1024 * 1024)
+
+static BlockRequest g_Requests[BENCH_REQUESTS];
+static uint8_t g_Buffers[BENCH_REQUESTS][BENCH_BLOCK_SIZE] __attribute__((aligned(4096)));
+static volatile uint32_t g_Remaining;
+static volatile uint32_t g_Failed;
+static Completion g_Done;
+
+static uint32_t Bench_Random(uint32_t* state){
+    *state = *state * 1664525 + 1013904223;
+    return *state;
+}
+
+static void Bench_Complete(BlockRequest* request){
+    if(!request->Success)
+        g_Failed++;
+    if(--g_Remaining == 0)
+        Completion_Signal(&g_Done);
+}
+
+// Submits a round of 4 KiB reads under a plug, so adjacent ones can merge
+// before the driver sees them, and waits for all of them
+static bool Bench_Round(BlockDevice* device, uint64_t* lbas){
+    uint32_t sectors = BENCH_BLOCK_SIZE / BLOCK_SECTOR_SIZE;
+
+    Completion_Initialize(&g_Done);
+    g_Remaining = BENCH_REQUESTS;
+
+    Block_Plug(device);
+    for(uint32_t i = 0; i < BENCH_REQUESTS; i++){
+        BlockRequest* request = &g_Requests[i];
+        request->Lba = lbas[i];
+        request->Count = sectors;
+        request->Write = false;
+        // buffers follow the disk layout, so merged neighbours fuse into
+        // one segment; random reads may share one, the data is not used
+        request->Segments[0].Buffer = g_Buffers[(lbas[i] / sectors) % BENCH_REQUESTS];
+        request->Segments[0].Length = BENCH_BLOCK_SIZE;
+        request->SegmentCount = 1;
+        request->Callback = Bench_Complete;
+
+        if(!Block_Submit(device, request)){
+            g_Remaining -= BENCH_REQUESTS - i;
+            g_Failed++;
+            break;
+        }
+    }
+    Block_Unplug(device);
+
+    if(g_Remaining != 0)
+        Completion_Wait(&g_Done, 0);
+    return g_Failed == 0;
+}
+
+static void Bench_Run(BlockDevice* device, const char* name, bool sequential, uint32_t rounds){
+    uint32_t sectors = BENCH_BLOCK_SIZE / BLOCK_SECTOR_SIZE;
+    uint64_t blocks = device->SectorCount / sectors;
+    uint64_t lbas[BENCH_REQUESTS];
+    uint32_t seed = 12345;
+    uint64_t next = 0;
+
+    BlockStats before, after;
+    Block_GetStats(device, &before);
+    g_Failed = 0;
+
+    uint64_t start = Clock_NowNs();
+    for(uint32_t round = 0; round < rounds; round++){
+        // sequential rounds are submitted back to front so they merge at
+        // the front as well as at the back
+        for(uint32_t i = 0; i < BENCH_REQUESTS; i++){
+            if(sequential)
+                lbas[i] = ((next + (i % 2 ? BENCH_REQUESTS - 1 - i / 2 : i / 2)) % blocks) * sectors;
+            else
+                lbas[i] = (Bench_Random(&seed) % blocks) * sectors;
+        }
+        next += BENCH_REQUESTS;
+
+        if(!Bench_Round(device, lbas)){
+            printf("[BENCH] block %s: %u errors\r\n", name, g_Failed);
+            return;
+        }
+    }
+    uint64_t ns = Clock_NowNs() - start;
+    Block_GetStats(device, &after);
+
+    uint64_t requests = after.Completed - before.Completed;
+    printf("[BENCH] block %s: %llu IOPS, %llu requests in %llu commands, merges back=%llu front=%llu\r\n",
+           name, ns ? requests * NS_PER_SEC / ns : 0, requests,
+           after.Commands - before.Commands,
+           after.BackMerges - before.BackMerges,
+           after.FrontMerges - before.FrontMerges);
+}
+
+void Block_RunBenchmarks(){
+    BlockDevice* device = NULL;
+    for(uint32_t i = 0; i < Block_GetDeviceCount() && device == NULL; i++){
+        if(Block_GetDevice(i)->Parent == NULL)
+            device = Block_GetDevice(i);
+    }
+    if(device == NULL){
+        printf("[BENCH] block: no disk\r\n");
+        return;
+    }
+
+    Block_SetElevator(device, "noop");
+    Bench_Run(device, "noop sequential", true, BENCH_SEQUENTIAL_ROUNDS);
+    Bench_Run(device, "noop random", false, BENCH_RANDOM_ROUNDS);
+
+    Block_SetElevator(device, "deadline");
+    Bench_Run(device, "deadline sequential", true, BENCH_SEQUENTIAL_ROUNDS);
+    Bench_Run(device, "deadline random", false, BENCH_RANDOM_ROUNDS);
+    Block_SetElevator(device, "noop");
+
+    Block_PrintStats(device);
+}
+
+// Sector sized reads like a filesystem walking its metadata, once cold
+// and once more from the cache
+static uint64_t Bench_CachePass(BlockDevice* device, uint32_t sectors){
+    uint8_t sector[BLOCK_SECTOR_SIZE];
+
+    uint64_t start = Clock_NowNs();
+    for(uint32_t lba = 0; lba < sectors; lba++){
+        if(!BufferCache_ReadSectors(device, lba, 1, sector))
+            return 0;
+    }
+    return Clock_NowNs() - start;
+}
+
+void BufferCache_RunBenchmarks(){
+    BlockDevice* device = Block_GetDevice(0);
+    if(device == NULL){
+        printf("[BENCH] bcache: no disk\r\n");
+        return;
+    }
+
+    uint32_t sectors = BENCH_CACHE_BYTES / BLOCK_SECTOR_SIZE;
+    if(sectors > device->SectorCount)
+        sectors = device->SectorCount;
+
+    uint64_t cold = Bench_CachePass(device, sectors);
+    uint64_t warm = Bench_CachePass(device, sectors);
+    printf("[BENCH] bcache %s: %u sector reads, cold %lluus, warm %lluus\r\n",
+           device->Name, sectors, cold / NS_PER_US, warm / NS_PER_US);
+
+    BufferCache_PrintStats();
+}
+
+void Readahead_RunBenchmarks(){
+    VfsStat stat;
+    if(VFS_Stat("/", &stat) != VFS_OK){
+        printf("[BENCH] readahead: nothing mounted\r\n");
+        return;
+    }
+
+    VFS_RunStreamBenchmark();
+    BufferCache_PrintStats();
+}
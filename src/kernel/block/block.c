@@ -0,0 +1,571 @@
+#include "block.h"
+#include "elevator.h"
+#include "mbr.h"
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <sched/scheduler.h>
+#include <timer/clock.h>
+#include <util/trace.h>
+#include <stddef.h>
+#include "stdio.h"
+
+static BlockDevice g_Devices[BLOCK_MAX_DEVICES];
+static uint32_t g_DeviceCount = 0;
+
+// Commands come from one pool shared by all queues
+static BlockCommand g_Commands[BLOCK_MAX_COMMANDS];
+static BlockCommand* g_FreeCommands = NULL;
+static bool g_PoolReady = false;
+static Spinlock g_PoolLock;
+
+static BlockDevice* Block_GetDisk(BlockDevice* device){
+    return device->Parent != NULL ? device->Parent : device;
+}
+
+static void Block_CopyName(char* name, const char* source){
+    int i;
+    for(i = 0; i < BLOCK_NAME_SIZE - 1 && source[i]; i++)
+        name[i] = source[i];
+    name[i] = '\0';
+}
+
+static bool Block_NameEquals(const char* a, const char* b){
+    while(*a && *a == *b){
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+//
+// Command pool
+//
+
+static void Block_InitializePool(){
+    Spinlock_Initialize(&g_PoolLock, "block pool");
+    for(int i = BLOCK_MAX_COMMANDS - 1; i >= 0; i--){
+        g_Commands[i].QueueNext = g_FreeCommands;
+        g_FreeCommands = &g_Commands[i];
+    }
+    g_PoolReady = true;
+}
+
+// Called with the queue locked, so interrupts are already off
+static BlockCommand* Block_AllocateCommand(){
+    Spinlock_Acquire(&g_PoolLock);
+    BlockCommand* command = g_FreeCommands;
+    if(command != NULL)
+        g_FreeCommands = command->QueueNext;
+    Spinlock_Release(&g_PoolLock);
+    return command;
+}
+
+static void Block_FreeCommand(BlockCommand* command){
+    Spinlock_Acquire(&g_PoolLock);
+    command->QueueNext = g_FreeCommands;
+    g_FreeCommands = command;
+    Spinlock_Release(&g_PoolLock);
+}
+
+//
+// Registration
+//
+
+static BlockDevice* Block_AllocateDevice(const char* name){
+    if(g_DeviceCount == BLOCK_MAX_DEVICES){
+        printf("[BLOCK] too many devices, %s ignored\r\n", name);
+        return NULL;
+    }
+    if(!g_PoolReady)
+        Block_InitializePool();
+
+    BlockDevice* device = &g_Devices[g_DeviceCount++];
+    Block_CopyName(device->Name, name);
+    return device;
+}
+
+BlockDevice* Block_RegisterDisk(const char* name, uint64_t sectorCount, uint32_t queueDepth,
+                                const BlockDriver* driver, void* driverData){
+    BlockDevice* disk = Block_AllocateDevice(name);
+    if(disk == NULL)
+        return NULL;
+
+    disk->SectorCount = sectorCount;
+    disk->QueueDepth = queueDepth ? queueDepth : 1;
+    disk->Driver = driver;
+    disk->DriverData = driverData;
+    disk->Parent = NULL;
+    disk->Offset = 0;
+    disk->PartitionType = 0;
+
+    BlockQueue* queue = &disk->Queue;
+    Spinlock_Initialize(&queue->Lock, "block queue");
+    queue->Elevator = Elevator_GetNoop();
+    queue->Elevator->Initialize(queue);
+    queue->Pending = NULL;
+    queue->Requeue = NULL;
+    queue->Queued = 0;
+    queue->InFlight = 0;
+    queue->Plugged = 0;
+    queue->Running = false;
+    queue->RunAgain = false;
+
+    printf("[BLOCK] %s: %llu sectors (%llu MiB), %s, queue depth %u\r\n",
+           disk->Name, sectorCount, sectorCount * BLOCK_SECTOR_SIZE / (1024 * 1024),
+           driver->Name, disk->QueueDepth);
+
+    MBR_ScanPartitions(disk);
+    return disk;
+}
+
+BlockDevice* Block_RegisterPartition(BlockDevice* disk, uint8_t index, uint64_t offset,
+                                     uint64_t sectorCount, uint8_t type){
+    char name[BLOCK_NAME_SIZE];
+    int length;
+    for(length = 0; length < BLOCK_NAME_SIZE - 2 && disk->Name[length]; length++)
+        name[length] = disk->Name[length];
+    name[length++] = '0' + index;
+    name[length] = '\0';
+
+    if(offset >= disk->SectorCount || sectorCount > disk->SectorCount - offset){
+        printf("[BLOCK] %s: partition outside the disk\r\n", name);
+        return NULL;
+    }
+
+    BlockDevice* partition = Block_AllocateDevice(name);
+    if(partition == NULL)
+        return NULL;
+
+    partition->SectorCount = sectorCount;
+    partition->QueueDepth = disk->QueueDepth;
+    partition->Driver = disk->Driver;
+    partition->DriverData = disk->DriverData;
+    partition->Parent = disk;
+    partition->Offset = offset;
+    partition->PartitionType = type;
+
+    printf("[BLOCK] %s: type 0x%x, start %llu, %llu sectors\r\n", partition->Name, type, offset, sectorCount);
+    return partition;
+}
+
+uint32_t Block_GetDeviceCount(){
+    return g_DeviceCount;
+}
+
+BlockDevice* Block_GetDevice(uint32_t index){
+    return index < g_DeviceCount ? &g_Devices[index] : NULL;
+}
+
+BlockDevice* Block_Find(const char* name){
+    for(uint32_t i = 0; i < g_DeviceCount; i++){
+        if(Block_NameEquals(g_Devices[i].Name, name))
+            return &g_Devices[i];
+    }
+    return NULL;
+}
+
+bool Block_SetElevator(BlockDevice* device, const char* name){
+    const BlockElevator* elevators[] = { Elevator_GetNoop(), Elevator_GetDeadline() };
+    BlockDevice* disk = Block_GetDisk(device);
+    BlockQueue* queue = &disk->Queue;
+
+    for(int i = 0; i < 2; i++){
+        if(!Block_NameEquals(elevators[i]->Name, name))
+            continue;
+
+        // only switch between requests, the old elevator owns the queued ones
+        uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+        bool idle = queue->Queued == 0;
+        if(idle){
+            queue->Elevator = elevators[i];
+            queue->Elevator->Initialize(queue);
+        }
+        Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+        return idle;
+    }
+    return false;
+}
+
+//
+// Submission
+//
+
+static bool Block_ValidateRequest(BlockDevice* device, BlockRequest* request){
+    const BlockDriver* driver = Block_GetDisk(device)->Driver;
+
+    if(request->Count == 0 || request->Count > driver->MaxSectors)
+        return false;
+    if(request->Lba >= device->SectorCount || request->Count > device->SectorCount - request->Lba)
+        return false;
+    if(request->SegmentCount == 0 || request->SegmentCount > driver->MaxSegments)
+        return false;
+
+    uint32_t bytes = 0;
+    for(int i = 0; i < request->SegmentCount; i++){
+        if(request->Segments[i].Length == 0 || ((uint32_t)request->Segments[i].Buffer & 1))
+            return false;
+        bytes += request->Segments[i].Length;
+    }
+    return bytes == request->Count * BLOCK_SECTOR_SIZE;
+}
+
+static bool Block_Contiguous(const BlockSegment* first, const BlockSegment* second){
+    return (uint8_t*)first->Buffer + first->Length == (uint8_t*)second->Buffer;
+}
+
+// Joins two segment lists, fusing the seam when the buffers touch. Fails
+// if the result does not fit the driver.
+static bool Block_JoinSegments(BlockSegment* out, uint8_t* outCount, uint32_t max,
+                               const BlockSegment* first, uint8_t firstCount,
+                               const BlockSegment* second, uint8_t secondCount){
+    bool fuse = Block_Contiguous(&first[firstCount - 1], &second[0]);
+    uint32_t count = firstCount + secondCount - (fuse ? 1 : 0);
+    if(count > max)
+        return false;
+
+    BlockSegment joined[BLOCK_MAX_SEGMENTS];
+    uint32_t index = 0;
+    for(int i = 0; i < firstCount; i++)
+        joined[index++] = first[i];
+    if(fuse)
+        joined[index - 1].Length += second[0].Length;
+    for(int i = fuse ? 1 : 0; i < secondCount; i++)
+        joined[index++] = second[i];
+
+    for(uint32_t i = 0; i < count; i++)
+        out[i] = joined[i];
+    *outCount = count;
+    return true;
+}
+
+// Looks for a queued command the request extends at either end
+static bool Block_TryMerge(BlockDevice* disk, BlockRequest* request, uint64_t lba){
+    BlockQueue* queue = &disk->Queue;
+    const BlockDriver* driver = disk->Driver;
+
+    for(BlockCommand* command = queue->Pending; command != NULL; command = command->QueueNext){
+        if(command->Write != request->Write || command->Count + request->Count > driver->MaxSectors)
+            continue;
+
+        if(command->Lba + command->Count == lba){
+            if(!Block_JoinSegments(command->Segments, &command->SegmentCount, driver->MaxSegments,
+                                   command->Segments, command->SegmentCount,
+                                   request->Segments, request->SegmentCount))
+                continue;
+
+            command->Count += request->Count;
+            command->Last->Next = request;
+            command->Last = request;
+            queue->Stats.BackMerges++;
+            queue->Elevator->Merged(queue, command, false);
+            return true;
+        }
+
+        if(lba + request->Count == command->Lba){
+            if(!Block_JoinSegments(command->Segments, &command->SegmentCount, driver->MaxSegments,
+                                   request->Segments, request->SegmentCount,
+                                   command->Segments, command->SegmentCount))
+                continue;
+
+            command->Lba = lba;
+            command->Count += request->Count;
+            request->Next = command->First;
+            command->First = request;
+            queue->Stats.FrontMerges++;
+            queue->Elevator->Merged(queue, command, true);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Hands commands to the driver while it has room. One call at a time
+// dispatches for a disk: a call meanwhile, such as a driver completing
+// from inside Submit or an interrupt on another CPU, only makes the running
+// one look at the queue again. Synchronous drivers thus complete a whole
+// queue in this loop instead of recursing once per command.
+static void Block_Run(BlockDevice* disk){
+    BlockQueue* queue = &disk->Queue;
+    bool submitted = false;
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+    if(queue->Running){
+        queue->RunAgain = true;
+        Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+        return;
+    }
+    queue->Running = true;
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+
+    for(;;){
+        flags = Spinlock_AcquireIrqSave(&queue->Lock);
+        queue->RunAgain = false;
+        if(queue->Plugged || queue->InFlight >= disk->QueueDepth){
+            queue->Running = false;
+            Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+            break;
+        }
+
+        BlockCommand* command = queue->Requeue;
+        if(command != NULL){
+            queue->Requeue = command->QueueNext;
+        } else {
+            command = queue->Elevator->Next(queue);
+            if(command == NULL){
+                queue->Running = false;
+                Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+                break;
+            }
+
+            if(command->QueuePrev != NULL)
+                command->QueuePrev->QueueNext = command->QueueNext;
+            else
+                queue->Pending = command->QueueNext;
+            if(command->QueueNext != NULL)
+                command->QueueNext->QueuePrev = command->QueuePrev;
+            queue->Queued--;
+        }
+
+        queue->InFlight++;
+        queue->Stats.Commands++;
+        queue->Stats.QueueDepth = queue->InFlight;
+        if(queue->InFlight > queue->Stats.MaxQueueDepth)
+            queue->Stats.MaxQueueDepth = queue->InFlight;
+        Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+
+        // the driver may complete from its interrupt before this returns,
+        // so it is called without the queue lock
+        if(!disk->Driver->Submit(disk, command)){
+            flags = Spinlock_AcquireIrqSave(&queue->Lock);
+            command->QueueNext = queue->Requeue;
+            queue->Requeue = command;
+            queue->InFlight--;
+            queue->Stats.Commands--;
+            queue->Stats.QueueDepth = queue->InFlight;
+
+            // a completion while the driver refused may have made room
+            bool again = queue->RunAgain;
+            if(!again)
+                queue->Running = false;
+            Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+            if(again)
+                continue;
+            break;
+        }
+        submitted = true;
+    }
+
+    if(submitted && disk->Driver->Kick != NULL)
+        disk->Driver->Kick(disk);
+}
+
+bool Block_Submit(BlockDevice* device, BlockRequest* request){
+    if(!Block_ValidateRequest(device, request))
+        return false;
+
+    BlockDevice* disk = Block_GetDisk(device);
+    BlockQueue* queue = &disk->Queue;
+    uint64_t lba = request->Lba + device->Offset;
+
+    request->Next = NULL;
+    request->Success = false;
+    request->SubmitNs = Clock_NowNs();
+    TRACE(TRACE_BLOCK_SUBMIT, request, request->Count);
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+
+    if(!Block_TryMerge(disk, request, lba)){
+        BlockCommand* command = Block_AllocateCommand();
+        if(command == NULL){
+            Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+            return false;
+        }
+
+        command->Device = disk;
+        command->Lba = lba;
+        command->Count = request->Count;
+        command->Write = request->Write;
+        command->SegmentCount = request->SegmentCount;
+        for(int i = 0; i < request->SegmentCount; i++)
+            command->Segments[i] = request->Segments[i];
+        command->First = request;
+        command->Last = request;
+        command->DriverData = NULL;
+
+        command->QueuePrev = NULL;
+        command->QueueNext = queue->Pending;
+        if(queue->Pending != NULL)
+            queue->Pending->QueuePrev = command;
+        queue->Pending = command;
+
+        queue->Elevator->Add(queue, command);
+        queue->Queued++;
+        if(queue->Queued > queue->Stats.MaxQueued)
+            queue->Stats.MaxQueued = queue->Queued;
+    }
+
+    queue->Stats.Requests++;
+    if(queue->Stats.FirstNs == 0)
+        queue->Stats.FirstNs = request->SubmitNs;
+    bool plugged = queue->Plugged != 0;
+
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+
+    if(!plugged)
+        Block_Run(disk);
+    return true;
+}
+
+void Block_Plug(BlockDevice* device){
+    BlockQueue* queue = &Block_GetDisk(device)->Queue;
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+    queue->Plugged++;
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+}
+
+void Block_Unplug(BlockDevice* device){
+    BlockDevice* disk = Block_GetDisk(device);
+    BlockQueue* queue = &disk->Queue;
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+    if(queue->Plugged > 0)
+        queue->Plugged--;
+    bool run = queue->Plugged == 0;
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+
+    if(run)
+        Block_Run(disk);
+}
+
+void Block_Complete(BlockCommand* command, bool success){
+    BlockDevice* disk = command->Device;
+    BlockQueue* queue = &disk->Queue;
+    BlockRequest* request = command->First;
+    uint64_t now = Clock_NowNs();
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+    queue->InFlight--;
+    queue->Stats.QueueDepth = queue->InFlight;
+    queue->Stats.Sectors += command->Count;
+    queue->Stats.LastNs = now;
+    if(!success)
+        queue->Stats.Errors++;
+
+    for(BlockRequest* r = request; r != NULL; r = r->Next){
+        uint64_t latency = now - r->SubmitNs;
+        queue->Stats.Completed++;
+        queue->Stats.LatencyTotalNs += latency;
+        if(latency > queue->Stats.LatencyMaxNs)
+            queue->Stats.LatencyMaxNs = latency;
+    }
+    Block_FreeCommand(command);
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+
+    // the callback may resubmit the request, so fetch the link first
+    while(request != NULL){
+        BlockRequest* next = request->Next;
+        TRACE(TRACE_BLOCK_COMPLETE, request, success);
+        request->Success = success;
+        if(request->Callback != NULL)
+            request->Callback(request);
+        request = next;
+    }
+
+    Block_Run(disk);
+}
+
+//
+// Synchronous wrappers
+//
+
+static void Block_CompleteSync(BlockRequest* request){
+    Completion_Signal((Completion*)request->Context);
+}
+
+static bool Block_Transfer(BlockDevice* device, uint64_t lba, uint32_t count, void* buffer, bool write){
+    uint32_t maxSectors = Block_GetDisk(device)->Driver->MaxSectors;
+    uint8_t* data = (uint8_t*)buffer;
+    Completion done;
+    BlockRequest request;
+
+    while(count > 0){
+        uint32_t chunk = count > maxSectors ? maxSectors : count;
+
+        request.Lba = lba;
+        request.Count = chunk;
+        request.Write = write;
+        request.Segments[0].Buffer = data;
+        request.Segments[0].Length = chunk * BLOCK_SECTOR_SIZE;
+        request.SegmentCount = 1;
+        request.Callback = Block_CompleteSync;
+        request.Context = &done;
+
+        if(!Block_ValidateRequest(device, &request))
+            return false;
+
+        Completion_Initialize(&done);
+        while(!Block_Submit(device, &request))
+            Scheduler_Yield();
+
+        Completion_Wait(&done, 0);
+        if(!request.Success)
+            return false;
+
+        lba += chunk;
+        count -= chunk;
+        data += chunk * BLOCK_SECTOR_SIZE;
+    }
+    return true;
+}
+
+bool Block_Read(BlockDevice* device, uint64_t lba, uint32_t count, void* buffer){
+    return Block_Transfer(device, lba, count, buffer, false);
+}
+
+bool Block_Write(BlockDevice* device, uint64_t lba, uint32_t count, const void* buffer){
+    return Block_Transfer(device, lba, count, (void*)buffer, true);
+}
+
+//
+// Statistics
+//
+
+void Block_GetStats(BlockDevice* device, BlockStats* stats){
+    BlockQueue* queue = &Block_GetDisk(device)->Queue;
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+    *stats = queue->Stats;
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+}
+
+void Block_PrintStats(BlockDevice* device){
+    BlockDevice* disk = Block_GetDisk(device);
+    BlockStats stats;
+    Block_GetStats(disk, &stats);
+
+    uint64_t elapsed = stats.LastNs > stats.FirstNs ? stats.LastNs - stats.FirstNs : 0;
+
+    printf("===== BLOCK STATS %s (%s) =====\r\n", disk->Name, disk->Queue.Elevator->Name);
+    printf("requests=%llu completed=%llu commands=%llu sectors=%llu errors=%llu\r\n",
+           stats.Requests, stats.Completed, stats.Commands, stats.Sectors, stats.Errors);
+    printf("merges: back=%llu front=%llu\r\n", stats.BackMerges, stats.FrontMerges);
+    printf("queue depth=%u max=%u, max queued=%u\r\n", stats.QueueDepth, stats.MaxQueueDepth, stats.MaxQueued);
+    printf("iops=%llu latency avg=%lluus max=%lluus\r\n",
+           elapsed ? stats.Completed * NS_PER_SEC / elapsed : 0,
+           stats.Completed ? stats.LatencyTotalNs / stats.Completed / NS_PER_US : 0,
+           stats.LatencyMaxNs / NS_PER_US);
+    printf("=================================\r\n");
+}
+
+void Block_PrintDevices(){
+    for(uint32_t i = 0; i < g_DeviceCount; i++){
+        BlockDevice* device = &g_Devices[i];
+        if(device->Parent != NULL)
+            printf("[BLOCK] %s: %llu MiB on %s at %llu\r\n", device->Name,
+                   device->SectorCount * BLOCK_SECTOR_SIZE / (1024 * 1024),
+                   device->Parent->Name, device->Offset);
+        else
+            printf("[BLOCK] %s: %llu MiB, %s, %s\r\n", device->Name,
+                   device->SectorCount * BLOCK_SECTOR_SIZE / (1024 * 1024),
+                   device->Driver->Name, device->Queue.Elevator->Name);
+    }
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <util/spinlock.h>
+
+#define BLOCK_SECTOR_SIZE           512
+#define BLOCK_MAX_DEVICES           16
+#define BLOCK_MAX_SEGMENTS          8
+#define BLOCK_MAX_COMMANDS          128
+#define BLOCK_NAME_SIZE             8
+
+typedef struct BlockDevice BlockDevice;
+typedef struct BlockRequest BlockRequest;
+typedef struct BlockCommand BlockCommand;
+typedef struct BlockElevator BlockElevator;
+
+// Runs once the request is done, possibly from an interrupt handler
+typedef void (*BlockCallback)(BlockRequest* request);
+
+typedef struct{
+    void*       Buffer;                 // 2 byte aligned
+    uint32_t    Length;                 // bytes, multiple of the sector size
+} BlockSegment;
+
+// What filesystems submit. Adjacent requests are merged into one command
+// before they reach the driver.
+struct BlockRequest{
+    uint64_t        Lba;                // relative to the device, partitions included
+    uint32_t        Count;              // sectors, must match the segments
+    bool            Write;
+    BlockSegment    Segments[BLOCK_MAX_SEGMENTS];
+    uint8_t         SegmentCount;
+    BlockCallback   Callback;
+    void*           Context;
+
+    // set on completion
+    bool            Success;
+
+    // owned by the block layer while in flight
+    BlockRequest*   Next;
+    uint64_t        SubmitNs;
+};
+
+// What drivers execute: one or more merged requests, on the whole disk
+struct BlockCommand{
+    BlockDevice*    Device;
+    uint64_t        Lba;
+    uint32_t        Count;
+    bool            Write;
+    BlockSegment    Segments[BLOCK_MAX_SEGMENTS];
+    uint8_t         SegmentCount;
+    BlockRequest*   First;              // merged requests, in LBA order
+    BlockRequest*   Last;
+    uint64_t        Deadline;           // ns, for the deadline elevator
+    void*           DriverData;
+
+    // queue and elevator links
+    BlockCommand*   QueueNext;
+    BlockCommand*   QueuePrev;
+    BlockCommand*   SortNext;
+    BlockCommand*   SortPrev;
+    BlockCommand*   FifoNext;
+    BlockCommand*   FifoPrev;
+};
+
+typedef struct{
+    const char*     Name;
+    // Starts the command and returns at once; the driver reports the end
+    // with Block_Complete. False if the device is busy, the command is
+    // then retried after the next completion.
+    bool            (*Submit)(BlockDevice* device, BlockCommand* command);
+    // Optional, called after a round of submissions so batching drivers
+    // can notify the device once
+    void            (*Kick)(BlockDevice* device);
+    uint32_t        MaxSectors;         // per command
+    uint32_t        MaxSegments;
+} BlockDriver;
+
+typedef struct{
+    uint64_t Requests;                  // submitted by users
+    uint64_t Completed;
+    uint64_t Commands;                  // issued to the driver
+    uint64_t BackMerges;
+    uint64_t FrontMerges;
+    uint64_t Sectors;
+    uint64_t Errors;
+    uint64_t LatencyTotalNs;            // submission to completion
+    uint64_t LatencyMaxNs;
+    uint64_t FirstNs;                   // first submission and last completion,
+    uint64_t LastNs;                    // for the IOPS figure
+    uint32_t QueueDepth;                // commands in the driver right now
+    uint32_t MaxQueueDepth;
+    uint32_t MaxQueued;                 // commands waiting in the elevator
+} BlockStats;
+
+// Elevator state; each elevator uses the fields it needs
+typedef struct{
+    BlockCommand*   SortHead;
+    BlockCommand*   FifoHead[2];        // reads, writes
+    BlockCommand*   FifoTail[2];
+    uint64_t        Position;           // LBA after the last dispatched command
+    uint32_t        Batch;
+    uint32_t        WritesStarved;
+} BlockElevatorData;
+
+typedef struct{
+    Spinlock                Lock;
+    const BlockElevator*    Elevator;
+    BlockElevatorData       ElevatorData;
+    BlockCommand*           Pending;    // waiting in the elevator, merge candidates
+    BlockCommand*           Requeue;    // refused by the driver, goes first
+    uint32_t                Queued;
+    uint32_t                InFlight;
+    uint32_t                Plugged;
+    bool                    Running;    // a Block_Run is dispatching
+    bool                    RunAgain;   // and has to look at the queue again
+    BlockStats              Stats;
+} BlockQueue;
+
+struct BlockDevice{
+    char                Name[BLOCK_NAME_SIZE];
+    uint64_t            SectorCount;
+    uint32_t            QueueDepth;     // commands the driver takes at once
+    const BlockDriver*  Driver;
+    void*               DriverData;
+
+    // partitions forward to the queue of the disk
+    BlockDevice*        Parent;
+    uint64_t            Offset;
+    uint8_t             PartitionType;
+
+    BlockQueue          Queue;
+};
+
+// Adds a whole disk with the noop elevator and registers its partitions.
+// Reads the partition table, so it must be called from a thread.
+BlockDevice* Block_RegisterDisk(const char* name, uint64_t sectorCount, uint32_t queueDepth,
+                                const BlockDriver* driver, void* driverData);
+BlockDevice* Block_RegisterPartition(BlockDevice* disk, uint8_t index, uint64_t offset,
+                                     uint64_t sectorCount, uint8_t type);
+
+uint32_t Block_GetDeviceCount();
+BlockDevice* Block_GetDevice(uint32_t index);
+BlockDevice* Block_Find(const char* name);
+
+// "noop" or "deadline"
+bool Block_SetElevator(BlockDevice* device, const char* name);
+
+// Queues the request; false if it is invalid or no command is free.
+// Callable from interrupt handlers.
+bool Block_Submit(BlockDevice* device, BlockRequest* request);
+
+// While plugged, requests only collect in the queue where they can merge;
+// unplugging hands them to the driver
+void Block_Plug(BlockDevice* device);
+void Block_Unplug(BlockDevice* device);
+
+// Synchronous helpers, from a thread
+bool Block_Read(BlockDevice* device, uint64_t lba, uint32_t count, void* buffer);
+bool Block_Write(BlockDevice* device, uint64_t lba, uint32_t count, const void* buffer);
+
+// Driver side: the command finished, completes all merged requests
+void Block_Complete(BlockCommand* command, bool success);
+
+void Block_GetStats(BlockDevice* device, BlockStats* stats);
+void Block_PrintStats(BlockDevice* device);
+void Block_PrintDevices();
+void Block_RunBenchmarks();
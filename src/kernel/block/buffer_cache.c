@@ -0,0 +1,525 @@
+#include "buffer_cache.h"
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <sched/scheduler.h>
+#include <sched/thread.h>
+#include <timer/clock.h>
+#include <util/spinlock.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+#define BCACHE_HASH_BITS            10
+#define BCACHE_HASH_SIZE            (1 << BCACHE_HASH_BITS)
+#define BCACHE_MIN_BLOCKS           16
+#define BCACHE_WRITEBACK_BATCH      64
+#define BCACHE_WRITEBACK_INTERVAL   (1 * NS_PER_SEC)
+#define BCACHE_DIRTY_EXPIRE_NS      (3 * NS_PER_SEC)
+#define BCACHE_WRITEBACK_PRIORITY   (THREAD_PRIORITY_DEFAULT + 1)
+#define BCACHE_PREFETCH_MAX         256         // two full readahead windows
+
+static Buffer g_Buffers[CONFIG_BCACHE_BLOCKS];
+static uint8_t g_Data[CONFIG_BCACHE_BLOCKS][BCACHE_BLOCK_SIZE] __attribute__((aligned(4096)));
+static Buffer* g_Hash[BCACHE_HASH_SIZE];
+static uint32_t g_Capacity = CONFIG_BCACHE_BLOCKS;
+static uint32_t g_ClockHand = 0;
+static Spinlock g_Lock;
+static BufferCacheStats g_Stats;
+
+// One write-back batch at a time, from the thread or from a sync
+static volatile uint32_t g_WriteBusy = 0;
+static BlockRequest g_WriteRequests[BCACHE_WRITEBACK_BATCH];
+static Buffer* g_WriteBuffers[BCACHE_WRITEBACK_BATCH];
+static volatile uint32_t g_WriteRemaining;
+static Completion g_WriteDone;
+
+static BlockRequest g_PrefetchRequests[BCACHE_PREFETCH_MAX];
+static BlockRequest* g_FreePrefetch[BCACHE_PREFETCH_MAX];
+static uint32_t g_FreePrefetchCount = 0;
+
+static uint32_t BufferCache_Hash(BlockDevice* device, uint64_t block){
+    uint32_t key = (uint32_t)block ^ (uint32_t)(block >> 32) ^ ((uint32_t)device >> 4);
+    return (key * 2654435761u) >> (32 - BCACHE_HASH_BITS);
+}
+
+static Buffer* BufferCache_Lookup(BlockDevice* device, uint64_t block){
+    for(Buffer* buffer = g_Hash[BufferCache_Hash(device, block)]; buffer != NULL; buffer = buffer->HashNext){
+        if(buffer->Device == device && buffer->Block == block)
+            return buffer;
+    }
+    return NULL;
+}
+
+static void BufferCache_HashInsert(Buffer* buffer){
+    uint32_t bucket = BufferCache_Hash(buffer->Device, buffer->Block);
+    buffer->HashNext = g_Hash[bucket];
+    g_Hash[bucket] = buffer;
+    g_Stats.Cached++;
+}
+
+static void BufferCache_HashRemove(Buffer* buffer){
+    Buffer** link = &g_Hash[BufferCache_Hash(buffer->Device, buffer->Block)];
+    while(*link != buffer)
+        link = &(*link)->HashNext;
+    *link = buffer->HashNext;
+
+    buffer->Device = NULL;
+    buffer->HashNext = NULL;
+    g_Stats.Cached--;
+}
+
+// Sectors of the block that exist on the device, the last one may be short
+static uint32_t BufferCache_BlockSectors(BlockDevice* device, uint64_t block){
+    uint64_t first = block * BCACHE_BLOCK_SECTORS;
+    if(first >= device->SectorCount)
+        return 0;
+    uint64_t left = device->SectorCount - first;
+    return left < BCACHE_BLOCK_SECTORS ? left : BCACHE_BLOCK_SECTORS;
+}
+
+// CLOCK: recently referenced blocks get a second chance, the first idle
+// clean block without the bit goes. Called locked; NULL if every block is
+// in use or dirty.
+static Buffer* BufferCache_Evict(){
+    for(uint32_t scanned = 0; scanned < 2 * g_Capacity; scanned++){
+        Buffer* buffer = &g_Buffers[g_ClockHand];
+        g_ClockHand = (g_ClockHand + 1) % g_Capacity;
+
+        if(buffer->RefCount != 0 || (buffer->Flags & (BUFFER_BUSY | BUFFER_WRITEBACK | BUFFER_DIRTY)))
+            continue;
+        if(buffer->Flags & BUFFER_REFERENCED){
+            buffer->Flags &= ~BUFFER_REFERENCED;
+            continue;
+        }
+
+        if(buffer->Device != NULL){
+            BufferCache_HashRemove(buffer);
+            g_Stats.Evictions++;
+        }
+        buffer->Flags = 0;
+        return buffer;
+    }
+    return NULL;
+}
+
+//
+// Write-back
+//
+
+static void BufferCache_WriteComplete(BlockRequest* request){
+    if(--g_WriteRemaining == 0)
+        Completion_Signal(&g_WriteDone);
+}
+
+// Writes up to one batch of the device's blocks dirty since before
+// olderThan, sorted so the block layer can merge neighbours. Returns how
+// many were written.
+static uint32_t BufferCache_WriteBatch(BlockDevice* device, uint64_t olderThan, bool* failed){
+    while(__atomic_exchange_n(&g_WriteBusy, 1, __ATOMIC_ACQUIRE))
+        Scheduler_Yield();
+
+    uint32_t count = 0;
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+    for(uint32_t i = 0; i < g_Capacity && count < BCACHE_WRITEBACK_BATCH; i++){
+        Buffer* buffer = &g_Buffers[i];
+        if(!(buffer->Flags & BUFFER_DIRTY) || (buffer->Flags & (BUFFER_BUSY | BUFFER_WRITEBACK)))
+            continue;
+        if(device != NULL && buffer->Device != device)
+            continue;
+        if(buffer->DirtySince > olderThan)
+            continue;
+
+        // cleared now: a change made during the write dirties it again
+        buffer->Flags = (buffer->Flags & ~BUFFER_DIRTY) | BUFFER_WRITEBACK;
+        buffer->RefCount++;
+        g_Stats.Dirty--;
+
+        // insertion sort by device, then block
+        uint32_t j = count++;
+        while(j > 0 && (g_WriteBuffers[j - 1]->Device > buffer->Device
+                     || (g_WriteBuffers[j - 1]->Device == buffer->Device && g_WriteBuffers[j - 1]->Block > buffer->Block))){
+            g_WriteBuffers[j] = g_WriteBuffers[j - 1];
+            j--;
+        }
+        g_WriteBuffers[j] = buffer;
+    }
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+
+    if(count == 0){
+        __atomic_store_n(&g_WriteBusy, 0, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    Completion_Initialize(&g_WriteDone);
+    g_WriteRemaining = count;
+
+    BlockDevice* plugged = NULL;
+    for(uint32_t i = 0; i < count; i++){
+        Buffer* buffer = g_WriteBuffers[i];
+        BlockRequest* request = &g_WriteRequests[i];
+
+        if(buffer->Device != plugged){
+            if(plugged != NULL)
+                Block_Unplug(plugged);
+            plugged = buffer->Device;
+            Block_Plug(plugged);
+        }
+
+        request->Lba = buffer->Block * BCACHE_BLOCK_SECTORS;
+        request->Count = BufferCache_BlockSectors(buffer->Device, buffer->Block);
+        request->Write = true;
+        request->Segments[0].Buffer = buffer->Data;
+        request->Segments[0].Length = request->Count * BLOCK_SECTOR_SIZE;
+        request->SegmentCount = 1;
+        request->Callback = BufferCache_WriteComplete;
+        request->Context = buffer;
+
+        // out of commands: let the queued ones go first
+        while(!Block_Submit(buffer->Device, request)){
+            Block_Unplug(plugged);
+            Scheduler_Yield();
+            Block_Plug(plugged);
+        }
+    }
+    Block_Unplug(plugged);
+    Completion_Wait(&g_WriteDone, 0);
+
+    flags = Spinlock_AcquireIrqSave(&g_Lock);
+    for(uint32_t i = 0; i < count; i++){
+        Buffer* buffer = g_WriteBuffers[i];
+        buffer->Flags &= ~BUFFER_WRITEBACK;
+        buffer->RefCount--;
+
+        if(!g_WriteRequests[i].Success){
+            g_Stats.WriteErrors++;
+            *failed = true;
+            if(!(buffer->Flags & BUFFER_DIRTY)){
+                buffer->Flags |= BUFFER_DIRTY;
+                g_Stats.Dirty++;
+            }
+        }
+    }
+    g_Stats.WriteBacks += count;
+    g_Stats.WriteBatches++;
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+
+    __atomic_store_n(&g_WriteBusy, 0, __ATOMIC_RELEASE);
+    return count;
+}
+
+static void BufferCache_WriteBackThread(void* arg){
+    for(;;){
+        Thread_Sleep(BCACHE_WRITEBACK_INTERVAL);
+
+        // old blocks go out, and everything once half the cache is dirty
+        uint64_t olderThan = Clock_NowNs() - BCACHE_DIRTY_EXPIRE_NS;
+        if(g_Stats.Dirty > g_Capacity / 2)
+            olderThan = ~0ULL;
+
+        bool failed = false;
+        while(!failed && BufferCache_WriteBatch(NULL, olderThan, &failed) != 0);
+    }
+}
+
+bool BufferCache_Sync(BlockDevice* device){
+    bool failed = false;
+    while(!failed && BufferCache_WriteBatch(device, ~0ULL, &failed) != 0);
+    return !failed;
+}
+
+//
+// Access
+//
+
+Buffer* BufferCache_Get(BlockDevice* device, uint64_t block){
+    uint32_t sectors = BufferCache_BlockSectors(device, block);
+    if(sectors == 0)
+        return NULL;
+
+    for(;;){
+        uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+
+        Buffer* buffer = BufferCache_Lookup(device, block);
+        if(buffer != NULL){
+            buffer->RefCount++;
+            buffer->Flags |= BUFFER_REFERENCED;
+            g_Stats.Hits++;
+            if(buffer->Flags & BUFFER_PREFETCHED){
+                buffer->Flags &= ~BUFFER_PREFETCHED;
+                g_Stats.PrefetchHits++;
+            }
+            Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+
+            // somebody else is reading it in
+            while(buffer->Flags & BUFFER_BUSY)
+                Scheduler_Yield();
+            if(buffer->Flags & BUFFER_VALID)
+                return buffer;
+
+            // that read failed and dropped it, try ourselves
+            BufferCache_Release(buffer);
+            continue;
+        }
+
+        buffer = BufferCache_Evict();
+        if(buffer == NULL){
+            Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+            bool failed = false;
+            if(BufferCache_WriteBatch(NULL, ~0ULL, &failed) == 0)
+                Scheduler_Yield();
+            continue;
+        }
+
+        buffer->Device = device;
+        buffer->Block = block;
+        buffer->Flags = BUFFER_BUSY | BUFFER_REFERENCED;
+        buffer->RefCount = 1;
+        BufferCache_HashInsert(buffer);
+        g_Stats.Misses++;
+        Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+
+        bool ok = Block_Read(device, block * BCACHE_BLOCK_SECTORS, sectors, buffer->Data);
+        if(sectors < BCACHE_BLOCK_SECTORS)
+            memset(buffer->Data + sectors * BLOCK_SECTOR_SIZE, 0, (BCACHE_BLOCK_SECTORS - sectors) * BLOCK_SECTOR_SIZE);
+
+        flags = Spinlock_AcquireIrqSave(&g_Lock);
+        if(ok){
+            buffer->Flags = (buffer->Flags & ~BUFFER_BUSY) | BUFFER_VALID;
+        } else {
+            g_Stats.ReadErrors++;
+            BufferCache_HashRemove(buffer);
+            buffer->Flags &= ~BUFFER_BUSY;
+            buffer->RefCount--;
+        }
+        Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+
+        return ok ? buffer : NULL;
+    }
+}
+
+//
+// Readahead
+//
+
+static void BufferCache_PrefetchComplete(BlockRequest* request){
+    Buffer* buffer = (Buffer*)request->Context;
+
+    // from the interrupt or, for synchronous drivers, inside Block_Submit
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+    if(request->Success){
+        buffer->Flags = (buffer->Flags & ~BUFFER_BUSY) | BUFFER_VALID;
+    } else {
+        // waiters see it invalid and read it themselves
+        g_Stats.ReadErrors++;
+        BufferCache_HashRemove(buffer);
+        buffer->Flags = 0;
+    }
+    g_FreePrefetch[g_FreePrefetchCount++] = request;
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+}
+
+uint32_t BufferCache_Prefetch(BlockDevice* device, uint64_t block, uint32_t count){
+    uint32_t issued = 0;
+
+    // one plug for the range, the block layer merges the neighbours
+    Block_Plug(device);
+    for(uint32_t i = 0; i < count; i++){
+        uint32_t sectors = BufferCache_BlockSectors(device, block + i);
+        if(sectors == 0)
+            break;
+
+        uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+        if(BufferCache_Lookup(device, block + i) != NULL){
+            Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+            continue;
+        }
+        if(g_FreePrefetchCount == 0){
+            Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+            break;
+        }
+
+        // no reference held: BUSY alone keeps it from being evicted
+        Buffer* buffer = BufferCache_Evict();
+        if(buffer == NULL){
+            Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+            break;
+        }
+        BlockRequest* request = g_FreePrefetch[--g_FreePrefetchCount];
+        buffer->Device = device;
+        buffer->Block = block + i;
+        buffer->Flags = BUFFER_BUSY | BUFFER_PREFETCHED;
+        buffer->RefCount = 0;
+        BufferCache_HashInsert(buffer);
+        g_Stats.Prefetched++;
+        Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+
+        if(sectors < BCACHE_BLOCK_SECTORS)
+            memset(buffer->Data + sectors * BLOCK_SECTOR_SIZE, 0, (BCACHE_BLOCK_SECTORS - sectors) * BLOCK_SECTOR_SIZE);
+
+        request->Lba = (block + i) * BCACHE_BLOCK_SECTORS;
+        request->Count = sectors;
+        request->Write = false;
+        request->Segments[0].Buffer = buffer->Data;
+        request->Segments[0].Length = sectors * BLOCK_SECTOR_SIZE;
+        request->SegmentCount = 1;
+        request->Callback = BufferCache_PrefetchComplete;
+        request->Context = buffer;
+
+        if(!Block_Submit(device, request)){
+            flags = Spinlock_AcquireIrqSave(&g_Lock);
+            BufferCache_HashRemove(buffer);
+            buffer->Flags = 0;
+            g_Stats.Prefetched--;
+            g_FreePrefetch[g_FreePrefetchCount++] = request;
+            Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+            break;
+        }
+        issued++;
+    }
+    Block_Unplug(device);
+
+    return issued;
+}
+
+void BufferCache_Release(Buffer* buffer){
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+    buffer->RefCount--;
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+}
+
+void BufferCache_MarkDirty(Buffer* buffer){
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+    if(!(buffer->Flags & BUFFER_DIRTY)){
+        buffer->Flags |= BUFFER_DIRTY;
+        buffer->DirtySince = Clock_NowNs();
+        g_Stats.Dirty++;
+    }
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+}
+
+static bool BufferCache_Transfer(BlockDevice* device, uint64_t lba, uint32_t count, uint8_t* data, bool write){
+    while(count > 0){
+        uint64_t block = lba / BCACHE_BLOCK_SECTORS;
+        uint32_t offset = lba % BCACHE_BLOCK_SECTORS;
+        uint32_t sectors = BCACHE_BLOCK_SECTORS - offset;
+        if(sectors > count)
+            sectors = count;
+
+        Buffer* buffer = BufferCache_Get(device, block);
+        if(buffer == NULL)
+            return false;
+
+        uint8_t* cached = buffer->Data + offset * BLOCK_SECTOR_SIZE;
+        if(write){
+            memcpy(cached, data, sectors * BLOCK_SECTOR_SIZE);
+            BufferCache_MarkDirty(buffer);
+        } else {
+            memcpy(data, cached, sectors * BLOCK_SECTOR_SIZE);
+        }
+        BufferCache_Release(buffer);
+
+        lba += sectors;
+        count -= sectors;
+        data += sectors * BLOCK_SECTOR_SIZE;
+    }
+    return true;
+}
+
+bool BufferCache_ReadSectors(BlockDevice* device, uint64_t lba, uint32_t count, void* buffer){
+    return BufferCache_Transfer(device, lba, count, (uint8_t*)buffer, false);
+}
+
+bool BufferCache_WriteSectors(BlockDevice* device, uint64_t lba, uint32_t count, const void* buffer){
+    return BufferCache_Transfer(device, lba, count, (uint8_t*)buffer, true);
+}
+
+//
+// Setup
+//
+
+void BufferCache_Invalidate(BlockDevice* device){
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+    for(uint32_t i = 0; i < g_Capacity; i++){
+        Buffer* buffer = &g_Buffers[i];
+        if(buffer->Device == NULL || (device != NULL && buffer->Device != device) || buffer->RefCount != 0)
+            continue;
+        if(buffer->Flags & (BUFFER_BUSY | BUFFER_WRITEBACK | BUFFER_DIRTY))
+            continue;
+
+        BufferCache_HashRemove(buffer);
+        buffer->Flags = 0;
+    }
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+}
+
+uint32_t BufferCache_SetCapacity(uint32_t blocks){
+    if(blocks < BCACHE_MIN_BLOCKS)
+        blocks = BCACHE_MIN_BLOCKS;
+    if(blocks > CONFIG_BCACHE_BLOCKS)
+        blocks = CONFIG_BCACHE_BLOCKS;
+
+    if(blocks < g_Capacity)
+        BufferCache_Sync(NULL);
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+
+    // blocks past the new end must be idle to go
+    for(uint32_t i = blocks; i < g_Capacity; i++){
+        Buffer* buffer = &g_Buffers[i];
+        if(buffer->RefCount != 0 || (buffer->Flags & (BUFFER_BUSY | BUFFER_WRITEBACK | BUFFER_DIRTY))){
+            Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+            return g_Capacity;
+        }
+    }
+    for(uint32_t i = blocks; i < g_Capacity; i++){
+        if(g_Buffers[i].Device != NULL)
+            BufferCache_HashRemove(&g_Buffers[i]);
+        g_Buffers[i].Flags = 0;
+    }
+
+    g_Capacity = blocks;
+    g_ClockHand = 0;
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+    return blocks;
+}
+
+void BufferCache_Initialize(){
+    Spinlock_Initialize(&g_Lock, "bcache");
+    for(uint32_t i = 0; i < CONFIG_BCACHE_BLOCKS; i++){
+        g_Buffers[i].Device = NULL;
+        g_Buffers[i].Data = g_Data[i];
+        g_Buffers[i].Flags = 0;
+        g_Buffers[i].RefCount = 0;
+        g_Buffers[i].HashNext = NULL;
+    }
+    for(uint32_t i = 0; i < BCACHE_PREFETCH_MAX; i++)
+        g_FreePrefetch[g_FreePrefetchCount++] = &g_PrefetchRequests[i];
+
+    Thread_Create("bcache-wb", BufferCache_WriteBackThread, NULL, BCACHE_WRITEBACK_PRIORITY);
+}
+
+void BufferCache_GetStats(BufferCacheStats* stats){
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_Lock);
+    *stats = g_Stats;
+    stats->Capacity = g_Capacity;
+    stats->Footprint = g_Capacity * (BCACHE_BLOCK_SIZE + sizeof(Buffer)) + sizeof(g_Hash);
+    Spinlock_ReleaseIrqRestore(&g_Lock, flags);
+}
+
+void BufferCache_PrintStats(){
+    BufferCacheStats stats;
+    BufferCache_GetStats(&stats);
+
+    uint64_t lookups = stats.Hits + stats.Misses;
+
+    printf("===== BCACHE STATS =====\r\n");
+    printf("capacity=%u blocks, cached=%u, dirty=%u, footprint=%u KiB\r\n",
+           stats.Capacity, stats.Cached, stats.Dirty, stats.Footprint / 1024);
+    printf("hits=%llu misses=%llu hit ratio=%llu%%\r\n",
+           stats.Hits, stats.Misses, lookups ? stats.Hits * 100 / lookups : 0);
+    printf("evictions=%llu read errors=%llu\r\n", stats.Evictions, stats.ReadErrors);
+    printf("prefetched=%llu used=%llu\r\n", stats.Prefetched, stats.PrefetchHits);
+    printf("writebacks=%llu batches=%llu write errors=%llu\r\n",
+           stats.WriteBacks, stats.WriteBatches, stats.WriteErrors);
+    printf("========================\r\n");
+}
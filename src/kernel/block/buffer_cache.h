@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "block.h"
+#include "config.h"
+
+#define BCACHE_BLOCK_SIZE           4096
+#define BCACHE_BLOCK_SECTORS        (BCACHE_BLOCK_SIZE / BLOCK_SECTOR_SIZE)
+
+enum {
+    BUFFER_VALID                = 0x01,     // data matches the disk or is newer
+    BUFFER_DIRTY                = 0x02,     // newer, needs a write back
+    BUFFER_BUSY                 = 0x04,     // being read, wait before use
+    BUFFER_WRITEBACK            = 0x08,     // being written, may not be evicted
+    BUFFER_REFERENCED           = 0x10,     // CLOCK bit
+    BUFFER_PREFETCHED           = 0x20,     // read ahead, not used yet
+};
+
+typedef struct Buffer Buffer;
+
+// One cached block of BCACHE_BLOCK_SIZE bytes, block n covering sectors
+// n * BCACHE_BLOCK_SECTORS onwards of its device
+struct Buffer{
+    BlockDevice*        Device;
+    uint64_t            Block;
+    uint8_t*            Data;
+    volatile uint32_t   Flags;
+    uint32_t            RefCount;
+    uint64_t            DirtySince;         // ns
+    Buffer*             HashNext;
+};
+
+typedef struct{
+    uint64_t Hits;
+    uint64_t Misses;
+    uint64_t ReadErrors;
+    uint64_t Evictions;
+    uint64_t Prefetched;                    // blocks read ahead
+    uint64_t PrefetchHits;                  // of those, later used
+    uint64_t WriteBacks;                    // blocks written
+    uint64_t WriteBatches;
+    uint64_t WriteErrors;
+    uint32_t Capacity;                      // blocks in use by the cache
+    uint32_t Cached;
+    uint32_t Dirty;
+    uint32_t Footprint;                     // bytes of data and metadata
+} BufferCacheStats;
+
+// Starts the write-back thread, the scheduler must be running
+void BufferCache_Initialize();
+
+// Returns the block with a reference held, reading it on a miss; NULL on
+// a read error. Must be called from a thread.
+Buffer* BufferCache_Get(BlockDevice* device, uint64_t block);
+void BufferCache_Release(Buffer* buffer);
+// The data was changed, the write-back thread writes it out later
+void BufferCache_MarkDirty(Buffer* buffer);
+
+// Starts asynchronous reads of the blocks of the range not cached yet and
+// returns how many were started. Stops early when the cache is busy.
+uint32_t BufferCache_Prefetch(BlockDevice* device, uint64_t block, uint32_t count);
+
+// Sector granular access through the cache
+bool BufferCache_ReadSectors(BlockDevice* device, uint64_t lba, uint32_t count, void* buffer);
+bool BufferCache_WriteSectors(BlockDevice* device, uint64_t lba, uint32_t count, const void* buffer);
+
+// Writes out every dirty block of the device, all devices for NULL
+bool BufferCache_Sync(BlockDevice* device);
+// Drops the device's clean, unused blocks, e.g. after an unmount; all
+// devices for NULL
+void BufferCache_Invalidate(BlockDevice* device);
+
+// Limits the cache to fewer blocks than CONFIG_BCACHE_BLOCKS, writing and
+// dropping the ones beyond the new limit. Returns the capacity set.
+uint32_t BufferCache_SetCapacity(uint32_t blocks);
+
+void BufferCache_GetStats(BufferCacheStats* stats);
+void BufferCache_PrintStats();
+void BufferCache_RunBenchmarks();
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "block.h"
+
+// Orders the commands waiting in a queue. Called with the queue locked.
+struct BlockElevator{
+    const char*     Name;
+    void            (*Initialize)(BlockQueue* queue);
+    void            (*Add)(BlockQueue* queue, BlockCommand* command);
+    // Removes and returns the command to dispatch next, NULL if empty
+    BlockCommand*   (*Next)(BlockQueue* queue);
+    // The command grew; front merges moved its start
+    void            (*Merged)(BlockQueue* queue, BlockCommand* command, bool front);
+};
+
+const BlockElevator* Elevator_GetNoop();
+const BlockElevator* Elevator_GetDeadline();
@@ -0,0 +1,150 @@
+#include "elevator.h"
+#include <timer/clock.h>
+#include <stddef.h>
+
+// Serves commands in ascending LBA order like a one way elevator, in
+// batches. Between batches the oldest read and write are checked against
+// their deadline, so nothing starves behind a stream of nearby requests.
+// Reads expire sooner, somebody is usually waiting for them.
+
+#define DEADLINE_READ_EXPIRE_NS     (500 * NS_PER_MS)
+#define DEADLINE_WRITE_EXPIRE_NS    (5 * NS_PER_SEC)
+#define DEADLINE_BATCH              16
+#define DEADLINE_WRITES_STARVED     2           // read batches before writes win
+
+static void Deadline_Initialize(BlockQueue* queue){
+    BlockElevatorData* data = &queue->ElevatorData;
+
+    data->SortHead = NULL;
+    for(int i = 0; i < 2; i++){
+        data->FifoHead[i] = NULL;
+        data->FifoTail[i] = NULL;
+    }
+    data->Position = 0;
+    data->Batch = 0;
+    data->WritesStarved = 0;
+}
+
+static void Deadline_SortInsert(BlockElevatorData* data, BlockCommand* command){
+    BlockCommand* previous = NULL;
+    BlockCommand* current = data->SortHead;
+    while(current != NULL && current->Lba <= command->Lba){
+        previous = current;
+        current = current->SortNext;
+    }
+
+    command->SortPrev = previous;
+    command->SortNext = current;
+    if(previous != NULL)
+        previous->SortNext = command;
+    else
+        data->SortHead = command;
+    if(current != NULL)
+        current->SortPrev = command;
+}
+
+static void Deadline_SortRemove(BlockElevatorData* data, BlockCommand* command){
+    if(command->SortPrev != NULL)
+        command->SortPrev->SortNext = command->SortNext;
+    else
+        data->SortHead = command->SortNext;
+    if(command->SortNext != NULL)
+        command->SortNext->SortPrev = command->SortPrev;
+}
+
+static void Deadline_FifoRemove(BlockElevatorData* data, BlockCommand* command){
+    int direction = command->Write;
+
+    if(command->FifoPrev != NULL)
+        command->FifoPrev->FifoNext = command->FifoNext;
+    else
+        data->FifoHead[direction] = command->FifoNext;
+    if(command->FifoNext != NULL)
+        command->FifoNext->FifoPrev = command->FifoPrev;
+    else
+        data->FifoTail[direction] = command->FifoPrev;
+}
+
+static void Deadline_Add(BlockQueue* queue, BlockCommand* command){
+    BlockElevatorData* data = &queue->ElevatorData;
+    int direction = command->Write;
+
+    command->Deadline = Clock_NowNs() + (command->Write ? DEADLINE_WRITE_EXPIRE_NS : DEADLINE_READ_EXPIRE_NS);
+
+    command->FifoNext = NULL;
+    command->FifoPrev = data->FifoTail[direction];
+    if(data->FifoTail[direction] != NULL)
+        data->FifoTail[direction]->FifoNext = command;
+    else
+        data->FifoHead[direction] = command;
+    data->FifoTail[direction] = command;
+
+    Deadline_SortInsert(data, command);
+}
+
+// First command at or past the elevator position, wrapping around
+static BlockCommand* Deadline_Sweep(BlockElevatorData* data){
+    for(BlockCommand* command = data->SortHead; command != NULL; command = command->SortNext){
+        if(command->Lba >= data->Position)
+            return command;
+    }
+    return data->SortHead;
+}
+
+static bool Deadline_Expired(BlockElevatorData* data, int direction, uint64_t now){
+    BlockCommand* head = data->FifoHead[direction];
+    return head != NULL && head->Deadline <= now;
+}
+
+static BlockCommand* Deadline_Next(BlockQueue* queue){
+    BlockElevatorData* data = &queue->ElevatorData;
+    if(data->SortHead == NULL)
+        return NULL;
+
+    BlockCommand* command = NULL;
+
+    if(data->Batch == 0){
+        uint64_t now = Clock_NowNs();
+        bool readExpired = Deadline_Expired(data, 0, now);
+        bool writeExpired = Deadline_Expired(data, 1, now);
+
+        if(writeExpired && (!readExpired || data->WritesStarved >= DEADLINE_WRITES_STARVED)){
+            command = data->FifoHead[1];
+            data->WritesStarved = 0;
+        } else if(readExpired){
+            command = data->FifoHead[0];
+            if(data->FifoHead[1] != NULL)
+                data->WritesStarved++;
+        }
+        data->Batch = DEADLINE_BATCH;
+    }
+
+    if(command == NULL)
+        command = Deadline_Sweep(data);
+
+    Deadline_SortRemove(data, command);
+    Deadline_FifoRemove(data, command);
+    data->Position = command->Lba + command->Count;
+    data->Batch--;
+    return command;
+}
+
+static void Deadline_Merged(BlockQueue* queue, BlockCommand* command, bool front){
+    // a front merge moved the start, the sorted position may be stale
+    if(front){
+        Deadline_SortRemove(&queue->ElevatorData, command);
+        Deadline_SortInsert(&queue->ElevatorData, command);
+    }
+}
+
+static const BlockElevator g_DeadlineElevator = {
+    .Name = "deadline",
+    .Initialize = Deadline_Initialize,
+    .Add = Deadline_Add,
+    .Next = Deadline_Next,
+    .Merged = Deadline_Merged,
+};
+
+const BlockElevator* Elevator_GetDeadline(){
+    return &g_DeadlineElevator;
+}
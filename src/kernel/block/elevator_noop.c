@@ -0,0 +1,51 @@
+#include "elevator.h"
+#include <stddef.h>
+
+// Plain FIFO through the sort links; merging already happened in the
+// block layer, which is all a device with its own scheduler needs.
+
+static void Noop_Initialize(BlockQueue* queue){
+    queue->ElevatorData.SortHead = NULL;
+    queue->ElevatorData.FifoTail[0] = NULL;
+}
+
+static void Noop_Add(BlockQueue* queue, BlockCommand* command){
+    BlockElevatorData* data = &queue->ElevatorData;
+
+    command->SortNext = NULL;
+    command->SortPrev = data->FifoTail[0];
+    if(data->FifoTail[0] != NULL)
+        data->FifoTail[0]->SortNext = command;
+    else
+        data->SortHead = command;
+    data->FifoTail[0] = command;
+}
+
+static BlockCommand* Noop_Next(BlockQueue* queue){
+    BlockElevatorData* data = &queue->ElevatorData;
+    BlockCommand* command = data->SortHead;
+    if(command == NULL)
+        return NULL;
+
+    data->SortHead = command->SortNext;
+    if(data->SortHead != NULL)
+        data->SortHead->SortPrev = NULL;
+    else
+        data->FifoTail[0] = NULL;
+    return command;
+}
+
+static void Noop_Merged(BlockQueue* queue, BlockCommand* command, bool front){
+}
+
+static const BlockElevator g_NoopElevator = {
+    .Name = "noop",
+    .Initialize = Noop_Initialize,
+    .Add = Noop_Add,
+    .Next = Noop_Next,
+    .Merged = Noop_Merged,
+};
+
+const BlockElevator* Elevator_GetNoop(){
+    return &g_NoopElevator;
+}
@@ -0,0 +1,57 @@
+#include "mbr.h"
+#include <stddef.h>
+#include "stdio.h"
+
+#define MBR_ENTRY_OFFSET            446
+#define MBR_ENTRY_COUNT             4
+#define MBR_SIGNATURE_OFFSET        510
+#define MBR_SIGNATURE               0xAA55
+#define MBR_ATTRIBUTE_ACTIVE        0x80
+
+#define MBR_TYPE_EMPTY              0x00
+#define MBR_TYPE_EXTENDED_CHS       0x05
+#define MBR_TYPE_EXTENDED_LBA       0x0F
+
+// Same layout stage2 reads the boot partition from, see boot/stage2/mbr.c
+typedef struct{
+    uint8_t attributes;
+    uint8_t chsStart[3];
+    uint8_t partitionType;
+    uint8_t chsEnd[3];
+    uint32_t lbaStart;
+    uint32_t size;
+} __attribute__((packed)) MBREntry;
+
+static uint8_t g_Sector[BLOCK_SECTOR_SIZE] __attribute__((aligned(16)));
+
+void MBR_ScanPartitions(BlockDevice* disk){
+    if(!Block_Read(disk, 0, 1, g_Sector)){
+        printf("[BLOCK] %s: cannot read the partition table\r\n", disk->Name);
+        return;
+    }
+
+    // no signature: a floppy style image without partitions, like stage2
+    // treats disks below 0x80
+    uint16_t signature = g_Sector[MBR_SIGNATURE_OFFSET] | (g_Sector[MBR_SIGNATURE_OFFSET + 1] << 8);
+    if(signature != MBR_SIGNATURE)
+        return;
+
+    // a FAT boot sector carries the signature too, but no sane entries
+    MBREntry* entries = (MBREntry*)&g_Sector[MBR_ENTRY_OFFSET];
+    for(int i = 0; i < MBR_ENTRY_COUNT; i++){
+        if(entries[i].attributes != 0 && entries[i].attributes != MBR_ATTRIBUTE_ACTIVE)
+            return;
+    }
+
+    for(int i = 0; i < MBR_ENTRY_COUNT; i++){
+        MBREntry* entry = &entries[i];
+        if(entry->partitionType == MBR_TYPE_EMPTY || entry->size == 0)
+            continue;
+
+        // logical partitions in extended ones are not followed
+        if(entry->partitionType == MBR_TYPE_EXTENDED_CHS || entry->partitionType == MBR_TYPE_EXTENDED_LBA)
+            continue;
+
+        Block_RegisterPartition(disk, i + 1, entry->lbaStart, entry->size, entry->partitionType);
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "block.h"
+
+// Registers a block device for each primary partition of the disk's MBR
+void MBR_ScanPartitions(BlockDevice* disk);
@@ -0,0 +1,57 @@
+#include "ramdisk.h"
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+typedef struct{
+    uint8_t* Data;
+    uint32_t Size;
+} Ramdisk;
+
+static Ramdisk g_Disks[RAMDISK_MAX_DISKS];
+static uint32_t g_DiskCount = 0;
+
+// Copies right away, so the command completes before Submit returns. The
+// Block_Run that called us picks up the next command once we return.
+static bool Ramdisk_Submit(BlockDevice* device, BlockCommand* command){
+    Ramdisk* disk = (Ramdisk*)device->DriverData;
+    uint8_t* data = disk->Data + command->Lba * BLOCK_SECTOR_SIZE;
+
+    for(int i = 0; i < command->SegmentCount; i++){
+        BlockSegment* segment = &command->Segments[i];
+        if(command->Write)
+            memcpy(data, segment->Buffer, segment->Length);
+        else
+            memcpy(segment->Buffer, data, segment->Length);
+        data += segment->Length;
+    }
+
+    Block_Complete(command, true);
+    return true;
+}
+
+static const BlockDriver g_RamdiskDriver = {
+    .Name = "ramdisk",
+    .Submit = Ramdisk_Submit,
+    .MaxSectors = 2048,
+    .MaxSegments = BLOCK_MAX_SEGMENTS,
+};
+
+BlockDevice* Ramdisk_Register(const char* name, void* data, uint32_t size){
+    if(g_DiskCount == RAMDISK_MAX_DISKS || size < BLOCK_SECTOR_SIZE)
+        return NULL;
+
+    Ramdisk* disk = &g_Disks[g_DiskCount++];
+    disk->Data = (uint8_t*)data;
+    disk->Size = size - size % BLOCK_SECTOR_SIZE;
+    return Block_RegisterDisk(name, disk->Size / BLOCK_SECTOR_SIZE, 1, &g_RamdiskDriver, disk);
+}
+
+uint8_t* Ramdisk_GetData(BlockDevice* device, uint64_t* size){
+    if(device->Driver != &g_RamdiskDriver)
+        return NULL;
+
+    Ramdisk* disk = (Ramdisk*)device->DriverData;
+    *size = device->SectorCount * BLOCK_SECTOR_SIZE;
+    return disk->Data + device->Offset * BLOCK_SECTOR_SIZE;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "block.h"
+#include <stdint.h>
+
+#define RAMDISK_MAX_DISKS           2
+
+// A disk over memory that stays put, such as the initrd stage2 loaded.
+// Registered like any other disk, so its partitions are scanned too; size
+// is rounded down to whole sectors.
+BlockDevice* Ramdisk_Register(const char* name, void* data, uint32_t size);
+
+// The memory behind a ramdisk or one of its partitions, for drivers that
+// read it in place; NULL for other devices
+uint8_t* Ramdisk_GetData(BlockDevice* device, uint64_t* size);
@@ -0,0 +1,89 @@
+#include "readahead.h"
+#include "buffer_cache.h"
+#include <stddef.h>
+#include "memory.h"
+
+void Readahead_Initialize(Readahead* ra, BlockDevice* device, ReadaheadMap map, void* file, uint64_t fileSize){
+    memset(ra, 0, sizeof(Readahead));
+    ra->Device = device;
+    ra->Map = map;
+    ra->File = file;
+    ra->FileSize = fileSize;
+    ra->Enabled = true;
+}
+
+void Readahead_SetEnabled(Readahead* ra, bool enabled){
+    ra->Enabled = enabled;
+    ra->Streaming = false;
+    ra->Size = 0;
+}
+
+// Starts the reads of the cache blocks behind [offset, offset + length),
+// extent by extent. Blocks already cached are skipped.
+static void Readahead_Issue(Readahead* ra, uint64_t offset, uint32_t length){
+    if(offset >= ra->FileSize)
+        return;
+    if(length > ra->FileSize - offset)
+        length = ra->FileSize - offset;
+
+    ra->Stats.Windows++;
+    uint64_t end = offset + length;
+    offset &= ~(uint64_t)(BLOCK_SECTOR_SIZE - 1);
+
+    while(offset < end){
+        uint64_t lba;
+        uint32_t sectors;
+        if(!ra->Map(ra->File, offset, &lba, &sectors) || sectors == 0)
+            return;
+
+        uint32_t needed = (end - offset + BLOCK_SECTOR_SIZE - 1) / BLOCK_SECTOR_SIZE;
+        if(sectors > needed)
+            sectors = needed;
+
+        uint64_t first = lba / BCACHE_BLOCK_SECTORS;
+        uint32_t count = (lba + sectors - 1) / BCACHE_BLOCK_SECTORS - first + 1;
+        ra->Stats.Blocks += BufferCache_Prefetch(ra->Device, first, count);
+
+        offset += (uint64_t)sectors * BLOCK_SECTOR_SIZE;
+    }
+}
+
+void Readahead_OnRead(Readahead* ra, uint64_t offset, uint32_t length){
+    if(!ra->Enabled)
+        return;
+
+    bool sequential = offset == ra->NextOffset;
+    ra->NextOffset = offset + length;
+
+    if(!sequential){
+        // random access: reading ahead would only evict useful blocks, and
+        // a stream found again later starts from a smaller window
+        ra->Stats.Random++;
+        ra->Streaming = false;
+        ra->Size /= 4;
+        return;
+    }
+    ra->Stats.Sequential++;
+
+    if(!ra->Streaming){
+        // a new stream: the first window covers this read as well
+        ra->Streaming = true;
+        ra->Start = offset;
+        if(ra->Size < READAHEAD_MIN_WINDOW)
+            ra->Size = READAHEAD_MIN_WINDOW;
+        Readahead_Issue(ra, ra->Start, ra->Size);
+    } else if(offset + length <= ra->Start){
+        // still consuming the previous window
+        return;
+    }
+
+    // reads reached the window in flight: start the next one behind it
+    uint64_t next = ra->Start + ra->Size;
+    uint32_t size = ra->Size * 2;
+    if(size > READAHEAD_MAX_WINDOW)
+        size = READAHEAD_MAX_WINDOW;
+
+    ra->Start = next;
+    ra->Size = size;
+    Readahead_Issue(ra, next, size);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "block.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define READAHEAD_MIN_WINDOW        (16 * 1024)
+#define READAHEAD_MAX_WINDOW        (512 * 1024)
+
+// Where the file byte at offset lives on disk and how many sectors from
+// there are contiguous; false past the end of the file or on errors.
+typedef bool (*ReadaheadMap)(void* file, uint64_t offset, uint64_t* lba, uint32_t* sectors);
+
+typedef struct{
+    uint64_t Windows;                       // windows started
+    uint64_t Blocks;                        // cache blocks read ahead
+    uint64_t Sequential;                    // reads continuing the last one
+    uint64_t Random;                        // reads that shrank the window
+} ReadaheadStats;
+
+// Per open file. While streaming, [Start, Start + Size) is the last window
+// read ahead; once reads reach Start the next, twice as large, is started,
+// so one window is in flight while the previous one is consumed.
+typedef struct{
+    BlockDevice* Device;
+    ReadaheadMap Map;
+    void* File;
+    uint64_t FileSize;
+    bool Enabled;
+
+    uint64_t NextOffset;                    // where a sequential read goes on
+    bool Streaming;                         // sequential access detected
+    uint64_t Start;
+    uint32_t Size;
+    ReadaheadStats Stats;
+} Readahead;
+
+void Readahead_Initialize(Readahead* ra, BlockDevice* device, ReadaheadMap map, void* file, uint64_t fileSize);
+void Readahead_SetEnabled(Readahead* ra, bool enabled);
+
+// Called by the file read path before it copies [offset, offset + length)
+// out of the buffer cache
+void Readahead_OnRead(Readahead* ra, uint64_t offset, uint32_t length);
+
+void Readahead_RunBenchmarks();
@@ -0,0 +1,61 @@
+[bits 32]
+
+; The first bytes of kernel.bin. Stage2 jumps to the very start and reads
+; the KernelHeader behind the jump to find where the image ends in memory,
+; BSS included, so the initrd can go right after it (see boot/bootinfo.h).
+;
+; A Multiboot (v1) header follows, so QEMU -kernel and GRUB can load the
+; flat binary too: the address fields tell them where it goes, and they
+; enter through multiboot_entry instead.
+
+extern start
+extern Multiboot_Start
+extern __entry_start
+extern __end
+
+MULTIBOOT_MAGIC             equ 0x1BADB002
+MULTIBOOT_PAGE_ALIGN        equ 1 << 0      ; modules on page boundaries
+MULTIBOOT_MEMORY_INFO       equ 1 << 1      ; memory map wanted
+MULTIBOOT_AOUT_KLUDGE       equ 1 << 16     ; load by the fields below, no ELF
+MULTIBOOT_FLAGS             equ MULTIBOOT_PAGE_ALIGN | MULTIBOOT_MEMORY_INFO | MULTIBOOT_AOUT_KLUDGE
+
+; Stage2 leaves the kernel on its own stack, a Multiboot loader leaves no
+; stack at all. This one goes right after the BSS, where start() does not
+; clear it; the loader keeps its modules and tables clear of it because
+; it counts as BSS in the header.
+MULTIBOOT_STACK_SIZE        equ 0x4000
+
+section .header progbits alloc exec nowrite align=4
+
+    jmp near start
+    align 4, db 0
+    dd 0x4C4E524B                           ; KERNEL_HEADER_MAGIC
+    dd __end
+
+multiboot_header:
+    dd MULTIBOOT_MAGIC
+    dd MULTIBOOT_FLAGS
+    dd -(MULTIBOOT_MAGIC + MULTIBOOT_FLAGS)
+    dd multiboot_header                     ; header_addr
+    dd __entry_start                        ; load_addr, the start of the file
+    dd 0                                    ; load_end_addr, the whole file
+    dd __end + MULTIBOOT_STACK_SIZE         ; bss_end_addr
+    dd multiboot_entry                      ; entry_addr
+
+section .text
+
+; eax = bootloader magic, ebx = physical address of the Multiboot info;
+; protected mode with flat segments, interrupts off. The GDT register may
+; be stale, but nothing reloads a segment before HAL_Initialize loads the
+; kernel's own GDT.
+multiboot_entry:
+    mov esp, __end + MULTIBOOT_STACK_SIZE
+    and esp, ~0xF
+    push ebx
+    push eax
+    call Multiboot_Start
+
+    cli
+.halt:
+    hlt
+    jmp .halt
@@ -0,0 +1,52 @@
+#include "multiboot.h"
+#include "memory.h"
+
+// The entry point stage2 calls, in main.c
+void start(const BootInfo* bootInfo);
+
+void Multiboot_Convert(const MultibootInfo* info, BootInfo* bootInfo){
+    memset(bootInfo, 0, sizeof(BootInfo));
+    bootInfo->Magic = BOOTINFO_MAGIC;
+
+    if(info->Flags & MULTIBOOT_INFO_BOOT_DEVICE)
+        bootInfo->BootDrive = info->BootDevice >> 24;
+
+    if((info->Flags & MULTIBOOT_INFO_MODULES) && info->ModuleCount > 0){
+        const MultibootModule* module = (const MultibootModule*)info->ModuleAddress;
+        bootInfo->InitrdAddress = module->Start;
+        bootInfo->InitrdSize = module->End - module->Start;
+    }
+
+    if(info->Flags & MULTIBOOT_INFO_MEMORY_MAP){
+        uint32_t address = info->MemoryMapAddress;
+        uint32_t end = address + info->MemoryMapLength;
+        while(address < end && bootInfo->MemoryRegionCount < BOOTINFO_MAX_MEMORY_REGIONS){
+            const MultibootMemoryRegion* region = (const MultibootMemoryRegion*)address;
+            BootMemoryRegion* out = &bootInfo->MemoryRegions[bootInfo->MemoryRegionCount++];
+            out->Base = region->Base;
+            out->Length = region->Length;
+            out->Type = region->Type;
+            address += region->Size + sizeof(region->Size);
+        }
+    } else if(info->Flags & MULTIBOOT_INFO_MEMORY){
+        // just the two sizes: conventional memory, and what follows 1 MiB
+        bootInfo->MemoryRegions[0].Base = 0;
+        bootInfo->MemoryRegions[0].Length = (uint64_t)info->MemoryLower * 1024;
+        bootInfo->MemoryRegions[0].Type = BOOTINFO_MEMORY_AVAILABLE;
+        bootInfo->MemoryRegions[1].Base = 0x100000;
+        bootInfo->MemoryRegions[1].Length = (uint64_t)info->MemoryUpper * 1024;
+        bootInfo->MemoryRegions[1].Type = BOOTINFO_MEMORY_AVAILABLE;
+        bootInfo->MemoryRegionCount = 2;
+    }
+}
+
+// Called by multiboot_entry in boot/header.asm on the boot stack. The boot
+// info is built on that stack too, start() would clear it in the BSS.
+void __attribute__((cdecl)) Multiboot_Start(uint32_t magic, const MultibootInfo* info){
+    BootInfo bootInfo;
+    if(magic == MULTIBOOT_BOOTLOADER_MAGIC)
+        Multiboot_Convert(info, &bootInfo);
+    else
+        memset(&bootInfo, 0, sizeof(BootInfo));
+    start(&bootInfo);
+}
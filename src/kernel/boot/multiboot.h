@@ -0,0 +1,47 @@
+#pragma once
+#include "bootinfo.h"
+#include <stdint.h>
+
+#define MULTIBOOT_BOOTLOADER_MAGIC  0x2BADB002
+
+enum {
+    MULTIBOOT_INFO_MEMORY           = 1 << 0,
+    MULTIBOOT_INFO_BOOT_DEVICE      = 1 << 1,
+    MULTIBOOT_INFO_MODULES          = 1 << 3,
+    MULTIBOOT_INFO_MEMORY_MAP       = 1 << 6,
+};
+
+typedef struct{
+    uint32_t Flags;                         // which of the fields below are valid
+    uint32_t MemoryLower;                   // KiB from 0
+    uint32_t MemoryUpper;                   // KiB from 1 MiB
+    uint32_t BootDevice;                    // BIOS drive in the top byte
+    uint32_t CommandLine;
+    uint32_t ModuleCount;
+    uint32_t ModuleAddress;
+    uint32_t Symbols[4];
+    uint32_t MemoryMapLength;               // bytes
+    uint32_t MemoryMapAddress;
+} __attribute__((packed)) MultibootInfo;
+
+typedef struct{
+    uint32_t Start;
+    uint32_t End;                           // exclusive
+    uint32_t String;
+    uint32_t Reserved;
+} __attribute__((packed)) MultibootModule;
+
+// Size does not count itself, entries may be longer than this
+typedef struct{
+    uint32_t Size;
+    uint64_t Base;
+    uint64_t Length;
+    uint32_t Type;                          // BOOTINFO_MEMORY_*
+} __attribute__((packed)) MultibootMemoryRegion;
+
+// Fills bootInfo from what a Multiboot loader passed: the memory map, the
+// boot drive, and the first module as the initrd
+void Multiboot_Convert(const MultibootInfo* info, BootInfo* bootInfo);
+
+// Where multiboot_entry in boot/header.asm goes; converts and calls start()
+void __attribute__((cdecl)) Multiboot_Start(uint32_t magic, const MultibootInfo* info);
@@ -0,0 +1,38 @@
+#pragma once
+
+// Compile time switches for optional kernel features.
+// Benchmarks run once at boot and print their results over debugcon.
+
+#define CONFIG_SCHED_BENCHMARK          0
+#define CONFIG_LOCK_STRESSTEST          0
+#define CONFIG_LOCKFREE_BENCHMARK       0
+#define CONFIG_ATA_BENCHMARK            0
+#define CONFIG_AHCI_BENCHMARK           0
+#define CONFIG_VIRTIO_BENCHMARK         0
+#define CONFIG_BLOCK_BENCHMARK          0
+#define CONFIG_BCACHE_BENCHMARK         0
+#define CONFIG_READAHEAD_BENCHMARK      0
+#define CONFIG_VFS_BENCHMARK            0
+// Arms one-shot timers at boot, checks when they fire against their
+// deadlines and counts the idle wakeups in between
+#define CONFIG_TIMER_CHECK              0
+
+// Per lock class acquisition and contention counters, see util/lockstat.h
+#define CONFIG_LOCKSTAT                 0
+
+// Timer driven sampling profiler, see util/profiler.h. When enabled it runs
+// across the boot benchmarks and dumps its samples afterwards.
+#define CONFIG_PROFILER                 0
+// Samples kept per CPU, statically reserved
+#define CONFIG_PROFILER_SAMPLES         2048
+
+// Static tracepoints, see util/trace.h. They are compiled in but record
+// nothing until Trace_Start; CONFIG_TRACE_BOOT traces the boot benchmarks
+// and dumps the records afterwards.
+#define CONFIG_TRACE                    1
+#define CONFIG_TRACE_BOOT               0
+// Records kept per CPU, a power of two, statically reserved
+#define CONFIG_TRACE_RECORDS            4096
+
+// Blocks of 4 KiB in the buffer cache, statically reserved
+#define CONFIG_BCACHE_BLOCKS            512
@@ -0,0 +1,869 @@
+#include "ahci.h"
+#include <drivers/pci/pci.h>
+#include <block/block.h>
+#include <arch/i686/apic/lapic.h>
+#include <arch/i686/interrupts/irq.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <sched/scheduler.h>
+#include <timer/clock.h>
+#include <util/spinlock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define AHCI_BAR_ABAR               5
+#define AHCI_PORT_BASE              0x100
+#define AHCI_PORT_SIZE              0x80
+#define AHCI_FIS_AREA_SIZE          256
+#define AHCI_PRD_MAX_BYTES          (4 * 1024 * 1024)
+#define AHCI_MAX_SECTORS            0xFFFF
+#define AHCI_POLL_TIMEOUT_NS        (1 * NS_PER_SEC)
+#define AHCI_TIMEOUT_NS             (5 * NS_PER_SEC)
+
+#define AHCI_SIGNATURE_ATA          0x00000101
+
+// Generic host control registers
+enum {
+    AHCI_REG_CAP                = 0x00,
+    AHCI_REG_GHC                = 0x04,
+    AHCI_REG_IS                 = 0x08,
+    AHCI_REG_PI                 = 0x0C,
+    AHCI_REG_VS                 = 0x10,
+};
+
+enum {
+    AHCI_CAP_NCS_SHIFT          = 8,
+    AHCI_CAP_NCS_MASK           = 0x1F,
+    AHCI_CAP_SNCQ               = 0x40000000,
+
+    AHCI_GHC_HR                 = 0x00000001,
+    AHCI_GHC_IE                 = 0x00000002,
+    AHCI_GHC_AE                 = 0x80000000,
+};
+
+// Port registers, relative to the port's block
+enum {
+    AHCI_PORT_CLB               = 0x00,
+    AHCI_PORT_CLBU              = 0x04,
+    AHCI_PORT_FB                = 0x08,
+    AHCI_PORT_FBU               = 0x0C,
+    AHCI_PORT_IS                = 0x10,
+    AHCI_PORT_IE                = 0x14,
+    AHCI_PORT_CMD               = 0x18,
+    AHCI_PORT_TFD               = 0x20,
+    AHCI_PORT_SIG               = 0x24,
+    AHCI_PORT_SSTS              = 0x28,
+    AHCI_PORT_SCTL              = 0x2C,
+    AHCI_PORT_SERR              = 0x30,
+    AHCI_PORT_SACT              = 0x34,
+    AHCI_PORT_CI                = 0x38,
+};
+
+enum {
+    AHCI_PORT_CMD_ST            = 0x0001,
+    AHCI_PORT_CMD_FRE           = 0x0010,
+    AHCI_PORT_CMD_FR            = 0x4000,
+    AHCI_PORT_CMD_CR            = 0x8000,
+
+    AHCI_PORT_SSTS_DET_MASK     = 0x0F,
+    AHCI_PORT_SSTS_DET_PRESENT  = 0x03,
+
+    AHCI_PORT_SCTL_DET_INIT     = 0x01,
+
+    AHCI_PORT_TFD_ERR           = 0x01,
+    AHCI_PORT_TFD_DRQ           = 0x08,
+    AHCI_PORT_TFD_BSY           = 0x80,
+};
+
+// Port interrupt status / enable bits
+enum {
+    AHCI_PORT_INT_DHRS          = 0x00000001,   // D2H register FIS, non queued commands
+    AHCI_PORT_INT_PSS           = 0x00000002,   // PIO setup FIS
+    AHCI_PORT_INT_DSS           = 0x00000004,   // DMA setup FIS
+    AHCI_PORT_INT_SDBS          = 0x00000008,   // set device bits FIS, NCQ completions
+    AHCI_PORT_INT_DPS           = 0x00000020,   // PRD with the I bit done
+    AHCI_PORT_INT_IFS           = 0x08000000,
+    AHCI_PORT_INT_HBDS          = 0x10000000,
+    AHCI_PORT_INT_HBFS          = 0x20000000,
+    AHCI_PORT_INT_TFES          = 0x40000000,
+
+    AHCI_PORT_INT_ERRORS        = AHCI_PORT_INT_IFS | AHCI_PORT_INT_HBDS
+                                | AHCI_PORT_INT_HBFS | AHCI_PORT_INT_TFES,
+    AHCI_PORT_INT_DEFAULT       = AHCI_PORT_INT_DHRS | AHCI_PORT_INT_PSS | AHCI_PORT_INT_DSS
+                                | AHCI_PORT_INT_SDBS | AHCI_PORT_INT_DPS | AHCI_PORT_INT_ERRORS,
+};
+
+enum {
+    AHCI_FIS_REG_H2D            = 0x27,
+    AHCI_FIS_COMMAND            = 0x80,
+    AHCI_FIS_DEVICE_LBA         = 0x40,
+};
+
+enum {
+    AHCI_CMD_READ_DMA_EXT       = 0x25,
+    AHCI_CMD_WRITE_DMA_EXT      = 0x35,
+    AHCI_CMD_READ_FPDMA_QUEUED  = 0x60,
+    AHCI_CMD_WRITE_FPDMA_QUEUED = 0x61,
+    AHCI_CMD_READ_LOG_EXT       = 0x2F,
+    AHCI_CMD_IDENTIFY           = 0xEC,
+};
+
+// NCQ command error log, READ LOG EXT page 10h
+enum {
+    AHCI_LOG_NCQ_ERROR          = 0x10,
+
+    AHCI_LOG_NCQ_TAG_MASK       = 0x1F,
+    AHCI_LOG_NCQ_NQ             = 0x80,     // the error was not for a queued command
+};
+
+// IDENTIFY words
+enum {
+    AHCI_ID_MODEL               = 27,
+    AHCI_ID_QUEUE_DEPTH         = 75,
+    AHCI_ID_SATA_CAPABILITIES   = 76,
+    AHCI_ID_COMMAND_SETS        = 83,
+    AHCI_ID_LBA28_SECTORS       = 60,
+    AHCI_ID_LBA48_SECTORS       = 100,
+
+    AHCI_ID_QUEUE_DEPTH_MASK    = 0x1F,
+    AHCI_ID_SATA_NCQ            = 0x0100,
+    AHCI_ID_SET_LBA48           = 0x0400,
+};
+
+enum {
+    AHCI_HEADER_FIS_DWORDS      = 5,            // register H2D FIS
+    AHCI_HEADER_WRITE           = 0x0040,
+    AHCI_HEADER_PREFETCH        = 0x0080,
+    AHCI_HEADER_CLEAR_BUSY      = 0x0400,
+
+    AHCI_PRD_INTERRUPT          = 0x80000000,
+};
+
+// Command list entry, one per slot
+typedef struct{
+    uint16_t            Flags;
+    uint16_t            PrdtLength;
+    volatile uint32_t   PrdByteCount;
+    uint32_t            Table;
+    uint32_t            TableHigh;
+    uint32_t            Reserved[4];
+} __attribute__((packed)) AHCICommandHeader;
+
+typedef struct{
+    uint32_t Address;
+    uint32_t AddressHigh;
+    uint32_t Reserved;
+    uint32_t Info;                              // byte count - 1, interrupt bit
+} __attribute__((packed)) AHCIPrd;
+
+typedef struct{
+    uint8_t     Fis[64];
+    uint8_t     Atapi[16];
+    uint8_t     Reserved[48];
+    AHCIPrd     Prdt[AHCI_MAX_SEGMENTS];
+} __attribute__((packed, aligned(128))) AHCICommandTable;
+
+struct AHCIPort{
+    uintptr_t               Base;               // the port's registers
+    uint8_t                 Index;
+    uint32_t                SlotMask;           // slots usable with this disk
+    uint32_t                FreeSlots;
+    uint32_t                Outstanding;
+    AHCICommandHeader*      CommandList;
+    uint8_t*                ReceivedFis;
+    AHCICommandTable*       Tables;
+    AHCIRequest*            Requests[AHCI_MAX_SLOTS];
+    AHCIDisk*               Disk;
+    Spinlock                Lock;
+};
+
+static uintptr_t g_Abar;
+static uint32_t g_SlotCount;
+static bool g_HostNCQ;
+static bool g_Attached = false;
+static AHCIPort g_Ports[AHCI_MAX_PORTS];
+static uint32_t g_PortCount = 0;
+static AHCIDisk g_Disks[AHCI_MAX_PORTS];
+static uint32_t g_DiskCount = 0;
+static AHCIStats g_Stats;
+
+// Driver requests backing the block commands, one per usable slot
+static AHCIRequest g_BlockRequests[AHCI_MAX_PORTS][AHCI_MAX_SLOTS];
+static uint32_t g_BlockFree[AHCI_MAX_PORTS];
+
+// The HBA wants a 1 KiB aligned command list, a 256 byte FIS area and
+// 128 byte aligned tables. Memory is identity mapped, so the addresses go
+// to the controller as they are.
+static AHCICommandHeader g_CommandLists[AHCI_MAX_PORTS][AHCI_MAX_SLOTS] __attribute__((aligned(1024)));
+static uint8_t g_ReceivedFis[AHCI_MAX_PORTS][AHCI_FIS_AREA_SIZE] __attribute__((aligned(256)));
+static AHCICommandTable g_CommandTables[AHCI_MAX_PORTS][AHCI_MAX_SLOTS];
+static uint16_t g_IdentifyBuffer[256] __attribute__((aligned(16)));
+static uint8_t g_LogBuffers[AHCI_MAX_PORTS][AHCI_SECTOR_SIZE] __attribute__((aligned(16)));
+
+//
+// Register access
+//
+
+static uint32_t AHCI_ReadHost(uint32_t reg){
+    return *(volatile uint32_t*)(g_Abar + reg);
+}
+
+static void AHCI_WriteHost(uint32_t reg, uint32_t value){
+    *(volatile uint32_t*)(g_Abar + reg) = value;
+}
+
+static uint32_t AHCI_ReadPort(AHCIPort* port, uint32_t reg){
+    return *(volatile uint32_t*)(port->Base + reg);
+}
+
+static void AHCI_WritePort(AHCIPort* port, uint32_t reg, uint32_t value){
+    *(volatile uint32_t*)(port->Base + reg) = value;
+}
+
+// Waits until all bits of mask read as value; false on timeout
+static bool AHCI_PollPort(AHCIPort* port, uint32_t reg, uint32_t mask, uint32_t value){
+    uint64_t timeout = Clock_NowNs() + AHCI_POLL_TIMEOUT_NS;
+    while((AHCI_ReadPort(port, reg) & mask) != value){
+        if(Clock_NowNs() > timeout)
+            return false;
+        i686_pause();
+    }
+    return true;
+}
+
+static bool AHCI_StopPort(AHCIPort* port){
+    uint32_t cmd = AHCI_ReadPort(port, AHCI_PORT_CMD);
+    AHCI_WritePort(port, AHCI_PORT_CMD, cmd & ~AHCI_PORT_CMD_ST);
+    if(!AHCI_PollPort(port, AHCI_PORT_CMD, AHCI_PORT_CMD_CR, 0))
+        return false;
+
+    cmd = AHCI_ReadPort(port, AHCI_PORT_CMD);
+    AHCI_WritePort(port, AHCI_PORT_CMD, cmd & ~AHCI_PORT_CMD_FRE);
+    return AHCI_PollPort(port, AHCI_PORT_CMD, AHCI_PORT_CMD_FR, 0);
+}
+
+static bool AHCI_StartPort(AHCIPort* port){
+    AHCI_WritePort(port, AHCI_PORT_CMD, AHCI_ReadPort(port, AHCI_PORT_CMD) | AHCI_PORT_CMD_FRE);
+
+    // a device still busy from an error needs a COMRESET before ST may be set
+    if(!AHCI_PollPort(port, AHCI_PORT_TFD, AHCI_PORT_TFD_BSY | AHCI_PORT_TFD_DRQ, 0)){
+        AHCI_WritePort(port, AHCI_PORT_SCTL, AHCI_PORT_SCTL_DET_INIT);
+        uint64_t end = Clock_NowNs() + NS_PER_MS;
+        while(Clock_NowNs() < end)
+            i686_pause();
+        AHCI_WritePort(port, AHCI_PORT_SCTL, 0);
+        if(!AHCI_PollPort(port, AHCI_PORT_TFD, AHCI_PORT_TFD_BSY | AHCI_PORT_TFD_DRQ, 0))
+            return false;
+    }
+
+    AHCI_WritePort(port, AHCI_PORT_SERR, 0xFFFFFFFF);
+    AHCI_WritePort(port, AHCI_PORT_CMD, AHCI_ReadPort(port, AHCI_PORT_CMD) | AHCI_PORT_CMD_ST);
+    return true;
+}
+
+//
+// Command construction
+//
+
+static void AHCI_SetupFis(uint8_t* fis, uint8_t command, uint64_t lba, uint16_t count, uint16_t features){
+    for(int i = 0; i < 20; i++)
+        fis[i] = 0;
+
+    fis[0] = AHCI_FIS_REG_H2D;
+    fis[1] = AHCI_FIS_COMMAND;
+    fis[2] = command;
+    fis[3] = features & 0xFF;
+    fis[4] = lba & 0xFF;
+    fis[5] = (lba >> 8) & 0xFF;
+    fis[6] = (lba >> 16) & 0xFF;
+    fis[7] = AHCI_FIS_DEVICE_LBA;
+    fis[8] = (lba >> 24) & 0xFF;
+    fis[9] = (lba >> 32) & 0xFF;
+    fis[10] = (lba >> 40) & 0xFF;
+    fis[11] = features >> 8;
+    fis[12] = count & 0xFF;
+    fis[13] = count >> 8;
+}
+
+// Fills in the slot's header and PRD table from the request segments
+static void AHCI_SetupSlot(AHCIPort* port, uint32_t slot, AHCIRequest* request){
+    AHCICommandHeader* header = &port->CommandList[slot];
+    AHCICommandTable* table = &port->Tables[slot];
+
+    for(int i = 0; i < request->SegmentCount; i++){
+        table->Prdt[i].Address = (uint32_t)request->Segments[i].Buffer;
+        table->Prdt[i].AddressHigh = 0;
+        table->Prdt[i].Reserved = 0;
+        table->Prdt[i].Info = request->Segments[i].Length - 1;
+    }
+
+    header->Flags = AHCI_HEADER_FIS_DWORDS | AHCI_HEADER_CLEAR_BUSY
+                  | (request->Write ? AHCI_HEADER_WRITE | AHCI_HEADER_PREFETCH : 0);
+    header->PrdtLength = request->SegmentCount;
+    header->PrdByteCount = 0;
+    header->Table = (uint32_t)table;
+    header->TableHigh = 0;
+}
+
+static bool AHCI_ValidateRequest(AHCIDisk* disk, AHCIRequest* request){
+    if(request->Count == 0 || request->Count > AHCI_MAX_SECTORS)
+        return false;
+    if(request->Lba + request->Count > disk->SectorCount)
+        return false;
+    if(request->SegmentCount == 0 || request->SegmentCount > AHCI_MAX_SEGMENTS)
+        return false;
+
+    uint32_t bytes = 0;
+    for(int i = 0; i < request->SegmentCount; i++){
+        AHCISegment* segment = &request->Segments[i];
+        if(segment->Length == 0 || segment->Length > AHCI_PRD_MAX_BYTES)
+            return false;
+        if((segment->Length & 1) || ((uint32_t)segment->Buffer & 1))
+            return false;
+        bytes += segment->Length;
+    }
+    return bytes == request->Count * AHCI_SECTOR_SIZE;
+}
+
+bool AHCI_Submit(AHCIDisk* disk, AHCIRequest* request){
+    if(!AHCI_ValidateRequest(disk, request))
+        return false;
+
+    AHCIPort* port = disk->Port;
+    uint32_t flags = Spinlock_AcquireIrqSave(&port->Lock);
+
+    uint32_t free = port->FreeSlots & port->SlotMask;
+    if(free == 0){
+        Spinlock_ReleaseIrqRestore(&port->Lock, flags);
+        return false;
+    }
+
+    uint32_t slot = __builtin_ctz(free);
+    uint32_t bit = 1u << slot;
+    AHCI_SetupSlot(port, slot, request);
+
+    // queued commands carry the count in the features field and the tag
+    // in the count field
+    uint8_t* fis = port->Tables[slot].Fis;
+    if(disk->NCQ)
+        AHCI_SetupFis(fis,
+                      request->Write ? AHCI_CMD_WRITE_FPDMA_QUEUED : AHCI_CMD_READ_FPDMA_QUEUED,
+                      request->Lba, slot << 3, request->Count);
+    else
+        AHCI_SetupFis(fis,
+                      request->Write ? AHCI_CMD_WRITE_DMA_EXT : AHCI_CMD_READ_DMA_EXT,
+                      request->Lba, request->Count, 0);
+
+    request->Tag = slot;
+    request->Success = false;
+    port->Requests[slot] = request;
+    port->FreeSlots &= ~bit;
+    port->Outstanding |= bit;
+
+    if(disk->NCQ)
+        AHCI_WritePort(port, AHCI_PORT_SACT, bit);
+    AHCI_WritePort(port, AHCI_PORT_CI, bit);
+
+    g_Stats.Commands++;
+    g_Stats.Sectors += request->Count;
+    uint32_t outstanding = __builtin_popcount(port->Outstanding);
+    if(outstanding > g_Stats.MaxOutstanding)
+        g_Stats.MaxOutstanding = outstanding;
+
+    Spinlock_ReleaseIrqRestore(&port->Lock, flags);
+    return true;
+}
+
+//
+// Interrupts
+//
+
+// Polled, on a restarted port after an NCQ error: the drive has aborted
+// every queued command and accepts nothing else until the log is read.
+// Returns the tag of the command that failed, -1 if the log names none.
+// Slot 0 is borrowed, its FIS and first PRD are put back afterwards for
+// a requeue.
+static int AHCI_ReadNCQErrorTag(AHCIPort* port){
+    uint8_t* log = g_LogBuffers[port - g_Ports];
+    AHCIRequest request = {
+        .Count = 1,
+        .Segments = {{ log, AHCI_SECTOR_SIZE }},
+        .SegmentCount = 1,
+    };
+
+    AHCICommandHeader header = port->CommandList[0];
+    AHCIPrd prd = port->Tables[0].Prdt[0];
+    uint8_t fis[20];
+    for(int i = 0; i < 20; i++)
+        fis[i] = port->Tables[0].Fis[i];
+
+    AHCI_SetupSlot(port, 0, &request);
+    AHCI_SetupFis(port->Tables[0].Fis, AHCI_CMD_READ_LOG_EXT, AHCI_LOG_NCQ_ERROR, 1, 0);
+    AHCI_WritePort(port, AHCI_PORT_CI, 1);
+    bool success = AHCI_PollPort(port, AHCI_PORT_CI, 1, 0)
+                && !(AHCI_ReadPort(port, AHCI_PORT_TFD) & AHCI_PORT_TFD_ERR);
+    AHCI_WritePort(port, AHCI_PORT_IS, 0xFFFFFFFF);
+
+    port->CommandList[0] = header;
+    port->Tables[0].Prdt[0] = prd;
+    for(int i = 0; i < 20; i++)
+        port->Tables[0].Fis[i] = fis[i];
+
+    if(!success || (log[0] & AHCI_LOG_NCQ_NQ))
+        return -1;
+    return log[0] & AHCI_LOG_NCQ_TAG_MASK;
+}
+
+// Restarting the port, after a task file error or a timeout, drops every
+// command still in CI or SActive. Those in requeue are issued again from
+// their untouched command tables, the others are returned as failed.
+// After an NCQ error the log says which command failed, and the rest,
+// aborted by the drive along with it, are requeued. Called with the port
+// lock held.
+static uint32_t AHCI_RecoverPort(AHCIPort* port, uint32_t lost, uint32_t requeue, bool ncqError){
+    AHCI_StopPort(port);
+    AHCI_WritePort(port, AHCI_PORT_SERR, 0xFFFFFFFF);
+    AHCI_WritePort(port, AHCI_PORT_IS, 0xFFFFFFFF);
+    if(!AHCI_StartPort(port)){
+        printf("[AHCI] port %u: recovery failed\r\n", port->Index);
+        requeue = 0;
+    } else if(ncqError){
+        int tag = AHCI_ReadNCQErrorTag(port);
+        if(tag >= 0 && (lost & (1u << tag))){
+            printf("[AHCI] port %u: NCQ error on tag %u\r\n", port->Index, tag);
+            requeue = lost & ~(1u << tag);
+        }
+    }
+
+    requeue &= lost;
+    if(requeue != 0){
+        for(uint32_t slots = requeue; slots != 0; slots &= slots - 1)
+            port->CommandList[__builtin_ctz(slots)].PrdByteCount = 0;
+
+        if(port->Disk != NULL && port->Disk->NCQ)
+            AHCI_WritePort(port, AHCI_PORT_SACT, requeue);
+        AHCI_WritePort(port, AHCI_PORT_CI, requeue);
+        g_Stats.Requeued += __builtin_popcount(requeue);
+    }
+
+    uint32_t failed = lost & ~requeue;
+    g_Stats.Errors += __builtin_popcount(failed);
+    return failed;
+}
+
+// Completes whatever the port finished. With expired set, the request that
+// timed out, the port is reset if that request is still outstanding: it
+// fails and the other outstanding commands are requeued. With abort set,
+// everything outstanding fails. A task file error fails the command the
+// NCQ error log names, or everything outstanding without NCQ, where the
+// HBA does not say which command caused it. Interrupts must be disabled.
+static void AHCI_HandlePort(AHCIPort* port, AHCIRequest* expired, bool abort){
+    uint32_t status = AHCI_ReadPort(port, AHCI_PORT_IS);
+    AHCI_WritePort(port, AHCI_PORT_IS, status);
+
+    AHCIRequest* done[AHCI_MAX_SLOTS];
+    uint32_t doneCount = 0;
+
+    Spinlock_Acquire(&port->Lock);
+
+    // a slot is finished once the HBA cleared it from both CI and SActive;
+    // read before a reset, which clears both
+    uint32_t busy = AHCI_ReadPort(port, AHCI_PORT_SACT) | AHCI_ReadPort(port, AHCI_PORT_CI);
+    uint32_t finished = port->Outstanding & ~busy;
+    uint32_t lost = port->Outstanding & busy;
+
+    // the request may have completed in between, or even been reused
+    uint32_t timedOut = 0;
+    if(expired != NULL && port->Requests[expired->Tag] == expired)
+        timedOut = lost & (1u << expired->Tag);
+
+    bool ncq = port->Disk != NULL && port->Disk->NCQ;
+    uint32_t failed = 0;
+    if(status & AHCI_PORT_INT_ERRORS)
+        failed = AHCI_RecoverPort(port, lost, 0, ncq && (status & AHCI_PORT_INT_TFES));
+    else if(abort && lost != 0)
+        failed = AHCI_RecoverPort(port, lost, 0, false);
+    else if(timedOut != 0)
+        failed = AHCI_RecoverPort(port, lost, lost & ~timedOut, false);
+    finished |= failed;
+
+    while(finished != 0){
+        uint32_t slot = __builtin_ctz(finished);
+        finished &= finished - 1;
+
+        AHCIRequest* request = port->Requests[slot];
+        port->Requests[slot] = NULL;
+        port->Outstanding &= ~(1u << slot);
+        port->FreeSlots |= 1u << slot;
+
+        request->Success = !(failed & (1u << slot));
+        done[doneCount++] = request;
+    }
+
+    Spinlock_Release(&port->Lock);
+
+    // outside the lock, so callbacks can submit the next request
+    for(uint32_t i = 0; i < doneCount; i++){
+        if(done[i]->Callback != NULL)
+            done[i]->Callback(done[i]);
+    }
+}
+
+static void AHCI_HandleInterrupt(){
+    uint32_t pending = AHCI_ReadHost(AHCI_REG_IS);
+    if(pending == 0)
+        return;
+
+    g_Stats.Interrupts++;
+    for(uint32_t i = 0; i < g_PortCount; i++){
+        if(pending & (1u << g_Ports[i].Index))
+            AHCI_HandlePort(&g_Ports[i], NULL, false);
+    }
+
+    // port status first, then the host bit, or the interrupt fires again
+    AHCI_WriteHost(AHCI_REG_IS, pending);
+}
+
+static void AHCI_IRQ(Registers* regs){
+    AHCI_HandleInterrupt();
+}
+
+static void AHCI_MSI(Registers* regs){
+    AHCI_HandleInterrupt();
+    i686_LAPIC_SendEOI();
+}
+
+//
+// Synchronous wrappers
+//
+
+static void AHCI_CompleteSync(AHCIRequest* request){
+    Completion_Signal((Completion*)request->Context);
+}
+
+static bool AHCI_Transfer(AHCIDisk* disk, uint64_t lba, uint32_t count, void* buffer, bool write){
+    uint8_t* data = (uint8_t*)buffer;
+    Completion done;
+    AHCIRequest request;
+
+    while(count > 0){
+        uint32_t chunk = count;
+        if(chunk > AHCI_PRD_MAX_BYTES / AHCI_SECTOR_SIZE)
+            chunk = AHCI_PRD_MAX_BYTES / AHCI_SECTOR_SIZE;
+
+        request.Lba = lba;
+        request.Count = chunk;
+        request.Write = write;
+        request.Segments[0].Buffer = data;
+        request.Segments[0].Length = chunk * AHCI_SECTOR_SIZE;
+        request.SegmentCount = 1;
+        request.Callback = AHCI_CompleteSync;
+        request.Context = &done;
+
+        Completion_Initialize(&done);
+        while(!AHCI_Submit(disk, &request)){
+            if(!AHCI_ValidateRequest(disk, &request))
+                return false;
+            Scheduler_Yield();
+        }
+
+        if(!Completion_Wait(&done, AHCI_TIMEOUT_NS)){
+            // the request lives on our stack, the port must let go of it
+            printf("[AHCI] port %u: command timeout\r\n", disk->Port->Index);
+            uint32_t flags = i686_irqsave();
+            AHCI_HandlePort(disk->Port, &request, false);
+            i686_irqrestore(flags);
+        }
+        if(!request.Success)
+            return false;
+
+        lba += chunk;
+        count -= chunk;
+        data += chunk * AHCI_SECTOR_SIZE;
+    }
+    return true;
+}
+
+bool AHCI_ReadSectors(AHCIDisk* disk, uint64_t lba, uint32_t count, void* buffer){
+    return AHCI_Transfer(disk, lba, count, buffer, false);
+}
+
+bool AHCI_WriteSectors(AHCIDisk* disk, uint64_t lba, uint32_t count, const void* buffer){
+    return AHCI_Transfer(disk, lba, count, (void*)buffer, true);
+}
+
+void AHCI_Abort(AHCIDisk* disk){
+    uint32_t flags = i686_irqsave();
+    AHCI_HandlePort(disk->Port, NULL, true);
+    i686_irqrestore(flags);
+}
+
+//
+// Detection
+//
+
+// Polled, before the port interrupts are enabled
+static bool AHCI_Identify(AHCIPort* port){
+    AHCIRequest request = {
+        .Count = 1,
+        .Segments = {{ g_IdentifyBuffer, sizeof(g_IdentifyBuffer) }},
+        .SegmentCount = 1,
+    };
+
+    AHCI_SetupSlot(port, 0, &request);
+    AHCI_SetupFis(port->Tables[0].Fis, AHCI_CMD_IDENTIFY, 0, 0, 0);
+    AHCI_WritePort(port, AHCI_PORT_IS, 0xFFFFFFFF);
+    AHCI_WritePort(port, AHCI_PORT_CI, 1);
+
+    if(!AHCI_PollPort(port, AHCI_PORT_CI, 1, 0))
+        return false;
+    return !(AHCI_ReadPort(port, AHCI_PORT_TFD) & AHCI_PORT_TFD_ERR);
+}
+
+static void AHCI_SetupDisk(AHCIPort* port){
+    uint16_t* id = g_IdentifyBuffer;
+    if(!AHCI_Identify(port) || !(id[AHCI_ID_COMMAND_SETS] & AHCI_ID_SET_LBA48)){
+        printf("[AHCI] port %u: IDENTIFY failed\r\n", port->Index);
+        return;
+    }
+
+    AHCIDisk* disk = &g_Disks[g_DiskCount++];
+    disk->Port = port;
+    disk->Index = port->Index;
+    disk->SectorCount = (uint64_t)id[AHCI_ID_LBA48_SECTORS]
+                      | ((uint64_t)id[AHCI_ID_LBA48_SECTORS + 1] << 16)
+                      | ((uint64_t)id[AHCI_ID_LBA48_SECTORS + 2] << 32)
+                      | ((uint64_t)id[AHCI_ID_LBA48_SECTORS + 3] << 48);
+
+    // NCQ needs both sides; the drive reports its depth minus one
+    disk->NCQ = g_HostNCQ && (id[AHCI_ID_SATA_CAPABILITIES] & AHCI_ID_SATA_NCQ);
+    disk->QueueDepth = g_SlotCount;
+    if(disk->NCQ){
+        uint32_t depth = (id[AHCI_ID_QUEUE_DEPTH] & AHCI_ID_QUEUE_DEPTH_MASK) + 1;
+        if(depth < disk->QueueDepth)
+            disk->QueueDepth = depth;
+    }
+    port->SlotMask = disk->QueueDepth == 32 ? 0xFFFFFFFF : (1u << disk->QueueDepth) - 1;
+    port->Disk = disk;
+
+    // the model string is stored with the bytes of each word swapped
+    int i;
+    for(i = 0; i < AHCI_MODEL_SIZE - 1; i += 2){
+        disk->Model[i] = id[AHCI_ID_MODEL + i / 2] >> 8;
+        disk->Model[i + 1] = id[AHCI_ID_MODEL + i / 2] & 0xFF;
+    }
+    for(i = AHCI_MODEL_SIZE - 1; i > 0 && (disk->Model[i - 1] == ' ' || disk->Model[i - 1] == '\0'); i--);
+    disk->Model[i] = '\0';
+
+    printf("[AHCI] port %u: %s, %llu sectors, %s, queue depth %u\r\n",
+           port->Index, disk->Model, disk->SectorCount,
+           disk->NCQ ? "NCQ" : "no NCQ", disk->QueueDepth);
+}
+
+static void AHCI_SetupPort(uint8_t index){
+    if(g_PortCount == AHCI_MAX_PORTS)
+        return;
+
+    AHCIPort* port = &g_Ports[g_PortCount];
+    port->Base = g_Abar + AHCI_PORT_BASE + index * AHCI_PORT_SIZE;
+    port->Index = index;
+
+    if((AHCI_ReadPort(port, AHCI_PORT_SSTS) & AHCI_PORT_SSTS_DET_MASK) != AHCI_PORT_SSTS_DET_PRESENT)
+        return;
+    if(AHCI_ReadPort(port, AHCI_PORT_SIG) != AHCI_SIGNATURE_ATA)
+        return;
+
+    if(!AHCI_StopPort(port)){
+        printf("[AHCI] port %u: does not stop\r\n", index);
+        return;
+    }
+
+    port->CommandList = g_CommandLists[g_PortCount];
+    port->ReceivedFis = g_ReceivedFis[g_PortCount];
+    port->Tables = g_CommandTables[g_PortCount];
+    port->FreeSlots = g_SlotCount == 32 ? 0xFFFFFFFF : (1u << g_SlotCount) - 1;
+    port->SlotMask = port->FreeSlots;
+    port->Outstanding = 0;
+    port->Disk = NULL;
+    Spinlock_Initialize(&port->Lock, "ahci port");
+
+    AHCI_WritePort(port, AHCI_PORT_CLB, (uint32_t)port->CommandList);
+    AHCI_WritePort(port, AHCI_PORT_CLBU, 0);
+    AHCI_WritePort(port, AHCI_PORT_FB, (uint32_t)port->ReceivedFis);
+    AHCI_WritePort(port, AHCI_PORT_FBU, 0);
+    AHCI_WritePort(port, AHCI_PORT_IE, 0);
+    AHCI_WritePort(port, AHCI_PORT_IS, 0xFFFFFFFF);
+
+    if(!AHCI_StartPort(port)){
+        printf("[AHCI] port %u: does not start\r\n", index);
+        return;
+    }
+
+    g_PortCount++;
+    AHCI_SetupDisk(port);
+    AHCI_WritePort(port, AHCI_PORT_IS, 0xFFFFFFFF);
+    AHCI_WritePort(port, AHCI_PORT_IE, AHCI_PORT_INT_DEFAULT);
+}
+
+//
+// Block layer
+//
+
+static void AHCI_BlockDone(AHCIRequest* request){
+    BlockCommand* command = (BlockCommand*)request->Context;
+    AHCIDisk* disk = (AHCIDisk*)command->Device->DriverData;
+    uint32_t index = disk - g_Disks;
+
+    uint32_t flags = i686_irqsave();
+    g_BlockFree[index] |= 1u << (request - g_BlockRequests[index]);
+    i686_irqrestore(flags);
+
+    Block_Complete(command, request->Success);
+}
+
+static bool AHCI_BlockSubmit(BlockDevice* device, BlockCommand* command){
+    AHCIDisk* disk = (AHCIDisk*)device->DriverData;
+    uint32_t index = disk - g_Disks;
+
+    uint32_t flags = i686_irqsave();
+    if(g_BlockFree[index] == 0){
+        i686_irqrestore(flags);
+        return false;
+    }
+    uint32_t slot = __builtin_ctz(g_BlockFree[index]);
+    g_BlockFree[index] &= ~(1u << slot);
+    i686_irqrestore(flags);
+
+    AHCIRequest* request = &g_BlockRequests[index][slot];
+    request->Lba = command->Lba;
+    request->Count = command->Count;
+    request->Write = command->Write;
+    request->SegmentCount = command->SegmentCount;
+    for(int i = 0; i < command->SegmentCount; i++){
+        request->Segments[i].Buffer = command->Segments[i].Buffer;
+        request->Segments[i].Length = command->Segments[i].Length;
+    }
+    request->Callback = AHCI_BlockDone;
+    request->Context = command;
+
+    if(!AHCI_Submit(disk, request)){
+        flags = i686_irqsave();
+        g_BlockFree[index] |= 1u << slot;
+        i686_irqrestore(flags);
+        return false;
+    }
+    return true;
+}
+
+static const BlockDriver g_AHCIBlockDriver = {
+    .Name = "ahci",
+    .Submit = AHCI_BlockSubmit,
+    .Kick = NULL,
+    .MaxSectors = AHCI_PRD_MAX_BYTES / AHCI_SECTOR_SIZE,
+    .MaxSegments = AHCI_MAX_SEGMENTS < BLOCK_MAX_SEGMENTS ? AHCI_MAX_SEGMENTS : BLOCK_MAX_SEGMENTS,
+};
+
+static void AHCI_RegisterBlockDevices(){
+    for(uint32_t i = 0; i < g_DiskCount; i++){
+        AHCIDisk* disk = &g_Disks[i];
+        char name[] = "sda";
+        name[2] += i;
+
+        g_BlockFree[i] = disk->QueueDepth == 32 ? 0xFFFFFFFF : (1u << disk->QueueDepth) - 1;
+        Block_RegisterDisk(name, disk->SectorCount, disk->QueueDepth, &g_AHCIBlockDriver, disk);
+    }
+}
+
+static bool AHCI_Attach(PCIDevice* device){
+    if(g_Attached || device->Bars[AHCI_BAR_ABAR].IO || device->Bars[AHCI_BAR_ABAR].Size == 0)
+        return false;
+
+    PCI_Enable(device, PCI_COMMAND_MEMORY | PCI_COMMAND_BUS_MASTER);
+    g_Abar = device->Bars[AHCI_BAR_ABAR].Base;
+
+    // reset the HBA into a known state, then switch it to AHCI mode
+    AHCI_WriteHost(AHCI_REG_GHC, AHCI_ReadHost(AHCI_REG_GHC) | AHCI_GHC_AE);
+    AHCI_WriteHost(AHCI_REG_GHC, AHCI_ReadHost(AHCI_REG_GHC) | AHCI_GHC_HR);
+    uint64_t timeout = Clock_NowNs() + AHCI_POLL_TIMEOUT_NS;
+    while(AHCI_ReadHost(AHCI_REG_GHC) & AHCI_GHC_HR){
+        if(Clock_NowNs() > timeout){
+            printf("[AHCI] HBA reset timeout\r\n");
+            return false;
+        }
+        i686_pause();
+    }
+    AHCI_WriteHost(AHCI_REG_GHC, AHCI_GHC_AE);
+
+    uint32_t cap = AHCI_ReadHost(AHCI_REG_CAP);
+    uint32_t version = AHCI_ReadHost(AHCI_REG_VS);
+    g_SlotCount = ((cap >> AHCI_CAP_NCS_SHIFT) & AHCI_CAP_NCS_MASK) + 1;
+    g_HostNCQ = (cap & AHCI_CAP_SNCQ) != 0;
+
+    printf("[AHCI] version %u.%u, %u slots%s\r\n",
+           version >> 16, (version >> 8) & 0xFF, g_SlotCount, g_HostNCQ ? ", NCQ" : "");
+
+    uint32_t implemented = AHCI_ReadHost(AHCI_REG_PI);
+    for(uint8_t i = 0; i < 32; i++){
+        if(implemented & (1u << i))
+            AHCI_SetupPort(i);
+    }
+
+    // MSI when the local APIC is up, the legacy line otherwise
+    uint8_t vector = 0;
+    if(i686_LAPIC_IsEnabled())
+        vector = PCI_EnableMSI(device, i686_LAPIC_GetID());
+
+    if(vector != 0){
+        i686_ISR_RegisterHandler(vector, AHCI_MSI);
+    } else {
+        i686_IRQ_RegisterHandler(device->InterruptLine, AHCI_IRQ);
+        i686_IRQ_Unmask(device->InterruptLine);
+    }
+
+    AHCI_WriteHost(AHCI_REG_IS, 0xFFFFFFFF);
+    AHCI_WriteHost(AHCI_REG_GHC, AHCI_GHC_AE | AHCI_GHC_IE);
+
+    g_Attached = true;
+    AHCI_RegisterBlockDevices();
+    return true;
+}
+
+static const PCIDriver g_AHCIDriver = {
+    .Name = "ahci",
+    .VendorId = PCI_ANY_ID,
+    .DeviceId = PCI_ANY_ID,
+    .Class = PCI_CLASS_STORAGE,
+    .Subclass = PCI_SUBCLASS_SATA,
+    .ProgIF = PCI_ANY_CLASS,
+    .Attach = AHCI_Attach,
+};
+
+void AHCI_Initialize(){
+    PCI_RegisterDriver(&g_AHCIDriver);
+}
+
+uint32_t AHCI_GetDiskCount(){
+    return g_DiskCount;
+}
+
+AHCIDisk* AHCI_GetDisk(uint32_t index){
+    return index < g_DiskCount ? &g_Disks[index] : NULL;
+}
+
+void AHCI_GetStats(AHCIStats* stats){
+    uint32_t flags = i686_irqsave();
+    *stats = g_Stats;
+    i686_irqrestore(flags);
+}
+
+void AHCI_PrintStats(){
+    AHCIStats stats;
+    AHCI_GetStats(&stats);
+
+    printf("===== AHCI STATS =====\r\n");
+    printf("commands=%llu sectors=%llu\r\n", stats.Commands, stats.Sectors);
+    printf("interrupts=%llu max outstanding=%u\r\n", stats.Interrupts, stats.MaxOutstanding);
+    printf("errors=%llu requeued=%llu\r\n", stats.Errors, stats.Requeued);
+    printf("======================\r\n");
+}
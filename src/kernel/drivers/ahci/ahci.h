@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AHCI_SECTOR_SIZE            512
+#define AHCI_MAX_PORTS              4
+#define AHCI_MAX_SLOTS              32
+#define AHCI_MAX_SEGMENTS           8
+#define AHCI_MODEL_SIZE             41
+
+typedef struct AHCIPort AHCIPort;
+typedef struct AHCIRequest AHCIRequest;
+
+// Runs from the port interrupt once the request is done
+typedef void (*AHCICallback)(AHCIRequest* request);
+
+typedef struct{
+    void*       Buffer;                 // 2 byte aligned
+    uint32_t    Length;                 // bytes, even
+} AHCISegment;
+
+struct AHCIRequest{
+    uint64_t        Lba;
+    uint32_t        Count;              // sectors, must match the segments
+    bool            Write;
+    AHCISegment     Segments[AHCI_MAX_SEGMENTS];
+    uint8_t         SegmentCount;
+    AHCICallback    Callback;
+    void*           Context;
+
+    // set by the driver
+    bool            Success;
+    uint8_t         Tag;
+};
+
+typedef struct{
+    AHCIPort*   Port;
+    uint8_t     Index;
+    bool        NCQ;
+    uint8_t     QueueDepth;             // commands that may be outstanding
+    uint64_t    SectorCount;
+    char        Model[AHCI_MODEL_SIZE];
+} AHCIDisk;
+
+typedef struct{
+    uint64_t Commands;
+    uint64_t Sectors;
+    uint64_t Interrupts;
+    uint64_t Errors;
+    uint64_t Requeued;                  // reissued after another command's timeout
+    uint32_t MaxOutstanding;
+} AHCIStats;
+
+// Registers the PCI driver for AHCI controllers, e.g. QEMU's ich9-ahci
+void AHCI_Initialize();
+
+uint32_t AHCI_GetDiskCount();
+AHCIDisk* AHCI_GetDisk(uint32_t index);
+
+// Queues the request; false if all command slots are busy or the request
+// is invalid. Callable from interrupt handlers.
+bool AHCI_Submit(AHCIDisk* disk, AHCIRequest* request);
+
+// Synchronous helpers for a single contiguous buffer, from a thread
+bool AHCI_ReadSectors(AHCIDisk* disk, uint64_t lba, uint32_t count, void* buffer);
+bool AHCI_WriteSectors(AHCIDisk* disk, uint64_t lba, uint32_t count, const void* buffer);
+
+// Resets the port under whatever the disk still has outstanding; those
+// requests complete as failed before this returns, the finished ones as
+// usual. For a caller that stops waiting on its requests.
+void AHCI_Abort(AHCIDisk* disk);
+
+void AHCI_GetStats(AHCIStats* stats);
+void AHCI_PrintStats();
+void AHCI_RunBenchmarks();
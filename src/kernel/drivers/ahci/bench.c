@@ -0,0 +1,143 @@
+#include "ahci.h"
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define BENCH_REQUESTS              2000
+#define BENCH_BLOCK_SIZE            4096
+
+// Random 4 KiB reads with a fixed number of them always in flight. Every
+// completion submits the next one straight from the interrupt, so the
+// queue never drains while the sweep point runs.
+typedef struct{
+    AHCIRequest Request;
+    uint64_t    Submitted;
+} BenchSlot;
+
+static BenchSlot g_Slots[AHCI_MAX_SLOTS];
+static uint8_t g_Buffers[AHCI_MAX_SLOTS][BENCH_BLOCK_SIZE] __attribute__((aligned(4096)));
+
+static AHCIDisk* g_Disk;
+static uint32_t g_Seed;
+static uint32_t g_Blocks;
+static volatile uint32_t g_Issued;
+static volatile uint32_t g_Completed;
+static volatile uint32_t g_Failed;
+static volatile uint32_t g_InFlight;
+static uint64_t g_LatencyTotal;
+static uint64_t g_LatencyMax;
+static Completion g_Done;
+
+static uint32_t Bench_Random(uint32_t* state){
+    *state = *state * 1664525 + 1013904223;
+    return *state;
+}
+
+static void Bench_Complete(AHCIRequest* request);
+
+// Interrupts disabled: called from the submitting thread with them off and
+// from the completion callback
+static void Bench_Issue(BenchSlot* slot){
+    uint32_t sectors = BENCH_BLOCK_SIZE / AHCI_SECTOR_SIZE;
+
+    slot->Request.Lba = (uint64_t)(Bench_Random(&g_Seed) % g_Blocks) * sectors;
+    slot->Request.Count = sectors;
+    slot->Request.Write = false;
+    slot->Request.SegmentCount = 1;
+    slot->Request.Callback = Bench_Complete;
+    slot->Request.Context = slot;
+    slot->Submitted = i686_rdtsc();
+
+    g_Issued++;
+    g_InFlight++;
+    if(!AHCI_Submit(g_Disk, &slot->Request)){
+        g_Failed++;
+        g_InFlight--;
+    }
+}
+
+static void Bench_Complete(AHCIRequest* request){
+    BenchSlot* slot = (BenchSlot*)request->Context;
+
+    uint64_t cycles = i686_rdtsc() - slot->Submitted;
+    g_LatencyTotal += cycles;
+    if(cycles > g_LatencyMax)
+        g_LatencyMax = cycles;
+
+    if(!request->Success)
+        g_Failed++;
+    g_Completed++;
+    g_InFlight--;
+
+    if(g_Issued < BENCH_REQUESTS)
+        Bench_Issue(slot);
+    if(g_InFlight == 0)
+        Completion_Signal(&g_Done);
+}
+
+static void Bench_QueueDepth(uint32_t depth){
+    g_Seed = 12345;
+    g_Issued = 0;
+    g_Completed = 0;
+    g_Failed = 0;
+    g_InFlight = 0;
+    g_LatencyTotal = 0;
+    g_LatencyMax = 0;
+    Completion_Initialize(&g_Done);
+
+    uint64_t start = i686_rdtsc();
+
+    uint32_t flags = i686_irqsave();
+    for(uint32_t i = 0; i < depth; i++)
+        Bench_Issue(&g_Slots[i]);
+    bool idle = g_InFlight == 0;
+    i686_irqrestore(flags);
+
+    if(!idle && !Completion_Wait(&g_Done, 30 * NS_PER_SEC)){
+        printf("[BENCH] ahci qd%u: timeout\r\n", depth);
+
+        // the slots still in flight hold g_Slots and g_Buffers, which the
+        // next depth reuses: stop reissuing and take them back first
+        flags = i686_irqsave();
+        g_Issued = BENCH_REQUESTS;
+        AHCI_Abort(g_Disk);
+        i686_irqrestore(flags);
+        return;
+    }
+
+    uint64_t ns = Clock_CyclesToNs(i686_rdtsc() - start);
+    uint32_t completed = g_Completed;
+    if(completed == 0 || g_Failed != 0){
+        printf("[BENCH] ahci qd%u: %u errors\r\n", depth, g_Failed);
+        return;
+    }
+
+    printf("[BENCH] ahci qd%u: %llu IOPS, %llu KiB/s, latency avg=%lluus max=%lluus\r\n",
+           depth,
+           ns ? (uint64_t)completed * NS_PER_SEC / ns : 0,
+           ns ? (uint64_t)completed * BENCH_BLOCK_SIZE * NS_PER_SEC / ns / 1024 : 0,
+           Clock_CyclesToNs(g_LatencyTotal / completed) / NS_PER_US,
+           Clock_CyclesToNs(g_LatencyMax) / NS_PER_US);
+}
+
+void AHCI_RunBenchmarks(){
+    g_Disk = AHCI_GetDisk(0);
+    if(g_Disk == NULL){
+        printf("[BENCH] ahci: no disk\r\n");
+        return;
+    }
+
+    g_Blocks = g_Disk->SectorCount / (BENCH_BLOCK_SIZE / AHCI_SECTOR_SIZE);
+    for(uint32_t i = 0; i < AHCI_MAX_SLOTS; i++){
+        g_Slots[i].Request.Segments[0].Buffer = g_Buffers[i];
+        g_Slots[i].Request.Segments[0].Length = BENCH_BLOCK_SIZE;
+    }
+
+    // QD1, 2, 4 ... up to what the disk accepts
+    for(uint32_t depth = 1; depth <= g_Disk->QueueDepth; depth *= 2)
+        Bench_QueueDepth(depth);
+
+    AHCI_PrintStats();
+}
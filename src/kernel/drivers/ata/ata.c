@@ -0,0 +1,668 @@
+#include "ata.h"
+#include <drivers/pci/pci.h>
+#include <block/block.h>
+#include <arch/i686/interrupts/irq.h>
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <sched/scheduler.h>
+#include <sched/workqueue.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define ATA_CHANNEL_COUNT           2
+#define ATA_TIMEOUT_NS              (5 * NS_PER_SEC)
+#define ATA_POLL_TIMEOUT_NS         (1 * NS_PER_SEC)
+
+#define ATA_PRIMARY_IO              0x1F0
+#define ATA_PRIMARY_CONTROL         0x3F6
+#define ATA_PRIMARY_IRQ             14
+#define ATA_SECONDARY_IO            0x170
+#define ATA_SECONDARY_CONTROL       0x376
+#define ATA_SECONDARY_IRQ           15
+
+#define ATA_PROGIF_PRIMARY_NATIVE   0x01
+#define ATA_PROGIF_SECONDARY_NATIVE 0x04
+#define ATA_BAR_BUS_MASTER          4
+
+#define ATA_PRD_MAX                 8
+#define ATA_PRD_MAX_BYTES           0x10000
+#define ATA_PRD_END_OF_TABLE        0x8000
+
+enum {
+    ATA_REG_DATA                = 0,
+    ATA_REG_ERROR               = 1,
+    ATA_REG_SECTOR_COUNT        = 2,
+    ATA_REG_LBA0                = 3,
+    ATA_REG_LBA1                = 4,
+    ATA_REG_LBA2                = 5,
+    ATA_REG_DRIVE               = 6,
+    ATA_REG_STATUS              = 7,
+    ATA_REG_COMMAND             = 7,
+};
+
+enum {
+    ATA_STATUS_ERR              = 0x01,
+    ATA_STATUS_DRQ              = 0x08,
+    ATA_STATUS_DF               = 0x20,
+    ATA_STATUS_DRDY             = 0x40,
+    ATA_STATUS_BSY              = 0x80,
+};
+
+enum {
+    ATA_CONTROL_NIEN            = 0x02,
+};
+
+enum {
+    ATA_DRIVE_LBA               = 0x40,
+    ATA_DRIVE_LEGACY            = 0xA0,
+    ATA_DRIVE_SLAVE             = 0x10,
+};
+
+enum {
+    ATA_CMD_READ_SECTORS        = 0x20,
+    ATA_CMD_READ_SECTORS_EXT    = 0x24,
+    ATA_CMD_READ_DMA_EXT        = 0x25,
+    ATA_CMD_WRITE_SECTORS       = 0x30,
+    ATA_CMD_WRITE_SECTORS_EXT   = 0x34,
+    ATA_CMD_WRITE_DMA_EXT       = 0x35,
+    ATA_CMD_READ_DMA            = 0xC8,
+    ATA_CMD_WRITE_DMA           = 0xCA,
+    ATA_CMD_FLUSH_CACHE         = 0xE7,
+    ATA_CMD_FLUSH_CACHE_EXT     = 0xEA,
+    ATA_CMD_IDENTIFY            = 0xEC,
+};
+
+// Bus master IDE registers, relative to the channel's part of BAR4
+enum {
+    ATA_BM_COMMAND              = 0,
+    ATA_BM_STATUS               = 2,
+    ATA_BM_PRDT                 = 4,
+    ATA_BM_CHANNEL_SIZE         = 8,
+};
+
+enum {
+    ATA_BM_COMMAND_START        = 0x01,
+    ATA_BM_COMMAND_TO_MEMORY    = 0x08,
+
+    ATA_BM_STATUS_ACTIVE        = 0x01,
+    ATA_BM_STATUS_ERROR         = 0x02,
+    ATA_BM_STATUS_IRQ           = 0x04,
+};
+
+// IDENTIFY words
+enum {
+    ATA_ID_MODEL                = 27,
+    ATA_ID_CAPABILITIES         = 49,
+    ATA_ID_LBA28_SECTORS        = 60,
+    ATA_ID_COMMAND_SETS         = 83,
+    ATA_ID_LBA48_SECTORS        = 100,
+
+    ATA_ID_CAP_DMA              = 0x0100,
+    ATA_ID_CAP_LBA              = 0x0200,
+    ATA_ID_SET_LBA48            = 0x0400,
+};
+
+// Physical Region Descriptor: one piece of a DMA transfer, which must not
+// cross a 64 KiB boundary. A byte count of 0 means 64 KiB.
+typedef struct{
+    uint32_t Address;
+    uint16_t ByteCount;
+    uint16_t Flags;
+} __attribute__((packed)) PRD;
+
+struct ATAChannel{
+    uint16_t            IOBase;
+    uint16_t            ControlBase;
+    uint16_t            BusMasterBase;          // 0 without bus mastering
+    uint8_t             Irq;
+    uint8_t             SelectedDrive;
+    volatile uint32_t   Busy;
+    volatile bool       Active;                 // an interrupt is expected
+    uint8_t             Status;                 // latched by the interrupt handler
+    uint8_t             BusMasterStatus;
+    Completion          Done;
+    PRD*                Prdt;
+};
+
+static ATAChannel g_Channels[ATA_CHANNEL_COUNT];
+static ATADrive g_Drives[ATA_MAX_DRIVES];
+static uint32_t g_DriveCount = 0;
+static bool g_Attached = false;
+static bool g_DMAEnabled = true;
+static bool g_SharedIrq = false;             // native mode, both channels on the PCI line
+static ATAStats g_Stats;
+
+// The transfers sleep, so block commands run on a worker thread, one per
+// drive at a time
+static WorkQueue g_BlockQueue;
+static Work g_BlockWork[ATA_MAX_DRIVES];
+static BlockCommand* volatile g_BlockCommands[ATA_MAX_DRIVES];
+
+// one 4 KiB aligned table per channel never crosses a 64 KiB boundary
+static PRD g_Prdt[ATA_CHANNEL_COUNT][ATA_PRD_MAX] __attribute__((aligned(4096)));
+
+//
+// Low level register access
+//
+
+static uint8_t ATA_AltStatus(ATAChannel* channel){
+    return i686_inb(channel->ControlBase);
+}
+
+// Reading the alternate status four times gives the drive the 400ns it
+// needs to update its status after a drive select or command
+static void ATA_Delay400(ATAChannel* channel){
+    for(int i = 0; i < 4; i++)
+        ATA_AltStatus(channel);
+}
+
+static bool ATA_PollNotBusy(ATAChannel* channel){
+    uint64_t timeout = Clock_NowNs() + ATA_POLL_TIMEOUT_NS;
+    while(ATA_AltStatus(channel) & ATA_STATUS_BSY){
+        if(Clock_NowNs() > timeout)
+            return false;
+        i686_pause();
+    }
+    return true;
+}
+
+static bool ATA_PollDataRequest(ATAChannel* channel){
+    uint64_t timeout = Clock_NowNs() + ATA_POLL_TIMEOUT_NS;
+    for(;;){
+        uint8_t status = ATA_AltStatus(channel);
+        if(status & (ATA_STATUS_ERR | ATA_STATUS_DF))
+            return false;
+        if(!(status & ATA_STATUS_BSY) && (status & ATA_STATUS_DRQ))
+            return true;
+        if(Clock_NowNs() > timeout)
+            return false;
+        i686_pause();
+    }
+}
+
+static void ATA_SelectDrive(ATAChannel* channel, uint8_t value){
+    if(channel->SelectedDrive == value)
+        return;
+
+    i686_outb(channel->IOBase + ATA_REG_DRIVE, value);
+    ATA_Delay400(channel);
+    channel->SelectedDrive = value;
+}
+
+// Loads the task file. With LBA48 every register is a two deep FIFO,
+// written high byte first.
+static void ATA_SetupTaskFile(ATADrive* drive, uint64_t lba, uint32_t count){
+    ATAChannel* channel = drive->Channel;
+    uint16_t io = channel->IOBase;
+    uint8_t slave = drive->Index ? ATA_DRIVE_SLAVE : 0;
+
+    if(drive->LBA48){
+        ATA_SelectDrive(channel, ATA_DRIVE_LEGACY | ATA_DRIVE_LBA | slave);
+        i686_outb(io + ATA_REG_SECTOR_COUNT, (count >> 8) & 0xFF);
+        i686_outb(io + ATA_REG_LBA0, (lba >> 24) & 0xFF);
+        i686_outb(io + ATA_REG_LBA1, (lba >> 32) & 0xFF);
+        i686_outb(io + ATA_REG_LBA2, (lba >> 40) & 0xFF);
+    } else {
+        // the top 4 LBA bits live in the drive register
+        channel->SelectedDrive = 0xFF;
+        ATA_SelectDrive(channel, ATA_DRIVE_LEGACY | ATA_DRIVE_LBA | slave | ((lba >> 24) & 0x0F));
+    }
+
+    // a count of 256 is written as 0
+    i686_outb(io + ATA_REG_SECTOR_COUNT, count & 0xFF);
+    i686_outb(io + ATA_REG_LBA0, lba & 0xFF);
+    i686_outb(io + ATA_REG_LBA1, (lba >> 8) & 0xFF);
+    i686_outb(io + ATA_REG_LBA2, (lba >> 16) & 0xFF);
+}
+
+//
+// Interrupts
+//
+
+static void ATA_HandleInterrupt(ATAChannel* channel){
+    uint8_t busMasterStatus = 0;
+    if(channel->BusMasterBase != 0)
+        busMasterStatus = i686_inb(channel->BusMasterBase + ATA_BM_STATUS);
+
+    // on a shared line the bus master status tells whether it was us
+    if(g_SharedIrq && channel->BusMasterBase != 0 && !(busMasterStatus & ATA_BM_STATUS_IRQ))
+        return;
+
+    // reading the status register acknowledges the drive's interrupt
+    uint8_t status = i686_inb(channel->IOBase + ATA_REG_STATUS);
+
+    if(channel->BusMasterBase != 0)
+        i686_outb(channel->BusMasterBase + ATA_BM_STATUS, busMasterStatus);
+
+    if(!channel->Active)
+        return;
+
+    g_Stats.Interrupts++;
+    channel->Status = status;
+    channel->BusMasterStatus = busMasterStatus;
+    Completion_Signal(&channel->Done);
+}
+
+static void ATA_PrimaryIRQ(Registers* regs){
+    ATA_HandleInterrupt(&g_Channels[0]);
+    if(g_SharedIrq)
+        ATA_HandleInterrupt(&g_Channels[1]);
+}
+
+static void ATA_SecondaryIRQ(Registers* regs){
+    ATA_HandleInterrupt(&g_Channels[1]);
+}
+
+// Waits for the next interrupt of the channel; false on timeout or error
+static bool ATA_WaitInterrupt(ATAChannel* channel){
+    if(!Completion_Wait(&channel->Done, ATA_TIMEOUT_NS)){
+        g_Stats.Timeouts++;
+        return false;
+    }
+    return !(channel->Status & (ATA_STATUS_ERR | ATA_STATUS_DF));
+}
+
+//
+// Transfers
+//
+
+// Only one command per channel at a time: master and slave share the task file
+static void ATA_LockChannel(ATAChannel* channel){
+    while(__atomic_exchange_n(&channel->Busy, 1, __ATOMIC_ACQUIRE))
+        Scheduler_Yield();
+}
+
+static void ATA_UnlockChannel(ATAChannel* channel){
+    __atomic_store_n(&channel->Busy, 0, __ATOMIC_RELEASE);
+}
+
+// Splits the buffer at 64 KiB boundaries. Identity mapped memory, so the
+// address is also the physical one.
+static bool ATA_BuildPrdt(ATAChannel* channel, void* buffer, uint32_t bytes){
+    uint32_t address = (uint32_t)buffer;
+    int count = 0;
+
+    while(bytes > 0){
+        if(count == ATA_PRD_MAX)
+            return false;
+
+        uint32_t chunk = ATA_PRD_MAX_BYTES - (address & (ATA_PRD_MAX_BYTES - 1));
+        if(chunk > bytes)
+            chunk = bytes;
+
+        channel->Prdt[count].Address = address;
+        channel->Prdt[count].ByteCount = chunk & 0xFFFF;
+        channel->Prdt[count].Flags = 0;
+        count++;
+
+        address += chunk;
+        bytes -= chunk;
+    }
+
+    channel->Prdt[count - 1].Flags = ATA_PRD_END_OF_TABLE;
+    return true;
+}
+
+static bool ATA_TransferDMA(ATADrive* drive, uint64_t lba, uint32_t count, void* buffer, bool write){
+    ATAChannel* channel = drive->Channel;
+    uint16_t bm = channel->BusMasterBase;
+
+    if(!ATA_BuildPrdt(channel, buffer, count * ATA_SECTOR_SIZE))
+        return false;
+
+    i686_outb(bm + ATA_BM_COMMAND, 0);
+    i686_outl(bm + ATA_BM_PRDT, (uint32_t)channel->Prdt);
+    i686_outb(bm + ATA_BM_COMMAND, write ? 0 : ATA_BM_COMMAND_TO_MEMORY);
+    i686_outb(bm + ATA_BM_STATUS, i686_inb(bm + ATA_BM_STATUS) | ATA_BM_STATUS_ERROR | ATA_BM_STATUS_IRQ);
+
+    if(!ATA_PollNotBusy(channel))
+        return false;
+    ATA_SetupTaskFile(drive, lba, count);
+
+    uint8_t command = write
+        ? (drive->LBA48 ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_WRITE_DMA)
+        : (drive->LBA48 ? ATA_CMD_READ_DMA_EXT : ATA_CMD_READ_DMA);
+
+    Completion_Reset(&channel->Done);
+    channel->Active = true;
+    i686_outb(channel->IOBase + ATA_REG_COMMAND, command);
+    i686_outb(bm + ATA_BM_COMMAND, (write ? 0 : ATA_BM_COMMAND_TO_MEMORY) | ATA_BM_COMMAND_START);
+
+    bool ok = ATA_WaitInterrupt(channel);
+    channel->Active = false;
+
+    i686_outb(bm + ATA_BM_COMMAND, 0);
+    g_Stats.DMACommands++;
+    return ok && !(channel->BusMasterStatus & ATA_BM_STATUS_ERROR);
+}
+
+// One interrupt per sector. The next one may fire as soon as the data of
+// the current sector is moved, so the completion is rearmed before that.
+static bool ATA_TransferPIO(ATADrive* drive, uint64_t lba, uint32_t count, void* buffer, bool write){
+    ATAChannel* channel = drive->Channel;
+    uint16_t* data = (uint16_t*)buffer;
+
+    if(!ATA_PollNotBusy(channel))
+        return false;
+    ATA_SetupTaskFile(drive, lba, count);
+
+    uint8_t command = write
+        ? (drive->LBA48 ? ATA_CMD_WRITE_SECTORS_EXT : ATA_CMD_WRITE_SECTORS)
+        : (drive->LBA48 ? ATA_CMD_READ_SECTORS_EXT : ATA_CMD_READ_SECTORS);
+
+    Completion_Reset(&channel->Done);
+    channel->Active = true;
+    i686_outb(channel->IOBase + ATA_REG_COMMAND, command);
+
+    bool ok = true;
+    for(uint32_t i = 0; i < count && ok; i++){
+        if(write){
+            // no interrupt before the first sector, the drive just asks for data
+            ok = i > 0 || ATA_PollDataRequest(channel);
+            if(!ok)
+                break;
+            Completion_Reset(&channel->Done);
+            i686_outsw(channel->IOBase + ATA_REG_DATA, data, ATA_SECTOR_SIZE / 2);
+            ok = ATA_WaitInterrupt(channel);
+        } else {
+            ok = ATA_WaitInterrupt(channel) && (channel->Status & ATA_STATUS_DRQ);
+            if(!ok)
+                break;
+            Completion_Reset(&channel->Done);
+            i686_insw(channel->IOBase + ATA_REG_DATA, data, ATA_SECTOR_SIZE / 2);
+        }
+        data += ATA_SECTOR_SIZE / 2;
+    }
+
+    channel->Active = false;
+    g_Stats.PIOCommands++;
+    return ok;
+}
+
+static bool ATA_Flush(ATADrive* drive){
+    ATAChannel* channel = drive->Channel;
+
+    if(!ATA_PollNotBusy(channel))
+        return false;
+    ATA_SelectDrive(channel, ATA_DRIVE_LEGACY | ATA_DRIVE_LBA | (drive->Index ? ATA_DRIVE_SLAVE : 0));
+
+    Completion_Reset(&channel->Done);
+    channel->Active = true;
+    i686_outb(channel->IOBase + ATA_REG_COMMAND, drive->LBA48 ? ATA_CMD_FLUSH_CACHE_EXT : ATA_CMD_FLUSH_CACHE);
+    bool ok = ATA_WaitInterrupt(channel);
+    channel->Active = false;
+    return ok;
+}
+
+static bool ATA_Transfer(ATADrive* drive, uint64_t lba, uint32_t count, void* buffer, bool write){
+    if(lba + count > drive->SectorCount || lba + count < lba)
+        return false;
+
+    bool dma = g_DMAEnabled && drive->DMA && ((uint32_t)buffer & 1) == 0;
+    uint8_t* data = (uint8_t*)buffer;
+    bool ok = true;
+
+    ATA_LockChannel(drive->Channel);
+    while(count > 0 && ok){
+        uint32_t chunk = count > ATA_MAX_SECTORS ? ATA_MAX_SECTORS : count;
+
+        ok = dma ? ATA_TransferDMA(drive, lba, chunk, data, write)
+                 : ATA_TransferPIO(drive, lba, chunk, data, write);
+
+        lba += chunk;
+        count -= chunk;
+        data += chunk * ATA_SECTOR_SIZE;
+        g_Stats.Sectors += chunk;
+    }
+
+    if(ok && write)
+        ok = ATA_Flush(drive);
+    ATA_UnlockChannel(drive->Channel);
+
+    if(!ok)
+        g_Stats.Errors++;
+    return ok;
+}
+
+bool ATA_ReadSectors(ATADrive* drive, uint64_t lba, uint32_t count, void* buffer){
+    g_Stats.Reads++;
+    return ATA_Transfer(drive, lba, count, buffer, false);
+}
+
+bool ATA_WriteSectors(ATADrive* drive, uint64_t lba, uint32_t count, const void* buffer){
+    g_Stats.Writes++;
+    return ATA_Transfer(drive, lba, count, (void*)buffer, true);
+}
+
+//
+// Detection
+//
+
+static void ATA_Identify(ATAChannel* channel, uint8_t index){
+    uint16_t io = channel->IOBase;
+    uint16_t id[256];
+
+    channel->SelectedDrive = 0xFF;
+    ATA_SelectDrive(channel, ATA_DRIVE_LEGACY | (index ? ATA_DRIVE_SLAVE : 0));
+    i686_outb(io + ATA_REG_SECTOR_COUNT, 0);
+    i686_outb(io + ATA_REG_LBA0, 0);
+    i686_outb(io + ATA_REG_LBA1, 0);
+    i686_outb(io + ATA_REG_LBA2, 0);
+    i686_outb(io + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+    ATA_Delay400(channel);
+
+    // 0 means no drive, 0xFF a floating bus
+    uint8_t status = i686_inb(io + ATA_REG_STATUS);
+    if(status == 0 || status == 0xFF || !ATA_PollNotBusy(channel))
+        return;
+
+    // ATAPI and SATA devices abort IDENTIFY and leave a signature here
+    if(i686_inb(io + ATA_REG_LBA1) != 0 || i686_inb(io + ATA_REG_LBA2) != 0)
+        return;
+    if(!ATA_PollDataRequest(channel))
+        return;
+
+    i686_insw(io + ATA_REG_DATA, id, 256);
+
+    if(!(id[ATA_ID_CAPABILITIES] & ATA_ID_CAP_LBA) || g_DriveCount == ATA_MAX_DRIVES)
+        return;
+
+    ATADrive* drive = &g_Drives[g_DriveCount++];
+    drive->Channel = channel;
+    drive->Index = index;
+    drive->DMA = channel->BusMasterBase != 0 && (id[ATA_ID_CAPABILITIES] & ATA_ID_CAP_DMA);
+    drive->LBA48 = (id[ATA_ID_COMMAND_SETS] & ATA_ID_SET_LBA48) != 0;
+
+    if(drive->LBA48)
+        drive->SectorCount = (uint64_t)id[ATA_ID_LBA48_SECTORS]
+                           | ((uint64_t)id[ATA_ID_LBA48_SECTORS + 1] << 16)
+                           | ((uint64_t)id[ATA_ID_LBA48_SECTORS + 2] << 32)
+                           | ((uint64_t)id[ATA_ID_LBA48_SECTORS + 3] << 48);
+    else
+        drive->SectorCount = id[ATA_ID_LBA28_SECTORS] | ((uint32_t)id[ATA_ID_LBA28_SECTORS + 1] << 16);
+
+    // the model string is stored with the bytes of each word swapped
+    int i;
+    for(i = 0; i < ATA_MODEL_SIZE - 1; i += 2){
+        drive->Model[i] = id[ATA_ID_MODEL + i / 2] >> 8;
+        drive->Model[i + 1] = id[ATA_ID_MODEL + i / 2] & 0xFF;
+    }
+    for(i = ATA_MODEL_SIZE - 1; i > 0 && (drive->Model[i - 1] == ' ' || drive->Model[i - 1] == '\0'); i--);
+    drive->Model[i] = '\0';
+
+    printf("[ATA] %s %s: %s, %llu sectors, %s%s\r\n",
+           channel == &g_Channels[0] ? "primary" : "secondary",
+           index ? "slave" : "master",
+           drive->Model, drive->SectorCount,
+           drive->LBA48 ? "LBA48" : "LBA28",
+           drive->DMA ? ", DMA" : "");
+}
+
+static void ATA_SetupChannel(ATAChannel* channel, uint16_t io, uint16_t control, uint16_t busMaster, uint8_t irq, PRD* prdt){
+    channel->IOBase = io;
+    channel->ControlBase = control;
+    channel->BusMasterBase = busMaster;
+    channel->Irq = irq;
+    channel->SelectedDrive = 0xFF;
+    channel->Busy = 0;
+    channel->Active = false;
+    channel->Prdt = prdt;
+    Completion_Initialize(&channel->Done);
+
+    // detection polls, keep the drives quiet until the handlers are in place
+    i686_outb(control, ATA_CONTROL_NIEN);
+
+    ATA_Identify(channel, 0);
+    ATA_Identify(channel, 1);
+}
+
+//
+// Block layer
+//
+
+static void ATA_BlockWork(Work* work, void* context){
+    ATADrive* drive = (ATADrive*)context;
+    uint32_t index = drive - g_Drives;
+    BlockCommand* command = g_BlockCommands[index];
+
+    uint64_t lba = command->Lba;
+    bool ok = true;
+    for(int i = 0; i < command->SegmentCount && ok; i++){
+        uint32_t count = command->Segments[i].Length / ATA_SECTOR_SIZE;
+        ok = ATA_Transfer(drive, lba, count, command->Segments[i].Buffer, command->Write);
+        lba += count;
+    }
+
+    if(command->Write)
+        g_Stats.Writes++;
+    else
+        g_Stats.Reads++;
+
+    // free before completing, the completion submits the next command
+    g_BlockCommands[index] = NULL;
+    Block_Complete(command, ok);
+}
+
+static bool ATA_BlockSubmit(BlockDevice* device, BlockCommand* command){
+    ATADrive* drive = (ATADrive*)device->DriverData;
+    uint32_t index = drive - g_Drives;
+
+    if(g_BlockCommands[index] != NULL)
+        return false;
+
+    g_BlockCommands[index] = command;
+    WorkQueue_Queue(&g_BlockQueue, &g_BlockWork[index]);
+    return true;
+}
+
+static const BlockDriver g_ATABlockDriver = {
+    .Name = "ata",
+    .Submit = ATA_BlockSubmit,
+    .Kick = NULL,
+    .MaxSectors = 1024,
+    .MaxSegments = BLOCK_MAX_SEGMENTS,
+};
+
+static void ATA_RegisterBlockDevices(){
+    if(g_DriveCount == 0)
+        return;
+
+    WorkQueue_Setup(&g_BlockQueue, "ata", WORKQUEUE_THREAD, WORKQUEUE_DEFAULT_BATCH, THREAD_PRIORITY_DEFAULT - 1);
+
+    // hda..hdd by position on the cable, like the BIOS numbering
+    for(uint32_t i = 0; i < g_DriveCount; i++){
+        ATADrive* drive = &g_Drives[i];
+        char name[] = "hda";
+        name[2] += (drive->Channel - g_Channels) * 2 + drive->Index;
+
+        Work_Setup(&g_BlockWork[i], ATA_BlockWork, drive);
+        g_BlockCommands[i] = NULL;
+        Block_RegisterDisk(name, drive->SectorCount, 1, &g_ATABlockDriver, drive);
+    }
+}
+
+static bool ATA_Attach(PCIDevice* device){
+    if(g_Attached)
+        return false;
+
+    // in native mode the channels are at BAR0-3 and share the PCI interrupt
+    bool primaryNative = (device->ProgIF & ATA_PROGIF_PRIMARY_NATIVE) != 0;
+    bool secondaryNative = (device->ProgIF & ATA_PROGIF_SECONDARY_NATIVE) != 0;
+
+    uint16_t busMaster = 0;
+    if(device->Bars[ATA_BAR_BUS_MASTER].IO && device->Bars[ATA_BAR_BUS_MASTER].Size != 0)
+        busMaster = device->Bars[ATA_BAR_BUS_MASTER].Base;
+
+    PCI_Enable(device, PCI_COMMAND_IO | (busMaster ? PCI_COMMAND_BUS_MASTER : 0));
+
+    ATA_SetupChannel(&g_Channels[0],
+                     primaryNative ? device->Bars[0].Base : ATA_PRIMARY_IO,
+                     primaryNative ? device->Bars[1].Base + 2 : ATA_PRIMARY_CONTROL,
+                     busMaster,
+                     primaryNative ? device->InterruptLine : ATA_PRIMARY_IRQ,
+                     g_Prdt[0]);
+    ATA_SetupChannel(&g_Channels[1],
+                     secondaryNative ? device->Bars[2].Base : ATA_SECONDARY_IO,
+                     secondaryNative ? device->Bars[3].Base + 2 : ATA_SECONDARY_CONTROL,
+                     busMaster ? busMaster + ATA_BM_CHANNEL_SIZE : 0,
+                     secondaryNative ? device->InterruptLine : ATA_SECONDARY_IRQ,
+                     g_Prdt[1]);
+
+    g_SharedIrq = g_Channels[1].Irq == g_Channels[0].Irq;
+    i686_IRQ_RegisterHandler(g_Channels[0].Irq, ATA_PrimaryIRQ);
+    if(!g_SharedIrq)
+        i686_IRQ_RegisterHandler(g_Channels[1].Irq, ATA_SecondaryIRQ);
+
+    for(int i = 0; i < ATA_CHANNEL_COUNT; i++){
+        i686_IRQ_Unmask(g_Channels[i].Irq);
+        i686_outb(g_Channels[i].ControlBase, 0);
+    }
+
+    g_Attached = true;
+    ATA_RegisterBlockDevices();
+    return true;
+}
+
+static const PCIDriver g_ATADriver = {
+    .Name = "ata",
+    .VendorId = PCI_ANY_ID,
+    .DeviceId = PCI_ANY_ID,
+    .Class = PCI_CLASS_STORAGE,
+    .Subclass = PCI_SUBCLASS_IDE,
+    .ProgIF = PCI_ANY_CLASS,
+    .Attach = ATA_Attach,
+};
+
+void ATA_Initialize(){
+    PCI_RegisterDriver(&g_ATADriver);
+}
+
+uint32_t ATA_GetDriveCount(){
+    return g_DriveCount;
+}
+
+ATADrive* ATA_GetDrive(uint32_t index){
+    return index < g_DriveCount ? &g_Drives[index] : NULL;
+}
+
+void ATA_SetDMAEnabled(bool enabled){
+    g_DMAEnabled = enabled;
+}
+
+void ATA_GetStats(ATAStats* stats){
+    uint32_t flags = i686_irqsave();
+    *stats = g_Stats;
+    i686_irqrestore(flags);
+}
+
+void ATA_PrintStats(){
+    ATAStats stats;
+    ATA_GetStats(&stats);
+
+    printf("===== ATA STATS =====\r\n");
+    printf("reads=%llu writes=%llu sectors=%llu\r\n", stats.Reads, stats.Writes, stats.Sectors);
+    printf("dma=%llu pio=%llu interrupts=%llu\r\n", stats.DMACommands, stats.PIOCommands, stats.Interrupts);
+    printf("errors=%llu timeouts=%llu\r\n", stats.Errors, stats.Timeouts);
+    printf("=====================\r\n");
+}
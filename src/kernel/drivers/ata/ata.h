@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ATA_SECTOR_SIZE             512
+#define ATA_MAX_SECTORS             256         // per command, 128 KiB
+#define ATA_MAX_DRIVES              4
+#define ATA_MODEL_SIZE              41
+
+typedef struct ATAChannel ATAChannel;
+
+typedef struct{
+    ATAChannel* Channel;
+    uint8_t     Index;                  // 0 = master, 1 = slave
+    bool        LBA48;
+    bool        DMA;                    // drive and controller can bus master
+    uint64_t    SectorCount;
+    char        Model[ATA_MODEL_SIZE];
+} ATADrive;
+
+typedef struct{
+    uint64_t Reads;
+    uint64_t Writes;
+    uint64_t Sectors;
+    uint64_t DMACommands;
+    uint64_t PIOCommands;
+    uint64_t Interrupts;
+    uint64_t Errors;
+    uint64_t Timeouts;
+} ATAStats;
+
+// Registers the PCI driver for IDE controllers, e.g. QEMU's PIIX
+void ATA_Initialize();
+
+uint32_t ATA_GetDriveCount();
+ATADrive* ATA_GetDrive(uint32_t index);
+
+// Sleep until the transfer completes, so they must be called from a
+// thread. Requests larger than ATA_MAX_SECTORS are split. Buffers must be
+// 2 byte aligned for DMA, otherwise PIO is used.
+bool ATA_ReadSectors(ATADrive* drive, uint64_t lba, uint32_t count, void* buffer);
+bool ATA_WriteSectors(ATADrive* drive, uint64_t lba, uint32_t count, const void* buffer);
+
+// Forces PIO even where DMA works, to compare the two
+void ATA_SetDMAEnabled(bool enabled);
+
+void ATA_GetStats(ATAStats* stats);
+void ATA_PrintStats();
+void ATA_RunBenchmarks();
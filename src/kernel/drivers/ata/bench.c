@@ -0,0 +1,79 @@
+#include "ata.h"
+#include <arch/i686/io.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define BENCH_SEQUENTIAL_BYTES      (16 * 1024 * 1024)
+#define BENCH_SEQUENTIAL_CHUNK      (128 * 1024)
+#define BENCH_RANDOM_READS          1000
+#define BENCH_RANDOM_SIZE           4096
+
+static uint8_t g_Buffer[BENCH_SEQUENTIAL_CHUNK] __attribute__((aligned(4096)));
+
+static uint32_t Bench_Random(uint32_t* state){
+    *state = *state * 1664525 + 1013904223;
+    return *state;
+}
+
+static void Bench_Sequential(ATADrive* drive, const char* mode){
+    uint32_t sectors = BENCH_SEQUENTIAL_CHUNK / ATA_SECTOR_SIZE;
+    uint64_t total = BENCH_SEQUENTIAL_BYTES / ATA_SECTOR_SIZE;
+    if(total > drive->SectorCount)
+        total = drive->SectorCount - drive->SectorCount % sectors;
+
+    uint64_t start = i686_rdtsc();
+    for(uint64_t lba = 0; lba < total; lba += sectors){
+        if(!ATA_ReadSectors(drive, lba, sectors, g_Buffer)){
+            printf("[BENCH] ata %s sequential: read error at %llu\r\n", mode, lba);
+            return;
+        }
+    }
+    uint64_t ns = Clock_CyclesToNs(i686_rdtsc() - start);
+
+    uint64_t bytes = total * ATA_SECTOR_SIZE;
+    printf("[BENCH] ata %s sequential: %llu KiB in %lluus, %llu KiB/s\r\n",
+           mode, bytes / 1024, ns / NS_PER_US, ns ? bytes * NS_PER_SEC / ns / 1024 : 0);
+}
+
+static void Bench_RandomRead(ATADrive* drive, const char* mode){
+    uint32_t sectors = BENCH_RANDOM_SIZE / ATA_SECTOR_SIZE;
+    uint32_t blocks = drive->SectorCount / sectors;
+    uint32_t seed = 12345;
+
+    uint64_t start = i686_rdtsc();
+    for(int i = 0; i < BENCH_RANDOM_READS; i++){
+        uint64_t lba = (uint64_t)(Bench_Random(&seed) % blocks) * sectors;
+        if(!ATA_ReadSectors(drive, lba, sectors, g_Buffer)){
+            printf("[BENCH] ata %s random: read error at %llu\r\n", mode, lba);
+            return;
+        }
+    }
+    uint64_t ns = Clock_CyclesToNs(i686_rdtsc() - start);
+
+    printf("[BENCH] ata %s random 4K: %u reads in %lluus, %llu IOPS, %lluus/read\r\n",
+           mode, BENCH_RANDOM_READS, ns / NS_PER_US,
+           ns ? BENCH_RANDOM_READS * NS_PER_SEC / ns : 0,
+           ns / BENCH_RANDOM_READS / NS_PER_US);
+}
+
+void ATA_RunBenchmarks(){
+    ATADrive* drive = ATA_GetDrive(0);
+    if(drive == NULL){
+        printf("[BENCH] ata: no drive\r\n");
+        return;
+    }
+
+    if(drive->DMA){
+        ATA_SetDMAEnabled(true);
+        Bench_Sequential(drive, "dma");
+        Bench_RandomRead(drive, "dma");
+    }
+
+    ATA_SetDMAEnabled(false);
+    Bench_Sequential(drive, "pio");
+    Bench_RandomRead(drive, "pio");
+    ATA_SetDMAEnabled(true);
+
+    ATA_PrintStats();
+}
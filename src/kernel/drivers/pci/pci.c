@@ -0,0 +1,334 @@
+#include "pci.h"
+#include <arch/i686/apic/lapic.h>
+#include <arch/i686/io.h>
+#include <util/spinlock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define PCI_CONFIG_ADDRESS          0xCF8
+#define PCI_CONFIG_DATA             0xCFC
+#define PCI_CONFIG_ENABLE           0x80000000
+
+#define PCI_SLOT_COUNT              32
+#define PCI_FUNCTION_COUNT          8
+#define PCI_HEADER_MULTIFUNCTION    0x80
+#define PCI_HEADER_TYPE_MASK        0x7F
+#define PCI_HEADER_BRIDGE           0x01
+
+#define PCI_STATUS_CAPABILITIES     0x10
+#define PCI_CAPABILITY_MSI          0x05
+#define PCI_CAPABILITY_MSIX         0x11
+
+#define PCI_BAR_IO                  0x01
+#define PCI_BAR_TYPE_MASK           0x06
+#define PCI_BAR_TYPE_64BIT          0x04
+#define PCI_BAR_PREFETCHABLE        0x08
+
+#define MSI_CONTROL_ENABLE          0x0001
+#define MSI_CONTROL_MULTIPLE_MASK   0x0070
+#define MSI_CONTROL_64BIT           0x0080
+#define MSI_ADDRESS_BASE            0xFEE00000
+
+static PCIDevice g_Devices[PCI_MAX_DEVICES];
+static uint32_t g_DeviceCount = 0;
+static const PCIDriver* g_Drivers[PCI_MAX_DRIVERS];
+static uint32_t g_DriverCount = 0;
+static uint8_t g_NextMSIVector = LAPIC_VECTOR_MSI_FIRST;
+static Spinlock g_ConfigLock;
+
+// Configuration mechanism #1: select the dword through 0xCF8, access it
+// through 0xCFC
+static uint32_t PCI_Address(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset){
+    return PCI_CONFIG_ENABLE | ((uint32_t)bus << 16) | ((uint32_t)slot << 11)
+         | ((uint32_t)function << 8) | (offset & 0xFC);
+}
+
+static uint32_t PCI_Read(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset){
+    uint32_t address = PCI_Address(bus, slot, function, offset);
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_ConfigLock);
+    i686_outl(PCI_CONFIG_ADDRESS, address);
+    uint32_t value = i686_inl(PCI_CONFIG_DATA);
+    Spinlock_ReleaseIrqRestore(&g_ConfigLock, flags);
+    return value;
+}
+
+static void PCI_Write(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset, uint32_t value){
+    uint32_t address = PCI_Address(bus, slot, function, offset);
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_ConfigLock);
+    i686_outl(PCI_CONFIG_ADDRESS, address);
+    i686_outl(PCI_CONFIG_DATA, value);
+    Spinlock_ReleaseIrqRestore(&g_ConfigLock, flags);
+}
+
+uint32_t PCI_ConfigRead32(PCIDevice* device, uint8_t offset){
+    return PCI_Read(device->Bus, device->Slot, device->Function, offset);
+}
+
+uint16_t PCI_ConfigRead16(PCIDevice* device, uint8_t offset){
+    return PCI_ConfigRead32(device, offset) >> ((offset & 2) * 8);
+}
+
+uint8_t PCI_ConfigRead8(PCIDevice* device, uint8_t offset){
+    return PCI_ConfigRead32(device, offset) >> ((offset & 3) * 8);
+}
+
+void PCI_ConfigWrite32(PCIDevice* device, uint8_t offset, uint32_t value){
+    PCI_Write(device->Bus, device->Slot, device->Function, offset, value);
+}
+
+// Narrow writes go to their own bytes of the data port and leave the rest
+// of the dword alone. Writing it back whole would write the status
+// register's set RW1C bits, master abort, parity error, as ones and clear
+// them along with a command register update.
+void PCI_ConfigWrite16(PCIDevice* device, uint8_t offset, uint16_t value){
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_ConfigLock);
+    i686_outl(PCI_CONFIG_ADDRESS, PCI_Address(device->Bus, device->Slot, device->Function, offset));
+    i686_outw(PCI_CONFIG_DATA + (offset & 2), value);
+    Spinlock_ReleaseIrqRestore(&g_ConfigLock, flags);
+}
+
+void PCI_ConfigWrite8(PCIDevice* device, uint8_t offset, uint8_t value){
+    uint32_t flags = Spinlock_AcquireIrqSave(&g_ConfigLock);
+    i686_outl(PCI_CONFIG_ADDRESS, PCI_Address(device->Bus, device->Slot, device->Function, offset));
+    i686_outb(PCI_CONFIG_DATA + (offset & 3), value);
+    Spinlock_ReleaseIrqRestore(&g_ConfigLock, flags);
+}
+
+void PCI_Enable(PCIDevice* device, uint16_t command){
+    PCI_ConfigWrite16(device, PCI_REG_COMMAND, PCI_ConfigRead16(device, PCI_REG_COMMAND) | command);
+}
+
+// Size of a BAR: write all ones, the bits that stay zero are the size.
+// Decoding is turned off meanwhile so the device does not answer at the
+// bogus address.
+static void PCI_ReadBars(PCIDevice* device){
+    uint16_t command = PCI_ConfigRead16(device, PCI_REG_COMMAND);
+    PCI_ConfigWrite16(device, PCI_REG_COMMAND, command & ~(PCI_COMMAND_IO | PCI_COMMAND_MEMORY));
+
+    for(int i = 0; i < PCI_BAR_COUNT; i++){
+        uint8_t offset = PCI_REG_BAR0 + i * 4;
+        uint32_t bar = PCI_ConfigRead32(device, offset);
+        PCI_ConfigWrite32(device, offset, 0xFFFFFFFF);
+        uint32_t mask = PCI_ConfigRead32(device, offset);
+        PCI_ConfigWrite32(device, offset, bar);
+
+        PCIBar* entry = &device->Bars[i];
+        if(mask == 0 || mask == 0xFFFFFFFF)
+            continue;
+
+        if(bar & PCI_BAR_IO){
+            entry->IO = true;
+            entry->Base = bar & ~0x3u;
+            entry->Size = (~(mask & ~0x3u) + 1) & 0xFFFF;
+            continue;
+        }
+
+        entry->Base = bar & ~0xFu;
+        entry->Size = ~(mask & ~0xFu) + 1;
+        entry->Prefetchable = (bar & PCI_BAR_PREFETCHABLE) != 0;
+
+        // the upper half has to be zero for us to reach it, skip it
+        if((bar & PCI_BAR_TYPE_MASK) == PCI_BAR_TYPE_64BIT){
+            if(PCI_ConfigRead32(device, offset + 4) != 0){
+                entry->Base = 0;
+                entry->Size = 0;
+            }
+            i++;
+        }
+    }
+
+    PCI_ConfigWrite16(device, PCI_REG_COMMAND, command);
+}
+
+static void PCI_ReadCapabilities(PCIDevice* device){
+    if(!(PCI_ConfigRead16(device, PCI_REG_STATUS) & PCI_STATUS_CAPABILITIES))
+        return;
+
+    // the list is bounded in case a broken device links it into a loop
+    uint8_t offset = PCI_ConfigRead8(device, PCI_REG_CAPABILITIES) & 0xFC;
+    for(int i = 0; i < 48 && offset != 0; i++){
+        uint8_t id = PCI_ConfigRead8(device, offset);
+        if(id == PCI_CAPABILITY_MSI)
+            device->MSICapability = offset;
+        else if(id == PCI_CAPABILITY_MSIX)
+            device->MSIXCapability = offset;
+
+        offset = PCI_ConfigRead8(device, offset + 1) & 0xFC;
+    }
+}
+
+static void PCI_ScanBus(uint8_t bus);
+
+static void PCI_ScanFunction(uint8_t bus, uint8_t slot, uint8_t function){
+    if(g_DeviceCount == PCI_MAX_DEVICES){
+        printf("[PCI] Run out of device slots!\r\n");
+        return;
+    }
+
+    PCIDevice* device = &g_Devices[g_DeviceCount++];
+    device->Bus = bus;
+    device->Slot = slot;
+    device->Function = function;
+
+    uint32_t id = PCI_ConfigRead32(device, PCI_REG_VENDOR_ID);
+    uint32_t classes = PCI_ConfigRead32(device, PCI_REG_REVISION);
+    uint32_t interrupt = PCI_ConfigRead32(device, PCI_REG_INTERRUPT_LINE);
+
+    device->VendorId = id & 0xFFFF;
+    device->DeviceId = id >> 16;
+    device->Revision = classes & 0xFF;
+    device->ProgIF = (classes >> 8) & 0xFF;
+    device->Subclass = (classes >> 16) & 0xFF;
+    device->Class = classes >> 24;
+    device->InterruptLine = interrupt & 0xFF;
+    device->InterruptPin = (interrupt >> 8) & 0xFF;
+
+    uint8_t header = PCI_ConfigRead8(device, PCI_REG_HEADER_TYPE) & PCI_HEADER_TYPE_MASK;
+    if(header == 0){
+        PCI_ReadBars(device);
+        PCI_ReadCapabilities(device);
+    }
+
+    if(device->Class == PCI_CLASS_BRIDGE && device->Subclass == PCI_SUBCLASS_PCI_BRIDGE && header == PCI_HEADER_BRIDGE){
+        uint8_t secondary = PCI_ConfigRead8(device, PCI_REG_SECONDARY_BUS);
+        if(secondary > bus)
+            PCI_ScanBus(secondary);
+    }
+}
+
+static void PCI_ScanSlot(uint8_t bus, uint8_t slot){
+    if((PCI_Read(bus, slot, 0, PCI_REG_VENDOR_ID) & 0xFFFF) == 0xFFFF)
+        return;
+
+    PCI_ScanFunction(bus, slot, 0);
+
+    uint8_t header = PCI_Read(bus, slot, 0, PCI_REG_HEADER_TYPE) >> 16;
+    if(!(header & PCI_HEADER_MULTIFUNCTION))
+        return;
+
+    for(uint8_t function = 1; function < PCI_FUNCTION_COUNT; function++){
+        if((PCI_Read(bus, slot, function, PCI_REG_VENDOR_ID) & 0xFFFF) != 0xFFFF)
+            PCI_ScanFunction(bus, slot, function);
+    }
+}
+
+static void PCI_ScanBus(uint8_t bus){
+    for(uint8_t slot = 0; slot < PCI_SLOT_COUNT; slot++)
+        PCI_ScanSlot(bus, slot);
+}
+
+// Walks the tree from bus 0 through the PCI-to-PCI bridges, so only buses
+// that exist are visited instead of all 256
+void PCI_Initialize(){
+    Spinlock_Initialize(&g_ConfigLock, "pci-config");
+
+    // probe for mechanism #1: the address register reads back what we wrote
+    i686_outl(PCI_CONFIG_ADDRESS, PCI_CONFIG_ENABLE);
+    if(i686_inl(PCI_CONFIG_ADDRESS) != PCI_CONFIG_ENABLE){
+        printf("[PCI] No configuration mechanism #1!\r\n");
+        return;
+    }
+
+    // a multifunction host bridge means one host controller per function
+    uint8_t header = PCI_Read(0, 0, 0, PCI_REG_HEADER_TYPE) >> 16;
+    if(!(header & PCI_HEADER_MULTIFUNCTION)){
+        PCI_ScanBus(0);
+    } else {
+        for(uint8_t function = 0; function < PCI_FUNCTION_COUNT; function++){
+            if((PCI_Read(0, 0, function, PCI_REG_VENDOR_ID) & 0xFFFF) != 0xFFFF)
+                PCI_ScanBus(function);
+        }
+    }
+
+    printf("[PCI] Found %u functions\r\n", g_DeviceCount);
+}
+
+static bool PCI_Matches(const PCIDriver* driver, PCIDevice* device){
+    return (driver->VendorId == PCI_ANY_ID || driver->VendorId == device->VendorId)
+        && (driver->DeviceId == PCI_ANY_ID || driver->DeviceId == device->DeviceId)
+        && (driver->Class == PCI_ANY_CLASS || driver->Class == device->Class)
+        && (driver->Subclass == PCI_ANY_CLASS || driver->Subclass == device->Subclass)
+        && (driver->ProgIF == PCI_ANY_CLASS || driver->ProgIF == device->ProgIF);
+}
+
+void PCI_RegisterDriver(const PCIDriver* driver){
+    if(g_DriverCount == PCI_MAX_DRIVERS){
+        printf("[PCI] Run out of driver slots!\r\n");
+        return;
+    }
+    g_Drivers[g_DriverCount++] = driver;
+
+    for(uint32_t i = 0; i < g_DeviceCount; i++){
+        PCIDevice* device = &g_Devices[i];
+        if(device->Driver != NULL || !PCI_Matches(driver, device))
+            continue;
+
+        if(driver->Attach(device)){
+            device->Driver = driver;
+            printf("[PCI] %s attached to %x:%x.%x\r\n", driver->Name, device->Bus, device->Slot, device->Function);
+        }
+    }
+}
+
+uint32_t PCI_GetDeviceCount(){
+    return g_DeviceCount;
+}
+
+PCIDevice* PCI_GetDevice(uint32_t index){
+    return index < g_DeviceCount ? &g_Devices[index] : NULL;
+}
+
+PCIDevice* PCI_FindDevice(uint16_t vendorId, uint16_t deviceId){
+    for(uint32_t i = 0; i < g_DeviceCount; i++){
+        if(g_Devices[i].VendorId == vendorId && g_Devices[i].DeviceId == deviceId)
+            return &g_Devices[i];
+    }
+    return NULL;
+}
+
+uint8_t PCI_EnableMSI(PCIDevice* device, uint8_t apicId){
+    if(device->MSICapability == 0 || g_NextMSIVector > LAPIC_VECTOR_MSI_LAST)
+        return 0;
+
+    uint8_t capability = device->MSICapability;
+    uint8_t vector = g_NextMSIVector++;
+    uint16_t control = PCI_ConfigRead16(device, capability + 2);
+
+    // fixed delivery, edge triggered, a single message
+    PCI_ConfigWrite32(device, capability + 4, MSI_ADDRESS_BASE | ((uint32_t)apicId << 12));
+    if(control & MSI_CONTROL_64BIT){
+        PCI_ConfigWrite32(device, capability + 8, 0);
+        PCI_ConfigWrite16(device, capability + 12, vector);
+    } else {
+        PCI_ConfigWrite16(device, capability + 8, vector);
+    }
+
+    control &= ~MSI_CONTROL_MULTIPLE_MASK;
+    PCI_ConfigWrite16(device, capability + 2, control | MSI_CONTROL_ENABLE);
+    PCI_Enable(device, PCI_COMMAND_INTX_DISABLE);
+    return vector;
+}
+
+void PCI_PrintDevices(){
+    printf("===== PCI DEVICES =====\r\n");
+    for(uint32_t i = 0; i < g_DeviceCount; i++){
+        PCIDevice* device = &g_Devices[i];
+        printf("%x:%x.%x %x:%x class=%x/%x/%x irq=%u%s%s\r\n",
+               device->Bus, device->Slot, device->Function,
+               device->VendorId, device->DeviceId,
+               device->Class, device->Subclass, device->ProgIF,
+               device->InterruptLine,
+               device->MSICapability ? " msi" : "",
+               device->MSIXCapability ? " msix" : "");
+
+        for(int bar = 0; bar < PCI_BAR_COUNT; bar++){
+            if(device->Bars[bar].Size != 0)
+                printf("    bar%u %s base=%x size=%x\r\n", bar,
+                       device->Bars[bar].IO ? "io " : "mem",
+                       device->Bars[bar].Base, device->Bars[bar].Size);
+        }
+    }
+    printf("=======================\r\n");
+}
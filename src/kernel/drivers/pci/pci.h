@@ -0,0 +1,109 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PCI_MAX_DEVICES             64
+#define PCI_MAX_DRIVERS             16
+#define PCI_BAR_COUNT               6
+
+#define PCI_ANY_ID                  0xFFFF
+#define PCI_ANY_CLASS               0xFFFF
+
+enum {
+    PCI_REG_VENDOR_ID           = 0x00,
+    PCI_REG_DEVICE_ID           = 0x02,
+    PCI_REG_COMMAND             = 0x04,
+    PCI_REG_STATUS              = 0x06,
+    PCI_REG_REVISION            = 0x08,
+    PCI_REG_PROG_IF             = 0x09,
+    PCI_REG_SUBCLASS            = 0x0A,
+    PCI_REG_CLASS               = 0x0B,
+    PCI_REG_HEADER_TYPE         = 0x0E,
+    PCI_REG_BAR0                = 0x10,
+    PCI_REG_SECONDARY_BUS       = 0x19,
+    PCI_REG_CAPABILITIES        = 0x34,
+    PCI_REG_INTERRUPT_LINE      = 0x3C,
+    PCI_REG_INTERRUPT_PIN       = 0x3D,
+};
+
+enum {
+    PCI_COMMAND_IO              = 0x0001,
+    PCI_COMMAND_MEMORY          = 0x0002,
+    PCI_COMMAND_BUS_MASTER      = 0x0004,
+    PCI_COMMAND_INTX_DISABLE    = 0x0400,
+};
+
+enum {
+    PCI_CLASS_STORAGE           = 0x01,
+    PCI_CLASS_BRIDGE            = 0x06,
+
+    PCI_SUBCLASS_IDE            = 0x01,
+    PCI_SUBCLASS_SATA           = 0x06,
+    PCI_SUBCLASS_PCI_BRIDGE     = 0x04,
+};
+
+typedef struct{
+    uint32_t    Base;
+    uint32_t    Size;
+    bool        IO;
+    bool        Prefetchable;
+} PCIBar;
+
+typedef struct PCIDriver PCIDriver;
+
+// One function found at boot. Everything a driver needs to decide whether
+// to attach is cached here, so nobody has to poke configuration space again.
+typedef struct{
+    uint8_t             Bus;
+    uint8_t             Slot;
+    uint8_t             Function;
+    uint16_t            VendorId;
+    uint16_t            DeviceId;
+    uint8_t             Class;
+    uint8_t             Subclass;
+    uint8_t             ProgIF;
+    uint8_t             Revision;
+    uint8_t             InterruptLine;
+    uint8_t             InterruptPin;
+    uint8_t             MSICapability;      // offset in config space, 0 if none
+    uint8_t             MSIXCapability;
+    PCIBar              Bars[PCI_BAR_COUNT];
+    const PCIDriver*    Driver;
+    void*               DriverData;
+} PCIDevice;
+
+// Matches on any combination of ids and class codes, PCI_ANY_* for don't care
+struct PCIDriver{
+    const char* Name;
+    uint16_t    VendorId;
+    uint16_t    DeviceId;
+    uint16_t    Class;
+    uint16_t    Subclass;
+    uint16_t    ProgIF;
+    bool        (*Attach)(PCIDevice* device);
+};
+
+void PCI_Initialize();
+// Attaches the driver to every matching device not owned by another one
+void PCI_RegisterDriver(const PCIDriver* driver);
+
+uint32_t PCI_GetDeviceCount();
+PCIDevice* PCI_GetDevice(uint32_t index);
+PCIDevice* PCI_FindDevice(uint16_t vendorId, uint16_t deviceId);
+
+uint32_t PCI_ConfigRead32(PCIDevice* device, uint8_t offset);
+uint16_t PCI_ConfigRead16(PCIDevice* device, uint8_t offset);
+uint8_t PCI_ConfigRead8(PCIDevice* device, uint8_t offset);
+void PCI_ConfigWrite32(PCIDevice* device, uint8_t offset, uint32_t value);
+void PCI_ConfigWrite16(PCIDevice* device, uint8_t offset, uint16_t value);
+void PCI_ConfigWrite8(PCIDevice* device, uint8_t offset, uint8_t value);
+
+// Sets bits in the command register, e.g. PCI_COMMAND_BUS_MASTER
+void PCI_Enable(PCIDevice* device, uint16_t command);
+
+// Routes the device interrupt straight to a local APIC as a message
+// instead of a shared legacy IRQ line. Returns the vector, 0 on failure;
+// the handler must acknowledge it with i686_LAPIC_SendEOI.
+uint8_t PCI_EnableMSI(PCIDevice* device, uint8_t apicId);
+
+void PCI_PrintDevices();
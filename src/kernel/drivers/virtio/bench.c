@@ -0,0 +1,165 @@
+#include "virtio_blk.h"
+#include <drivers/ata/ata.h>
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define BENCH_SEQUENTIAL_BYTES      (16 * 1024 * 1024)
+#define BENCH_SEQUENTIAL_CHUNK      (128 * 1024)
+#define BENCH_RANDOM_READS          1000
+#define BENCH_BLOCK_SIZE            4096
+#define BENCH_BATCH_MAX             32
+
+static const uint32_t g_BatchSizes[] = { 1, 4, 16, 32 };
+
+static uint8_t g_Buffer[BENCH_SEQUENTIAL_CHUNK] __attribute__((aligned(4096)));
+static uint8_t g_BatchBuffers[BENCH_BATCH_MAX][BENCH_BLOCK_SIZE] __attribute__((aligned(4096)));
+static VirtioBlkRequest g_Requests[BENCH_BATCH_MAX];
+static volatile uint32_t g_Remaining;
+static volatile uint32_t g_Failed;
+static Completion g_BatchDone;
+
+// Both paths read through the same interface, so the numbers compare
+typedef bool (*BenchRead)(void* disk, uint64_t lba, uint32_t count, void* buffer);
+
+static bool Bench_ReadATA(void* disk, uint64_t lba, uint32_t count, void* buffer){
+    return ATA_ReadSectors((ATADrive*)disk, lba, count, buffer);
+}
+
+static bool Bench_ReadVirtio(void* disk, uint64_t lba, uint32_t count, void* buffer){
+    return VirtioBlk_ReadSectors((VirtioBlkDisk*)disk, lba, count, buffer);
+}
+
+static uint32_t Bench_Random(uint32_t* state){
+    *state = *state * 1664525 + 1013904223;
+    return *state;
+}
+
+static void Bench_Sequential(const char* name, BenchRead read, void* disk, uint64_t sectorCount){
+    uint32_t sectors = BENCH_SEQUENTIAL_CHUNK / VIRTIO_BLK_SECTOR_SIZE;
+    uint64_t total = BENCH_SEQUENTIAL_BYTES / VIRTIO_BLK_SECTOR_SIZE;
+    if(total > sectorCount)
+        total = sectorCount - sectorCount % sectors;
+
+    uint64_t start = i686_rdtsc();
+    for(uint64_t lba = 0; lba < total; lba += sectors){
+        if(!read(disk, lba, sectors, g_Buffer)){
+            printf("[BENCH] %s sequential: read error at %llu\r\n", name, lba);
+            return;
+        }
+    }
+    uint64_t ns = Clock_CyclesToNs(i686_rdtsc() - start);
+
+    uint64_t bytes = total * VIRTIO_BLK_SECTOR_SIZE;
+    printf("[BENCH] %s sequential: %llu KiB in %lluus, %llu KiB/s\r\n",
+           name, bytes / 1024, ns / NS_PER_US, ns ? bytes * NS_PER_SEC / ns / 1024 : 0);
+}
+
+static void Bench_RandomRead(const char* name, BenchRead read, void* disk, uint64_t sectorCount){
+    uint32_t sectors = BENCH_BLOCK_SIZE / VIRTIO_BLK_SECTOR_SIZE;
+    uint32_t blocks = sectorCount / sectors;
+    uint32_t seed = 12345;
+
+    uint64_t start = i686_rdtsc();
+    for(int i = 0; i < BENCH_RANDOM_READS; i++){
+        uint64_t lba = (uint64_t)(Bench_Random(&seed) % blocks) * sectors;
+        if(!read(disk, lba, sectors, g_Buffer)){
+            printf("[BENCH] %s random: read error at %llu\r\n", name, lba);
+            return;
+        }
+    }
+    uint64_t ns = Clock_CyclesToNs(i686_rdtsc() - start);
+
+    printf("[BENCH] %s random 4K: %llu IOPS, %lluus/read\r\n",
+           name, ns ? BENCH_RANDOM_READS * NS_PER_SEC / ns : 0,
+           ns / BENCH_RANDOM_READS / NS_PER_US);
+}
+
+static void Bench_BatchComplete(VirtioBlkRequest* request){
+    if(!request->Success)
+        g_Failed++;
+    if(--g_Remaining == 0)
+        Completion_Signal(&g_BatchDone);
+}
+
+// Random 4K reads queued batch requests at a time with one kick per batch;
+// the notify and interrupt counts show what the batching saves. The
+// BENCH_RANDOM_READS requests are rounded up to whole batches.
+static void Bench_Batched(VirtioBlkDisk* disk, uint32_t batch){
+    uint32_t sectors = BENCH_BLOCK_SIZE / VIRTIO_BLK_SECTOR_SIZE;
+    uint32_t blocks = disk->SectorCount / sectors;
+    uint32_t batches = (BENCH_RANDOM_READS + batch - 1) / batch;
+    uint32_t seed = 12345;
+
+    VirtioBlkStats before, after;
+    VirtioBlk_GetStats(&before);
+    g_Failed = 0;
+
+    uint64_t start = i686_rdtsc();
+    for(uint32_t b = 0; b < batches; b++){
+        Completion_Initialize(&g_BatchDone);
+        g_Remaining = batch;
+
+        for(uint32_t i = 0; i < batch; i++){
+            VirtioBlkRequest* request = &g_Requests[i];
+            request->Lba = (uint64_t)(Bench_Random(&seed) % blocks) * sectors;
+            request->Count = sectors;
+            request->Write = false;
+            request->Segments[0].Buffer = g_BatchBuffers[i];
+            request->Segments[0].Length = BENCH_BLOCK_SIZE;
+            request->SegmentCount = 1;
+            request->Callback = Bench_BatchComplete;
+
+            if(!VirtioBlk_Queue(disk, request)){
+                printf("[BENCH] virtio batch %u: queue full\r\n", batch);
+                if(i == 0)
+                    return;
+
+                // the requests already queued still own g_BatchBuffers,
+                // so see them through before giving the buffers up
+                if(__atomic_sub_fetch(&g_Remaining, batch - i, __ATOMIC_SEQ_CST) == 0)
+                    Completion_Signal(&g_BatchDone);
+                VirtioBlk_Kick(disk);
+                Completion_Wait(&g_BatchDone, 0);
+                return;
+            }
+        }
+
+        VirtioBlk_Kick(disk);
+        Completion_Wait(&g_BatchDone, 0);
+    }
+    uint64_t ns = Clock_CyclesToNs(i686_rdtsc() - start);
+    VirtioBlk_GetStats(&after);
+
+    uint64_t requests = after.Requests - before.Requests;
+    printf("[BENCH] virtio random 4K batch %u: %llu IOPS, %llu notifies, %llu interrupts for %llu requests%s\r\n",
+           batch, ns ? requests * NS_PER_SEC / ns : 0,
+           after.Notifies - before.Notifies,
+           after.Interrupts - before.Interrupts,
+           requests, g_Failed ? ", ERRORS" : "");
+}
+
+void VirtioBlk_RunBenchmarks(){
+    VirtioBlkDisk* disk = VirtioBlk_GetDisk(0);
+    if(disk == NULL){
+        printf("[BENCH] virtio: no disk\r\n");
+        return;
+    }
+
+    Bench_Sequential("virtio", Bench_ReadVirtio, disk, disk->SectorCount);
+    Bench_RandomRead("virtio", Bench_ReadVirtio, disk, disk->SectorCount);
+
+    // the same image on the IDE controller, see run.sh
+    ATADrive* drive = ATA_GetDrive(0);
+    if(drive != NULL){
+        Bench_Sequential("ide", Bench_ReadATA, drive, drive->SectorCount);
+        Bench_RandomRead("ide", Bench_ReadATA, drive, drive->SectorCount);
+    }
+
+    for(uint32_t i = 0; i < sizeof(g_BatchSizes) / sizeof(g_BatchSizes[0]); i++)
+        Bench_Batched(disk, g_BatchSizes[i]);
+
+    VirtioBlk_PrintStats();
+}
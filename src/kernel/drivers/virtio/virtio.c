@@ -0,0 +1,271 @@
+#include "virtio.h"
+#include <arch/i686/io.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+#define VIRTIO_BAR_IO               0
+#define VIRTIO_CONFIG_OFFSET        0x14        // device config, without MSI-X
+
+// Legacy registers, relative to BAR0
+enum {
+    VIRTIO_REG_DEVICE_FEATURES  = 0x00,
+    VIRTIO_REG_GUEST_FEATURES   = 0x04,
+    VIRTIO_REG_QUEUE_ADDRESS    = 0x08,
+    VIRTIO_REG_QUEUE_SIZE       = 0x0C,
+    VIRTIO_REG_QUEUE_SELECT     = 0x0E,
+    VIRTIO_REG_QUEUE_NOTIFY     = 0x10,
+    VIRTIO_REG_STATUS           = 0x12,
+    VIRTIO_REG_ISR              = 0x13,
+};
+
+enum {
+    VIRTIO_STATUS_ACKNOWLEDGE   = 0x01,
+    VIRTIO_STATUS_DRIVER        = 0x02,
+    VIRTIO_STATUS_DRIVER_OK     = 0x04,
+    VIRTIO_STATUS_FAILED        = 0x80,
+};
+
+enum {
+    VIRTQ_USED_F_NO_NOTIFY      = 1,
+};
+
+// The ring indices are shared with the device: stores must be visible
+// before the index that publishes them, and the index before we look at
+// whether the device wants a notification.
+static inline void Virtio_Barrier(){
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static uint32_t Virtio_Align(uint32_t value){
+    return (value + VIRTIO_QUEUE_ALIGN - 1) & ~(VIRTIO_QUEUE_ALIGN - 1);
+}
+
+bool Virtio_Initialize(VirtioDevice* device, PCIDevice* pci){
+    if(!pci->Bars[VIRTIO_BAR_IO].IO || pci->Bars[VIRTIO_BAR_IO].Size == 0)
+        return false;
+
+    PCI_Enable(pci, PCI_COMMAND_IO | PCI_COMMAND_BUS_MASTER);
+    device->Pci = pci;
+    device->IOBase = pci->Bars[VIRTIO_BAR_IO].Base;
+    device->Features = 0;
+
+    i686_outb(device->IOBase + VIRTIO_REG_STATUS, 0);
+    i686_outb(device->IOBase + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    i686_outb(device->IOBase + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+    return true;
+}
+
+uint32_t Virtio_NegotiateFeatures(VirtioDevice* device, uint32_t wanted){
+    uint32_t offered = i686_inl(device->IOBase + VIRTIO_REG_DEVICE_FEATURES);
+    device->Features = offered & wanted;
+    i686_outl(device->IOBase + VIRTIO_REG_GUEST_FEATURES, device->Features);
+    return device->Features;
+}
+
+bool Virtio_HasFeature(VirtioDevice* device, uint32_t feature){
+    return (device->Features & (1u << feature)) != 0;
+}
+
+void Virtio_Ready(VirtioDevice* device){
+    uint8_t status = i686_inb(device->IOBase + VIRTIO_REG_STATUS);
+    i686_outb(device->IOBase + VIRTIO_REG_STATUS, status | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void Virtio_Fail(VirtioDevice* device){
+    uint8_t status = i686_inb(device->IOBase + VIRTIO_REG_STATUS);
+    i686_outb(device->IOBase + VIRTIO_REG_STATUS, status | VIRTIO_STATUS_FAILED);
+}
+
+uint8_t Virtio_ReadISR(VirtioDevice* device){
+    return i686_inb(device->IOBase + VIRTIO_REG_ISR);
+}
+
+uint8_t Virtio_ReadConfig8(VirtioDevice* device, uint16_t offset){
+    return i686_inb(device->IOBase + VIRTIO_CONFIG_OFFSET + offset);
+}
+
+uint32_t Virtio_ReadConfig32(VirtioDevice* device, uint16_t offset){
+    return i686_inl(device->IOBase + VIRTIO_CONFIG_OFFSET + offset);
+}
+
+uint64_t Virtio_ReadConfig64(VirtioDevice* device, uint16_t offset){
+    return Virtio_ReadConfig32(device, offset)
+         | ((uint64_t)Virtio_ReadConfig32(device, offset + 4) << 32);
+}
+
+//
+// Virtqueues
+//
+
+// used_event sits right after the avail ring, avail_event after the used one
+static volatile uint16_t* Virtqueue_UsedEvent(Virtqueue* queue){
+    return &queue->Avail->Ring[queue->Size];
+}
+
+static volatile uint16_t* Virtqueue_AvailEvent(Virtqueue* queue){
+    return (volatile uint16_t*)&queue->Used->Ring[queue->Size];
+}
+
+bool Virtqueue_Setup(Virtqueue* queue, VirtioDevice* device, uint16_t index, void* memory){
+    uint16_t io = device->IOBase;
+
+    i686_outw(io + VIRTIO_REG_QUEUE_SELECT, index);
+    uint16_t size = i686_inw(io + VIRTIO_REG_QUEUE_SIZE);
+    if(size == 0 || size > VIRTIO_QUEUE_MAX_SIZE){
+        printf("[VIRTIO] queue %u: unsupported size %u\r\n", index, size);
+        return false;
+    }
+
+    // legacy layout: descriptors, avail ring, then the used ring on the
+    // next aligned boundary
+    uint32_t availOffset = size * sizeof(VirtqDesc);
+    uint32_t usedOffset = Virtio_Align(availOffset + sizeof(uint16_t) * (3 + size));
+    uint32_t total = Virtio_Align(usedOffset + sizeof(uint16_t) * 3 + sizeof(VirtqUsedElem) * size);
+    if(total > VIRTIO_QUEUE_MEMORY_SIZE)
+        return false;
+
+    memset(memory, 0, total);
+    queue->Device = device;
+    queue->Index = index;
+    queue->Size = size;
+    queue->Desc = (VirtqDesc*)memory;
+    queue->Avail = (VirtqAvail*)((uint8_t*)memory + availOffset);
+    queue->Used = (VirtqUsed*)((uint8_t*)memory + usedOffset);
+    queue->AvailIndex = 0;
+    queue->Published = 0;
+    queue->LastUsed = 0;
+    queue->Indirect = Virtio_HasFeature(device, VIRTIO_F_RING_INDIRECT_DESC);
+    queue->EventIdx = Virtio_HasFeature(device, VIRTIO_F_RING_EVENT_IDX);
+    queue->Kicks = 0;
+    queue->Notifies = 0;
+
+    // all descriptors start on the free list, chained through Next
+    for(uint16_t i = 0; i < size; i++){
+        queue->Desc[i].Next = i + 1;
+        queue->Tokens[i] = NULL;
+    }
+    queue->FreeHead = 0;
+    queue->FreeCount = size;
+
+    i686_outl(io + VIRTIO_REG_QUEUE_ADDRESS, (uint32_t)memory / VIRTIO_QUEUE_ALIGN);
+    return true;
+}
+
+static void Virtqueue_FillDesc(VirtqDesc* desc, const VirtqBuffer* buffer){
+    desc->Address = (uint32_t)buffer->Buffer;
+    desc->Length = buffer->Length;
+    desc->Flags = buffer->DeviceWrites ? VIRTQ_DESC_F_WRITE : 0;
+}
+
+bool Virtqueue_Add(Virtqueue* queue, const VirtqBuffer* buffers, uint16_t count, VirtqDesc* indirect, void* token){
+    if(count == 0)
+        return false;
+
+    bool useIndirect = queue->Indirect && indirect != NULL && count > 1;
+    uint16_t needed = useIndirect ? 1 : count;
+    if(queue->FreeCount < needed)
+        return false;
+
+    uint16_t head = queue->FreeHead;
+
+    if(useIndirect){
+        // the chain lives in the caller's table, the ring holds one entry
+        for(uint16_t i = 0; i < count; i++){
+            Virtqueue_FillDesc(&indirect[i], &buffers[i]);
+            if(i + 1 < count){
+                indirect[i].Flags |= VIRTQ_DESC_F_NEXT;
+                indirect[i].Next = i + 1;
+            }
+        }
+
+        VirtqDesc* desc = &queue->Desc[head];
+        queue->FreeHead = desc->Next;
+        desc->Address = (uint32_t)indirect;
+        desc->Length = count * sizeof(VirtqDesc);
+        desc->Flags = VIRTQ_DESC_F_INDIRECT;
+    } else {
+        uint16_t index = head;
+        for(uint16_t i = 0; i < count; i++){
+            VirtqDesc* desc = &queue->Desc[index];
+            uint16_t next = desc->Next;
+            Virtqueue_FillDesc(desc, &buffers[i]);
+            if(i + 1 < count){
+                desc->Flags |= VIRTQ_DESC_F_NEXT;
+                desc->Next = next;
+            }
+            index = next;
+        }
+        queue->FreeHead = index;
+    }
+
+    queue->FreeCount -= needed;
+    queue->Tokens[head] = token;
+    queue->Avail->Ring[queue->AvailIndex % queue->Size] = head;
+    queue->AvailIndex++;
+    return true;
+}
+
+void Virtqueue_Kick(Virtqueue* queue){
+    uint16_t previous = queue->Published;
+    uint16_t next = queue->AvailIndex;
+    if(previous == next)
+        return;
+
+    Virtio_Barrier();
+    queue->Avail->Index = next;
+    queue->Published = next;
+    Virtio_Barrier();
+    queue->Kicks++;
+
+    // with event indices the device names the avail index it wants to hear
+    // about; only notify if this batch moved past it
+    bool notify;
+    if(queue->EventIdx){
+        uint16_t event = *Virtqueue_AvailEvent(queue);
+        notify = (uint16_t)(next - event - 1) < (uint16_t)(next - previous);
+    } else {
+        notify = !(queue->Used->Flags & VIRTQ_USED_F_NO_NOTIFY);
+    }
+
+    if(notify){
+        queue->Notifies++;
+        i686_outw(queue->Device->IOBase + VIRTIO_REG_QUEUE_NOTIFY, queue->Index);
+    }
+}
+
+void* Virtqueue_GetUsed(Virtqueue* queue, uint32_t* length){
+    if(queue->LastUsed == queue->Used->Index)
+        return NULL;
+    Virtio_Barrier();
+
+    VirtqUsedElem* element = &queue->Used->Ring[queue->LastUsed % queue->Size];
+    uint16_t head = element->Id;
+    if(length != NULL)
+        *length = element->Length;
+    queue->LastUsed++;
+
+    void* token = queue->Tokens[head];
+    queue->Tokens[head] = NULL;
+
+    // give the chain back to the free list
+    uint16_t last = head;
+    uint16_t count = 1;
+    while(queue->Desc[last].Flags & VIRTQ_DESC_F_NEXT){
+        last = queue->Desc[last].Next;
+        count++;
+    }
+    queue->Desc[last].Next = queue->FreeHead;
+    queue->FreeHead = head;
+    queue->FreeCount += count;
+
+    return token;
+}
+
+bool Virtqueue_EnableInterrupts(Virtqueue* queue){
+    // interrupt as soon as the device moves past what we consumed
+    if(queue->EventIdx)
+        *Virtqueue_UsedEvent(queue) = queue->LastUsed;
+    Virtio_Barrier();
+    return queue->LastUsed == queue->Used->Index;
+}
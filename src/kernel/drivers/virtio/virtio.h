@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <drivers/pci/pci.h>
+
+#define VIRTIO_VENDOR_ID            0x1AF4
+#define VIRTIO_QUEUE_MAX_SIZE       1024
+#define VIRTIO_QUEUE_ALIGN          4096
+
+// Memory one legacy queue of the maximum size needs, see Virtqueue_Setup
+#define VIRTIO_QUEUE_MEMORY_SIZE    (8 * VIRTIO_QUEUE_ALIGN)
+
+enum {
+    VIRTIO_F_RING_INDIRECT_DESC = 28,
+    VIRTIO_F_RING_EVENT_IDX     = 29,
+};
+
+enum {
+    VIRTQ_DESC_F_NEXT           = 1,
+    VIRTQ_DESC_F_WRITE          = 2,            // device writes, driver reads
+    VIRTQ_DESC_F_INDIRECT       = 4,
+};
+
+typedef struct{
+    uint64_t Address;
+    uint32_t Length;
+    uint16_t Flags;
+    uint16_t Next;
+} __attribute__((packed)) VirtqDesc;
+
+typedef struct{
+    uint16_t Flags;
+    volatile uint16_t Index;
+    uint16_t Ring[];                            // followed by used_event
+} VirtqAvail;
+
+typedef struct{
+    uint32_t Id;
+    uint32_t Length;
+} VirtqUsedElem;
+
+typedef struct{
+    volatile uint16_t Flags;
+    volatile uint16_t Index;
+    VirtqUsedElem Ring[];                       // followed by avail_event
+} VirtqUsed;
+
+// Legacy (0.9.5) PCI transport: everything behind the I/O BAR0
+typedef struct{
+    PCIDevice*  Pci;
+    uint16_t    IOBase;
+    uint32_t    Features;                       // negotiated
+} VirtioDevice;
+
+// One buffer of a request. Out buffers are read by the device, in buffers
+// written, and all out buffers come first.
+typedef struct{
+    void*       Buffer;
+    uint32_t    Length;
+    bool        DeviceWrites;
+} VirtqBuffer;
+
+typedef struct{
+    VirtioDevice*   Device;
+    uint16_t        Index;
+    uint16_t        Size;
+    VirtqDesc*      Desc;
+    VirtqAvail*     Avail;
+    VirtqUsed*      Used;
+    uint16_t        FreeHead;
+    uint16_t        FreeCount;
+    uint16_t        AvailIndex;                 // private copy, published by kick
+    uint16_t        Published;                  // what the device was last told
+    uint16_t        LastUsed;                   // next used entry to consume
+    bool            Indirect;
+    bool            EventIdx;
+    void*           Tokens[VIRTIO_QUEUE_MAX_SIZE];
+    uint64_t        Kicks;                      // Virtqueue_Kick calls
+    uint64_t        Notifies;                   // the ones that reached the device
+} Virtqueue;
+
+// Resets the device and acknowledges it, enabling its I/O BAR
+bool Virtio_Initialize(VirtioDevice* device, PCIDevice* pci);
+// Accepts the offered subset of features (bit numbers < 32)
+uint32_t Virtio_NegotiateFeatures(VirtioDevice* device, uint32_t wanted);
+bool Virtio_HasFeature(VirtioDevice* device, uint32_t feature);
+// Sets DRIVER_OK once the queues are set up
+void Virtio_Ready(VirtioDevice* device);
+void Virtio_Fail(VirtioDevice* device);
+// Reads and so acknowledges the interrupt status, bit 0 = queue used
+uint8_t Virtio_ReadISR(VirtioDevice* device);
+
+uint8_t Virtio_ReadConfig8(VirtioDevice* device, uint16_t offset);
+uint32_t Virtio_ReadConfig32(VirtioDevice* device, uint16_t offset);
+uint64_t Virtio_ReadConfig64(VirtioDevice* device, uint16_t offset);
+
+// Sets up queue number index in memory, which must be physically
+// contiguous, VIRTIO_QUEUE_ALIGN aligned and VIRTIO_QUEUE_MEMORY_SIZE big
+bool Virtqueue_Setup(Virtqueue* queue, VirtioDevice* device, uint16_t index, void* memory);
+
+// Adds a request without telling the device. With indirect descriptors
+// and a table of count entries it takes a single ring slot, otherwise one
+// per buffer. Returns false if the ring is full.
+bool Virtqueue_Add(Virtqueue* queue, const VirtqBuffer* buffers, uint16_t count, VirtqDesc* indirect, void* token);
+// Publishes everything added since the last kick and notifies the device
+// unless it asked not to be
+void Virtqueue_Kick(Virtqueue* queue);
+// Next finished request's token, NULL if none
+void* Virtqueue_GetUsed(Virtqueue* queue, uint32_t* length);
+// Asks for an interrupt on the next completion. False if some are already
+// pending, in which case they should be consumed first.
+bool Virtqueue_EnableInterrupts(Virtqueue* queue);
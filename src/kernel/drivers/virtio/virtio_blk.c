@@ -0,0 +1,428 @@
+#include "virtio_blk.h"
+#include "virtio.h"
+#include <drivers/pci/pci.h>
+#include <block/block.h>
+#include <arch/i686/interrupts/irq.h>
+#include <arch/i686/io.h>
+#include <sched/completion.h>
+#include <sched/scheduler.h>
+#include <timer/clock.h>
+#include <util/spinlock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define VIRTIO_BLK_DEVICE_LEGACY    0x1001
+#define VIRTIO_BLK_QUEUE            0
+#define VIRTIO_BLK_MAX_TRANSFER     (1024 * 1024)
+#define VIRTIO_BLK_TIMEOUT_NS       (5 * NS_PER_SEC)
+
+enum {
+    VIRTIO_BLK_F_SEG_MAX        = 2,
+    VIRTIO_BLK_F_RO             = 5,
+};
+
+// Device config
+enum {
+    VIRTIO_BLK_CONFIG_CAPACITY  = 0x00,
+    VIRTIO_BLK_CONFIG_SEG_MAX   = 0x0C,
+};
+
+enum {
+    VIRTIO_BLK_T_IN             = 0,
+    VIRTIO_BLK_T_OUT            = 1,
+};
+
+enum {
+    VIRTIO_BLK_S_OK             = 0,
+};
+
+typedef struct{
+    uint32_t Type;
+    uint32_t Reserved;
+    uint64_t Sector;
+} __attribute__((packed)) VirtioBlkHeader;
+
+// Driver side of one request in flight: the header and status the device
+// reads and writes, and the indirect table chaining them to the data
+typedef struct{
+    VirtqDesc           Indirect[VIRTIO_BLK_MAX_SEGMENTS + 2];
+    VirtioBlkHeader     Header;
+    volatile uint8_t    Status;
+    VirtioBlkRequest*   Request;
+} __attribute__((aligned(16))) VirtioBlkSlot;
+
+struct VirtioBlkState{
+    VirtioDevice    Device;
+    Virtqueue       Queue;
+    VirtioBlkSlot   Slots[VIRTIO_BLK_MAX_INFLIGHT];
+    uint8_t         FreeSlots[VIRTIO_BLK_MAX_INFLIGHT];
+    uint32_t        FreeSlotCount;
+    Spinlock        Lock;
+};
+
+static VirtioBlkState g_States[VIRTIO_BLK_MAX_DISKS];
+static VirtioBlkDisk g_Disks[VIRTIO_BLK_MAX_DISKS];
+static uint32_t g_DiskCount = 0;
+static VirtioBlkStats g_Stats;
+
+// Driver requests backing the block commands
+static VirtioBlkRequest g_BlockRequests[VIRTIO_BLK_MAX_DISKS][VIRTIO_BLK_MAX_INFLIGHT];
+static uint8_t g_BlockFree[VIRTIO_BLK_MAX_DISKS][VIRTIO_BLK_MAX_INFLIGHT];
+static uint32_t g_BlockFreeCount[VIRTIO_BLK_MAX_DISKS];
+static uint8_t g_QueueMemory[VIRTIO_BLK_MAX_DISKS][VIRTIO_QUEUE_MEMORY_SIZE] __attribute__((aligned(VIRTIO_QUEUE_ALIGN)));
+
+static bool VirtioBlk_ValidateRequest(VirtioBlkDisk* disk, VirtioBlkRequest* request){
+    if(request->Count == 0 || request->Lba + request->Count > disk->SectorCount)
+        return false;
+    if(request->Write && disk->ReadOnly)
+        return false;
+    if(request->SegmentCount == 0 || request->SegmentCount > disk->MaxSegments)
+        return false;
+
+    uint32_t bytes = 0;
+    for(int i = 0; i < request->SegmentCount; i++){
+        if(request->Segments[i].Length == 0)
+            return false;
+        bytes += request->Segments[i].Length;
+    }
+    return bytes == request->Count * VIRTIO_BLK_SECTOR_SIZE;
+}
+
+bool VirtioBlk_Queue(VirtioBlkDisk* disk, VirtioBlkRequest* request){
+    if(!VirtioBlk_ValidateRequest(disk, request))
+        return false;
+
+    VirtioBlkState* state = disk->State;
+    uint32_t flags = Spinlock_AcquireIrqSave(&state->Lock);
+
+    if(state->FreeSlotCount == 0){
+        Spinlock_ReleaseIrqRestore(&state->Lock, flags);
+        return false;
+    }
+
+    VirtioBlkSlot* slot = &state->Slots[state->FreeSlots[--state->FreeSlotCount]];
+    slot->Header.Type = request->Write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    slot->Header.Reserved = 0;
+    slot->Header.Sector = request->Lba;
+    slot->Status = 0xFF;
+    slot->Request = request;
+
+    // header, data, status: the device reads the first and writes the last
+    VirtqBuffer buffers[VIRTIO_BLK_MAX_SEGMENTS + 2];
+    uint16_t count = 0;
+    buffers[count++] = (VirtqBuffer){ &slot->Header, sizeof(VirtioBlkHeader), false };
+    for(int i = 0; i < request->SegmentCount; i++)
+        buffers[count++] = (VirtqBuffer){ request->Segments[i].Buffer, request->Segments[i].Length, !request->Write };
+    buffers[count++] = (VirtqBuffer){ (void*)&slot->Status, 1, true };
+
+    if(!Virtqueue_Add(&state->Queue, buffers, count, slot->Indirect, slot)){
+        state->FreeSlots[state->FreeSlotCount++] = slot - state->Slots;
+        Spinlock_ReleaseIrqRestore(&state->Lock, flags);
+        return false;
+    }
+
+    g_Stats.Requests++;
+    g_Stats.Sectors += request->Count;
+    Spinlock_ReleaseIrqRestore(&state->Lock, flags);
+    return true;
+}
+
+void VirtioBlk_Kick(VirtioBlkDisk* disk){
+    VirtioBlkState* state = disk->State;
+    uint32_t flags = Spinlock_AcquireIrqSave(&state->Lock);
+
+    uint64_t notifies = state->Queue.Notifies;
+    uint64_t kicks = state->Queue.Kicks;
+    Virtqueue_Kick(&state->Queue);
+    g_Stats.Kicks += state->Queue.Kicks - kicks;
+    g_Stats.Notifies += state->Queue.Notifies - notifies;
+
+    Spinlock_ReleaseIrqRestore(&state->Lock, flags);
+}
+
+bool VirtioBlk_Submit(VirtioBlkDisk* disk, VirtioBlkRequest* request){
+    if(!VirtioBlk_Queue(disk, request))
+        return false;
+    VirtioBlk_Kick(disk);
+    return true;
+}
+
+//
+// Interrupts
+//
+
+static void VirtioBlk_HandleInterrupt(VirtioBlkState* state){
+    // reading the ISR status also deasserts the line
+    if(!(Virtio_ReadISR(&state->Device) & 1))
+        return;
+
+    g_Stats.Interrupts++;
+
+    VirtioBlkRequest* done[VIRTIO_BLK_MAX_INFLIGHT];
+    uint32_t doneCount = 0;
+
+    Spinlock_Acquire(&state->Lock);
+    do {
+        VirtioBlkSlot* slot;
+        while((slot = Virtqueue_GetUsed(&state->Queue, NULL)) != NULL){
+            slot->Request->Success = slot->Status == VIRTIO_BLK_S_OK;
+            if(!slot->Request->Success)
+                g_Stats.Errors++;
+
+            done[doneCount++] = slot->Request;
+            slot->Request = NULL;
+            state->FreeSlots[state->FreeSlotCount++] = slot - state->Slots;
+        }
+    // more may have finished while interrupts were suppressed
+    } while(!Virtqueue_EnableInterrupts(&state->Queue));
+    Spinlock_Release(&state->Lock);
+
+    // outside the lock, so callbacks can queue the next request
+    for(uint32_t i = 0; i < doneCount; i++){
+        if(done[i]->Callback != NULL)
+            done[i]->Callback(done[i]);
+    }
+}
+
+static void VirtioBlk_IRQ(Registers* regs){
+    // legacy lines are shared, ask every disk
+    for(uint32_t i = 0; i < g_DiskCount; i++)
+        VirtioBlk_HandleInterrupt(g_Disks[i].State);
+}
+
+//
+// Synchronous wrappers
+//
+
+static void VirtioBlk_CompleteSync(VirtioBlkRequest* request){
+    Completion_Signal((Completion*)request->Context);
+}
+
+static bool VirtioBlk_Transfer(VirtioBlkDisk* disk, uint64_t lba, uint32_t count, void* buffer, bool write){
+    uint8_t* data = (uint8_t*)buffer;
+    Completion done;
+    VirtioBlkRequest request;
+
+    while(count > 0){
+        uint32_t chunk = count;
+        if(chunk > VIRTIO_BLK_MAX_TRANSFER / VIRTIO_BLK_SECTOR_SIZE)
+            chunk = VIRTIO_BLK_MAX_TRANSFER / VIRTIO_BLK_SECTOR_SIZE;
+
+        request.Lba = lba;
+        request.Count = chunk;
+        request.Write = write;
+        request.Segments[0].Buffer = data;
+        request.Segments[0].Length = chunk * VIRTIO_BLK_SECTOR_SIZE;
+        request.SegmentCount = 1;
+        request.Callback = VirtioBlk_CompleteSync;
+        request.Context = &done;
+
+        Completion_Initialize(&done);
+        while(!VirtioBlk_Submit(disk, &request)){
+            if(!VirtioBlk_ValidateRequest(disk, &request))
+                return false;
+            Scheduler_Yield();
+        }
+
+        // the device owns the request until it hands it back, there is no
+        // way to take it away again
+        if(!Completion_Wait(&done, VIRTIO_BLK_TIMEOUT_NS)){
+            printf("[VIRTIO] blk%u: request still pending after timeout\r\n", disk->Index);
+            Completion_Wait(&done, 0);
+        }
+        if(!request.Success)
+            return false;
+
+        lba += chunk;
+        count -= chunk;
+        data += chunk * VIRTIO_BLK_SECTOR_SIZE;
+    }
+    return true;
+}
+
+bool VirtioBlk_ReadSectors(VirtioBlkDisk* disk, uint64_t lba, uint32_t count, void* buffer){
+    return VirtioBlk_Transfer(disk, lba, count, buffer, false);
+}
+
+bool VirtioBlk_WriteSectors(VirtioBlkDisk* disk, uint64_t lba, uint32_t count, const void* buffer){
+    return VirtioBlk_Transfer(disk, lba, count, (void*)buffer, true);
+}
+
+//
+// Block layer
+//
+
+static void VirtioBlk_BlockDone(VirtioBlkRequest* request){
+    BlockCommand* command = (BlockCommand*)request->Context;
+    uint32_t index = ((VirtioBlkDisk*)command->Device->DriverData)->Index;
+
+    uint32_t flags = i686_irqsave();
+    g_BlockFree[index][g_BlockFreeCount[index]++] = request - g_BlockRequests[index];
+    i686_irqrestore(flags);
+
+    Block_Complete(command, request->Success);
+}
+
+// Only queues, the block layer kicks once per round of submissions
+static bool VirtioBlk_BlockSubmit(BlockDevice* device, BlockCommand* command){
+    VirtioBlkDisk* disk = (VirtioBlkDisk*)device->DriverData;
+    uint32_t index = disk->Index;
+
+    // refusing would only get it retried, fail it instead
+    if((command->Write && disk->ReadOnly) || command->SegmentCount > disk->MaxSegments){
+        Block_Complete(command, false);
+        return true;
+    }
+
+    uint32_t flags = i686_irqsave();
+    if(g_BlockFreeCount[index] == 0){
+        i686_irqrestore(flags);
+        return false;
+    }
+    uint8_t slot = g_BlockFree[index][--g_BlockFreeCount[index]];
+    i686_irqrestore(flags);
+
+    VirtioBlkRequest* request = &g_BlockRequests[index][slot];
+    request->Lba = command->Lba;
+    request->Count = command->Count;
+    request->Write = command->Write;
+    request->SegmentCount = command->SegmentCount;
+    for(int i = 0; i < command->SegmentCount; i++){
+        request->Segments[i].Buffer = command->Segments[i].Buffer;
+        request->Segments[i].Length = command->Segments[i].Length;
+    }
+    request->Callback = VirtioBlk_BlockDone;
+    request->Context = command;
+
+    if(!VirtioBlk_Queue(disk, request)){
+        flags = i686_irqsave();
+        g_BlockFree[index][g_BlockFreeCount[index]++] = slot;
+        i686_irqrestore(flags);
+        return false;
+    }
+    return true;
+}
+
+static void VirtioBlk_BlockKick(BlockDevice* device){
+    VirtioBlk_Kick((VirtioBlkDisk*)device->DriverData);
+}
+
+static const BlockDriver g_VirtioBlockDriver = {
+    .Name = "virtio-blk",
+    .Submit = VirtioBlk_BlockSubmit,
+    .Kick = VirtioBlk_BlockKick,
+    .MaxSectors = VIRTIO_BLK_MAX_TRANSFER / VIRTIO_BLK_SECTOR_SIZE,
+    .MaxSegments = VIRTIO_BLK_MAX_SEGMENTS < BLOCK_MAX_SEGMENTS ? VIRTIO_BLK_MAX_SEGMENTS : BLOCK_MAX_SEGMENTS,
+};
+
+static void VirtioBlk_RegisterBlockDevice(VirtioBlkDisk* disk){
+    char name[] = "vda";
+    name[2] += disk->Index;
+
+    for(uint32_t i = 0; i < VIRTIO_BLK_MAX_INFLIGHT; i++)
+        g_BlockFree[disk->Index][i] = i;
+    g_BlockFreeCount[disk->Index] = VIRTIO_BLK_MAX_INFLIGHT;
+
+    Block_RegisterDisk(name, disk->SectorCount, VIRTIO_BLK_MAX_INFLIGHT, &g_VirtioBlockDriver, disk);
+}
+
+//
+// Detection
+//
+
+static bool VirtioBlk_Attach(PCIDevice* device){
+    if(g_DiskCount == VIRTIO_BLK_MAX_DISKS)
+        return false;
+
+    uint32_t index = g_DiskCount;
+    VirtioBlkState* state = &g_States[index];
+    VirtioBlkDisk* disk = &g_Disks[index];
+
+    if(!Virtio_Initialize(&state->Device, device))
+        return false;
+
+    Virtio_NegotiateFeatures(&state->Device,
+                             (1u << VIRTIO_BLK_F_SEG_MAX) | (1u << VIRTIO_BLK_F_RO)
+                           | (1u << VIRTIO_F_RING_INDIRECT_DESC) | (1u << VIRTIO_F_RING_EVENT_IDX));
+
+    if(!Virtqueue_Setup(&state->Queue, &state->Device, VIRTIO_BLK_QUEUE, g_QueueMemory[index])){
+        Virtio_Fail(&state->Device);
+        return false;
+    }
+
+    // header and status take two descriptors of a direct chain
+    disk->MaxSegments = VIRTIO_BLK_MAX_SEGMENTS;
+    if(Virtio_HasFeature(&state->Device, VIRTIO_BLK_F_SEG_MAX)){
+        uint32_t max = Virtio_ReadConfig32(&state->Device, VIRTIO_BLK_CONFIG_SEG_MAX);
+        if(max != 0 && max < disk->MaxSegments)
+            disk->MaxSegments = max;
+    }
+    if(!state->Queue.Indirect && state->Queue.Size - 2 < disk->MaxSegments)
+        disk->MaxSegments = state->Queue.Size - 2;
+
+    for(uint32_t i = 0; i < VIRTIO_BLK_MAX_INFLIGHT; i++){
+        state->Slots[i].Request = NULL;
+        state->FreeSlots[i] = VIRTIO_BLK_MAX_INFLIGHT - 1 - i;
+    }
+    state->FreeSlotCount = VIRTIO_BLK_MAX_INFLIGHT;
+    Spinlock_Initialize(&state->Lock, "virtio-blk");
+
+    disk->State = state;
+    disk->Index = index;
+    disk->ReadOnly = Virtio_HasFeature(&state->Device, VIRTIO_BLK_F_RO);
+    disk->SectorCount = Virtio_ReadConfig64(&state->Device, VIRTIO_BLK_CONFIG_CAPACITY);
+    g_DiskCount++;
+
+    i686_IRQ_RegisterHandler(device->InterruptLine, VirtioBlk_IRQ);
+    i686_IRQ_Unmask(device->InterruptLine);
+    Virtqueue_EnableInterrupts(&state->Queue);
+    Virtio_Ready(&state->Device);
+
+    printf("[VIRTIO] blk%u: %llu sectors, queue size %u%s%s%s, irq %u\r\n",
+           index, disk->SectorCount, state->Queue.Size,
+           disk->ReadOnly ? ", read-only" : "",
+           state->Queue.Indirect ? ", indirect" : "",
+           state->Queue.EventIdx ? ", event-idx" : "",
+           device->InterruptLine);
+
+    VirtioBlk_RegisterBlockDevice(disk);
+    return true;
+}
+
+static const PCIDriver g_VirtioBlkDriver = {
+    .Name = "virtio-blk",
+    .VendorId = VIRTIO_VENDOR_ID,
+    .DeviceId = VIRTIO_BLK_DEVICE_LEGACY,
+    .Class = PCI_ANY_CLASS,
+    .Subclass = PCI_ANY_CLASS,
+    .ProgIF = PCI_ANY_CLASS,
+    .Attach = VirtioBlk_Attach,
+};
+
+void VirtioBlk_Initialize(){
+    PCI_RegisterDriver(&g_VirtioBlkDriver);
+}
+
+uint32_t VirtioBlk_GetDiskCount(){
+    return g_DiskCount;
+}
+
+VirtioBlkDisk* VirtioBlk_GetDisk(uint32_t index){
+    return index < g_DiskCount ? &g_Disks[index] : NULL;
+}
+
+void VirtioBlk_GetStats(VirtioBlkStats* stats){
+    uint32_t flags = i686_irqsave();
+    *stats = g_Stats;
+    i686_irqrestore(flags);
+}
+
+void VirtioBlk_PrintStats(){
+    VirtioBlkStats stats;
+    VirtioBlk_GetStats(&stats);
+
+    printf("===== VIRTIO-BLK STATS =====\r\n");
+    printf("requests=%llu sectors=%llu errors=%llu\r\n", stats.Requests, stats.Sectors, stats.Errors);
+    printf("kicks=%llu notifies=%llu interrupts=%llu\r\n", stats.Kicks, stats.Notifies, stats.Interrupts);
+    printf("============================\r\n");
+}
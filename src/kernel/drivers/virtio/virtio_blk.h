@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VIRTIO_BLK_SECTOR_SIZE      512
+#define VIRTIO_BLK_MAX_DISKS        2
+#define VIRTIO_BLK_MAX_SEGMENTS     8
+#define VIRTIO_BLK_MAX_INFLIGHT     64
+
+typedef struct VirtioBlkState VirtioBlkState;
+typedef struct VirtioBlkRequest VirtioBlkRequest;
+
+// Runs from the interrupt handler once the request is done
+typedef void (*VirtioBlkCallback)(VirtioBlkRequest* request);
+
+typedef struct{
+    void*       Buffer;
+    uint32_t    Length;
+} VirtioBlkSegment;
+
+struct VirtioBlkRequest{
+    uint64_t            Lba;
+    uint32_t            Count;                  // sectors, must match the segments
+    bool                Write;
+    VirtioBlkSegment    Segments[VIRTIO_BLK_MAX_SEGMENTS];
+    uint8_t             SegmentCount;
+    VirtioBlkCallback   Callback;
+    void*               Context;
+
+    // set by the driver
+    bool                Success;
+};
+
+typedef struct{
+    VirtioBlkState* State;
+    uint8_t         Index;
+    bool            ReadOnly;
+    uint64_t        SectorCount;
+    uint32_t        MaxSegments;
+} VirtioBlkDisk;
+
+typedef struct{
+    uint64_t Requests;
+    uint64_t Sectors;
+    uint64_t Kicks;                 // batches handed to the device
+    uint64_t Notifies;              // kicks that actually exited to the host
+    uint64_t Interrupts;
+    uint64_t Errors;
+} VirtioBlkStats;
+
+// Registers the PCI driver for legacy and transitional virtio-blk devices
+void VirtioBlk_Initialize();
+
+uint32_t VirtioBlk_GetDiskCount();
+VirtioBlkDisk* VirtioBlk_GetDisk(uint32_t index);
+
+// Adds the request to the ring without notifying the device, so a batch
+// costs a single VirtioBlk_Kick. False if the queue is full or the request
+// invalid. Callable from interrupt handlers.
+bool VirtioBlk_Queue(VirtioBlkDisk* disk, VirtioBlkRequest* request);
+void VirtioBlk_Kick(VirtioBlkDisk* disk);
+// Queue and kick
+bool VirtioBlk_Submit(VirtioBlkDisk* disk, VirtioBlkRequest* request);
+
+// Synchronous helpers for a single contiguous buffer, from a thread
+bool VirtioBlk_ReadSectors(VirtioBlkDisk* disk, uint64_t lba, uint32_t count, void* buffer);
+bool VirtioBlk_WriteSectors(VirtioBlkDisk* disk, uint64_t lba, uint32_t count, const void* buffer);
+
+void VirtioBlk_GetStats(VirtioBlkStats* stats);
+void VirtioBlk_PrintStats();
+void VirtioBlk_RunBenchmarks();
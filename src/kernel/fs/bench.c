@@ -0,0 +1,210 @@
+#include "vfs.h"
+#include "dcache.h"
+#include <fs/fat/fat.h>
+#include <block/buffer_cache.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "config.h"
+#include "stdio.h"
+
+#define BENCH_LOOKUP_ROUNDS         1000
+#define BENCH_STREAM_PATH           "/rabench.bin"
+#define BENCH_STREAM_BYTES          (8 * 1024 * 1024)
+#define BENCH_STREAM_CHUNK          4096
+#define BENCH_DIRECTORY_PATH        "/bigdir"
+#define BENCH_DIRECTORY_FILES       2000
+#define BENCH_DIRECTORY_MISSES      200
+
+static uint8_t g_Chunk[64 * 1024];
+
+static const char* g_BenchPaths[] = {
+    "/boot/kernel.bin",
+    "/test.txt",
+    "/subir/test.txt",
+    "/boot/missing.bin",                    // negative entries
+    "/nothere/kernel.bin",
+};
+
+// The first lookup of a path goes to the disk, the rest should be one
+// dentry cache probe per component
+static void Bench_Lookup(const char* path){
+    VfsStat stat;
+
+    uint64_t start = Clock_NowNs();
+    VfsStatus status = VFS_Stat(path, &stat);
+    uint64_t cold = Clock_NowNs() - start;
+
+    start = Clock_NowNs();
+    for(uint32_t i = 0; i < BENCH_LOOKUP_ROUNDS; i++)
+        VFS_Stat(path, &stat);
+    uint64_t warm = (Clock_NowNs() - start) / BENCH_LOOKUP_ROUNDS;
+
+    printf("[BENCH] vfs %s (%s): cold %lluns, cached %lluns\r\n",
+           path, VFS_StatusString(status), cold, warm);
+}
+
+static void Bench_Open(const char* path){
+    int handle;
+
+    uint64_t start = Clock_NowNs();
+    for(uint32_t i = 0; i < BENCH_LOOKUP_ROUNDS; i++){
+        if(VFS_Open(path, VFS_OPEN_READ, &handle) != VFS_OK){
+            printf("[BENCH] vfs open %s failed\r\n", path);
+            return;
+        }
+        VFS_Close(handle);
+    }
+    uint64_t ns = (Clock_NowNs() - start) / BENCH_LOOKUP_ROUNDS;
+
+    printf("[BENCH] vfs open+close %s: %lluns\r\n", path, ns);
+}
+
+// The image holds no file that large, the first run writes it
+static bool Bench_PrepareFile(const char* path, uint64_t size){
+    VfsStat stat;
+    if(VFS_Stat(path, &stat) == VFS_OK && stat.Size == size)
+        return true;
+
+    int handle;
+    VfsStatus status = VFS_Open(path, VFS_OPEN_WRITE | VFS_OPEN_CREATE | VFS_OPEN_TRUNCATE, &handle);
+    if(status == VFS_OK){
+        for(uint32_t i = 0; i < sizeof(g_Chunk); i++)
+            g_Chunk[i] = i;
+        for(uint64_t written = 0; written < size && status == VFS_OK; written += sizeof(g_Chunk)){
+            uint32_t done;
+            uint32_t count = size - written < sizeof(g_Chunk) ? size - written : sizeof(g_Chunk);
+            status = VFS_Write(handle, g_Chunk, count, &done);
+        }
+        VFS_Close(handle);
+    }
+    if(status == VFS_OK)
+        status = VFS_Sync();
+
+    if(status != VFS_OK)
+        printf("[BENCH] vfs: cannot write %s: %s\r\n", path, VFS_StatusString(status));
+    return status == VFS_OK;
+}
+
+// Reads the file in small chunks from a cold cache, summing it up so there
+// is some consumption for the reads ahead to overlap with. Readahead
+// follows the filesystem's map of the file, as it does for any reader.
+static void Bench_Stream(bool readahead){
+    int handle;
+    if(VFS_Open(BENCH_STREAM_PATH, VFS_OPEN_READ, &handle) != VFS_OK){
+        printf("[BENCH] vfs: cannot open %s\r\n", BENCH_STREAM_PATH);
+        return;
+    }
+    VFS_SetReadahead(handle, readahead);
+    BufferCache_Invalidate(NULL);
+
+    uint32_t sum = 0, done;
+    uint64_t bytes = 0;
+    uint64_t start = Clock_NowNs();
+    VfsStatus status;
+    while((status = VFS_Read(handle, g_Chunk, BENCH_STREAM_CHUNK, &done)) == VFS_OK && done > 0){
+        for(uint32_t i = 0; i < done; i++)
+            sum += g_Chunk[i];
+        bytes += done;
+    }
+    uint64_t ns = Clock_NowNs() - start;
+
+    ReadaheadStats stats;
+    VFS_GetReadaheadStats(handle, &stats);
+    VFS_Close(handle);
+
+    if(status != VFS_OK){
+        printf("[BENCH] vfs: read error in %s at %llu: %s\r\n", BENCH_STREAM_PATH, bytes, VFS_StatusString(status));
+        return;
+    }
+
+    // tenths of MiB/s, printf has no precision
+    uint64_t rate = ns ? bytes * 10 * NS_PER_SEC / ns / (1024 * 1024) : 0;
+    printf("[BENCH] vfs read %s, readahead %s: %llu KiB in %lluus, %llu.%llu MiB/s (sum %x)\r\n",
+           BENCH_STREAM_PATH, readahead ? "on" : "off", bytes / 1024, ns / NS_PER_US,
+           rate / 10, rate % 10, sum);
+    if(readahead)
+        printf("[BENCH] readahead: windows=%llu blocks=%llu sequential=%llu random=%llu\r\n",
+               stats.Windows, stats.Blocks, stats.Sequential, stats.Random);
+}
+
+void VFS_RunStreamBenchmark(){
+    if(!Bench_PrepareFile(BENCH_STREAM_PATH, BENCH_STREAM_BYTES))
+        return;
+
+    Bench_Stream(false);
+    Bench_Stream(true);
+}
+
+// path = directory "/" prefix number, no snprintf here
+static void Bench_NumberedPath(char* path, char prefix, uint32_t number){
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = '0' + number % 10;
+        number /= 10;
+    } while(number > 0);
+
+    int length = 0;
+    for(const char* c = BENCH_DIRECTORY_PATH "/"; *c; c++)
+        path[length++] = *c;
+    path[length++] = prefix;
+    while(count > 0)
+        path[length++] = digits[--count];
+    path[length] = '\0';
+}
+
+// Lookups of names never seen before miss the dentry cache and scan the
+// whole directory in the filesystem, so this times the directory walk
+static void Bench_Directory(){
+    char path[32];
+    VfsStat stat;
+
+    Bench_NumberedPath(path, 'f', BENCH_DIRECTORY_FILES - 1);
+    if(VFS_Stat(path, &stat) != VFS_OK){
+        VfsStatus status = VFS_MakeDirectory(BENCH_DIRECTORY_PATH);
+        if(status != VFS_OK && status != VFS_EXISTS){
+            printf("[BENCH] vfs: cannot create %s: %s\r\n", BENCH_DIRECTORY_PATH, VFS_StatusString(status));
+            return;
+        }
+
+        for(uint32_t i = 0; i < BENCH_DIRECTORY_FILES && status != VFS_NO_SPACE; i++){
+            int handle;
+            Bench_NumberedPath(path, 'f', i);
+            status = VFS_Open(path, VFS_OPEN_WRITE | VFS_OPEN_CREATE, &handle);
+            if(status == VFS_OK)
+                VFS_Close(handle);
+        }
+        VFS_Sync();
+    }
+
+    uint64_t start = Clock_NowNs();
+    for(uint32_t i = 0; i < BENCH_DIRECTORY_MISSES; i++){
+        Bench_NumberedPath(path, 'x', i);
+        VFS_Stat(path, &stat);
+    }
+    uint64_t ns = (Clock_NowNs() - start) / BENCH_DIRECTORY_MISSES;
+
+    printf("[BENCH] vfs uncached lookup in %s (%u entries): %lluns, %lluns/entry\r\n",
+           BENCH_DIRECTORY_PATH, BENCH_DIRECTORY_FILES, ns, ns / BENCH_DIRECTORY_FILES);
+}
+
+void VFS_RunBenchmarks(){
+    VfsStat stat;
+    if(VFS_Stat("/", &stat) != VFS_OK){
+        printf("[BENCH] vfs: nothing mounted\r\n");
+        return;
+    }
+
+    for(uint32_t i = 0; i < sizeof(g_BenchPaths) / sizeof(g_BenchPaths[0]); i++)
+        Bench_Lookup(g_BenchPaths[i]);
+    Bench_Open("/boot/kernel.bin");
+    Bench_Directory();
+
+    // the readahead benchmark streams the file already
+#if !CONFIG_READAHEAD_BENCHMARK
+    VFS_RunStreamBenchmark();
+#endif
+
+    VFS_PrintStats();
+    FAT_PrintStats();
+}
@@ -0,0 +1,200 @@
+#include "dcache.h"
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+#define DCACHE_HASH_BITS            10
+#define DCACHE_HASH_SIZE            (1 << DCACHE_HASH_BITS)
+
+static Dentry g_Entries[DCACHE_ENTRIES];
+static Dentry* g_Hash[DCACHE_HASH_SIZE];
+static Dentry* g_Free;                      // linked through HashNext
+static Dentry* g_LruHead;                   // most recently released
+static Dentry* g_LruTail;
+static DcacheStats g_Stats;
+
+// FNV-1a
+uint32_t Dcache_HashName(const char* name, uint32_t length){
+    uint32_t hash = 2166136261u;
+    for(uint32_t i = 0; i < length; i++){
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t Dcache_Bucket(Dentry* parent, uint32_t hash){
+    uint32_t key = hash ^ ((uint32_t)parent >> 4);
+    return (key * 2654435761u) >> (32 - DCACHE_HASH_BITS);
+}
+
+static void Dcache_LruRemove(Dentry* dentry){
+    if(dentry->LruPrev != NULL)
+        dentry->LruPrev->LruNext = dentry->LruNext;
+    else
+        g_LruHead = dentry->LruNext;
+    if(dentry->LruNext != NULL)
+        dentry->LruNext->LruPrev = dentry->LruPrev;
+    else
+        g_LruTail = dentry->LruPrev;
+    dentry->LruPrev = dentry->LruNext = NULL;
+}
+
+static void Dcache_LruAdd(Dentry* dentry){
+    dentry->LruPrev = NULL;
+    dentry->LruNext = g_LruHead;
+    if(g_LruHead != NULL)
+        g_LruHead->LruPrev = dentry;
+    else
+        g_LruTail = dentry;
+    g_LruHead = dentry;
+}
+
+static void Dcache_HashRemove(Dentry* dentry){
+    Dentry** link = &g_Hash[Dcache_Bucket(dentry->Parent, dentry->Hash)];
+    while(*link != dentry)
+        link = &(*link)->HashNext;
+    *link = dentry->HashNext;
+    dentry->HashNext = NULL;
+}
+
+// Drops the least recently used unreferenced entry. Its parent may become
+// unreferenced in turn; it joins the LRU at the head like any other put,
+// since lookups that ended at the directory itself left no trace on the
+// LRU while its children held it.
+bool Dcache_Evict(){
+    Dentry* victim = g_LruTail;
+    if(victim == NULL)
+        return false;
+
+    Dcache_LruRemove(victim);
+    Dcache_HashRemove(victim);
+    g_Stats.Evictions++;
+    g_Stats.Entries--;
+
+    if(victim->Vnode != NULL)
+        VFS_PutVnode(victim->Vnode);
+    else
+        g_Stats.Negative--;
+
+    Dentry* parent = victim->Parent;
+    victim->Parent = NULL;
+    victim->Vnode = NULL;
+    victim->HashNext = g_Free;
+    g_Free = victim;
+
+    if(parent != NULL)
+        Dcache_Put(parent);
+    return true;
+}
+
+static Dentry* Dcache_Allocate(){
+    if(g_Free == NULL && !Dcache_Evict())
+        return NULL;
+
+    Dentry* dentry = g_Free;
+    g_Free = dentry->HashNext;
+    memset(dentry, 0, sizeof(Dentry));
+    return dentry;
+}
+
+Dentry* Dcache_Lookup(Dentry* parent, const char* name, uint32_t length, uint32_t hash){
+    g_Stats.Lookups++;
+
+    for(Dentry* dentry = g_Hash[Dcache_Bucket(parent, hash)]; dentry != NULL; dentry = dentry->HashNext){
+        if(dentry->Parent != parent || dentry->Hash != hash || dentry->NameLength != length)
+            continue;
+        if(memcmp(dentry->Name, name, length) != 0)
+            continue;
+
+        g_Stats.Hits++;
+        if(dentry->Vnode == NULL)
+            g_Stats.NegativeHits++;
+        return Dcache_Get(dentry);
+    }
+    return NULL;
+}
+
+Dentry* Dcache_Add(Dentry* parent, const char* name, uint32_t length, uint32_t hash, Vnode* vnode){
+    if(length > VFS_NAME_MAX)
+        return NULL;
+
+    Dentry* dentry = Dcache_Allocate();
+    if(dentry == NULL)
+        return NULL;
+
+    dentry->Parent = Dcache_Get(parent);
+    dentry->Vnode = vnode;
+    dentry->Hash = hash;
+    dentry->RefCount = 1;
+    dentry->NameLength = length;
+    memcpy(dentry->Name, name, length);
+    dentry->Name[length] = '\0';
+
+    uint32_t bucket = Dcache_Bucket(parent, hash);
+    dentry->HashNext = g_Hash[bucket];
+    g_Hash[bucket] = dentry;
+
+    g_Stats.Entries++;
+    if(vnode == NULL)
+        g_Stats.Negative++;
+    return dentry;
+}
+
+Dentry* Dcache_AddRoot(Vnode* vnode){
+    Dentry* dentry = Dcache_Allocate();
+    if(dentry == NULL)
+        return NULL;
+
+    dentry->Vnode = vnode;
+    dentry->RefCount = 1;
+    dentry->Name[0] = '/';
+    dentry->NameLength = 1;
+    return dentry;
+}
+
+void Dcache_Instantiate(Dentry* dentry, Vnode* vnode){
+    dentry->Vnode = vnode;
+    g_Stats.Negative--;
+}
+
+Dentry* Dcache_Get(Dentry* dentry){
+    if(dentry->RefCount++ == 0)
+        Dcache_LruRemove(dentry);
+    return dentry;
+}
+
+void Dcache_Put(Dentry* dentry){
+    if(--dentry->RefCount != 0)
+        return;
+
+    // mount roots are never unreferenced, everything else stays cached
+    // until evicted
+    Dcache_LruAdd(dentry);
+}
+
+void Dcache_Initialize(){
+    g_Free = NULL;
+    for(int i = DCACHE_ENTRIES - 1; i >= 0; i--){
+        g_Entries[i].HashNext = g_Free;
+        g_Free = &g_Entries[i];
+    }
+}
+
+void Dcache_GetStats(DcacheStats* stats){
+    *stats = g_Stats;
+}
+
+void Dcache_PrintStats(){
+    DcacheStats stats;
+    Dcache_GetStats(&stats);
+
+    printf("===== DCACHE STATS =====\r\n");
+    printf("lookups=%llu hits=%llu (%llu%%) negative hits=%llu\r\n",
+           stats.Lookups, stats.Hits,
+           stats.Lookups ? stats.Hits * 100 / stats.Lookups : 0,
+           stats.NegativeHits);
+    printf("entries=%u negative=%u evictions=%llu\r\n",
+           stats.Entries, stats.Negative, stats.Evictions);
+    printf("========================\r\n");
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "vfs.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DCACHE_ENTRIES              1024
+
+// A name in a directory. Negative entries (no vnode) remember that the
+// name does not exist. Children hold a reference on their parent, so an
+// entry only becomes evictable once nothing below it is cached.
+typedef struct Dentry{
+    struct Dentry* Parent;                  // NULL for the root of a mount
+    Vnode* Vnode;                           // NULL for a negative entry
+    uint32_t Hash;                          // of the name
+    uint32_t RefCount;
+    struct Dentry* HashNext;
+    struct Dentry* LruPrev;                 // unreferenced entries, oldest last
+    struct Dentry* LruNext;
+    uint8_t NameLength;
+    char Name[VFS_NAME_MAX + 1];
+} Dentry;
+
+typedef struct{
+    uint64_t Lookups;
+    uint64_t Hits;
+    uint64_t NegativeHits;                  // of the hits
+    uint64_t Evictions;
+    uint32_t Entries;
+    uint32_t Negative;
+} DcacheStats;
+
+// Called under the VFS lock
+void Dcache_Initialize();
+uint32_t Dcache_HashName(const char* name, uint32_t length);
+
+// Referenced entry for the name, or NULL if it is not cached
+Dentry* Dcache_Lookup(Dentry* parent, const char* name, uint32_t length, uint32_t hash);
+// Caches a name, taking over the vnode reference; NULL vnode makes a
+// negative entry. Returns it referenced, NULL if the cache is full.
+Dentry* Dcache_Add(Dentry* parent, const char* name, uint32_t length, uint32_t hash, Vnode* vnode);
+// An unhashed entry for the root of a mount
+Dentry* Dcache_AddRoot(Vnode* vnode);
+// A negative entry whose name was just created
+void Dcache_Instantiate(Dentry* dentry, Vnode* vnode);
+
+Dentry* Dcache_Get(Dentry* dentry);
+void Dcache_Put(Dentry* dentry);
+// Drops the least recently used unreferenced entry, false if there is none
+bool Dcache_Evict();
+
+void Dcache_GetStats(DcacheStats* stats);
+void Dcache_PrintStats();
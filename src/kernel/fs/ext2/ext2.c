@@ -0,0 +1,654 @@
+#include "ext2.h"
+#include <block/buffer_cache.h>
+#include <block/readahead.h>
+#include <fs/vfs.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+#define EXT2_SUPERBLOCK_OFFSET      1024
+#define EXT2_SUPERBLOCK_SIZE        1024
+#define EXT2_MAGIC                  0xEF53
+#define EXT2_ROOT_INODE             2
+#define EXT2_GOOD_OLD_INODE_SIZE    128
+#define EXT2_MAX_BLOCK_SIZE         BCACHE_BLOCK_SIZE   // pointer blocks fit one cache block
+#define EXT2_MAX_VOLUMES            2
+#define EXT2_MAX_GROUPS             2048
+#define EXT2_MAX_NODES              VFS_MAX_VNODES
+
+#define EXT2_DIRECT_BLOCKS          12
+#define EXT2_INDIRECT_BLOCK         12
+#define EXT2_BLOCK_POINTERS         15
+
+enum {
+    EXT2_S_IFMT                     = 0xF000,
+    EXT2_S_IFDIR                    = 0x4000,
+    EXT2_S_IFREG                    = 0x8000,
+};
+
+enum {
+    EXT2_FEATURE_INCOMPAT_FILETYPE  = 0x0002,
+    EXT2_FEATURE_INCOMPAT_FLEX_BG   = 0x0200,
+    EXT2_FEATURE_RO_COMPAT_LARGE_FILE = 0x0002,
+};
+
+// incompatible features that only change where things are, not how to read them
+#define EXT2_FEATURE_INCOMPAT_SUPPORTED (EXT2_FEATURE_INCOMPAT_FILETYPE | EXT2_FEATURE_INCOMPAT_FLEX_BG)
+
+enum {
+    EXT2_FT_REG_FILE                = 1,
+    EXT2_FT_DIR                     = 2,
+};
+
+typedef struct{
+    uint32_t InodesCount;
+    uint32_t BlocksCount;
+    uint32_t ReservedBlocksCount;
+    uint32_t FreeBlocksCount;
+    uint32_t FreeInodesCount;
+    uint32_t FirstDataBlock;
+    uint32_t LogBlockSize;                  // block size = 1024 << LogBlockSize
+    uint32_t LogFragmentSize;
+    uint32_t BlocksPerGroup;
+    uint32_t FragmentsPerGroup;
+    uint32_t InodesPerGroup;
+    uint32_t MountTime;
+    uint32_t WriteTime;
+    uint16_t MountCount;
+    uint16_t MaxMountCount;
+    uint16_t Magic;
+    uint16_t State;
+    uint16_t Errors;
+    uint16_t MinorRevision;
+    uint32_t LastCheck;
+    uint32_t CheckInterval;
+    uint32_t CreatorOS;
+    uint32_t Revision;
+    uint16_t ReservedUid;
+    uint16_t ReservedGid;
+
+    // revision 1 onwards
+    uint32_t FirstInode;
+    uint16_t InodeSize;
+    uint16_t BlockGroup;
+    uint32_t FeatureCompat;
+    uint32_t FeatureIncompat;
+    uint32_t FeatureRoCompat;
+} __attribute__((packed)) EXT2_Superblock;
+
+typedef struct{
+    uint32_t BlockBitmap;
+    uint32_t InodeBitmap;
+    uint32_t InodeTable;
+    uint16_t FreeBlocksCount;
+    uint16_t FreeInodesCount;
+    uint16_t UsedDirsCount;
+    uint16_t _Pad;
+    uint8_t  _Reserved[12];
+} __attribute__((packed)) EXT2_GroupDescriptor;
+
+typedef struct{
+    uint16_t Mode;
+    uint16_t Uid;
+    uint32_t Size;
+    uint32_t AccessTime;
+    uint32_t ChangeTime;
+    uint32_t ModifyTime;
+    uint32_t DeleteTime;
+    uint16_t Gid;
+    uint16_t LinksCount;
+    uint32_t Sectors;
+    uint32_t Flags;
+    uint32_t _Os1;
+    uint32_t Block[EXT2_BLOCK_POINTERS];
+    uint32_t Generation;
+    uint32_t FileAcl;
+    uint32_t SizeHigh;                      // directory ACL before large files
+    uint32_t FragmentAddress;
+    uint8_t  _Os2[12];
+} __attribute__((packed)) EXT2_Inode;
+
+typedef struct{
+    uint32_t Inode;                         // 0: unused
+    uint16_t RecordLength;
+    uint8_t  NameLength;
+    uint8_t  FileType;                      // with the filetype feature only
+    char     Name[];
+} __attribute__((packed)) EXT2_DirectoryEntry;
+
+#define EXT2_DIRENT_HEADER          8
+
+typedef struct{
+    BlockDevice* Device;                    // NULL while the slot is free
+    uint32_t BlockSize;
+    uint32_t PointersPerBlock;
+    uint32_t BlocksCount;
+    uint32_t InodesCount;
+    uint32_t InodesPerGroup;
+    uint32_t InodeSize;
+    uint32_t GroupCount;
+    bool FileType;                          // directory entries carry the type
+    bool LargeFiles;
+    EXT2_GroupDescriptor* Groups;           // the whole table, read at mount
+} EXT2Volume;
+
+// Vnode private data
+typedef struct{
+    EXT2Volume* Volume;                     // NULL while the slot is free
+    uint32_t Inode;
+    uint32_t Block[EXT2_BLOCK_POINTERS];
+} EXT2Node;
+
+static EXT2Volume g_Volumes[EXT2_MAX_VOLUMES];
+static EXT2_GroupDescriptor g_Groups[EXT2_MAX_VOLUMES][EXT2_MAX_GROUPS];
+static EXT2Node g_Nodes[EXT2_MAX_NODES];
+static EXT2Stats g_Stats;
+
+//
+// Disk access, everything goes through the buffer cache
+//
+
+static bool EXT2_Transfer(EXT2Volume* volume, uint64_t offset, void* buffer, uint32_t length){
+    uint8_t* data = (uint8_t*)buffer;
+
+    while(length > 0){
+        uint32_t inBlock = offset % BCACHE_BLOCK_SIZE;
+        uint32_t chunk = BCACHE_BLOCK_SIZE - inBlock;
+        if(chunk > length)
+            chunk = length;
+
+        Buffer* block = BufferCache_Get(volume->Device, offset / BCACHE_BLOCK_SIZE);
+        if(block == NULL)
+            return false;
+        memcpy(data, block->Data + inBlock, chunk);
+        BufferCache_Release(block);
+
+        offset += chunk;
+        length -= chunk;
+        data += chunk;
+    }
+    return true;
+}
+
+static uint64_t EXT2_BlockOffset(EXT2Volume* volume, uint32_t block){
+    return (uint64_t)block * volume->BlockSize;
+}
+
+static bool EXT2_ReadInode(EXT2Volume* volume, uint32_t inode, EXT2_Inode* out){
+    if(inode == 0 || inode > volume->InodesCount)
+        return false;
+
+    uint32_t group = (inode - 1) / volume->InodesPerGroup;
+    uint32_t index = (inode - 1) % volume->InodesPerGroup;
+    uint64_t offset = EXT2_BlockOffset(volume, volume->Groups[group].InodeTable) + (uint64_t)index * volume->InodeSize;
+
+    g_Stats.InodeReads++;
+    return EXT2_Transfer(volume, offset, out, sizeof(EXT2_Inode));
+}
+
+static uint64_t EXT2_InodeSize(EXT2Volume* volume, const EXT2_Inode* inode){
+    uint64_t size = inode->Size;
+    if(volume->LargeFiles && (inode->Mode & EXT2_S_IFMT) == EXT2_S_IFREG)
+        size |= (uint64_t)inode->SizeHigh << 32;
+    return size;
+}
+
+//
+// Block map
+//
+
+// Finds the array of block pointers holding the one for logical block index
+// and where in it that one is. Pointer blocks are looked at in place in the
+// cache, *held then has to be released. A missing pointer block makes the
+// whole range below it a hole: *array is NULL and *count how many blocks
+// from index on it covers.
+static bool EXT2_PointerArray(EXT2Volume* volume, EXT2Node* node, uint32_t index, Buffer** held, const uint32_t** array, uint32_t* position, uint32_t* count){
+    *held = NULL;
+    if(index < EXT2_DIRECT_BLOCKS){
+        *array = node->Block;
+        *position = index;
+        *count = EXT2_DIRECT_BLOCKS;
+        return true;
+    }
+
+    // single, double and triple indirect: each level spans ptrs times more
+    uint32_t ptrs = volume->PointersPerBlock;
+    uint32_t level = 1;
+    uint64_t span = ptrs;
+    index -= EXT2_DIRECT_BLOCKS;
+    while(index >= span){
+        index -= span;
+        if(++level > 3)
+            return false;
+        span *= ptrs;
+    }
+
+    uint32_t block = node->Block[EXT2_INDIRECT_BLOCK + level - 1];
+    for(;;){
+        if(block == 0 || block >= volume->BlocksCount){
+            *array = NULL;
+            *position = 0;
+            *count = span - index;
+            return true;
+        }
+
+        uint64_t offset = EXT2_BlockOffset(volume, block);
+        Buffer* buffer = BufferCache_Get(volume->Device, offset / BCACHE_BLOCK_SIZE);
+        if(buffer == NULL)
+            return false;
+        const uint32_t* pointers = (const uint32_t*)(buffer->Data + offset % BCACHE_BLOCK_SIZE);
+
+        span /= ptrs;
+        if(span == 1){
+            *held = buffer;
+            *array = pointers;
+            *position = index;
+            *count = ptrs;
+            return true;
+        }
+
+        block = pointers[index / span];
+        index %= span;
+        BufferCache_Release(buffer);
+    }
+}
+
+// The physical block of logical block index, 0 for a hole, and how many of
+// the following (at most max in all) continue it on disk or in the hole
+static bool EXT2_Run(EXT2Volume* volume, EXT2Node* node, uint32_t index, uint32_t max, uint32_t* block, uint32_t* length){
+    Buffer* held;
+    const uint32_t* array;
+    uint32_t position, count;
+    if(!EXT2_PointerArray(volume, node, index, &held, &array, &position, &count))
+        return false;
+
+    uint32_t available = count - position;
+    if(available > max)
+        available = max;
+
+    if(array == NULL){
+        *block = 0;
+        *length = available;
+        return true;
+    }
+
+    // consecutive pointers to consecutive blocks, or a run of holes
+    uint32_t first = array[position];
+    if(first >= volume->BlocksCount)
+        first = 0;
+    uint32_t run = 1;
+    while(run < available && array[position + run] == (first != 0 ? first + run : 0))
+        run++;
+
+    if(held != NULL)
+        BufferCache_Release(held);
+
+    *block = first;
+    *length = run;
+    return true;
+}
+
+static VfsStatus EXT2_FileRead(EXT2Volume* volume, EXT2Node* node, uint64_t offset, uint8_t* buffer, uint32_t count, uint32_t* done){
+    *done = 0;
+    while(count > 0){
+        uint32_t inBlock = offset % volume->BlockSize;
+        uint32_t maxBlocks = (inBlock + count + volume->BlockSize - 1) / volume->BlockSize;
+
+        uint32_t block, blocks;
+        if(!EXT2_Run(volume, node, offset / volume->BlockSize, maxBlocks, &block, &blocks))
+            return VFS_IO_ERROR;
+
+        uint32_t chunk = blocks * volume->BlockSize - inBlock;
+        if(chunk > count)
+            chunk = count;
+
+        if(block == 0){
+            memset(buffer, 0, chunk);
+            g_Stats.Holes++;
+        } else {
+            // a run spanning several cache blocks is started as a whole so
+            // the block layer can merge it into one request
+            uint64_t start = EXT2_BlockOffset(volume, block) + inBlock;
+            uint64_t first = start / BCACHE_BLOCK_SIZE;
+            uint64_t last = (start + chunk - 1) / BCACHE_BLOCK_SIZE;
+            if(last > first)
+                BufferCache_Prefetch(volume->Device, first, last - first + 1);
+
+            if(!EXT2_Transfer(volume, start, buffer, chunk))
+                return VFS_IO_ERROR;
+            g_Stats.Runs++;
+            g_Stats.Blocks += blocks;
+        }
+
+        offset += chunk;
+        count -= chunk;
+        *done += chunk;
+        buffer += chunk;
+    }
+    return VFS_OK;
+}
+
+//
+// Nodes
+//
+
+static EXT2Node* EXT2_AllocateNode(EXT2Volume* volume, uint32_t inode, const EXT2_Inode* data){
+    for(uint32_t i = 0; i < EXT2_MAX_NODES; i++){
+        EXT2Node* node = &g_Nodes[i];
+        if(node->Volume != NULL)
+            continue;
+
+        node->Volume = volume;
+        node->Inode = inode;
+        memcpy(node->Block, data->Block, sizeof(node->Block));
+        return node;
+    }
+    return NULL;
+}
+
+static VfsStatus EXT2_FillVnode(EXT2Volume* volume, uint32_t inode, Vnode* out){
+    EXT2_Inode data;
+    if(!EXT2_ReadInode(volume, inode, &data))
+        return VFS_IO_ERROR;
+
+    EXT2Node* node = EXT2_AllocateNode(volume, inode, &data);
+    if(node == NULL)
+        return VFS_NO_RESOURCES;
+
+    // anything that is not a directory reads as a file
+    bool directory = (data.Mode & EXT2_S_IFMT) == EXT2_S_IFDIR;
+    out->Type = directory ? VNODE_DIRECTORY : VNODE_FILE;
+    out->Size = EXT2_InodeSize(volume, &data);
+    out->Id = inode;
+    out->Private = node;
+    return VFS_OK;
+}
+
+//
+// Directories
+//
+
+// Walks a directory's records in place in the cache, a file system block
+// at a time
+typedef struct{
+    EXT2Volume* Volume;
+    EXT2Node*   Dir;
+    uint64_t    Size;
+    uint64_t    Offset;                     // of the next record
+    uint64_t    Current;                    // of the record returned last
+    Buffer*     Block;
+    uint64_t    BlockEnd;                   // directory offset where the held block ends
+    uint8_t*    Data;                       // directory offset BlockEnd - BlockSize in the held block
+    VfsStatus   Status;
+} EXT2DirectoryIterator;
+
+static void EXT2_IteratorBegin(EXT2DirectoryIterator* it, EXT2Volume* volume, Vnode* dir, uint64_t offset){
+    it->Volume = volume;
+    it->Dir = (EXT2Node*)dir->Private;
+    it->Size = dir->Size;
+    it->Offset = offset;
+    it->Current = offset;
+    it->Block = NULL;
+    it->BlockEnd = 0;
+    it->Data = NULL;
+    it->Status = VFS_OK;
+}
+
+static void EXT2_IteratorEnd(EXT2DirectoryIterator* it){
+    if(it->Block != NULL)
+        BufferCache_Release(it->Block);
+    it->Block = NULL;
+}
+
+// The next used record, valid until the following call; NULL at the end or
+// on errors, with Status set
+static EXT2_DirectoryEntry* EXT2_IteratorNext(EXT2DirectoryIterator* it){
+    EXT2Volume* volume = it->Volume;
+
+    while(it->Offset < it->Size){
+        // records never cross file system blocks
+        if(it->Block == NULL || it->Offset >= it->BlockEnd){
+            EXT2_IteratorEnd(it);
+
+            uint32_t index = it->Offset / volume->BlockSize;
+            uint32_t block, blocks;
+            if(!EXT2_Run(volume, it->Dir, index, 1, &block, &blocks)){
+                it->Status = VFS_IO_ERROR;
+                return NULL;
+            }
+            if(block == 0){
+                it->Offset = (uint64_t)(index + 1) * volume->BlockSize;
+                continue;
+            }
+
+            uint64_t offset = EXT2_BlockOffset(volume, block);
+            it->Block = BufferCache_Get(volume->Device, offset / BCACHE_BLOCK_SIZE);
+            if(it->Block == NULL){
+                it->Status = VFS_IO_ERROR;
+                return NULL;
+            }
+            it->Data = it->Block->Data + offset % BCACHE_BLOCK_SIZE;
+            it->BlockEnd = (uint64_t)(index + 1) * volume->BlockSize;
+        }
+
+        uint32_t inBlock = it->Offset % volume->BlockSize;
+        EXT2_DirectoryEntry* entry = (EXT2_DirectoryEntry*)(it->Data + inBlock);
+        if(inBlock + EXT2_DIRENT_HEADER > volume->BlockSize || entry->RecordLength < EXT2_DIRENT_HEADER ||
+           inBlock + entry->RecordLength > volume->BlockSize || EXT2_DIRENT_HEADER + entry->NameLength > entry->RecordLength){
+            it->Status = VFS_INVALID;
+            return NULL;
+        }
+
+        it->Current = it->Offset;
+        it->Offset += entry->RecordLength;
+        if(entry->Inode != 0)
+            return entry;
+    }
+    return NULL;
+}
+
+static VfsStatus EXT2_Lookup(Vnode* dir, const char* name, Vnode* out){
+    EXT2Volume* volume = (EXT2Volume*)dir->Mount->Private;
+    uint32_t length = 0;
+    while(name[length] != '\0')
+        length++;
+
+    EXT2DirectoryIterator it;
+    EXT2_IteratorBegin(&it, volume, dir, 0);
+
+    EXT2_DirectoryEntry* entry;
+    while((entry = EXT2_IteratorNext(&it)) != NULL){
+        if(entry->NameLength != length || memcmp(entry->Name, name, length) != 0)
+            continue;
+
+        uint32_t inode = entry->Inode;
+        EXT2_IteratorEnd(&it);
+        return EXT2_FillVnode(volume, inode, out);
+    }
+
+    EXT2_IteratorEnd(&it);
+    return it.Status != VFS_OK ? it.Status : VFS_NOT_FOUND;
+}
+
+static VfsStatus EXT2_ReadDir(Vnode* dir, uint64_t* cookie, VfsDirEntry* out){
+    EXT2Volume* volume = (EXT2Volume*)dir->Mount->Private;
+
+    EXT2DirectoryIterator it;
+    EXT2_IteratorBegin(&it, volume, dir, *cookie);
+
+    EXT2_DirectoryEntry* entry;
+    while((entry = EXT2_IteratorNext(&it)) != NULL){
+        *cookie = it.Offset;
+        if(entry->Name[0] == '.' && (entry->NameLength == 1 || (entry->NameLength == 2 && entry->Name[1] == '.')))
+            continue;
+
+        uint32_t length = entry->NameLength <= VFS_NAME_MAX ? entry->NameLength : VFS_NAME_MAX;
+        memcpy(out->Name, entry->Name, length);
+        out->Name[length] = '\0';
+        uint32_t inode = entry->Inode;
+        uint8_t type = entry->FileType;
+        EXT2_IteratorEnd(&it);
+
+        // the size is only in the inode, and so is the type without the filetype feature
+        EXT2_Inode data;
+        if(!EXT2_ReadInode(volume, inode, &data))
+            return VFS_IO_ERROR;
+
+        bool directory = volume->FileType ? type == EXT2_FT_DIR : (data.Mode & EXT2_S_IFMT) == EXT2_S_IFDIR;
+        out->Type = directory ? VNODE_DIRECTORY : VNODE_FILE;
+        out->Size = directory ? 0 : EXT2_InodeSize(volume, &data);
+        return VFS_OK;
+    }
+
+    *cookie = it.Offset;
+    EXT2_IteratorEnd(&it);
+    return it.Status != VFS_OK ? it.Status : VFS_NOT_FOUND;
+}
+
+//
+// Files
+//
+
+static VfsStatus EXT2_Read(Vnode* vnode, uint64_t offset, void* buffer, uint32_t count, uint32_t* done){
+    EXT2Volume* volume = (EXT2Volume*)vnode->Mount->Private;
+    return EXT2_FileRead(volume, (EXT2Node*)vnode->Private, offset, (uint8_t*)buffer, count, done);
+}
+
+// Readahead: the contiguous blocks from offset on, a window at most
+static bool EXT2_Map(void* file, uint64_t offset, uint64_t* lba, uint32_t* sectors){
+    Vnode* vnode = (Vnode*)file;
+    EXT2Volume* volume = (EXT2Volume*)vnode->Mount->Private;
+    EXT2Node* node = (EXT2Node*)vnode->Private;
+
+    uint32_t inBlock = offset % volume->BlockSize;
+    uint32_t max = READAHEAD_MAX_WINDOW / volume->BlockSize + 1;
+    uint32_t block, blocks;
+    if(!EXT2_Run(volume, node, offset / volume->BlockSize, max, &block, &blocks) || block == 0)
+        return false;
+
+    *lba = EXT2_BlockOffset(volume, block) / BLOCK_SECTOR_SIZE + inBlock / BLOCK_SECTOR_SIZE;
+    *sectors = blocks * (volume->BlockSize / BLOCK_SECTOR_SIZE) - inBlock / BLOCK_SECTOR_SIZE;
+    return true;
+}
+
+static void EXT2_Release(Vnode* vnode){
+    EXT2Node* node = (EXT2Node*)vnode->Private;
+    if(node != NULL)
+        node->Volume = NULL;
+}
+
+//
+// Mounting
+//
+
+static VfsStatus EXT2_Mount(Mount* mount, Vnode* root){
+    union{
+        EXT2_Superblock Superblock;
+        uint8_t Bytes[EXT2_SUPERBLOCK_SIZE];
+    } sb;
+
+    if(!BufferCache_ReadSectors(mount->Device, EXT2_SUPERBLOCK_OFFSET / BLOCK_SECTOR_SIZE,
+                                EXT2_SUPERBLOCK_SIZE / BLOCK_SECTOR_SIZE, sb.Bytes))
+        return VFS_IO_ERROR;
+
+    EXT2_Superblock* super = &sb.Superblock;
+    if(super->Magic != EXT2_MAGIC)
+        return VFS_INVALID;
+    if(super->LogBlockSize > 2 || (1024u << super->LogBlockSize) > EXT2_MAX_BLOCK_SIZE)
+        return VFS_INVALID;
+    if(super->BlocksPerGroup == 0 || super->InodesPerGroup == 0 || super->FirstDataBlock >= super->BlocksCount)
+        return VFS_INVALID;
+
+    if(super->Revision >= 1 && (super->FeatureIncompat & ~EXT2_FEATURE_INCOMPAT_SUPPORTED)){
+        printf("[EXT2] %s: unsupported features %x\r\n", mount->Device->Name,
+               super->FeatureIncompat & ~EXT2_FEATURE_INCOMPAT_SUPPORTED);
+        return VFS_INVALID;
+    }
+
+    EXT2Volume* volume = NULL;
+    for(uint32_t i = 0; i < EXT2_MAX_VOLUMES && volume == NULL; i++){
+        if(g_Volumes[i].Device == NULL)
+            volume = &g_Volumes[i];
+    }
+    if(volume == NULL)
+        return VFS_NO_RESOURCES;
+
+    memset(volume, 0, sizeof(EXT2Volume));
+    volume->BlockSize = 1024u << super->LogBlockSize;
+    volume->PointersPerBlock = volume->BlockSize / sizeof(uint32_t);
+    volume->BlocksCount = super->BlocksCount;
+    volume->InodesCount = super->InodesCount;
+    volume->InodesPerGroup = super->InodesPerGroup;
+    volume->InodeSize = super->Revision >= 1 ? super->InodeSize : EXT2_GOOD_OLD_INODE_SIZE;
+    volume->GroupCount = (super->BlocksCount - super->FirstDataBlock + super->BlocksPerGroup - 1) / super->BlocksPerGroup;
+    volume->FileType = super->Revision >= 1 && (super->FeatureIncompat & EXT2_FEATURE_INCOMPAT_FILETYPE);
+    volume->LargeFiles = super->Revision >= 1 && (super->FeatureRoCompat & EXT2_FEATURE_RO_COMPAT_LARGE_FILE);
+
+    if(volume->InodeSize < EXT2_GOOD_OLD_INODE_SIZE || (volume->InodeSize & (volume->InodeSize - 1)))
+        return VFS_INVALID;
+    if((uint64_t)volume->BlocksCount * volume->BlockSize / BLOCK_SECTOR_SIZE > mount->Device->SectorCount)
+        return VFS_INVALID;
+    if(volume->GroupCount > EXT2_MAX_GROUPS){
+        printf("[EXT2] %s: %u block groups are too many\r\n", mount->Device->Name, volume->GroupCount);
+        return VFS_NO_RESOURCES;
+    }
+
+    // the descriptor table follows the superblock's block, every inode
+    // lookup needs it so it stays in memory
+    volume->Device = mount->Device;
+    volume->Groups = g_Groups[volume - g_Volumes];
+    uint64_t table = EXT2_BlockOffset(volume, super->FirstDataBlock + 1);
+    if(!EXT2_Transfer(volume, table, volume->Groups, volume->GroupCount * sizeof(EXT2_GroupDescriptor))){
+        volume->Device = NULL;
+        return VFS_IO_ERROR;
+    }
+
+    EXT2_Inode data;
+    EXT2Node* node = NULL;
+    if(EXT2_ReadInode(volume, EXT2_ROOT_INODE, &data) && (data.Mode & EXT2_S_IFMT) == EXT2_S_IFDIR)
+        node = EXT2_AllocateNode(volume, EXT2_ROOT_INODE, &data);
+    if(node == NULL){
+        volume->Device = NULL;
+        return VFS_INVALID;
+    }
+
+    root->Type = VNODE_DIRECTORY;
+    root->Id = EXT2_ROOT_INODE;
+    root->Size = data.Size;
+    root->Private = node;
+    mount->Private = volume;
+
+    printf("[EXT2] %s: %u blocks of %u bytes, %u groups, %u inodes\r\n",
+           mount->Device->Name, volume->BlocksCount, volume->BlockSize, volume->GroupCount, volume->InodesCount);
+    return VFS_OK;
+}
+
+static FileSystem g_FileSystem = {
+    .Name = "ext2",
+    .CaseInsensitive = false,
+    .Mount = EXT2_Mount,
+    .Lookup = EXT2_Lookup,
+    .Read = EXT2_Read,
+    .ReadDir = EXT2_ReadDir,
+    .Release = EXT2_Release,
+    .Map = EXT2_Map,
+};
+
+void EXT2_Initialize(){
+    VFS_RegisterFileSystem(&g_FileSystem);
+}
+
+void EXT2_GetStats(EXT2Stats* stats){
+    *stats = g_Stats;
+}
+
+void EXT2_PrintStats(){
+    EXT2Stats stats;
+    EXT2_GetStats(&stats);
+
+    printf("===== EXT2 STATS =====\r\n");
+    printf("runs=%llu blocks=%llu blocks/run=%llu holes=%llu\r\n",
+           stats.Runs, stats.Blocks, stats.Runs ? stats.Blocks / stats.Runs : 0, stats.Holes);
+    printf("inode reads=%llu\r\n", stats.InodeReads);
+    printf("======================\r\n");
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct{
+    uint64_t Runs;                          // physically contiguous pieces read
+    uint64_t Blocks;                        // file system blocks in them
+    uint64_t Holes;                         // unallocated pieces, zero filled
+    uint64_t InodeReads;
+} EXT2Stats;
+
+// Registers the read only driver with the VFS
+void EXT2_Initialize();
+
+void EXT2_GetStats(EXT2Stats* stats);
+void EXT2_PrintStats();
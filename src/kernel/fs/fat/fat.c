@@ -0,0 +1,1226 @@
+#include "fat.h"
+#include <block/buffer_cache.h>
+#include <fs/vfs.h>
+#include <util/trace.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+#define FAT_SECTOR_SIZE             512
+#define FAT_MAX_VOLUMES             2
+#define FAT_MAX_NODES               VFS_MAX_VNODES
+#define FAT_BITMAP_CLUSTERS         (1024 * 1024)   // larger volumes mount read only
+#define FAT_ENTRY_SIZE              sizeof(FAT_DirectoryEntry)
+
+#define FAT_CLUSTER_FREE            0
+#define FAT_CLUSTER_END             0xFFFFFFFF      // end of chain, bad clusters included
+
+#define FAT_FSINFO_LEAD_SIGNATURE   0x41615252
+#define FAT_FSINFO_STRUCT_SIGNATURE 0x61417272
+#define FAT_FSINFO_TRAIL_SIGNATURE  0xAA550000
+#define FAT_FSINFO_UNKNOWN          0xFFFFFFFF
+
+#define FAT_ENTRY_END               0x00            // first byte: no entries follow
+#define FAT_ENTRY_DELETED           0xE5
+
+enum {
+    FAT_CASE_LOWER_BASE         = 0x08,
+    FAT_CASE_LOWER_EXTENSION    = 0x10,
+};
+
+enum FATType{
+    FAT12 = 12,
+    FAT16 = 16,
+    FAT32 = 32,
+};
+
+typedef struct{
+    // extended boot record
+    uint8_t  DriveNumber;
+    uint8_t  _Reserved;
+    uint8_t  Signature;
+    uint32_t VolumeId;
+    uint8_t  VolumeLabel[11];
+    uint8_t  SystemId[8];
+} __attribute__((packed)) FATExtendedBootRecord;
+
+typedef struct{
+    uint32_t SectorsPerFat;
+    uint16_t Flags;
+    uint16_t VersionNumber;
+    uint32_t RootdirCluster;
+    uint16_t FSInfoSector;
+    uint16_t BackupBootSector;
+    uint8_t  _Reserved[12];
+    FATExtendedBootRecord EBR;
+} __attribute__((packed)) FAT32ExtendedBootRecord;
+
+typedef struct{
+    uint8_t  BootJumpInstruction[3];
+    uint8_t  OemIdentifier[8];
+    uint16_t BytesPerSector;
+    uint8_t  SectorsPerCluster;
+    uint16_t ReservedSectors;
+    uint8_t  FatCount;
+    uint16_t DirEntryCount;
+    uint16_t TotalSectors;
+    uint8_t  MediaDescriptorType;
+    uint16_t SectorsPerFat;
+    uint16_t SectorsPerTrack;
+    uint16_t Heads;
+    uint32_t HiddenSectors;
+    uint32_t LargeSectorCount;
+
+    union{
+        FATExtendedBootRecord   EBR1216;
+        FAT32ExtendedBootRecord EBR32;
+    };
+} __attribute__((packed)) FAT_BootSector;
+
+typedef struct{
+    uint32_t LeadSignature;
+    uint8_t  _Reserved[480];
+    uint32_t StructSignature;
+    uint32_t FreeCount;
+    uint32_t NextFree;
+    uint8_t  _Reserved2[12];
+    uint32_t TrailSignature;
+} __attribute__((packed)) FAT_FSInfo;
+
+typedef struct{
+    BlockDevice* Device;                    // NULL while the slot is free
+    uint8_t Type;
+    bool ReadOnly;
+    uint32_t SectorsPerCluster;
+    uint32_t ClusterSize;
+    uint32_t FatStart;
+    uint32_t FatCount;
+    uint32_t SectorsPerFat;
+    uint32_t RootStart;                     // FAT12/16: fixed root directory
+    uint32_t RootEntries;
+    uint32_t RootCluster;                   // FAT32
+    uint32_t DataStart;
+    uint32_t ClusterCount;                  // data clusters, numbered from 2
+    uint32_t FSInfoSector;                  // 0: none
+
+    // allocation state, built from the FAT at mount
+    uint32_t* Bitmap;                       // bit set: cluster in use
+    uint32_t FreeCount;
+    uint32_t NextFree;                      // where the next search starts
+    bool FSInfoDirty;
+
+    // FAT sectors changed since the copies were last brought up to date
+    uint32_t FatDirtyFirst;
+    uint32_t FatDirtyLast;
+} FATVolume;
+
+// Vnode private data
+typedef struct{
+    FATVolume* Volume;                      // NULL while the slot is free
+    uint32_t FirstCluster;                  // 0: empty file or the fixed root
+    uint64_t Entry;                         // byte offset of the directory entry, 0 for the root
+    uint32_t CachedIndex;                   // last position walked to in the chain
+    uint32_t CachedCluster;
+} FATNode;
+
+static FATVolume g_Volumes[FAT_MAX_VOLUMES];
+static uint32_t g_Bitmaps[FAT_MAX_VOLUMES][FAT_BITMAP_CLUSTERS / 32];
+static FATNode g_Nodes[FAT_MAX_NODES];
+static uint8_t g_MirrorBuffer[BCACHE_BLOCK_SIZE];
+static FATStats g_Stats;
+
+//
+// Disk access, everything goes through the buffer cache
+//
+
+// Copies between buffer and the device bytes at offset. Writing with a
+// NULL buffer zeroes the range.
+static bool FAT_Transfer(FATVolume* volume, uint64_t offset, void* buffer, uint32_t length, bool write){
+    uint8_t* data = (uint8_t*)buffer;
+
+    while(length > 0){
+        uint32_t inBlock = offset % BCACHE_BLOCK_SIZE;
+        uint32_t chunk = BCACHE_BLOCK_SIZE - inBlock;
+        if(chunk > length)
+            chunk = length;
+
+        Buffer* block = BufferCache_Get(volume->Device, offset / BCACHE_BLOCK_SIZE);
+        if(block == NULL)
+            return false;
+
+        if(!write){
+            memcpy(data, block->Data + inBlock, chunk);
+        } else {
+            if(data != NULL)
+                memcpy(block->Data + inBlock, data, chunk);
+            else
+                memset(block->Data + inBlock, 0, chunk);
+            BufferCache_MarkDirty(block);
+        }
+        BufferCache_Release(block);
+
+        offset += chunk;
+        length -= chunk;
+        if(data != NULL)
+            data += chunk;
+    }
+    return true;
+}
+
+static uint64_t FAT_ClusterOffset(FATVolume* volume, uint32_t cluster){
+    return ((uint64_t)volume->DataStart + (uint64_t)(cluster - 2) * volume->SectorsPerCluster) * FAT_SECTOR_SIZE;
+}
+
+static bool FAT_IsCluster(FATVolume* volume, uint32_t cluster){
+    return cluster >= 2 && cluster < volume->ClusterCount + 2;
+}
+
+//
+// File allocation table
+//
+
+static uint32_t FAT_EntryOffset(FATVolume* volume, uint32_t cluster){
+    if(volume->Type == FAT12)
+        return cluster + cluster / 2;
+    return cluster * (volume->Type / 8);
+}
+
+// Next cluster of the chain, FAT_CLUSTER_END past the last one
+static bool FAT_GetNext(FATVolume* volume, uint32_t cluster, uint32_t* next){
+    uint64_t offset = (uint64_t)volume->FatStart * FAT_SECTOR_SIZE + FAT_EntryOffset(volume, cluster);
+    uint32_t value = 0;
+
+    if(!FAT_Transfer(volume, offset, &value, volume->Type == FAT32 ? 4 : 2, false))
+        return false;
+
+    if(volume->Type == FAT12)
+        value = (cluster & 1) ? value >> 4 : value & 0x0FFF;
+    else if(volume->Type == FAT32)
+        value &= 0x0FFFFFFF;
+
+    // reserved, bad or end of chain values all end it
+    if(value != FAT_CLUSTER_FREE && !FAT_IsCluster(volume, value))
+        value = FAT_CLUSTER_END;
+    *next = value;
+    return true;
+}
+
+static bool FAT_SetNext(FATVolume* volume, uint32_t cluster, uint32_t next){
+    uint32_t offset = FAT_EntryOffset(volume, cluster);
+    uint64_t position = (uint64_t)volume->FatStart * FAT_SECTOR_SIZE + offset;
+    uint32_t length = volume->Type == FAT32 ? 4 : 2;
+    uint32_t value = 0;
+
+    if(volume->Type == FAT12){
+        if(next == FAT_CLUSTER_END)
+            next = 0x0FFF;
+        if(!FAT_Transfer(volume, position, &value, 2, false))
+            return false;
+        if(cluster & 1)
+            value = (value & 0x000F) | (next << 4);
+        else
+            value = (value & 0xF000) | next;
+    } else if(volume->Type == FAT16){
+        value = next == FAT_CLUSTER_END ? 0xFFFF : next;
+    } else {
+        // the top four bits are reserved and kept
+        if(!FAT_Transfer(volume, position, &value, 4, false))
+            return false;
+        value = (value & 0xF0000000) | (next == FAT_CLUSTER_END ? 0x0FFFFFFF : next);
+    }
+
+    if(!FAT_Transfer(volume, position, &value, length, true))
+        return false;
+
+    // only the first FAT is written here, FAT_FlushFat mirrors the range
+    uint32_t first = offset / FAT_SECTOR_SIZE;
+    uint32_t last = (offset + length - 1) / FAT_SECTOR_SIZE;
+    if(first < volume->FatDirtyFirst)
+        volume->FatDirtyFirst = first;
+    if(last > volume->FatDirtyLast || volume->FatDirtyLast == FAT_CLUSTER_END)
+        volume->FatDirtyLast = last;
+    return true;
+}
+
+static void FAT_MarkFatClean(FATVolume* volume){
+    volume->FatDirtyFirst = FAT_CLUSTER_END;
+    volume->FatDirtyLast = FAT_CLUSTER_END;
+}
+
+// Copies the FAT sectors changed by the last operation to the other FATs,
+// once per operation instead of once per entry
+static bool FAT_FlushFat(FATVolume* volume){
+    if(volume->FatDirtyLast == FAT_CLUSTER_END)
+        return true;
+
+    uint32_t first = volume->FatDirtyFirst;
+    uint32_t count = volume->FatDirtyLast - first + 1;
+    FAT_MarkFatClean(volume);
+
+    g_Stats.FatFlushes++;
+    g_Stats.FatSectorsMirrored += count;
+
+    while(count > 0){
+        uint32_t chunk = count < BCACHE_BLOCK_SECTORS ? count : BCACHE_BLOCK_SECTORS;
+        if(!BufferCache_ReadSectors(volume->Device, volume->FatStart + first, chunk, g_MirrorBuffer))
+            return false;
+
+        for(uint32_t copy = 1; copy < volume->FatCount; copy++){
+            uint32_t lba = volume->FatStart + copy * volume->SectorsPerFat + first;
+            if(!BufferCache_WriteSectors(volume->Device, lba, chunk, g_MirrorBuffer))
+                return false;
+        }
+
+        first += chunk;
+        count -= chunk;
+    }
+    return true;
+}
+
+//
+// Free cluster bitmap
+//
+
+static bool FAT_IsUsed(FATVolume* volume, uint32_t cluster){
+    return volume->Bitmap[cluster / 32] & (1u << (cluster % 32));
+}
+
+static void FAT_SetUsed(FATVolume* volume, uint32_t cluster, bool used){
+    if(used){
+        volume->Bitmap[cluster / 32] |= 1u << (cluster % 32);
+        volume->FreeCount--;
+    } else {
+        volume->Bitmap[cluster / 32] &= ~(1u << (cluster % 32));
+        volume->FreeCount++;
+    }
+    volume->FSInfoDirty = true;
+}
+
+// Scans the whole FAT once. Clusters 0 and 1 and anything past the end of
+// the last bitmap word count as used, so searches never return them.
+static bool FAT_BuildBitmap(FATVolume* volume){
+    uint32_t words = (volume->ClusterCount + 2 + 31) / 32;
+    memset(volume->Bitmap, 0xFF, words * sizeof(uint32_t));
+    volume->FreeCount = 0;
+
+    if(volume->Type == FAT12){
+        for(uint32_t cluster = 2; cluster < volume->ClusterCount + 2; cluster++){
+            uint32_t next;
+            if(!FAT_GetNext(volume, cluster, &next))
+                return false;
+            if(next == FAT_CLUSTER_FREE){
+                volume->Bitmap[cluster / 32] &= ~(1u << (cluster % 32));
+                volume->FreeCount++;
+            }
+        }
+        return true;
+    }
+
+    // whole blocks at a time, the entries never straddle them
+    uint32_t perBlock = BCACHE_BLOCK_SIZE / (volume->Type / 8);
+    uint64_t start = (uint64_t)volume->FatStart * FAT_SECTOR_SIZE;
+    uint32_t cluster = 0;
+    while(cluster < volume->ClusterCount + 2){
+        uint64_t offset = start + FAT_EntryOffset(volume, cluster);
+        Buffer* block = BufferCache_Get(volume->Device, offset / BCACHE_BLOCK_SIZE);
+        if(block == NULL)
+            return false;
+
+        uint32_t index = (offset % BCACHE_BLOCK_SIZE) / (volume->Type / 8);
+        for(; index < perBlock && cluster < volume->ClusterCount + 2; index++, cluster++){
+            uint32_t value = volume->Type == FAT16
+                ? ((uint16_t*)block->Data)[index]
+                : ((uint32_t*)block->Data)[index] & 0x0FFFFFFF;
+            if(cluster >= 2 && value == FAT_CLUSTER_FREE){
+                volume->Bitmap[cluster / 32] &= ~(1u << (cluster % 32));
+                volume->FreeCount++;
+            }
+        }
+        BufferCache_Release(block);
+    }
+    return true;
+}
+
+// Free clusters for count more: right behind the file's last cluster if
+// that is free, else the first run of at least count from the hint, else
+// the longest run there is. Returns 0 when nothing is free.
+static uint32_t FAT_FindRun(FATVolume* volume, uint32_t after, uint32_t count, uint32_t* length){
+    uint32_t end = volume->ClusterCount + 2;
+
+    if(after != 0 && after + 1 < end && !FAT_IsUsed(volume, after + 1)){
+        uint32_t run = 1;
+        while(run < count && after + 1 + run < end && !FAT_IsUsed(volume, after + 1 + run))
+            run++;
+        *length = run;
+        return after + 1;
+    }
+
+    uint32_t best = 0, bestLength = 0;
+    uint32_t cluster = FAT_IsCluster(volume, volume->NextFree) ? volume->NextFree : 2;
+    uint32_t scanned = 0;
+    while(scanned < volume->ClusterCount){
+        // full words in one step
+        if(cluster % 32 == 0 && volume->Bitmap[cluster / 32] == 0xFFFFFFFF && cluster + 32 <= end){
+            cluster += 32;
+            scanned += 32;
+        } else if(FAT_IsUsed(volume, cluster)){
+            cluster++;
+            scanned++;
+        } else {
+            uint32_t run = 1;
+            while(run < count && cluster + run < end && !FAT_IsUsed(volume, cluster + run))
+                run++;
+            if(run == count){
+                *length = run;
+                return cluster;
+            }
+            if(run > bestLength){
+                best = cluster;
+                bestLength = run;
+            }
+            cluster += run;
+            scanned += run;
+        }
+
+        if(cluster >= end)
+            cluster = 2;
+    }
+
+    *length = bestLength;
+    return best;
+}
+
+// Appends count clusters to the chain ending at last (0: no chain yet)
+// and returns the first new one
+static VfsStatus FAT_Extend(FATVolume* volume, uint32_t last, uint32_t count, uint32_t* first){
+    if(volume->ReadOnly)
+        return VFS_READ_ONLY;
+    if(count > volume->FreeCount)
+        return VFS_NO_SPACE;
+
+    *first = 0;
+    while(count > 0){
+        uint32_t length;
+        uint32_t start = FAT_FindRun(volume, last, count, &length);
+        if(start == 0)
+            return VFS_NO_SPACE;
+
+        for(uint32_t i = 0; i < length; i++){
+            FAT_SetUsed(volume, start + i, true);
+            if(!FAT_SetNext(volume, start + i, i + 1 < length ? start + i + 1 : FAT_CLUSTER_END))
+                return VFS_IO_ERROR;
+        }
+        if(last != 0 && !FAT_SetNext(volume, last, start))
+            return VFS_IO_ERROR;
+
+        g_Stats.Allocations++;
+        g_Stats.Clusters += length;
+        if(last != 0 && start == last + 1)
+            g_Stats.Contiguous++;
+        else if(last != 0)
+            g_Stats.Fragments++;
+
+        if(*first == 0)
+            *first = start;
+        last = start + length - 1;
+        count -= length;
+        volume->NextFree = last + 1;
+    }
+    return VFS_OK;
+}
+
+static VfsStatus FAT_FreeChain(FATVolume* volume, uint32_t cluster){
+    while(FAT_IsCluster(volume, cluster)){
+        uint32_t next;
+        if(!FAT_GetNext(volume, cluster, &next) || !FAT_SetNext(volume, cluster, FAT_CLUSTER_FREE))
+            return VFS_IO_ERROR;
+
+        if(FAT_IsUsed(volume, cluster))
+            FAT_SetUsed(volume, cluster, false);
+        g_Stats.Freed++;
+        cluster = next;
+    }
+    return VFS_OK;
+}
+
+//
+// Cluster chains of files
+//
+
+// The cluster holding position index of the chain, how many contiguous
+// clusters follow from there (up to max) and whether that is the end.
+// Walks on from the last position when it can.
+static bool FAT_Run(FATVolume* volume, FATNode* node, uint32_t index, uint32_t max, bool remember, uint32_t* cluster, uint32_t* length){
+    uint32_t current = node->FirstCluster;
+    uint32_t position = 0;
+    if(node->CachedCluster != 0 && node->CachedIndex <= index){
+        current = node->CachedCluster;
+        position = node->CachedIndex;
+    }
+
+    while(position < index && FAT_IsCluster(volume, current)){
+        if(!FAT_GetNext(volume, current, &current))
+            return false;
+        position++;
+    }
+
+    *cluster = FAT_IsCluster(volume, current) ? current : FAT_CLUSTER_END;
+    *length = 0;
+    if(*cluster == FAT_CLUSTER_END)
+        return true;
+
+    if(remember){
+        node->CachedIndex = index;
+        node->CachedCluster = current;
+    }
+
+    uint32_t run = 1;
+    while(run < max){
+        uint32_t next;
+        if(!FAT_GetNext(volume, current, &next))
+            return false;
+        if(next != current + 1)
+            break;
+        current = next;
+        run++;
+    }
+    *length = run;
+    return true;
+}
+
+// Clusters in the chain and the last one of them
+static bool FAT_ChainEnd(FATVolume* volume, FATNode* node, uint32_t* count, uint32_t* last){
+    uint32_t current = node->FirstCluster;
+    uint32_t position = 0;
+    if(node->CachedCluster != 0){
+        current = node->CachedCluster;
+        position = node->CachedIndex;
+    }
+
+    *count = 0;
+    *last = 0;
+    while(FAT_IsCluster(volume, current)){
+        *last = current;
+        *count = position + 1;
+        if(!FAT_GetNext(volume, current, &current))
+            return false;
+        position++;
+    }
+
+    if(*last != 0){
+        node->CachedIndex = *count - 1;
+        node->CachedCluster = *last;
+    }
+    return true;
+}
+
+// Reads or writes the allocated part of a file
+static VfsStatus FAT_FileTransfer(FATVolume* volume, FATNode* node, uint64_t offset, uint8_t* buffer, uint32_t count, bool write, uint32_t* done){
+    *done = 0;
+    while(count > 0){
+        uint32_t inCluster = offset % volume->ClusterSize;
+        uint32_t maxClusters = (inCluster + count + volume->ClusterSize - 1) / volume->ClusterSize;
+
+        uint32_t cluster, clusters;
+        if(!FAT_Run(volume, node, offset / volume->ClusterSize, maxClusters, true, &cluster, &clusters))
+            return VFS_IO_ERROR;
+        if(cluster == FAT_CLUSTER_END)
+            break;
+
+        uint32_t chunk = clusters * volume->ClusterSize - inCluster;
+        if(chunk > count)
+            chunk = count;
+
+        if(!write)
+            TRACE(TRACE_FAT_READ_BEGIN, cluster, clusters);
+        bool transferred = FAT_Transfer(volume, FAT_ClusterOffset(volume, cluster) + inCluster, buffer, chunk, write);
+        if(!write)
+            TRACE(TRACE_FAT_READ_END, cluster, 0);
+        if(!transferred)
+            return VFS_IO_ERROR;
+
+        offset += chunk;
+        count -= chunk;
+        *done += chunk;
+        if(buffer != NULL)
+            buffer += chunk;
+    }
+    return VFS_OK;
+}
+
+// Makes the chain long enough to hold size bytes
+static VfsStatus FAT_Reserve(FATVolume* volume, FATNode* node, uint64_t size){
+    uint32_t count, last;
+    if(!FAT_ChainEnd(volume, node, &count, &last))
+        return VFS_IO_ERROR;
+
+    uint32_t needed = (size + volume->ClusterSize - 1) / volume->ClusterSize;
+    if(needed <= count)
+        return VFS_OK;
+
+    uint32_t first;
+    VfsStatus status = FAT_Extend(volume, last, needed - count, &first);
+    if(status == VFS_OK && node->FirstCluster == 0){
+        node->FirstCluster = first;
+        node->CachedIndex = 0;
+        node->CachedCluster = first;
+    }
+    return status;
+}
+
+//
+// Directories
+//
+
+// Byte offset on disk of entry index of the directory, false past its end
+static bool FAT_DirectoryEntryOffset(FATVolume* volume, FATNode* dir, uint32_t index, uint64_t* offset, VfsStatus* status){
+    *status = VFS_OK;
+
+    // the FAT12/16 root directory is a fixed area before the data
+    if(dir->Entry == 0 && volume->Type != FAT32){
+        if(index >= volume->RootEntries)
+            return false;
+        *offset = (uint64_t)volume->RootStart * FAT_SECTOR_SIZE + index * FAT_ENTRY_SIZE;
+        return true;
+    }
+
+    uint32_t byte = index * FAT_ENTRY_SIZE;
+    uint32_t cluster, clusters;
+    if(!FAT_Run(volume, dir, byte / volume->ClusterSize, 1, true, &cluster, &clusters)){
+        *status = VFS_IO_ERROR;
+        return false;
+    }
+    if(cluster == FAT_CLUSTER_END)
+        return false;
+
+    *offset = FAT_ClusterOffset(volume, cluster) + byte % volume->ClusterSize;
+    return true;
+}
+
+// Walks a directory entry by entry, looking at each in place in the cached
+// block holding it. Entries of a cluster are contiguous, so the chain is
+// only consulted when crossing into the next one.
+typedef struct{
+    FATVolume*  Volume;
+    FATNode*    Dir;
+    uint32_t    Index;                      // of the next entry
+    uint64_t    Offset;                     // of the entry returned last
+    Buffer*     Block;
+    VfsStatus   Status;
+} FATDirectoryIterator;
+
+static void FAT_IteratorBegin(FATDirectoryIterator* it, FATVolume* volume, FATNode* dir, uint32_t index){
+    it->Volume = volume;
+    it->Dir = dir;
+    it->Index = index;
+    it->Offset = 0;
+    it->Block = NULL;
+    it->Status = VFS_OK;
+}
+
+static void FAT_IteratorEnd(FATDirectoryIterator* it){
+    if(it->Block != NULL)
+        BufferCache_Release(it->Block);
+    it->Block = NULL;
+}
+
+// The next entry, valid until the following call; NULL past the end of the
+// directory or on errors, with Status set
+static FAT_DirectoryEntry* FAT_IteratorNext(FATDirectoryIterator* it){
+    FATVolume* volume = it->Volume;
+    bool fixed = it->Dir->Entry == 0 && volume->Type != FAT32;
+    uint64_t offset;
+
+    if(it->Block == NULL || fixed || (it->Index * FAT_ENTRY_SIZE) % volume->ClusterSize == 0){
+        if(!FAT_DirectoryEntryOffset(volume, it->Dir, it->Index, &offset, &it->Status))
+            return NULL;
+    } else {
+        offset = it->Offset + FAT_ENTRY_SIZE;
+    }
+
+    uint64_t block = offset / BCACHE_BLOCK_SIZE;
+    if(it->Block == NULL || it->Block->Block != block){
+        FAT_IteratorEnd(it);
+        it->Block = BufferCache_Get(volume->Device, block);
+        if(it->Block == NULL){
+            it->Status = VFS_IO_ERROR;
+            return NULL;
+        }
+    }
+
+    it->Index++;
+    it->Offset = offset;
+    return (FAT_DirectoryEntry*)(it->Block->Data + offset % BCACHE_BLOCK_SIZE);
+}
+
+// Deleted entries and long name pieces, the latter carry the volume id bit
+static bool FAT_IsSkipped(const FAT_DirectoryEntry* entry){
+    return entry->Name[0] == FAT_ENTRY_DELETED || (entry->Attributes & FAT_ATTRIBUTE_VOLUME_ID);
+}
+
+// Compares 8.3 names as two words, a half word and a byte
+static bool FAT_ShortNameEquals(const uint8_t* a, const uint8_t* b){
+    return *(const uint32_t*)a == *(const uint32_t*)b
+        && *(const uint32_t*)(a + 4) == *(const uint32_t*)(b + 4)
+        && *(const uint16_t*)(a + 8) == *(const uint16_t*)(b + 8)
+        && a[10] == b[10];
+}
+
+static bool FAT_IsNameChar(char c){
+    if(c >= 'a' && c <= 'z')
+        return true;
+    if(c >= 'A' && c <= 'Z')
+        return true;
+    if(c >= '0' && c <= '9')
+        return true;
+    return c == '_' || c == '-' || c == '~' || c == '!' || c == '#' || c == '$' ||
+           c == '%' || c == '&' || c == '\'' || c == '(' || c == ')' || c == '@' ||
+           c == '^' || c == '`' || c == '{' || c == '}';
+}
+
+// Converts a name to its 8.3 form and reports which parts were all lower
+// case; false if it has no 8.3 form
+static bool FAT_ToShortName(const char* name, uint8_t* shortName, uint8_t* lowerCase){
+    memset(shortName, ' ', 11);
+    *lowerCase = FAT_CASE_LOWER_BASE | FAT_CASE_LOWER_EXTENSION;
+
+    int length = 0, extension = -1;
+    for(; name[length] != '\0'; length++){
+        if(name[length] == '.'){
+            if(extension >= 0)
+                return false;
+            extension = length;
+        } else if(!FAT_IsNameChar(name[length])){
+            return false;
+        }
+    }
+
+    int baseLength = extension >= 0 ? extension : length;
+    int extensionLength = extension >= 0 ? length - extension - 1 : 0;
+    if(baseLength == 0 || baseLength > 8 || extensionLength > 3 || (extension >= 0 && extensionLength == 0))
+        return false;
+
+    for(int i = 0; i < length; i++){
+        char c = name[i];
+        if(i == extension)
+            continue;
+
+        uint8_t part = i < baseLength ? FAT_CASE_LOWER_BASE : FAT_CASE_LOWER_EXTENSION;
+        if(c >= 'a' && c <= 'z')
+            c -= 'a' - 'A';
+        else if(c >= 'A' && c <= 'Z')
+            *lowerCase &= ~part;
+
+        shortName[i < baseLength ? i : 8 + i - extension - 1] = c;
+    }
+
+    // 0xE5 marks deleted entries, 0x05 stands for it
+    if(shortName[0] == FAT_ENTRY_DELETED)
+        shortName[0] = 0x05;
+    return true;
+}
+
+static void FAT_FromShortName(const FAT_DirectoryEntry* entry, char* name){
+    int length = 0;
+    for(int i = 0; i < 8 && entry->Name[i] != ' '; i++){
+        char c = i == 0 && entry->Name[0] == 0x05 ? FAT_ENTRY_DELETED : entry->Name[i];
+        if((entry->_Reserved & FAT_CASE_LOWER_BASE) && c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        name[length++] = c;
+    }
+
+    if(entry->Name[8] != ' ')
+        name[length++] = '.';
+    for(int i = 8; i < 11 && entry->Name[i] != ' '; i++){
+        char c = entry->Name[i];
+        if((entry->_Reserved & FAT_CASE_LOWER_EXTENSION) && c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        name[length++] = c;
+    }
+    name[length] = '\0';
+}
+
+static FATNode* FAT_AllocateNode(FATVolume* volume, uint32_t firstCluster, uint64_t entry){
+    for(uint32_t i = 0; i < FAT_MAX_NODES; i++){
+        FATNode* node = &g_Nodes[i];
+        if(node->Volume != NULL)
+            continue;
+
+        node->Volume = volume;
+        node->FirstCluster = firstCluster;
+        node->Entry = entry;
+        node->CachedIndex = 0;
+        node->CachedCluster = 0;
+        return node;
+    }
+    return NULL;
+}
+
+static VfsStatus FAT_FillVnode(FATVolume* volume, const FAT_DirectoryEntry* entry, uint64_t offset, Vnode* out){
+    uint32_t cluster = entry->FirstClusterLow | ((uint32_t)entry->FirstClusterHigh << 16);
+    FATNode* node = FAT_AllocateNode(volume, FAT_IsCluster(volume, cluster) ? cluster : 0, offset);
+    if(node == NULL)
+        return VFS_NO_RESOURCES;
+
+    bool directory = entry->Attributes & FAT_ATTRIBUTE_DIRECTORY;
+    out->Type = directory ? VNODE_DIRECTORY : VNODE_FILE;
+    out->Size = directory ? 0 : entry->Size;
+    out->Id = offset / FAT_ENTRY_SIZE;
+    out->Private = node;
+    return VFS_OK;
+}
+
+// Writes the node's size and first cluster back to its directory entry
+static VfsStatus FAT_UpdateEntry(FATVolume* volume, Vnode* vnode){
+    FATNode* node = (FATNode*)vnode->Private;
+    FAT_DirectoryEntry entry;
+
+    if(!FAT_Transfer(volume, node->Entry, &entry, FAT_ENTRY_SIZE, false))
+        return VFS_IO_ERROR;
+
+    entry.FirstClusterLow = node->FirstCluster & 0xFFFF;
+    entry.FirstClusterHigh = node->FirstCluster >> 16;
+    entry.Size = vnode->Type == VNODE_DIRECTORY ? 0 : vnode->Size;
+    if(vnode->Type == VNODE_FILE)
+        entry.Attributes |= FAT_ATTRIBUTE_ARCHIVE;
+
+    if(!FAT_Transfer(volume, node->Entry, &entry, FAT_ENTRY_SIZE, true))
+        return VFS_IO_ERROR;
+    return VFS_OK;
+}
+
+static VfsStatus FAT_Lookup(Vnode* dir, const char* name, Vnode* out){
+    FATVolume* volume = (FATVolume*)dir->Mount->Private;
+    FATNode* node = (FATNode*)dir->Private;
+
+    uint8_t shortName[11];
+    uint8_t lowerCase;
+    if(!FAT_ToShortName(name, shortName, &lowerCase))
+        return VFS_NOT_FOUND;
+
+    FATDirectoryIterator it;
+    FAT_IteratorBegin(&it, volume, node, 0);
+
+    FAT_DirectoryEntry* entry;
+    while((entry = FAT_IteratorNext(&it)) != NULL){
+        if(entry->Name[0] == FAT_ENTRY_END)
+            break;
+        if(FAT_IsSkipped(entry) || !FAT_ShortNameEquals(entry->Name, shortName))
+            continue;
+
+        FAT_DirectoryEntry found = *entry;
+        FAT_IteratorEnd(&it);
+        return FAT_FillVnode(volume, &found, it.Offset, out);
+    }
+
+    FAT_IteratorEnd(&it);
+    return it.Status != VFS_OK ? it.Status : VFS_NOT_FOUND;
+}
+
+static VfsStatus FAT_ReadDir(Vnode* dir, uint64_t* cookie, VfsDirEntry* out){
+    FATVolume* volume = (FATVolume*)dir->Mount->Private;
+    FATNode* node = (FATNode*)dir->Private;
+
+    FATDirectoryIterator it;
+    FAT_IteratorBegin(&it, volume, node, *cookie);
+
+    FAT_DirectoryEntry* entry;
+    while((entry = FAT_IteratorNext(&it)) != NULL){
+        if(entry->Name[0] == FAT_ENTRY_END)
+            break;
+
+        (*cookie)++;
+        if(FAT_IsSkipped(entry) || entry->Name[0] == '.')
+            continue;
+
+        FAT_FromShortName(entry, out->Name);
+        out->Type = (entry->Attributes & FAT_ATTRIBUTE_DIRECTORY) ? VNODE_DIRECTORY : VNODE_FILE;
+        out->Size = out->Type == VNODE_FILE ? entry->Size : 0;
+        FAT_IteratorEnd(&it);
+        return VFS_OK;
+    }
+
+    FAT_IteratorEnd(&it);
+    return it.Status != VFS_OK ? it.Status : VFS_NOT_FOUND;
+}
+
+// A free slot for one more entry, growing the directory by a cluster when
+// it is full
+static VfsStatus FAT_FindFreeEntry(FATVolume* volume, FATNode* dir, uint64_t* offset){
+    FATDirectoryIterator it;
+    FAT_IteratorBegin(&it, volume, dir, 0);
+
+    FAT_DirectoryEntry* entry;
+    while((entry = FAT_IteratorNext(&it)) != NULL){
+        if(entry->Name[0] == FAT_ENTRY_END || entry->Name[0] == FAT_ENTRY_DELETED){
+            FAT_IteratorEnd(&it);
+            *offset = it.Offset;
+            return VFS_OK;
+        }
+    }
+
+    FAT_IteratorEnd(&it);
+    VfsStatus status = it.Status;
+    if(status != VFS_OK)
+        return status;
+    if(dir->Entry == 0 && volume->Type != FAT32)
+        return VFS_NO_SPACE;
+
+    uint32_t count, last, cluster;
+    if(!FAT_ChainEnd(volume, dir, &count, &last))
+        return VFS_IO_ERROR;
+    status = FAT_Extend(volume, last, 1, &cluster);
+    if(status != VFS_OK)
+        return status;
+    if(!FAT_Transfer(volume, FAT_ClusterOffset(volume, cluster), NULL, volume->ClusterSize, true))
+        return VFS_IO_ERROR;
+
+    *offset = FAT_ClusterOffset(volume, cluster);
+    return VFS_OK;
+}
+
+static VfsStatus FAT_Create(Vnode* dir, const char* name, VnodeType type, Vnode* out){
+    FATVolume* volume = (FATVolume*)dir->Mount->Private;
+    FATNode* parent = (FATNode*)dir->Private;
+    if(volume->ReadOnly)
+        return VFS_READ_ONLY;
+
+    FAT_DirectoryEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    if(!FAT_ToShortName(name, entry.Name, &entry._Reserved))
+        return VFS_INVALID;
+
+    uint64_t offset;
+    VfsStatus status = FAT_FindFreeEntry(volume, parent, &offset);
+
+    // directories start with a cluster holding . and ..
+    uint32_t cluster = 0;
+    if(status == VFS_OK && type == VNODE_DIRECTORY){
+        status = FAT_Extend(volume, 0, 1, &cluster);
+        if(status == VFS_OK && !FAT_Transfer(volume, FAT_ClusterOffset(volume, cluster), NULL, volume->ClusterSize, true))
+            status = VFS_IO_ERROR;
+
+        FAT_DirectoryEntry dots[2];
+        memset(dots, 0, sizeof(dots));
+        memset(dots[0].Name, ' ', 11);
+        memset(dots[1].Name, ' ', 11);
+        dots[0].Name[0] = '.';
+        dots[1].Name[0] = dots[1].Name[1] = '.';
+        dots[0].Attributes = dots[1].Attributes = FAT_ATTRIBUTE_DIRECTORY;
+        dots[0].FirstClusterLow = cluster & 0xFFFF;
+        dots[0].FirstClusterHigh = cluster >> 16;
+        // the root is cluster 0 here, on FAT32 as well
+        uint32_t up = parent->Entry != 0 ? parent->FirstCluster : 0;
+        dots[1].FirstClusterLow = up & 0xFFFF;
+        dots[1].FirstClusterHigh = up >> 16;
+
+        if(status == VFS_OK && !FAT_Transfer(volume, FAT_ClusterOffset(volume, cluster), dots, sizeof(dots), true))
+            status = VFS_IO_ERROR;
+    }
+
+    if(status == VFS_OK){
+        entry.Attributes = type == VNODE_DIRECTORY ? FAT_ATTRIBUTE_DIRECTORY : FAT_ATTRIBUTE_ARCHIVE;
+        entry.FirstClusterLow = cluster & 0xFFFF;
+        entry.FirstClusterHigh = cluster >> 16;
+        if(!FAT_Transfer(volume, offset, &entry, FAT_ENTRY_SIZE, true))
+            status = VFS_IO_ERROR;
+    }
+
+    if(status != VFS_OK && cluster != 0)
+        FAT_FreeChain(volume, cluster);
+    if(!FAT_FlushFat(volume) && status == VFS_OK)
+        status = VFS_IO_ERROR;
+    if(status != VFS_OK)
+        return status;
+
+    return FAT_FillVnode(volume, &entry, offset, out);
+}
+
+//
+// Files
+//
+
+static VfsStatus FAT_Read(Vnode* vnode, uint64_t offset, void* buffer, uint32_t count, uint32_t* done){
+    FATVolume* volume = (FATVolume*)vnode->Mount->Private;
+    return FAT_FileTransfer(volume, (FATNode*)vnode->Private, offset, (uint8_t*)buffer, count, false, done);
+}
+
+static VfsStatus FAT_Write(Vnode* vnode, uint64_t offset, const void* buffer, uint32_t count, uint32_t* done){
+    FATVolume* volume = (FATVolume*)vnode->Mount->Private;
+    FATNode* node = (FATNode*)vnode->Private;
+    *done = 0;
+
+    if(volume->ReadOnly)
+        return VFS_READ_ONLY;
+    if(offset + count > 0xFFFFFFFFull)
+        return VFS_NO_SPACE;
+
+    // all clusters up front, as few runs as the free space allows
+    uint32_t firstCluster = node->FirstCluster;
+    VfsStatus status = FAT_Reserve(volume, node, offset + count);
+    uint32_t written = 0;
+
+    // writing past the end leaves a zeroed gap
+    if(status == VFS_OK && offset > vnode->Size)
+        status = FAT_FileTransfer(volume, node, vnode->Size, NULL, offset - vnode->Size, true, &written);
+    if(status == VFS_OK)
+        status = FAT_FileTransfer(volume, node, offset, (uint8_t*)buffer, count, true, done);
+
+    if(*done > 0 && offset + *done > vnode->Size){
+        vnode->Size = offset + *done;
+        VfsStatus update = FAT_UpdateEntry(volume, vnode);
+        if(status == VFS_OK)
+            status = update;
+    } else if(node->FirstCluster != firstCluster){
+        // an empty file got its first cluster
+        VfsStatus update = FAT_UpdateEntry(volume, vnode);
+        if(status == VFS_OK)
+            status = update;
+    }
+
+    if(!FAT_FlushFat(volume) && status == VFS_OK)
+        status = VFS_IO_ERROR;
+    return status;
+}
+
+static VfsStatus FAT_Truncate(Vnode* vnode, uint64_t size){
+    FATVolume* volume = (FATVolume*)vnode->Mount->Private;
+    FATNode* node = (FATNode*)vnode->Private;
+
+    if(volume->ReadOnly)
+        return VFS_READ_ONLY;
+    if(size > 0xFFFFFFFFull)
+        return VFS_NO_SPACE;
+
+    VfsStatus status = VFS_OK;
+    if(size > vnode->Size){
+        uint32_t zeroed;
+        status = FAT_Reserve(volume, node, size);
+        if(status == VFS_OK)
+            status = FAT_FileTransfer(volume, node, vnode->Size, NULL, size - vnode->Size, true, &zeroed);
+    } else {
+        uint32_t keep = (size + volume->ClusterSize - 1) / volume->ClusterSize;
+        uint32_t rest = node->FirstCluster;
+
+        if(keep == 0){
+            node->FirstCluster = 0;
+        } else {
+            uint32_t last, length;
+            if(!FAT_Run(volume, node, keep - 1, 1, false, &last, &length))
+                status = VFS_IO_ERROR;
+            else if(last == FAT_CLUSTER_END)
+                rest = 0;
+            else if(!FAT_GetNext(volume, last, &rest) || !FAT_SetNext(volume, last, FAT_CLUSTER_END))
+                status = VFS_IO_ERROR;
+        }
+
+        if(status == VFS_OK && FAT_IsCluster(volume, rest))
+            status = FAT_FreeChain(volume, rest);
+
+        // the cached position may have been freed
+        node->CachedIndex = 0;
+        node->CachedCluster = 0;
+    }
+
+    if(status == VFS_OK){
+        vnode->Size = size;
+        status = FAT_UpdateEntry(volume, vnode);
+    }
+    if(!FAT_FlushFat(volume) && status == VFS_OK)
+        status = VFS_IO_ERROR;
+    return status;
+}
+
+// Readahead: the disk extent behind a file offset
+static bool FAT_Map(void* file, uint64_t offset, uint64_t* lba, uint32_t* sectors){
+    Vnode* vnode = (Vnode*)file;
+    FATVolume* volume = (FATVolume*)vnode->Mount->Private;
+    FATNode* node = (FATNode*)vnode->Private;
+
+    // no further than a window ahead, and leave the read position alone
+    uint32_t inCluster = offset % volume->ClusterSize;
+    uint32_t max = READAHEAD_MAX_WINDOW / volume->ClusterSize + 1;
+    uint32_t cluster, clusters;
+    if(!FAT_Run(volume, node, offset / volume->ClusterSize, max, false, &cluster, &clusters) || cluster == FAT_CLUSTER_END)
+        return false;
+
+    *lba = FAT_ClusterOffset(volume, cluster) / FAT_SECTOR_SIZE + inCluster / FAT_SECTOR_SIZE;
+    *sectors = clusters * volume->SectorsPerCluster - inCluster / FAT_SECTOR_SIZE;
+    return true;
+}
+
+static void FAT_Release(Vnode* vnode){
+    FATNode* node = (FATNode*)vnode->Private;
+    if(node != NULL)
+        node->Volume = NULL;
+}
+
+//
+// Volumes
+//
+
+static VfsStatus FAT_Sync(Mount* mount){
+    FATVolume* volume = (FATVolume*)mount->Private;
+    if(volume->ReadOnly)
+        return VFS_OK;
+    if(!FAT_FlushFat(volume))
+        return VFS_IO_ERROR;
+    if(!volume->FSInfoDirty || volume->FSInfoSector == 0)
+        return VFS_OK;
+
+    FAT_FSInfo info;
+    if(!BufferCache_ReadSectors(volume->Device, volume->FSInfoSector, 1, &info))
+        return VFS_IO_ERROR;
+
+    info.FreeCount = volume->FreeCount;
+    info.NextFree = volume->NextFree;
+    if(!BufferCache_WriteSectors(volume->Device, volume->FSInfoSector, 1, &info))
+        return VFS_IO_ERROR;
+
+    volume->FSInfoDirty = false;
+    return VFS_OK;
+}
+
+static VfsStatus FAT_Mount(Mount* mount, Vnode* root){
+    union{
+        FAT_BootSector BootSector;
+        uint8_t Bytes[FAT_SECTOR_SIZE];
+    } bs;
+
+    if(!BufferCache_ReadSectors(mount->Device, 0, 1, bs.Bytes))
+        return VFS_IO_ERROR;
+
+    FAT_BootSector* boot = &bs.BootSector;
+    if(bs.Bytes[510] != 0x55 || bs.Bytes[511] != 0xAA)
+        return VFS_INVALID;
+    if(boot->BytesPerSector != FAT_SECTOR_SIZE || boot->FatCount == 0 || boot->ReservedSectors == 0)
+        return VFS_INVALID;
+    if(boot->SectorsPerCluster == 0 || (boot->SectorsPerCluster & (boot->SectorsPerCluster - 1)))
+        return VFS_INVALID;
+
+    FATVolume* volume = NULL;
+    for(uint32_t i = 0; i < FAT_MAX_VOLUMES && volume == NULL; i++){
+        if(g_Volumes[i].Device == NULL)
+            volume = &g_Volumes[i];
+    }
+    if(volume == NULL)
+        return VFS_NO_RESOURCES;
+
+    memset(volume, 0, sizeof(FATVolume));
+    uint32_t totalSectors = boot->TotalSectors != 0 ? boot->TotalSectors : boot->LargeSectorCount;
+    volume->SectorsPerFat = boot->SectorsPerFat != 0 ? boot->SectorsPerFat : boot->EBR32.SectorsPerFat;
+    volume->SectorsPerCluster = boot->SectorsPerCluster;
+    volume->ClusterSize = boot->SectorsPerCluster * FAT_SECTOR_SIZE;
+    volume->FatStart = boot->ReservedSectors;
+    volume->FatCount = boot->FatCount;
+    volume->RootStart = volume->FatStart + volume->FatCount * volume->SectorsPerFat;
+    volume->RootEntries = boot->DirEntryCount;
+    volume->DataStart = volume->RootStart + (volume->RootEntries * FAT_ENTRY_SIZE + FAT_SECTOR_SIZE - 1) / FAT_SECTOR_SIZE;
+    if(volume->SectorsPerFat == 0 || totalSectors <= volume->DataStart || totalSectors > mount->Device->SectorCount)
+        return VFS_INVALID;
+
+    // only FAT32 keeps the FAT size in its extended record, FAT12 and 16
+    // tell apart by cluster count
+    volume->ClusterCount = (totalSectors - volume->DataStart) / volume->SectorsPerCluster;
+    if(boot->SectorsPerFat == 0)
+        volume->Type = FAT32;
+    else if(volume->ClusterCount < 4085)
+        volume->Type = FAT12;
+    else
+        volume->Type = FAT16;
+
+    // clusters the FAT has no room for do not exist
+    uint32_t fatEntries = (uint64_t)volume->SectorsPerFat * FAT_SECTOR_SIZE * 8 / volume->Type;
+    if(volume->ClusterCount + 2 > fatEntries)
+        volume->ClusterCount = fatEntries - 2;
+
+    if(volume->Type == FAT32){
+        volume->RootCluster = boot->EBR32.RootdirCluster;
+        if(!FAT_IsCluster(volume, volume->RootCluster))
+            return VFS_INVALID;
+        if(boot->EBR32.FSInfoSector != 0 && boot->EBR32.FSInfoSector < boot->ReservedSectors)
+            volume->FSInfoSector = boot->EBR32.FSInfoSector;
+    }
+
+    volume->Device = mount->Device;
+    FAT_MarkFatClean(volume);
+
+    if(volume->ClusterCount + 2 > FAT_BITMAP_CLUSTERS){
+        printf("[FAT] %s: %u clusters are too many to track, mounting read only\r\n",
+               mount->Device->Name, volume->ClusterCount);
+        volume->ReadOnly = true;
+    } else {
+        volume->Bitmap = g_Bitmaps[volume - g_Volumes];
+        if(!FAT_BuildBitmap(volume)){
+            volume->Device = NULL;
+            return VFS_IO_ERROR;
+        }
+    }
+
+    // FSInfo only holds hints, the bitmap is what counts
+    volume->NextFree = 2;
+    if(volume->FSInfoSector != 0){
+        FAT_FSInfo info;
+        if(BufferCache_ReadSectors(volume->Device, volume->FSInfoSector, 1, &info) &&
+           info.LeadSignature == FAT_FSINFO_LEAD_SIGNATURE &&
+           info.StructSignature == FAT_FSINFO_STRUCT_SIGNATURE &&
+           info.TrailSignature == FAT_FSINFO_TRAIL_SIGNATURE){
+            if(FAT_IsCluster(volume, info.NextFree))
+                volume->NextFree = info.NextFree;
+            volume->FSInfoDirty = info.FreeCount != volume->FreeCount;
+        } else {
+            volume->FSInfoSector = 0;
+        }
+    }
+
+    FATNode* node = FAT_AllocateNode(volume, volume->RootCluster, 0);
+    if(node == NULL){
+        volume->Device = NULL;
+        return VFS_NO_RESOURCES;
+    }
+
+    root->Type = VNODE_DIRECTORY;
+    root->Id = 0;
+    root->Size = 0;
+    root->Private = node;
+    mount->Private = volume;
+
+    printf("[FAT] %s: FAT%u, %u clusters of %u bytes, %u free\r\n",
+           mount->Device->Name, volume->Type, volume->ClusterCount, volume->ClusterSize,
+           volume->ReadOnly ? 0 : volume->FreeCount);
+    return VFS_OK;
+}
+
+static FileSystem g_FileSystem = {
+    .Name = "fat",
+    .CaseInsensitive = true,
+    .Mount = FAT_Mount,
+    .Lookup = FAT_Lookup,
+    .Create = FAT_Create,
+    .Read = FAT_Read,
+    .Write = FAT_Write,
+    .Truncate = FAT_Truncate,
+    .ReadDir = FAT_ReadDir,
+    .Sync = FAT_Sync,
+    .Release = FAT_Release,
+    .Map = FAT_Map,
+};
+
+void FAT_Initialize(){
+    VFS_RegisterFileSystem(&g_FileSystem);
+}
+
+void FAT_GetStats(FATStats* stats){
+    *stats = g_Stats;
+}
+
+void FAT_PrintStats(){
+    FATStats stats;
+    FAT_GetStats(&stats);
+
+    printf("===== FAT STATS =====\r\n");
+    printf("allocations=%llu clusters=%llu contiguous=%llu fragments=%llu freed=%llu\r\n",
+           stats.Allocations, stats.Clusters, stats.Contiguous, stats.Fragments, stats.Freed);
+    printf("fat flushes=%llu sectors mirrored=%llu\r\n", stats.FatFlushes, stats.FatSectorsMirrored);
+    printf("=====================\r\n");
+}
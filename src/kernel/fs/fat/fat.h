@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    uint8_t Name[11];
+    uint8_t Attributes;
+    uint8_t _Reserved;                      // case of the 8.3 name, see FAT_CASE_*
+    uint8_t CreatedTimeTenths;
+    uint16_t CreatedTime;
+    uint16_t CreatedDate;
+    uint16_t AccessedDate;
+    uint16_t FirstClusterHigh;
+    uint16_t ModifiedTime;
+    uint16_t ModifiedDate;
+    uint16_t FirstClusterLow;
+    uint32_t Size;
+}__attribute__((packed)) FAT_DirectoryEntry;
+
+enum FAT_Attributes{
+    FAT_ATTRIBUTE_READ_ONLY            = 0x01,
+    FAT_ATTRIBUTE_HIDDEN               = 0x02,
+    FAT_ATTRIBUTE_SYSTEM               = 0x04,
+    FAT_ATTRIBUTE_VOLUME_ID            = 0x08,
+    FAT_ATTRIBUTE_DIRECTORY            = 0x10,
+    FAT_ATTRIBUTE_ARCHIVE              = 0x20,
+    FAT_ATTRIBUTE_LFN                  = FAT_ATTRIBUTE_READ_ONLY | FAT_ATTRIBUTE_HIDDEN | FAT_ATTRIBUTE_SYSTEM | FAT_ATTRIBUTE_VOLUME_ID,
+};
+
+typedef struct{
+    uint64_t Allocations;                   // runs of clusters handed out
+    uint64_t Clusters;
+    uint64_t Contiguous;                    // runs that extended a file in place
+    uint64_t Fragments;                     // runs that started elsewhere
+    uint64_t Freed;
+    uint64_t FatFlushes;                    // batches mirrored to the other FATs
+    uint64_t FatSectorsMirrored;
+} FATStats;
+
+// Registers the driver with the VFS
+void FAT_Initialize();
+
+void FAT_GetStats(FATStats* stats);
+void FAT_PrintStats();
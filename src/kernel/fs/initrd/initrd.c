@@ -0,0 +1,407 @@
+#include "initrd.h"
+#include <block/ramdisk.h>
+#include <fs/vfs.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+#define USTAR_BLOCK_SIZE            512
+#define INITRD_MAX_NODES            4096
+#define INITRD_HASH_BUCKETS         4096    // power of two
+#define INITRD_MAX_DEPTH            32
+#define INITRD_NONE                 0xFFFFFFFF
+#define INITRD_ROOT                 0
+
+#define FNV_OFFSET_BASIS            2166136261u
+#define FNV_PRIME                   16777619u
+
+enum {
+    USTAR_TYPE_OLD_FILE             = '\0',
+    USTAR_TYPE_FILE                 = '0',
+    USTAR_TYPE_DIRECTORY            = '5',
+    USTAR_TYPE_CONTIGUOUS           = '7',
+};
+
+typedef struct{
+    char Name[100];
+    char Mode[8];
+    char Uid[8];
+    char Gid[8];
+    char Size[12];                          // octal, like every number here
+    char ModifiedTime[12];
+    char Checksum[8];
+    char Type;
+    char LinkName[100];
+    char Magic[6];                          // "ustar"
+    char Version[2];
+    char UserName[32];
+    char GroupName[32];
+    char DeviceMajor[8];
+    char DeviceMinor[8];
+    char Prefix[155];                       // goes before Name, with a '/'
+    char Pad[12];
+} __attribute__((packed)) Ustar_Header;
+
+// Names and data point into the archive. Directories the archive only
+// implies through the paths below them get a node too.
+typedef struct{
+    const char* Name;                       // not terminated
+    uint32_t NameLength;
+    uint32_t Hash;                          // of the whole path, see Initrd_Hash
+    uint32_t Parent;
+    uint32_t FirstChild;                    // in archive order
+    uint32_t LastChild;
+    uint32_t NextSibling;
+    uint32_t HashNext;
+    VnodeType Type;
+    const uint8_t* Data;
+    uint32_t Size;
+} InitrdNode;
+
+typedef struct{
+    BlockDevice* Device;                    // NULL while unused
+    const uint8_t* Archive;
+    uint64_t ArchiveSize;
+    uint32_t NodeCount;
+    uint32_t Files;
+    uint32_t Directories;
+} InitrdVolume;
+
+// One archive at a time, there is only one initrd
+static InitrdVolume g_Volume;
+static InitrdNode g_Nodes[INITRD_MAX_NODES];
+static uint32_t g_Buckets[INITRD_HASH_BUCKETS];
+static InitrdStats g_Stats;
+
+//
+// Index
+//
+
+// FNV-1a over the path with a '/' before every component, so a child's
+// hash carries on from its parent's and a lookup only hashes its own name
+static uint32_t Initrd_Hash(uint32_t parent, const char* name, uint32_t length){
+    uint32_t hash = (parent ^ '/') * FNV_PRIME;
+    for(uint32_t i = 0; i < length; i++)
+        hash = (hash ^ (uint8_t)name[i]) * FNV_PRIME;
+    return hash;
+}
+
+static uint32_t Initrd_Find(uint32_t parent, const char* name, uint32_t length, uint32_t hash){
+    for(uint32_t i = g_Buckets[hash & (INITRD_HASH_BUCKETS - 1)]; i != INITRD_NONE; i = g_Nodes[i].HashNext){
+        InitrdNode* node = &g_Nodes[i];
+        g_Stats.Probes++;
+        if(node->Hash == hash && node->Parent == parent && node->NameLength == length &&
+           memcmp(node->Name, name, length) == 0)
+            return i;
+    }
+    return INITRD_NONE;
+}
+
+static uint32_t Initrd_AddNode(uint32_t parent, const char* name, uint32_t length, uint32_t hash, VnodeType type){
+    if(g_Volume.NodeCount == INITRD_MAX_NODES)
+        return INITRD_NONE;
+
+    uint32_t index = g_Volume.NodeCount++;
+    InitrdNode* node = &g_Nodes[index];
+    memset(node, 0, sizeof(InitrdNode));
+    node->Name = name;
+    node->NameLength = length;
+    node->Hash = hash;
+    node->Parent = parent;
+    node->FirstChild = INITRD_NONE;
+    node->LastChild = INITRD_NONE;
+    node->NextSibling = INITRD_NONE;
+    node->Type = type;
+
+    uint32_t* bucket = &g_Buckets[hash & (INITRD_HASH_BUCKETS - 1)];
+    node->HashNext = *bucket;
+    *bucket = index;
+
+    InitrdNode* dir = &g_Nodes[parent];
+    if(dir->LastChild != INITRD_NONE)
+        g_Nodes[dir->LastChild].NextSibling = index;
+    else
+        dir->FirstChild = index;
+    dir->LastChild = index;
+
+    if(type == VNODE_DIRECTORY)
+        g_Volume.Directories++;
+    else
+        g_Volume.Files++;
+    return index;
+}
+
+// Splits one path field into components, dropping empty ones and "."
+static bool Initrd_SplitPath(const char* field, uint32_t size, const char** names, uint32_t* lengths, uint32_t* count){
+    uint32_t i = 0;
+    while(i < size && field[i] != '\0'){
+        uint32_t start = i;
+        while(i < size && field[i] != '\0' && field[i] != '/')
+            i++;
+
+        uint32_t length = i - start;
+        if(i < size && field[i] == '/')
+            i++;
+        if(length == 0 || (length == 1 && field[start] == '.'))
+            continue;
+        if(length == 2 && field[start] == '.' && field[start + 1] == '.')
+            return false;
+        if(*count == INITRD_MAX_DEPTH || length > VFS_NAME_MAX)
+            return false;
+
+        names[*count] = &field[start];
+        lengths[*count] = length;
+        (*count)++;
+    }
+    return true;
+}
+
+// Adds one archive member, making the directories above it on the way.
+// A member repeated later in the archive replaces the earlier one, as
+// when extracting.
+static VfsStatus Initrd_AddMember(const Ustar_Header* header, uint32_t size){
+    VnodeType type;
+    if(header->Type == USTAR_TYPE_DIRECTORY)
+        type = VNODE_DIRECTORY;
+    else if(header->Type == USTAR_TYPE_FILE || header->Type == USTAR_TYPE_OLD_FILE || header->Type == USTAR_TYPE_CONTIGUOUS)
+        type = VNODE_FILE;
+    else
+        return VFS_OK;                      // links and devices are left out
+
+    const char* names[INITRD_MAX_DEPTH];
+    uint32_t lengths[INITRD_MAX_DEPTH];
+    uint32_t count = 0;
+    if(!Initrd_SplitPath(header->Prefix, sizeof(header->Prefix), names, lengths, &count) ||
+       !Initrd_SplitPath(header->Name, sizeof(header->Name), names, lengths, &count))
+        return VFS_INVALID;
+    if(count == 0)
+        return VFS_OK;                      // the root itself
+
+    uint32_t index = INITRD_ROOT;
+    for(uint32_t i = 0; i < count; i++){
+        uint32_t parent = index;
+        if(g_Nodes[parent].Type != VNODE_DIRECTORY)
+            return VFS_NOT_DIRECTORY;
+
+        uint32_t hash = Initrd_Hash(g_Nodes[parent].Hash, names[i], lengths[i]);
+        index = Initrd_Find(parent, names[i], lengths[i], hash);
+        if(index == INITRD_NONE)
+            index = Initrd_AddNode(parent, names[i], lengths[i], hash, i + 1 < count ? VNODE_DIRECTORY : type);
+        if(index == INITRD_NONE)
+            return VFS_NO_RESOURCES;
+    }
+
+    InitrdNode* node = &g_Nodes[index];
+    if(node->Type != type)
+        return VFS_EXISTS;
+    if(type == VNODE_FILE){
+        node->Data = (const uint8_t*)header + USTAR_BLOCK_SIZE;
+        node->Size = size;
+    }
+    return VFS_OK;
+}
+
+static bool Initrd_ParseOctal(const char* field, uint32_t size, uint64_t* value){
+    uint32_t i = 0;
+    while(i < size && field[i] == ' ')
+        i++;
+
+    *value = 0;
+    uint32_t digits = 0;
+    for(; i < size && field[i] >= '0' && field[i] <= '7'; i++, digits++)
+        *value = *value * 8 + (field[i] - '0');
+    return digits > 0 && (i == size || field[i] == '\0' || field[i] == ' ');
+}
+
+static bool Initrd_CheckHeader(const Ustar_Header* header){
+    if(memcmp(header->Magic, "ustar", 5) != 0)
+        return false;
+
+    // the checksum is taken with its own field as spaces
+    const uint8_t* bytes = (const uint8_t*)header;
+    uint32_t offset = offsetof(Ustar_Header, Checksum);
+    uint32_t sum = ' ' * sizeof(header->Checksum);
+    for(uint32_t i = 0; i < USTAR_BLOCK_SIZE; i++){
+        if(i < offset || i >= offset + sizeof(header->Checksum))
+            sum += bytes[i];
+    }
+
+    uint64_t expected;
+    return Initrd_ParseOctal(header->Checksum, sizeof(header->Checksum), &expected) && expected == sum;
+}
+
+static VfsStatus Initrd_Index(const char* device){
+    uint64_t offset = 0;
+    while(offset + USTAR_BLOCK_SIZE <= g_Volume.ArchiveSize){
+        const Ustar_Header* header = (const Ustar_Header*)(g_Volume.Archive + offset);
+        if(header->Name[0] == '\0')
+            break;                          // the zero blocks closing the archive
+
+        uint64_t size;
+        if(!Initrd_CheckHeader(header) || !Initrd_ParseOctal(header->Size, sizeof(header->Size), &size) ||
+           size > g_Volume.ArchiveSize - offset - USTAR_BLOCK_SIZE)
+            return offset == 0 ? VFS_INVALID : VFS_IO_ERROR;
+
+        VfsStatus status = Initrd_AddMember(header, size);
+        if(status == VFS_NO_RESOURCES){
+            printf("[INITRD] %s: more than %u files and directories\r\n", device, INITRD_MAX_NODES);
+            return status;
+        }
+        if(status != VFS_OK)
+            printf("[INITRD] %s: skipped %s (%s)\r\n", device, header->Name, VFS_StatusString(status));
+
+        offset += USTAR_BLOCK_SIZE + (size + USTAR_BLOCK_SIZE - 1) / USTAR_BLOCK_SIZE * USTAR_BLOCK_SIZE;
+    }
+    return VFS_OK;
+}
+
+//
+// Directories
+//
+
+static void Initrd_FillVnode(uint32_t index, Vnode* out){
+    InitrdNode* node = &g_Nodes[index];
+    out->Type = node->Type;
+    out->Id = index;
+    out->Size = node->Size;
+    out->Private = node;
+}
+
+static VfsStatus Initrd_Lookup(Vnode* dir, const char* name, Vnode* out){
+    InitrdNode* node = (InitrdNode*)dir->Private;
+    uint32_t length = 0;
+    while(name[length] != '\0')
+        length++;
+
+    g_Stats.Lookups++;
+    uint32_t parent = node - g_Nodes;
+    uint32_t index = Initrd_Find(parent, name, length, Initrd_Hash(node->Hash, name, length));
+    if(index == INITRD_NONE)
+        return VFS_NOT_FOUND;
+
+    Initrd_FillVnode(index, out);
+    return VFS_OK;
+}
+
+// The cookie is the next child to return, 0 for the first: the root is
+// nobody's child
+static VfsStatus Initrd_ReadDir(Vnode* dir, uint64_t* cookie, VfsDirEntry* entry){
+    InitrdNode* node = (InitrdNode*)dir->Private;
+    uint32_t index = *cookie == 0 ? node->FirstChild : (uint32_t)*cookie;
+    if(index >= g_Volume.NodeCount)
+        return VFS_NOT_FOUND;
+
+    InitrdNode* child = &g_Nodes[index];
+    memcpy(entry->Name, child->Name, child->NameLength);
+    entry->Name[child->NameLength] = '\0';
+    entry->Type = child->Type;
+    entry->Size = child->Size;
+    *cookie = child->NextSibling;
+    return VFS_OK;
+}
+
+//
+// Files
+//
+
+static VfsStatus Initrd_Read(Vnode* vnode, uint64_t offset, void* buffer, uint32_t count, uint32_t* done){
+    InitrdNode* node = (InitrdNode*)vnode->Private;
+    *done = 0;
+    if(offset >= node->Size)
+        return VFS_OK;
+    if(count > node->Size - offset)
+        count = node->Size - offset;
+
+    memcpy(buffer, node->Data + offset, count);
+    g_Stats.BytesCopied += count;
+    *done = count;
+    return VFS_OK;
+}
+
+// Every file is one piece of the archive, so all of it maps at once
+static VfsStatus Initrd_Direct(Vnode* vnode, uint64_t offset, const void** data, uint32_t* count){
+    InitrdNode* node = (InitrdNode*)vnode->Private;
+    if(offset >= node->Size){
+        *data = NULL;
+        *count = 0;
+        return VFS_OK;
+    }
+    if(*count > node->Size - offset)
+        *count = node->Size - offset;
+
+    *data = node->Data + offset;
+    g_Stats.BytesMapped += *count;
+    return VFS_OK;
+}
+
+//
+// Mounting
+//
+
+static VfsStatus Initrd_Mount(Mount* mount, Vnode* root){
+    uint64_t size;
+    const uint8_t* archive = Ramdisk_GetData(mount->Device, &size);
+    if(archive == NULL)
+        return VFS_INVALID;
+    if(g_Volume.Device != NULL)
+        return VFS_NO_RESOURCES;
+
+    memset(&g_Volume, 0, sizeof(InitrdVolume));
+    g_Volume.Archive = archive;
+    g_Volume.ArchiveSize = size;
+    memset(g_Buckets, 0xFF, sizeof(g_Buckets));
+
+    InitrdNode* top = &g_Nodes[INITRD_ROOT];
+    memset(top, 0, sizeof(InitrdNode));
+    top->Name = "";
+    top->Hash = FNV_OFFSET_BASIS;
+    top->Parent = INITRD_NONE;
+    top->FirstChild = INITRD_NONE;
+    top->LastChild = INITRD_NONE;
+    top->NextSibling = INITRD_NONE;
+    top->HashNext = INITRD_NONE;
+    top->Type = VNODE_DIRECTORY;
+    g_Volume.NodeCount = 1;
+
+    VfsStatus status = Initrd_Index(mount->Device->Name);
+    if(status != VFS_OK)
+        return status;
+    g_Stats.Probes = 0;                     // indexing is not looking up
+
+    g_Volume.Device = mount->Device;
+    Initrd_FillVnode(INITRD_ROOT, root);
+    mount->Private = &g_Volume;
+
+    printf("[INITRD] %s: %u files, %u directories in %llu bytes\r\n",
+           mount->Device->Name, g_Volume.Files, g_Volume.Directories, size);
+    return VFS_OK;
+}
+
+static FileSystem g_FileSystem = {
+    .Name = "initrd",
+    .CaseInsensitive = false,
+    .Mount = Initrd_Mount,
+    .Lookup = Initrd_Lookup,
+    .Read = Initrd_Read,
+    .ReadDir = Initrd_ReadDir,
+    .Direct = Initrd_Direct,
+};
+
+void Initrd_Initialize(){
+    VFS_RegisterFileSystem(&g_FileSystem);
+}
+
+void Initrd_GetStats(InitrdStats* stats){
+    *stats = g_Stats;
+}
+
+void Initrd_PrintStats(){
+    InitrdStats stats;
+    Initrd_GetStats(&stats);
+
+    printf("===== INITRD STATS =====\r\n");
+    printf("lookups=%llu probes=%llu probes/lookup=%llu\r\n",
+           stats.Lookups, stats.Probes, stats.Lookups ? stats.Probes / stats.Lookups : 0);
+    printf("bytes copied=%llu bytes mapped=%llu\r\n", stats.BytesCopied, stats.BytesMapped);
+    printf("========================\r\n");
+}
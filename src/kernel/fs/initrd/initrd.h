@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct{
+    uint64_t Lookups;
+    uint64_t Probes;                        // hash chain entries compared
+    uint64_t BytesCopied;                   // through Read
+    uint64_t BytesMapped;                   // handed out in place, see VFS_ReadDirect
+} InitrdStats;
+
+// Registers the driver for ustar archives on ramdisks with the VFS. The
+// archive is indexed once at mount and never copied: names and file data
+// are used where they lie.
+void Initrd_Initialize();
+
+void Initrd_GetStats(InitrdStats* stats);
+void Initrd_PrintStats();
@@ -0,0 +1,715 @@
+#include "vfs.h"
+#include "dcache.h"
+#include <block/buffer_cache.h>
+#include <sched/scheduler.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "memory.h"
+#include "stdio.h"
+
+typedef struct{
+    Vnode* Vnode;                           // NULL while the slot is free
+    uint32_t Flags;
+    uint64_t Position;
+    Readahead Readahead;
+} File;
+
+static FileSystem* g_FileSystems[VFS_MAX_FILESYSTEMS];
+static uint32_t g_FileSystemCount = 0;
+static Mount g_Mounts[VFS_MAX_MOUNTS];
+static Mount* g_RootMount = NULL;
+static Vnode g_Vnodes[VFS_MAX_VNODES];
+static uint32_t g_VnodesUsed = 0;
+static File g_Files[VFS_MAX_FILES];
+static VfsStats g_Stats;
+
+// One big lock for now: drivers block on disk I/O while holding it, so it
+// is a sleeping one
+static volatile uint32_t g_Busy = 0;
+
+static void VFS_Lock(){
+    while(__atomic_exchange_n(&g_Busy, 1, __ATOMIC_ACQUIRE))
+        Scheduler_Yield();
+}
+
+static void VFS_Unlock(){
+    __atomic_store_n(&g_Busy, 0, __ATOMIC_RELEASE);
+}
+
+//
+// Vnodes
+//
+
+// The vnode for what a driver just looked up. Only reached on dentry cache
+// misses, which go to the disk anyway, so a linear scan will do.
+static Vnode* VFS_GetVnode(const Vnode* found){
+    Mount* mount = found->Mount;
+    Vnode* free = NULL;
+
+    for(uint32_t i = 0; i < VFS_MAX_VNODES; i++){
+        Vnode* vnode = &g_Vnodes[i];
+        if(vnode->Mount == mount && vnode->Id == found->Id){
+            // already in use through another name or an open file
+            if(mount->Fs->Release != NULL)
+                mount->Fs->Release((Vnode*)found);
+            vnode->RefCount++;
+            return vnode;
+        }
+        if(vnode->Mount == NULL && free == NULL)
+            free = vnode;
+    }
+
+    if(free == NULL){
+        if(mount->Fs->Release != NULL)
+            mount->Fs->Release((Vnode*)found);
+        return NULL;
+    }
+
+    *free = *found;
+    g_VnodesUsed++;
+    free->RefCount = 1;
+    free->Covered = NULL;
+    return free;
+}
+
+void VFS_PutVnode(Vnode* vnode){
+    if(--vnode->RefCount != 0)
+        return;
+
+    if(vnode->Mount->Fs->Release != NULL)
+        vnode->Mount->Fs->Release(vnode);
+    vnode->Mount = NULL;
+    g_VnodesUsed--;
+}
+
+// Cached names keep their vnodes, and with them the drivers' nodes, alive.
+// Called before asking a driver for a new one: unused names make room once
+// the table is full.
+static bool VFS_ReserveVnode(){
+    while(g_VnodesUsed >= VFS_MAX_VNODES){
+        if(!Dcache_Evict())
+            return false;
+    }
+    return true;
+}
+
+//
+// Path walk
+//
+
+static void VFS_FoldName(Mount* mount, const char* name, uint32_t length, char* key){
+    for(uint32_t i = 0; i < length; i++){
+        char c = name[i];
+        if(mount->Fs->CaseInsensitive && c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        key[i] = c;
+    }
+}
+
+// Steps onto the root of whatever is mounted on the entry
+static Dentry* VFS_CrossMounts(Dentry* dentry){
+    while(dentry->Vnode != NULL && dentry->Vnode->Covered != NULL){
+        Dentry* root = Dcache_Get(dentry->Vnode->Covered->Root);
+        Dcache_Put(dentry);
+        dentry = root;
+    }
+    return dentry;
+}
+
+static Dentry* VFS_Parent(Dentry* dentry){
+    // out of mounted filesystems first, the root's parent is itself
+    while(dentry->Parent == NULL && dentry->Vnode->Mount->Covered != NULL)
+        dentry = dentry->Vnode->Mount->Covered;
+    return Dcache_Get(dentry->Parent != NULL ? dentry->Parent : dentry);
+}
+
+// The referenced entry for name in dir, negative if it does not exist.
+// Cache misses ask the driver and remember the answer either way.
+static VfsStatus VFS_LookupChild(Dentry* dir, const char* name, uint32_t length, Dentry** out){
+    Vnode* vnode = dir->Vnode;
+    if(vnode->Type != VNODE_DIRECTORY)
+        return VFS_NOT_DIRECTORY;
+    if(length == 0 || length > VFS_NAME_MAX)
+        return VFS_INVALID;
+
+    Mount* mount = vnode->Mount;
+    char key[VFS_NAME_MAX + 1];
+    VFS_FoldName(mount, name, length, key);
+    uint32_t hash = Dcache_HashName(key, length);
+
+    Dentry* dentry = Dcache_Lookup(dir, key, length, hash);
+    if(dentry == NULL){
+        char raw[VFS_NAME_MAX + 1];
+        memcpy(raw, name, length);
+        raw[length] = '\0';
+
+        Vnode found;
+        memset(&found, 0, sizeof(Vnode));
+        found.Mount = mount;
+        g_Stats.FsLookups++;
+
+        if(!VFS_ReserveVnode())
+            return VFS_NO_RESOURCES;
+
+        Vnode* child = NULL;
+        VfsStatus status = mount->Fs->Lookup(vnode, raw, &found);
+        if(status == VFS_OK){
+            child = VFS_GetVnode(&found);
+            if(child == NULL)
+                return VFS_NO_RESOURCES;
+        } else if(status != VFS_NOT_FOUND){
+            return status;
+        }
+
+        dentry = Dcache_Add(dir, key, length, hash, child);
+        if(dentry == NULL){
+            if(child != NULL)
+                VFS_PutVnode(child);
+            return VFS_NO_RESOURCES;
+        }
+    }
+
+    *out = VFS_CrossMounts(dentry);
+    return VFS_OK;
+}
+
+// Resolves an absolute path to a referenced positive entry. With last
+// set, stops before the final component and returns its directory and
+// the component's name instead.
+static VfsStatus VFS_Walk(const char* path, Dentry** out, const char** last, uint32_t* lastLength){
+    if(g_RootMount == NULL)
+        return VFS_NOT_FOUND;
+    if(path[0] != '/')
+        return VFS_INVALID;
+
+    Dentry* current = Dcache_Get(g_RootMount->Root);
+    if(last != NULL)
+        *last = NULL;
+
+    for(;;){
+        while(*path == '/')
+            path++;
+        if(*path == '\0')
+            break;
+
+        const char* name = path;
+        while(*path != '\0' && *path != '/')
+            path++;
+        uint32_t length = path - name;
+
+        if(last != NULL){
+            const char* rest = path;
+            while(*rest == '/')
+                rest++;
+            if(*rest == '\0'){
+                *last = name;
+                *lastLength = length;
+                break;
+            }
+        }
+
+        Dentry* next;
+        if(length == 1 && name[0] == '.'){
+            continue;
+        } else if(length == 2 && name[0] == '.' && name[1] == '.'){
+            next = VFS_Parent(current);
+        } else {
+            VfsStatus status = VFS_LookupChild(current, name, length, &next);
+            if(status == VFS_OK && next->Vnode == NULL){
+                Dcache_Put(next);
+                status = VFS_NOT_FOUND;
+            }
+            if(status != VFS_OK){
+                Dcache_Put(current);
+                return status;
+            }
+        }
+
+        Dcache_Put(current);
+        current = next;
+    }
+
+    if(last != NULL && *last == NULL){
+        Dcache_Put(current);
+        return VFS_INVALID;
+    }
+
+    *out = current;
+    return VFS_OK;
+}
+
+static void VFS_AccountLookup(uint64_t start){
+    uint64_t ns = Clock_NowNs() - start;
+    g_Stats.Lookups++;
+    g_Stats.LookupNs += ns;
+    if(ns > g_Stats.LookupMaxNs)
+        g_Stats.LookupMaxNs = ns;
+}
+
+// Creates the name of a negative entry in dir
+static VfsStatus VFS_CreateChild(Dentry* dir, Dentry* dentry, const char* name, uint32_t length, VnodeType type){
+    Mount* mount = dir->Vnode->Mount;
+    if(mount->Fs->Create == NULL)
+        return VFS_READ_ONLY;
+
+    char raw[VFS_NAME_MAX + 1];
+    memcpy(raw, name, length);
+    raw[length] = '\0';
+
+    Vnode created;
+    memset(&created, 0, sizeof(Vnode));
+    created.Mount = mount;
+
+    if(!VFS_ReserveVnode())
+        return VFS_NO_RESOURCES;
+
+    VfsStatus status = mount->Fs->Create(dir->Vnode, raw, type, &created);
+    if(status != VFS_OK)
+        return status;
+
+    Vnode* vnode = VFS_GetVnode(&created);
+    if(vnode == NULL)
+        return VFS_NO_RESOURCES;
+
+    Dcache_Instantiate(dentry, vnode);
+    return VFS_OK;
+}
+
+// Walks to the final entry, creating it when asked to
+static VfsStatus VFS_Resolve(const char* path, bool create, VnodeType type, Dentry** out){
+    if(!create)
+        return VFS_Walk(path, out, NULL, NULL);
+
+    Dentry* dir;
+    const char* name;
+    uint32_t length;
+    VfsStatus status = VFS_Walk(path, &dir, &name, &length);
+    if(status != VFS_OK)
+        return status;
+
+    Dentry* dentry;
+    status = VFS_LookupChild(dir, name, length, &dentry);
+    if(status == VFS_OK && dentry->Vnode == NULL){
+        status = VFS_CreateChild(dir, dentry, name, length, type);
+        if(status != VFS_OK)
+            Dcache_Put(dentry);
+    } else if(status == VFS_OK && type == VNODE_DIRECTORY){
+        // mkdir of something that exists
+        Dcache_Put(dentry);
+        status = VFS_EXISTS;
+    }
+    Dcache_Put(dir);
+
+    if(status == VFS_OK)
+        *out = dentry;
+    return status;
+}
+
+//
+// Open files
+//
+
+static File* VFS_GetFile(int handle){
+    if(handle < 0 || handle >= VFS_MAX_FILES || g_Files[handle].Vnode == NULL)
+        return NULL;
+    return &g_Files[handle];
+}
+
+VfsStatus VFS_Open(const char* path, uint32_t flags, int* handle){
+    VFS_Lock();
+
+    uint64_t start = Clock_NowNs();
+    Dentry* dentry;
+    VfsStatus status = VFS_Resolve(path, flags & VFS_OPEN_CREATE, VNODE_FILE, &dentry);
+    VFS_AccountLookup(start);
+    if(status != VFS_OK){
+        VFS_Unlock();
+        return status;
+    }
+
+    Vnode* vnode = dentry->Vnode;
+    Mount* mount = vnode->Mount;
+    if(vnode->Type == VNODE_DIRECTORY && (flags & VFS_OPEN_WRITE))
+        status = VFS_IS_DIRECTORY;
+
+    int id = -1;
+    for(int i = 0; i < VFS_MAX_FILES && id < 0 && status == VFS_OK; i++){
+        if(g_Files[i].Vnode == NULL)
+            id = i;
+    }
+    if(id < 0 && status == VFS_OK)
+        status = VFS_NO_RESOURCES;
+
+    if(status == VFS_OK && (flags & VFS_OPEN_TRUNCATE) && (flags & VFS_OPEN_WRITE) && vnode->Size != 0)
+        status = mount->Fs->Truncate != NULL ? mount->Fs->Truncate(vnode, 0) : VFS_READ_ONLY;
+
+    if(status == VFS_OK){
+        File* file = &g_Files[id];
+        vnode->RefCount++;
+        file->Vnode = vnode;
+        file->Flags = flags;
+        file->Position = 0;
+        Readahead_Initialize(&file->Readahead, mount->Device, mount->Fs->Map, vnode, vnode->Size);
+        if(mount->Fs->Map == NULL)
+            Readahead_SetEnabled(&file->Readahead, false);
+
+        g_Stats.Opens++;
+        *handle = id;
+    }
+
+    Dcache_Put(dentry);
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_Close(int handle){
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    if(file == NULL){
+        VFS_Unlock();
+        return VFS_INVALID;
+    }
+
+    VFS_PutVnode(file->Vnode);
+    file->Vnode = NULL;
+
+    VFS_Unlock();
+    return VFS_OK;
+}
+
+VfsStatus VFS_Read(int handle, void* buffer, uint32_t count, uint32_t* read){
+    *read = 0;
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    VfsStatus status = VFS_OK;
+    if(file == NULL || !(file->Flags & VFS_OPEN_READ))
+        status = VFS_INVALID;
+    else if(file->Vnode->Type == VNODE_DIRECTORY)
+        status = VFS_IS_DIRECTORY;
+
+    if(status == VFS_OK && file->Position < file->Vnode->Size){
+        Vnode* vnode = file->Vnode;
+        if(count > vnode->Size - file->Position)
+            count = vnode->Size - file->Position;
+
+        // the file may have grown since it was opened
+        file->Readahead.FileSize = vnode->Size;
+        Readahead_OnRead(&file->Readahead, file->Position, count);
+
+        status = vnode->Mount->Fs->Read(vnode, file->Position, buffer, count, read);
+        file->Position += *read;
+        g_Stats.BytesRead += *read;
+    }
+
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_ReadDirect(int handle, const void** data, uint32_t count, uint32_t* read){
+    *data = NULL;
+    *read = 0;
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    VfsStatus status = VFS_OK;
+    if(file == NULL || !(file->Flags & VFS_OPEN_READ) || file->Vnode->Mount->Fs->Direct == NULL)
+        status = VFS_INVALID;
+    else if(file->Vnode->Type == VNODE_DIRECTORY)
+        status = VFS_IS_DIRECTORY;
+
+    if(status == VFS_OK && file->Position < file->Vnode->Size){
+        Vnode* vnode = file->Vnode;
+        if(count > vnode->Size - file->Position)
+            count = vnode->Size - file->Position;
+
+        status = vnode->Mount->Fs->Direct(vnode, file->Position, data, &count);
+        if(status == VFS_OK){
+            *read = count;
+            file->Position += count;
+            g_Stats.BytesRead += count;
+        }
+    }
+
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_Write(int handle, const void* buffer, uint32_t count, uint32_t* written){
+    *written = 0;
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    VfsStatus status = VFS_OK;
+    if(file == NULL || !(file->Flags & VFS_OPEN_WRITE))
+        status = VFS_INVALID;
+    else if(file->Vnode->Mount->Fs->Write == NULL)
+        status = VFS_READ_ONLY;
+
+    if(status == VFS_OK && count > 0){
+        Vnode* vnode = file->Vnode;
+        if(file->Flags & VFS_OPEN_APPEND)
+            file->Position = vnode->Size;
+
+        status = vnode->Mount->Fs->Write(vnode, file->Position, buffer, count, written);
+        file->Position += *written;
+        g_Stats.BytesWritten += *written;
+    }
+
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_Seek(int handle, uint64_t position){
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    if(file != NULL)
+        file->Position = position;
+
+    VFS_Unlock();
+    return file != NULL ? VFS_OK : VFS_INVALID;
+}
+
+VfsStatus VFS_SetReadahead(int handle, bool enabled){
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    if(file != NULL)
+        Readahead_SetEnabled(&file->Readahead, enabled && file->Vnode->Mount->Fs->Map != NULL);
+
+    VFS_Unlock();
+    return file != NULL ? VFS_OK : VFS_INVALID;
+}
+
+VfsStatus VFS_GetReadaheadStats(int handle, ReadaheadStats* stats){
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    if(file != NULL)
+        *stats = file->Readahead.Stats;
+
+    VFS_Unlock();
+    return file != NULL ? VFS_OK : VFS_INVALID;
+}
+
+VfsStatus VFS_ReadDir(int handle, VfsDirEntry* entry){
+    VFS_Lock();
+
+    File* file = VFS_GetFile(handle);
+    VfsStatus status;
+    if(file == NULL)
+        status = VFS_INVALID;
+    else if(file->Vnode->Type != VNODE_DIRECTORY)
+        status = VFS_NOT_DIRECTORY;
+    else
+        status = file->Vnode->Mount->Fs->ReadDir(file->Vnode, &file->Position, entry);
+
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_Stat(const char* path, VfsStat* stat){
+    VFS_Lock();
+
+    uint64_t start = Clock_NowNs();
+    Dentry* dentry;
+    VfsStatus status = VFS_Walk(path, &dentry, NULL, NULL);
+    VFS_AccountLookup(start);
+
+    if(status == VFS_OK){
+        stat->Type = dentry->Vnode->Type;
+        stat->Size = dentry->Vnode->Size;
+        Dcache_Put(dentry);
+    }
+
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_MakeDirectory(const char* path){
+    VFS_Lock();
+
+    Dentry* dentry;
+    VfsStatus status = VFS_Resolve(path, true, VNODE_DIRECTORY, &dentry);
+    if(status == VFS_OK)
+        Dcache_Put(dentry);
+
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_Sync(){
+    VfsStatus result = VFS_OK;
+    VFS_Lock();
+
+    for(uint32_t i = 0; i < VFS_MAX_MOUNTS; i++){
+        Mount* mount = &g_Mounts[i];
+        if(mount->Fs == NULL)
+            continue;
+
+        VfsStatus status = mount->Fs->Sync != NULL ? mount->Fs->Sync(mount) : VFS_OK;
+        if(!BufferCache_Sync(mount->Device))
+            status = VFS_IO_ERROR;
+        if(status != VFS_OK)
+            result = status;
+    }
+
+    VFS_Unlock();
+    return result;
+}
+
+//
+// Mounts
+//
+
+bool VFS_RegisterFileSystem(FileSystem* fs){
+    if(g_FileSystemCount >= VFS_MAX_FILESYSTEMS)
+        return false;
+
+    g_FileSystems[g_FileSystemCount++] = fs;
+    return true;
+}
+
+static bool VFS_NameEquals(const char* a, const char* b){
+    while(*a != '\0' && *a == *b){
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+VfsStatus VFS_Mount(const char* path, BlockDevice* device, const char* fsName){
+    VFS_Lock();
+
+    // the mount point: nothing for the root, else a directory not yet covered
+    Dentry* covered = NULL;
+    VfsStatus status = VFS_OK;
+    if(VFS_NameEquals(path, "/")){
+        if(g_RootMount != NULL)
+            status = VFS_EXISTS;
+    } else {
+        status = VFS_Walk(path, &covered, NULL, NULL);
+        if(status == VFS_OK && covered->Vnode->Type != VNODE_DIRECTORY)
+            status = VFS_NOT_DIRECTORY;
+        else if(status == VFS_OK && covered->Vnode->Covered != NULL)
+            status = VFS_EXISTS;
+    }
+
+    Mount* mount = NULL;
+    for(uint32_t i = 0; i < VFS_MAX_MOUNTS && mount == NULL && status == VFS_OK; i++){
+        if(g_Mounts[i].Fs == NULL)
+            mount = &g_Mounts[i];
+    }
+    if(mount == NULL && status == VFS_OK)
+        status = VFS_NO_RESOURCES;
+
+    Vnode root;
+    if(status == VFS_OK){
+        status = VFS_NOT_FOUND;
+        for(uint32_t i = 0; i < g_FileSystemCount && status != VFS_OK; i++){
+            FileSystem* fs = g_FileSystems[i];
+            if(fsName != NULL && !VFS_NameEquals(fsName, fs->Name))
+                continue;
+
+            memset(mount, 0, sizeof(Mount));
+            mount->Fs = fs;
+            mount->Device = device;
+            memset(&root, 0, sizeof(Vnode));
+            root.Mount = mount;
+            status = fs->Mount(mount, &root);
+        }
+        if(status != VFS_OK)
+            mount->Fs = NULL;
+    }
+
+    if(status == VFS_OK){
+        Vnode* vnode = VFS_GetVnode(&root);
+        mount->Root = vnode != NULL ? Dcache_AddRoot(vnode) : NULL;
+        if(mount->Root == NULL){
+            if(vnode != NULL)
+                VFS_PutVnode(vnode);
+            mount->Fs = NULL;
+            status = VFS_NO_RESOURCES;
+        }
+    }
+
+    if(status == VFS_OK){
+        // the mount keeps its mount point referenced
+        mount->Covered = covered;
+        if(covered != NULL)
+            covered->Vnode->Covered = mount;
+        else
+            g_RootMount = mount;
+        printf("[VFS] %s mounted on %s (%s)\r\n", device->Name, path, mount->Fs->Name);
+    } else if(covered != NULL){
+        Dcache_Put(covered);
+    }
+
+    VFS_Unlock();
+    return status;
+}
+
+VfsStatus VFS_MountRoot(){
+    // partitions first, whole disks only hold a filesystem without a table
+    for(int pass = 0; pass < 2; pass++){
+        for(uint32_t i = 0; i < Block_GetDeviceCount(); i++){
+            BlockDevice* device = Block_GetDevice(i);
+            if((device->Parent != NULL) != (pass == 0))
+                continue;
+            if(VFS_Mount("/", device, NULL) == VFS_OK)
+                return VFS_OK;
+        }
+    }
+
+    printf("[VFS] No root filesystem found\r\n");
+    return VFS_NOT_FOUND;
+}
+
+void VFS_Initialize(){
+    Dcache_Initialize();
+}
+
+//
+// Diagnostics
+//
+
+const char* VFS_StatusString(VfsStatus status){
+    switch(status){
+    case VFS_OK:                return "ok";
+    case VFS_NOT_FOUND:         return "not found";
+    case VFS_NOT_DIRECTORY:     return "not a directory";
+    case VFS_IS_DIRECTORY:      return "is a directory";
+    case VFS_EXISTS:            return "exists";
+    case VFS_NO_SPACE:          return "no space left";
+    case VFS_READ_ONLY:         return "read only";
+    case VFS_NO_RESOURCES:      return "out of resources";
+    case VFS_INVALID:           return "invalid argument";
+    case VFS_IO_ERROR:          return "I/O error";
+    }
+    return "?";
+}
+
+void VFS_GetStats(VfsStats* stats){
+    VFS_Lock();
+    *stats = g_Stats;
+    VFS_Unlock();
+}
+
+void VFS_PrintStats(){
+    VfsStats stats;
+    VFS_GetStats(&stats);
+
+    printf("===== VFS STATS =====\r\n");
+    printf("lookups=%llu avg=%lluns max=%lluns driver lookups=%llu\r\n",
+           stats.Lookups, stats.Lookups ? stats.LookupNs / stats.Lookups : 0,
+           stats.LookupMaxNs, stats.FsLookups);
+    printf("opens=%llu read=%llu written=%llu\r\n",
+           stats.Opens, stats.BytesRead, stats.BytesWritten);
+    printf("=====================\r\n");
+
+    VFS_Lock();
+    Dcache_PrintStats();
+    VFS_Unlock();
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <block/block.h>
+#include <block/readahead.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VFS_NAME_MAX                63
+#define VFS_MAX_FILESYSTEMS         4
+#define VFS_MAX_MOUNTS              8
+#define VFS_MAX_VNODES              256
+#define VFS_MAX_FILES               64
+
+typedef enum{
+    VFS_OK = 0,
+    VFS_NOT_FOUND,
+    VFS_NOT_DIRECTORY,
+    VFS_IS_DIRECTORY,
+    VFS_EXISTS,
+    VFS_NO_SPACE,
+    VFS_READ_ONLY,
+    VFS_NO_RESOURCES,                       // out of handles, vnodes or dentries
+    VFS_INVALID,
+    VFS_IO_ERROR,
+} VfsStatus;
+
+typedef enum{
+    VNODE_FILE,
+    VNODE_DIRECTORY,
+} VnodeType;
+
+enum VFS_OpenFlags{
+    VFS_OPEN_READ               = 0x01,
+    VFS_OPEN_WRITE              = 0x02,
+    VFS_OPEN_CREATE             = 0x04,
+    VFS_OPEN_TRUNCATE           = 0x08,
+    VFS_OPEN_APPEND             = 0x10,
+};
+
+struct Mount;
+struct Dentry;
+
+// One per file in use, shared by every dentry and open file naming it
+typedef struct Vnode{
+    struct Mount* Mount;                    // NULL while the slot is free
+    VnodeType Type;
+    uint64_t Id;                            // unique within the mount, set by the filesystem
+    uint64_t Size;
+    uint32_t RefCount;
+    struct Mount* Covered;                  // mounted on top of this directory
+    void* Private;
+} Vnode;
+
+typedef struct{
+    char Name[VFS_NAME_MAX + 1];
+    VnodeType Type;
+    uint64_t Size;
+} VfsDirEntry;
+
+// Filesystem drivers. Calls are serialized by the VFS. Lookup and Create
+// fill the Vnode they are given (Type, Id, Size, Private); Release frees
+// what the driver hung off Private once the vnode is no longer used.
+typedef struct{
+    const char* Name;
+    bool CaseInsensitive;                   // names are folded before caching
+
+    VfsStatus (*Mount)(struct Mount* mount, Vnode* root);
+    VfsStatus (*Lookup)(Vnode* dir, const char* name, Vnode* out);
+    VfsStatus (*Create)(Vnode* dir, const char* name, VnodeType type, Vnode* out);
+    VfsStatus (*Read)(Vnode* vnode, uint64_t offset, void* buffer, uint32_t count, uint32_t* done);
+    VfsStatus (*Write)(Vnode* vnode, uint64_t offset, const void* buffer, uint32_t count, uint32_t* done);
+    VfsStatus (*Truncate)(Vnode* vnode, uint64_t size);
+    // NOT_FOUND past the last entry; cookie starts at 0
+    VfsStatus (*ReadDir)(Vnode* dir, uint64_t* cookie, VfsDirEntry* entry);
+    VfsStatus (*Sync)(struct Mount* mount);
+    void (*Release)(Vnode* vnode);
+    // Optional, for filesystems whose files sit in memory: the bytes from
+    // offset on, in place, with count clipped to what is contiguous. They
+    // stay valid while the vnode is referenced.
+    VfsStatus (*Direct)(Vnode* vnode, uint64_t offset, const void** data, uint32_t* count);
+    ReadaheadMap Map;                       // file is the Vnode, NULL: no readahead
+} FileSystem;
+
+typedef struct Mount{
+    FileSystem* Fs;                         // NULL while the slot is free
+    BlockDevice* Device;
+    struct Dentry* Root;
+    struct Dentry* Covered;                 // mount point, NULL for the root
+    void* Private;
+} Mount;
+
+typedef struct{
+    VnodeType Type;
+    uint64_t Size;
+} VfsStat;
+
+typedef struct{
+    uint64_t Lookups;                       // path walks
+    uint64_t LookupNs;
+    uint64_t LookupMaxNs;
+    uint64_t FsLookups;                     // components that went to the driver
+    uint64_t Opens;
+    uint64_t BytesRead;
+    uint64_t BytesWritten;
+} VfsStats;
+
+void VFS_Initialize();
+bool VFS_RegisterFileSystem(FileSystem* fs);
+
+// fsName NULL tries every registered filesystem
+VfsStatus VFS_Mount(const char* path, BlockDevice* device, const char* fsName);
+// Mounts the first block device some filesystem recognizes on /
+VfsStatus VFS_MountRoot();
+
+// Paths are absolute
+VfsStatus VFS_Open(const char* path, uint32_t flags, int* handle);
+VfsStatus VFS_Close(int handle);
+VfsStatus VFS_Read(int handle, void* buffer, uint32_t count, uint32_t* read);
+// Zero copy read: points data at the next bytes of the file instead of
+// copying them, INVALID if the filesystem can't. read is 0 at the end.
+VfsStatus VFS_ReadDirect(int handle, const void** data, uint32_t count, uint32_t* read);
+VfsStatus VFS_Write(int handle, const void* buffer, uint32_t count, uint32_t* written);
+VfsStatus VFS_Seek(int handle, uint64_t position);
+// Readahead is on by default for filesystems that support it
+VfsStatus VFS_SetReadahead(int handle, bool enabled);
+VfsStatus VFS_GetReadaheadStats(int handle, ReadaheadStats* stats);
+VfsStatus VFS_ReadDir(int handle, VfsDirEntry* entry);
+VfsStatus VFS_Stat(const char* path, VfsStat* stat);
+VfsStatus VFS_MakeDirectory(const char* path);
+VfsStatus VFS_Sync();
+
+// Reference counting, for the dentry cache
+void VFS_PutVnode(Vnode* vnode);
+
+const char* VFS_StatusString(VfsStatus status);
+void VFS_GetStats(VfsStats* stats);
+void VFS_PrintStats();
+void VFS_RunBenchmarks();
+// Streams a large file with readahead off and on, writing it first if the
+// image does not hold it yet
+void VFS_RunStreamBenchmark();
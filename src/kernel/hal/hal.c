@@ -3,10 +3,16 @@
 #include <arch/i686/interrupts/idt.h>
 #include <arch/i686/interrupts/isr.h>
 #include <arch/i686/interrupts/irq.h>
+#include <arch/i686/apic/lapic.h>
+#include <arch/i686/fpu.h>
+#include <arch/i686/smp/percpu.h>
+#include <stddef.h>
 
 void HAL_Inizialize(){
-    i686_GDT_Initialize();
+    // the bootstrap processor keeps running on the stack stage2 gave it
+    i686_PerCPU_Initialize(0, NULL);
     i686_IDT_Initialize();
-    i686_ISR_Initialize();
     i686_IRQ_Initialize();
+    i686_LAPIC_Initialize();
+    i686_FPU_Initialize();
 }
\ No newline at end of file
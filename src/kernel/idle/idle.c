@@ -0,0 +1,90 @@
+#include "idle.h"
+#include <arch/i686/io.h>
+#include <arch/generic/cpu.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define MWAIT_HINT_C1               0x00
+
+static bool g_UseMwait = false;
+static IdleHook g_Hook = NULL;
+static volatile uint32_t g_WakeFlag __attribute__((aligned(64)));
+
+static uint64_t g_StartCycles;
+static IdleStats g_Stats;
+
+void Idle_Initialize(){
+    unsigned int eax, ebx, ecx, edx;
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    g_UseMwait = (ecx & CPUID_FEAT_ECX_MONITOR) != 0;
+
+    g_StartCycles = i686_rdtsc();
+
+    printf("[IDLE] Using %s\r\n", g_UseMwait ? "MONITOR/MWAIT" : "HLT");
+}
+
+void Idle_SetHook(IdleHook hook){
+    g_Hook = hook;
+}
+
+// Wakes a CPU sleeping in MWAIT without sending it an interrupt
+void Idle_Wake(){
+    g_WakeFlag = 1;
+}
+
+// Enters with interrupts disabled, returns with interrupts enabled.
+// The time spent in the handler of the waking interrupt counts as idle.
+static void Idle_Enter(){
+    uint64_t start = i686_rdtsc();
+
+    if(g_UseMwait){
+        i686_monitor(&g_WakeFlag);
+        if(g_WakeFlag == 0)
+            i686_sti_mwait(MWAIT_HINT_C1, 0);
+        else
+            i686_sti();
+    } else {
+        i686_sti_hlt();
+    }
+
+    i686_cli();
+    g_WakeFlag = 0;
+    g_Stats.IdleCycles += i686_rdtsc() - start;
+    g_Stats.Halts++;
+    i686_sti();
+}
+
+void Idle_Loop(){
+    for(;;){
+        // checking for work and halting must not be split by an interrupt,
+        // otherwise a wakeup could be lost until the next one arrives
+        i686_cli();
+        if(g_Hook != NULL && g_Hook()){
+            i686_sti();
+            continue;
+        }
+
+        Idle_Enter();
+    }
+}
+
+void Idle_GetStats(IdleStats* stats){
+    uint32_t flags = i686_irqsave();
+    *stats = g_Stats;
+    stats->TotalCycles = i686_rdtsc() - g_StartCycles;
+    i686_irqrestore(flags);
+}
+
+void Idle_PrintStats(){
+    IdleStats stats;
+    Idle_GetStats(&stats);
+
+    uint64_t busy = stats.TotalCycles - stats.IdleCycles;
+    uint32_t permille = stats.TotalCycles ? (uint32_t)(busy * 1000 / stats.TotalCycles) : 0;
+
+    printf("===== IDLE STATS =====\r\n");
+    printf("halts=%llu\r\n", stats.Halts);
+    printf("idle cycles=%llu busy cycles=%llu\r\n", stats.IdleCycles, busy);
+    printf("cpu utilization=%u.%u%%\r\n", permille / 10, permille % 10);
+    printf("======================\r\n");
+}
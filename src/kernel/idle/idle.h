@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Called with interrupts disabled before every halt. Returning true means
+// there is work to do, so the CPU must not halt.
+typedef bool (*IdleHook)();
+
+typedef struct{
+    uint64_t IdleCycles;            // TSC cycles spent halted
+    uint64_t TotalCycles;           // TSC cycles since Idle_Initialize
+    uint64_t Halts;                 // times the CPU was put to sleep
+} IdleStats;
+
+void Idle_Initialize();
+void Idle_SetHook(IdleHook hook);
+void __attribute__((noreturn)) Idle_Loop();
+void Idle_Wake();
+
+void Idle_GetStats(IdleStats* stats);
+void Idle_PrintStats();
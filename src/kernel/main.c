@@ -1,35 +1,242 @@
 #include <stdint.h>
+#include <stddef.h>
 #include <hal/hal.h>
 #include <arch/i686/io.h>
 #include <arch/i686/interrupts/irq.h>
+#include <arch/i686/smp/smp.h>
 #include <arch/generic/cpu.h>
+#include <timer/clock.h>
+#include <timer/timer.h>
+#include <idle/idle.h>
+#include <sched/scheduler.h>
+#include <sched/completion.h>
+#include <sched/thread.h>
+#include <sched/workqueue.h>
+#include <drivers/pci/pci.h>
+#include <drivers/ata/ata.h>
+#include <drivers/ahci/ahci.h>
+#include <drivers/virtio/virtio_blk.h>
+#include <block/block.h>
+#include <block/buffer_cache.h>
+#include <block/readahead.h>
+#include <block/ramdisk.h>
+#include <boot/bootinfo.h>
+#include <fs/vfs.h>
+#include <fs/ext2/ext2.h>
+#include <fs/fat/fat.h>
+#include <fs/initrd/initrd.h>
+#include <util/lockstress.h>
+#include <util/lockfree_bench.h>
+#include <util/profiler.h>
+#include <util/trace.h>
 
 #include "stdio.h"
 #include "memory.h"
-
-void timer(Registers* regs){
-}
+#include "config.h"
 
 extern uint8_t __bss_start;
 extern uint8_t __end;
 
-void __attribute__((section(".entry"))) start(uint16_t bootDrive){
+static BootInfo g_BootInfo;
+
+#if CONFIG_TIMER_CHECK
+
+#define TIMER_CHECK_ROUNDS          10
+#define TIMER_CHECK_GRACE_NS        (100 * NS_PER_MS)
+
+static const uint64_t g_TimerCheckDelays[] = {
+    1 * NS_PER_MS,
+    3 * NS_PER_MS,
+    10 * NS_PER_MS,
+    50 * NS_PER_MS,
+};
+
+static volatile uint64_t g_TimerFiredNs;
+static Completion g_TimerFired;
+
+static void TimerCheck_Fired(Timer* timer, void* context){
+    g_TimerFiredNs = Clock_NowNs();
+    Completion_Signal(&g_TimerFired);
+}
+
+// Nothing else runs meanwhile, so the CPU idles until each timer fires and
+// the halts counted are the wakeups the timers cost
+static void TimerCheck_Run(){
+    Timer timer;
+    Timer_Setup(&timer, TimerCheck_Fired, NULL);
+    Completion_Initialize(&g_TimerFired);
+
+    IdleStats idleBefore, idleAfter;
+    Idle_GetStats(&idleBefore);
+    uint32_t timers = 0;
+
+    for(uint32_t i = 0; i < sizeof(g_TimerCheckDelays) / sizeof(g_TimerCheckDelays[0]); i++){
+        uint64_t delay = g_TimerCheckDelays[i];
+        uint64_t totalLate = 0, maxLate = 0;
+        uint32_t early = 0, missed = 0;
+
+        for(uint32_t round = 0; round < TIMER_CHECK_ROUNDS; round++){
+            Completion_Reset(&g_TimerFired);
+            uint64_t deadline = Clock_NowNs() + delay;
+            Timer_Add(&timer, delay);
+            timers++;
+
+            if(!Completion_Wait(&g_TimerFired, delay + TIMER_CHECK_GRACE_NS)){
+                Timer_Cancel(&timer);
+                missed++;
+                continue;
+            }
+
+            if(g_TimerFiredNs < deadline){
+                early++;
+                continue;
+            }
+            uint64_t late = g_TimerFiredNs - deadline;
+            totalLate += late;
+            if(late > maxLate)
+                maxLate = late;
+        }
+
+        uint32_t fired = TIMER_CHECK_ROUNDS - missed - early;
+        printf("[TIMER] %llums one-shot: late avg %lluus max %lluus, %u early, %u missed\r\n",
+               delay / NS_PER_MS, fired ? totalLate / fired / NS_PER_US : 0, maxLate / NS_PER_US,
+               early, missed);
+    }
+
+    Idle_GetStats(&idleAfter);
+    printf("[TIMER] %u timers, %llu idle wakeups\r\n", timers, idleAfter.Halts - idleBefore.Halts);
+    Timer_PrintStats();
+}
+
+#endif
+
+void __attribute__((section(".entry"))) start(const BootInfo* bootInfo){
 
     memset(&__bss_start, 0, (&__end) - (&__bss_start));
 
+    // the loader's stack, stage2's or the Multiboot one, which the main
+    // thread keeps; this frame is the outermost one a stack walk needs
+    Thread_SetBootStack((uintptr_t)__builtin_frame_address(0) + 8);
+
+    // it lives in the loader's memory, which nothing keeps
+    if(bootInfo != NULL && bootInfo->Magic == BOOTINFO_MAGIC)
+        g_BootInfo = *bootInfo;
+
     clrscr();
     printf("Loaded Kernel !!!\r\n");
 
+    if(g_BootInfo.MemoryRegionCount != 0){
+        uint64_t available = 0;
+        for(uint32_t i = 0; i < g_BootInfo.MemoryRegionCount; i++){
+            if(g_BootInfo.MemoryRegions[i].Type == BOOTINFO_MEMORY_AVAILABLE)
+                available += g_BootInfo.MemoryRegions[i].Length;
+        }
+        printf("[BOOT] %llu KiB available in %u memory regions\r\n", available / 1024, g_BootInfo.MemoryRegionCount);
+    }
+
     HAL_Inizialize();
 
     printf("Initialized HAL !!!\r\n");
 
-    i686_IRQ_RegisterHandler(0, timer);
-
     print_cpu_info();
 
+    Clock_Initialize();
+    Timer_Initialize();
+    i686_SMP_Initialize();
+    Idle_Initialize();
+    WorkQueue_Initialize();
+    Scheduler_Initialize();
+
+    BufferCache_Initialize();
+
+    PCI_Initialize();
+    PCI_PrintDevices();
+    ATA_Initialize();
+    AHCI_Initialize();
+    VirtioBlk_Initialize();
+    Block_PrintDevices();
+
+    VFS_Initialize();
+    EXT2_Initialize();
+    FAT_Initialize();
+    Initrd_Initialize();
+    VfsStatus root = VFS_MountRoot();
+
+    // registered after the root is found so that it is never taken for it
+    // while there is a disk; without one the initrd becomes the root
+    if(g_BootInfo.InitrdSize != 0){
+        BlockDevice* initrd = Ramdisk_Register("initrd", (void*)g_BootInfo.InitrdAddress, g_BootInfo.InitrdSize);
+        VfsStatus status = initrd != NULL ? VFS_Mount(root == VFS_OK ? "/initrd" : "/", initrd, "initrd") : VFS_NO_RESOURCES;
+        if(status != VFS_OK)
+            printf("[BOOT] initrd not mounted: %s\r\n", VFS_StatusString(status));
+    }
+
+#if CONFIG_TIMER_CHECK
+    TimerCheck_Run();
+#endif
+
+#if CONFIG_PROFILER
+    Profiler_Start(PROFILER_DEFAULT_PERIOD_US, true);
+#endif
+
+#if CONFIG_TRACE && CONFIG_TRACE_BOOT
+    Trace_Start();
+#endif
+
+#if CONFIG_SCHED_BENCHMARK
+    Scheduler_RunBenchmarks();
+#endif
+
+#if CONFIG_LOCK_STRESSTEST
+    Lock_RunStressTest();
+#endif
+
+#if CONFIG_LOCKFREE_BENCHMARK
+    LockFree_RunBenchmarks();
+#endif
+
+#if CONFIG_ATA_BENCHMARK
+    ATA_RunBenchmarks();
+#endif
+
+#if CONFIG_AHCI_BENCHMARK
+    AHCI_RunBenchmarks();
+#endif
+
+#if CONFIG_VIRTIO_BENCHMARK
+    VirtioBlk_RunBenchmarks();
+#endif
+
+#if CONFIG_BLOCK_BENCHMARK
+    Block_RunBenchmarks();
+#endif
+
+#if CONFIG_BCACHE_BENCHMARK
+    BufferCache_RunBenchmarks();
+#endif
+
+#if CONFIG_READAHEAD_BENCHMARK
+    Readahead_RunBenchmarks();
+#endif
+
+#if CONFIG_VFS_BENCHMARK
+    VFS_RunBenchmarks();
+#endif
+
+#if CONFIG_TRACE && CONFIG_TRACE_BOOT
+    Trace_Dump();
+    Trace_PrintStats();
+#endif
+
+#if CONFIG_PROFILER
+    Profiler_Dump();
+    Profiler_PrintStats();
+#endif
+
+    // how much of the boot the CPU spent halted
+    Idle_PrintStats();
 
-    end:
-        for(;;);
+    // from now on the idle thread takes over whenever nothing else runs
+    Thread_Exit();
 
 }
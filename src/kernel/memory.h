@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 
-void * memcpy( void * dst, const void * src, uint16_t num);
-void * memset(void * ptr, int value, uint16_t num);
-int memcmp(const void * ptr1, const void * ptr2, uint16_t num);
\ No newline at end of file
+void * memcpy( void * dst, const void * src, size_t num);
+void * memset(void * ptr, int value, size_t num);
+int memcmp(const void * ptr1, const void * ptr2, size_t num);
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "scheduler.h"
+#include <arch/i686/fpu.h>
+#include <arch/i686/io.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define BENCH_YIELD_ROUNDS          10000
+#define BENCH_WAKE_ROUNDS           1000
+#define BENCH_FPU_ROUNDS            10000
+#define BENCH_WAITER_PRIORITY       (THREAD_PRIORITY_DEFAULT - 1)
+
+// Throughput: two threads of the same priority hand the CPU to each other.
+static Thread* g_BenchMain;
+static volatile uint32_t g_YieldRunning;
+static volatile uint64_t g_YieldStart;
+static volatile uint64_t g_YieldEnd;
+
+static void Bench_YieldThread(void* arg){
+    if(g_YieldStart == 0)
+        g_YieldStart = i686_rdtsc();
+
+    for(int i = 0; i < BENCH_YIELD_ROUNDS; i++)
+        Scheduler_Yield();
+
+    if(--g_YieldRunning == 0){
+        g_YieldEnd = i686_rdtsc();
+        Scheduler_Wake(g_BenchMain);
+    }
+}
+
+static void Bench_Yield(){
+    g_BenchMain = Thread_GetCurrent();
+    g_YieldStart = 0;
+    g_YieldRunning = 2;
+
+    // same priority as us, so neither starts before we block
+    uint32_t flags = i686_irqsave();
+    Thread_Create("yield-a", Bench_YieldThread, NULL, g_BenchMain->Priority);
+    Thread_Create("yield-b", Bench_YieldThread, NULL, g_BenchMain->Priority);
+    Scheduler_Block();
+    i686_irqrestore(flags);
+
+    uint64_t switches = 2 * BENCH_YIELD_ROUNDS;
+    uint64_t ns = Clock_CyclesToNs(g_YieldEnd - g_YieldStart);
+    printf("[BENCH] yield: %llu switches in %lluus, %lluns/switch, %llu switches/s\r\n",
+           switches, ns / NS_PER_US, ns / switches,
+           ns ? switches * NS_PER_SEC / ns : 0);
+}
+
+// Latency: from Scheduler_Wake in a low priority thread until the woken high
+// priority thread runs.
+static Thread* volatile g_Waiter;
+static volatile uint64_t g_WakeStamp;
+static volatile bool g_WaiterDone;
+static uint64_t g_WakeMin, g_WakeMax, g_WakeTotal;
+
+static void Bench_WaiterThread(void* arg){
+    for(int i = 0; i < BENCH_WAKE_ROUNDS; i++){
+        Scheduler_Block();
+
+        uint64_t cycles = i686_rdtsc() - g_WakeStamp;
+        g_WakeTotal += cycles;
+        if(cycles < g_WakeMin)
+            g_WakeMin = cycles;
+        if(cycles > g_WakeMax)
+            g_WakeMax = cycles;
+    }
+    g_WaiterDone = true;
+}
+
+static void Bench_WakeLatency(){
+    g_WakeMin = ~0ULL;
+    g_WakeMax = 0;
+    g_WakeTotal = 0;
+    g_WaiterDone = false;
+
+    // outranks us: runs immediately and blocks, and every wake switches to it
+    g_Waiter = Thread_Create("waiter", Bench_WaiterThread, NULL, BENCH_WAITER_PRIORITY);
+
+    while(!g_WaiterDone){
+        g_WakeStamp = i686_rdtsc();
+        Scheduler_Wake(g_Waiter);
+    }
+
+    printf("[BENCH] wake latency: min=%lluns avg=%lluns max=%lluns\r\n",
+           Clock_CyclesToNs(g_WakeMin),
+           Clock_CyclesToNs(g_WakeTotal / BENCH_WAKE_ROUNDS),
+           Clock_CyclesToNs(g_WakeMax));
+}
+
+// Lazy FPU switching: two threads yield to each other as in Bench_Yield,
+// either both using the x87 between switches or only one of them. Only the
+// first pair should need a save and a restore on every switch.
+static volatile uint32_t g_FpuRunning;
+static volatile uint32_t g_FpuErrors;
+
+static void Bench_FpuThread(void* arg){
+    bool useFpu = arg != NULL;
+    double sum = 0.0;
+
+    for(int i = 0; i < BENCH_FPU_ROUNDS; i++){
+        if(useFpu)
+            sum += 1.0;
+        Scheduler_Yield();
+    }
+
+    // a state lost or mixed up on some switch shows up here
+    if(useFpu && sum != (double)BENCH_FPU_ROUNDS)
+        g_FpuErrors++;
+
+    if(--g_FpuRunning == 0)
+        Scheduler_Wake(g_BenchMain);
+}
+
+static void Bench_FpuPair(const char* name, bool bothUseFpu){
+    FPUStats before, after;
+
+    g_BenchMain = Thread_GetCurrent();
+    g_FpuRunning = 2;
+    g_FpuErrors = 0;
+    i686_FPU_GetStats(&before);
+
+    uint32_t flags = i686_irqsave();
+    Thread_Create("fpu-a", Bench_FpuThread, (void*)1, g_BenchMain->Priority);
+    Thread_Create("fpu-b", Bench_FpuThread, bothUseFpu ? (void*)1 : NULL, g_BenchMain->Priority);
+    Scheduler_Block();
+    i686_irqrestore(flags);
+
+    i686_FPU_GetStats(&after);
+    uint64_t switches = after.Switches - before.Switches;
+    uint64_t saves = after.Saves - before.Saves;
+    uint64_t restores = after.Restores - before.Restores;
+
+    printf("[BENCH] fpu %s: %llu switches, per 100 switches: saves=%llu restores=%llu%s\r\n",
+           name, switches,
+           switches ? saves * 100 / switches : 0,
+           switches ? restores * 100 / switches : 0,
+           g_FpuErrors ? " STATE CORRUPTED" : "");
+}
+
+void Scheduler_RunBenchmarks(){
+    Bench_Yield();
+    Bench_WakeLatency();
+    Bench_FpuPair("both threads", true);
+    Bench_FpuPair("one thread", false);
+    Scheduler_PrintStats();
+    i686_FPU_PrintStats();
+}
@@ -0,0 +1,43 @@
+#include "completion.h"
+#include "scheduler.h"
+#include <arch/i686/io.h>
+#include <stddef.h>
+
+void Completion_Initialize(Completion* completion){
+    completion->Done = false;
+    completion->Waiter = NULL;
+}
+
+void Completion_Reset(Completion* completion){
+    completion->Done = false;
+}
+
+void Completion_Signal(Completion* completion){
+    uint32_t flags = i686_irqsave();
+
+    completion->Done = true;
+    if(completion->Waiter != NULL)
+        Scheduler_Wake(completion->Waiter);
+
+    i686_irqrestore(flags);
+}
+
+bool Completion_Wait(Completion* completion, uint64_t timeoutNs){
+    uint32_t flags = i686_irqsave();
+
+    // the sleep timer wakes us up on timeout, like Thread_Sleep
+    Thread* thread = Thread_GetCurrent();
+    completion->Waiter = thread;
+    if(timeoutNs != 0)
+        Timer_Add(&thread->SleepTimer, timeoutNs);
+
+    while(!completion->Done && (timeoutNs == 0 || Timer_IsPending(&thread->SleepTimer)))
+        Scheduler_Block();
+
+    Timer_Cancel(&thread->SleepTimer);
+    completion->Waiter = NULL;
+    bool done = completion->Done;
+
+    i686_irqrestore(flags);
+    return done;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "thread.h"
+
+// One-shot event a thread can sleep on, typically signaled by an interrupt
+// handler when a device is done.
+typedef struct{
+    volatile bool   Done;
+    Thread*         Waiter;
+} Completion;
+
+void Completion_Initialize(Completion* completion);
+// Rearms it for the next event; call before starting the operation
+void Completion_Reset(Completion* completion);
+// Safe from interrupt handlers
+void Completion_Signal(Completion* completion);
+// Returns false on timeout. A timeout of 0 waits forever.
+bool Completion_Wait(Completion* completion, uint64_t timeoutNs);
@@ -0,0 +1,192 @@
+#include "scheduler.h"
+#include <arch/i686/context.h>
+#include <arch/i686/fpu.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/io.h>
+#include <arch/i686/smp/percpu.h>
+#include <idle/idle.h>
+#include <timer/timer.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define SCHEDULER_TIME_SLICE_NS     (10 * NS_PER_MS)
+
+// One FIFO per priority plus a bitmap of the non-empty ones, so picking the
+// next thread is a single bit scan whatever the number of threads.
+typedef struct{
+    Thread* Head;
+    Thread* Tail;
+} RunQueue;
+
+static RunQueue g_RunQueues[THREAD_PRIORITY_COUNT];
+static uint32_t g_ReadyBitmap;
+
+static Thread* g_Current = NULL;
+static Thread* g_Previous = NULL;
+static Thread* g_Idle = NULL;
+static volatile bool g_NeedResched = false;
+
+static Timer g_SliceTimer;
+static SchedulerStats g_Stats;
+
+void Scheduler_Enqueue(Thread* thread){
+    RunQueue* queue = &g_RunQueues[thread->Priority];
+
+    thread->State = THREAD_STATE_READY;
+    thread->Next = NULL;
+    if(queue->Tail != NULL)
+        queue->Tail->Next = thread;
+    else
+        queue->Head = thread;
+    queue->Tail = thread;
+
+    g_ReadyBitmap |= 1u << thread->Priority;
+}
+
+static Thread* Scheduler_Dequeue(){
+    if(g_ReadyBitmap == 0)
+        return NULL;
+
+    RunQueue* queue = &g_RunQueues[__builtin_ctz(g_ReadyBitmap)];
+    Thread* thread = queue->Head;
+
+    queue->Head = thread->Next;
+    if(queue->Head == NULL){
+        queue->Tail = NULL;
+        g_ReadyBitmap &= ~(1u << thread->Priority);
+    }
+
+    thread->Next = NULL;
+    return thread;
+}
+
+Thread* Scheduler_GetCurrent(){
+    return g_Current;
+}
+
+// Runs on the new thread right after a switch
+void Scheduler_FinishSwitch(){
+    if(g_Previous != NULL && g_Previous->State == THREAD_STATE_EXITED)
+        g_Previous->State = THREAD_STATE_FREE;
+    g_Previous = NULL;
+}
+
+void Scheduler_Schedule(){
+    Thread* previous = g_Current;
+
+    if(previous->State == THREAD_STATE_RUNNING && previous != g_Idle)
+        Scheduler_Enqueue(previous);
+
+    Thread* next = Scheduler_Dequeue();
+    if(next == NULL)
+        next = g_Idle;
+
+    g_NeedResched = false;
+    next->State = THREAD_STATE_RUNNING;
+
+    // the idle thread runs until something is woken, it needs no time slice
+    if(next != g_Idle)
+        Timer_Modify(&g_SliceTimer, SCHEDULER_TIME_SLICE_NS);
+    else
+        Timer_Cancel(&g_SliceTimer);
+
+    if(next == previous)
+        return;
+
+    g_Stats.Switches++;
+    g_Previous = previous;
+    g_Current = next;
+    i686_FPU_SwitchTo(&next->Fpu);
+    i686_Context_Switch(&previous->Stack, next->Stack);
+
+    Scheduler_FinishSwitch();
+}
+
+void Scheduler_Yield(){
+    uint32_t flags = i686_irqsave();
+    g_Stats.Yields++;
+    Scheduler_Schedule();
+    i686_irqrestore(flags);
+}
+
+void Scheduler_Block(){
+    uint32_t flags = i686_irqsave();
+    g_Current->State = THREAD_STATE_BLOCKED;
+    Scheduler_Schedule();
+    i686_irqrestore(flags);
+}
+
+void Scheduler_Wake(Thread* thread){
+    uint32_t flags = i686_irqsave();
+
+    if(thread->State == THREAD_STATE_BLOCKED){
+        Scheduler_Enqueue(thread);
+
+        if(g_Current == g_Idle || thread->Priority < g_Current->Priority){
+            g_NeedResched = true;
+            Idle_Wake();
+        }
+
+        // from an interrupt the switch happens on exit
+        if(g_NeedResched && !i686_ISR_InInterrupt())
+            Scheduler_Schedule();
+    }
+
+    i686_irqrestore(flags);
+}
+
+static void Scheduler_SliceExpired(Timer* timer, void* context){
+    g_NeedResched = true;
+}
+
+static void Scheduler_InterruptExit(){
+    // threads only run on the bootstrap processor for now
+    if(!g_NeedResched || i686_PerCPU_GetId() != 0)
+        return;
+
+    g_Stats.Preemptions++;
+    Scheduler_Schedule();
+}
+
+static bool Scheduler_IdleHook(){
+    if(g_ReadyBitmap == 0)
+        return false;
+
+    Scheduler_Schedule();
+    return true;
+}
+
+static void Scheduler_IdleThread(void* arg){
+    Idle_Loop();
+}
+
+void Scheduler_Initialize(){
+    g_Current = Thread_Allocate("main", NULL, NULL, THREAD_PRIORITY_DEFAULT);
+    g_Current->State = THREAD_STATE_RUNNING;
+    i686_FPU_SwitchTo(&g_Current->Fpu);
+
+    g_Idle = Thread_Allocate("idle", Scheduler_IdleThread, NULL, THREAD_PRIORITY_LOWEST);
+
+    Timer_Setup(&g_SliceTimer, Scheduler_SliceExpired, NULL);
+    Idle_SetHook(Scheduler_IdleHook);
+    i686_ISR_RegisterExitHandler(Scheduler_InterruptExit);
+
+    Timer_Modify(&g_SliceTimer, SCHEDULER_TIME_SLICE_NS);
+}
+
+void Scheduler_GetStats(SchedulerStats* stats){
+    uint32_t flags = i686_irqsave();
+    *stats = g_Stats;
+    i686_irqrestore(flags);
+}
+
+void Scheduler_PrintStats(){
+    SchedulerStats stats;
+    Scheduler_GetStats(&stats);
+
+    printf("===== SCHED STATS =====\r\n");
+    printf("switches=%llu\r\n", stats.Switches);
+    printf("preemptions=%llu\r\n", stats.Preemptions);
+    printf("yields=%llu\r\n", stats.Yields);
+    printf("=======================\r\n");
+}
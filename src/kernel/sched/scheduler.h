@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "thread.h"
+
+typedef struct{
+    uint64_t Switches;
+    uint64_t Preemptions;           // switches forced at interrupt exit
+    uint64_t Yields;
+} SchedulerStats;
+
+// Turns the running boot code into the "main" thread and creates the idle thread
+void Scheduler_Initialize();
+
+// All of these may be called with interrupts enabled or disabled
+void Scheduler_Yield();
+void Scheduler_Block();
+void Scheduler_Wake(Thread* thread);
+
+// Internal to the scheduler and thread code, interrupts must be disabled
+void Scheduler_Enqueue(Thread* thread);
+void Scheduler_Schedule();
+void Scheduler_FinishSwitch();
+Thread* Scheduler_GetCurrent();
+
+void Scheduler_GetStats(SchedulerStats* stats);
+void Scheduler_PrintStats();
+void Scheduler_RunBenchmarks();
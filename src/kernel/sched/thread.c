@@ -0,0 +1,121 @@
+#include "thread.h"
+#include "scheduler.h"
+#include <arch/i686/context.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/io.h>
+#include <stddef.h>
+#include "stdio.h"
+
+static Thread g_Threads[THREAD_MAX];
+static uint8_t g_Stacks[THREAD_MAX][THREAD_STACK_SIZE] __attribute__((aligned(16)));
+static uintptr_t g_BootStackTop;
+
+// First code run by every new thread, entered with interrupts disabled
+static void Thread_Start(void* arg){
+    Thread* thread = (Thread*)arg;
+
+    Scheduler_FinishSwitch();
+    i686_sti();
+
+    thread->Entry(thread->Arg);
+    Thread_Exit();
+}
+
+static void Thread_SleepTimeout(Timer* timer, void* context){
+    Scheduler_Wake((Thread*)context);
+}
+
+Thread* Thread_Allocate(const char* name, ThreadEntry entry, void* arg, uint8_t priority){
+    uint32_t flags = i686_irqsave();
+
+    int id = -1;
+    for(int i = 0; i < THREAD_MAX && id < 0; i++){
+        if(g_Threads[i].State == THREAD_STATE_FREE)
+            id = i;
+    }
+
+    if(id < 0){
+        i686_irqrestore(flags);
+        printf("[SCHED] Run out of threads!\r\n");
+        return NULL;
+    }
+
+    Thread* thread = &g_Threads[id];
+    thread->Id = id;
+    thread->Priority = priority < THREAD_PRIORITY_COUNT ? priority : THREAD_PRIORITY_LOWEST;
+    thread->State = THREAD_STATE_BLOCKED;
+    thread->Next = NULL;
+    thread->Entry = entry;
+    thread->Arg = arg;
+    Timer_Setup(&thread->SleepTimer, Thread_SleepTimeout, thread);
+    i686_FPU_InitializeContext(&thread->Fpu);
+
+    int i;
+    for(i = 0; i < THREAD_NAME_SIZE - 1 && name[i]; i++)
+        thread->Name[i] = name[i];
+    thread->Name[i] = '\0';
+
+    if(entry != NULL)
+        thread->Stack = i686_Context_Initialize(g_Stacks[id] + THREAD_STACK_SIZE, Thread_Start, thread);
+
+    i686_irqrestore(flags);
+    return thread;
+}
+
+Thread* Thread_Create(const char* name, ThreadEntry entry, void* arg, uint8_t priority){
+    Thread* thread = Thread_Allocate(name, entry, arg, priority);
+    if(thread == NULL)
+        return NULL;
+
+    Scheduler_Wake(thread);
+    return thread;
+}
+
+void Thread_Exit(){
+    i686_cli();
+
+    Thread* thread = Scheduler_GetCurrent();
+    Timer_Cancel(&thread->SleepTimer);
+    i686_FPU_Release(&thread->Fpu);
+
+    // the slot is released by the next thread, once we are off this stack
+    thread->State = THREAD_STATE_EXITED;
+    Scheduler_Schedule();
+
+    // unreachable
+    for(;;);
+}
+
+void Thread_Sleep(uint64_t ns){
+    uint32_t flags = i686_irqsave();
+
+    Thread* thread = Scheduler_GetCurrent();
+    Timer_Add(&thread->SleepTimer, ns);
+    Scheduler_Block();
+
+    // woken up early by someone else
+    Timer_Cancel(&thread->SleepTimer);
+
+    i686_irqrestore(flags);
+}
+
+Thread* Thread_GetCurrent(){
+    return Scheduler_GetCurrent();
+}
+
+void Thread_GetStack(Thread* thread, uintptr_t* bottom, uintptr_t* top){
+    // before the scheduler starts, and in the adopted main thread, the code
+    // runs on the boot stack
+    if(thread == NULL || thread->Entry == NULL){
+        *top = g_BootStackTop;
+        *bottom = g_BootStackTop > THREAD_BOOT_STACK_SIZE ? g_BootStackTop - THREAD_BOOT_STACK_SIZE : 0;
+        return;
+    }
+
+    *bottom = (uintptr_t)g_Stacks[thread->Id];
+    *top = *bottom + THREAD_STACK_SIZE;
+}
+
+void Thread_SetBootStack(uintptr_t top){
+    g_BootStackTop = top;
+}
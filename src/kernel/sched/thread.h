@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <timer/timer.h>
+#include <arch/i686/fpu.h>
+
+#define THREAD_MAX                  32
+#define THREAD_STACK_SIZE           8192
+#define THREAD_NAME_SIZE            16
+
+// How far the loader's stack, which the adopted main thread keeps, is taken
+// to reach below the kernel entry: MULTIBOOT_STACK_SIZE in boot/header.asm.
+// stage2 leaves the kernel on its own stack below 0x10000.
+#define THREAD_BOOT_STACK_SIZE      0x4000
+
+// Lower value = higher priority
+#define THREAD_PRIORITY_COUNT       32
+#define THREAD_PRIORITY_HIGHEST     0
+#define THREAD_PRIORITY_DEFAULT     16
+#define THREAD_PRIORITY_LOWEST      (THREAD_PRIORITY_COUNT - 1)
+
+typedef enum{
+    THREAD_STATE_FREE,
+    THREAD_STATE_READY,
+    THREAD_STATE_RUNNING,
+    THREAD_STATE_BLOCKED,
+    THREAD_STATE_EXITED,
+} THREAD_STATE;
+
+typedef void (*ThreadEntry)(void* arg);
+
+typedef struct Thread Thread;
+
+struct Thread{
+    uint32_t*       Stack;          // saved stack pointer while switched out
+    Thread*         Next;           // run queue link
+    uint16_t        Id;
+    uint8_t         Priority;
+    uint8_t         State;
+    ThreadEntry     Entry;
+    void*           Arg;
+    Timer           SleepTimer;
+    char            Name[THREAD_NAME_SIZE];
+    FPUContext      Fpu;
+};
+
+Thread* Thread_Create(const char* name, ThreadEntry entry, void* arg, uint8_t priority);
+// Like Thread_Create, but the thread is not made runnable. A NULL entry adopts
+// the running context instead of building a new stack.
+Thread* Thread_Allocate(const char* name, ThreadEntry entry, void* arg, uint8_t priority);
+void __attribute__((noreturn)) Thread_Exit();
+void Thread_Sleep(uint64_t ns);
+Thread* Thread_GetCurrent();
+// The range [bottom, top) the thread's stack lives in, the boot stack for NULL
+void Thread_GetStack(Thread* thread, uintptr_t* bottom, uintptr_t* top);
+// Records where the kernel entry found the loader's stack, once the BSS is clear
+void Thread_SetBootStack(uintptr_t top);
@@ -0,0 +1,177 @@
+#include "workqueue.h"
+#include "scheduler.h"
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/smp/percpu.h>
+#include <arch/i686/io.h>
+#include <stddef.h>
+#include "stdio.h"
+
+static WorkQueue* g_SoftirqQueues[WORKQUEUE_MAX_SOFTIRQ];
+static uint32_t g_SoftirqCount = 0;
+static volatile uint32_t g_SoftirqPending = 0;
+static volatile bool g_InSoftirq = false;
+
+void Work_Setup(Work* work, WorkFunction function, void* context){
+    work->Next = NULL;
+    work->Function = function;
+    work->Context = context;
+    work->Pending = false;
+}
+
+bool WorkQueue_Queue(WorkQueue* queue, Work* work){
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+
+    if(work->Pending){
+        Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+        return false;
+    }
+
+    work->Pending = true;
+    work->Next = NULL;
+    if(queue->Tail != NULL)
+        queue->Tail->Next = work;
+    else
+        queue->Head = work;
+    queue->Tail = work;
+
+    queue->Stats.Queued++;
+    if(++queue->Depth > queue->Stats.MaxDepth)
+        queue->Stats.MaxDepth = queue->Depth;
+
+    if(queue->Type == WORKQUEUE_SOFTIRQ)
+        __atomic_fetch_or(&g_SoftirqPending, 1u << queue->SoftirqIndex, __ATOMIC_RELEASE);
+
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+
+    // softirq work runs at the next interrupt exit, or right away from
+    // thread context
+    if(queue->Type == WORKQUEUE_THREAD || !i686_ISR_InInterrupt())
+        Scheduler_Wake(queue->Worker);
+    return true;
+}
+
+// Runs up to BatchLimit items, interrupts enabled. Returns true if work is
+// left over.
+static bool WorkQueue_RunBatch(WorkQueue* queue){
+    for(uint32_t i = 0; i < queue->BatchLimit; i++){
+        uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+
+        Work* work = queue->Head;
+        if(work == NULL){
+            if(queue->Type == WORKQUEUE_SOFTIRQ)
+                __atomic_fetch_and(&g_SoftirqPending, ~(1u << queue->SoftirqIndex), __ATOMIC_RELAXED);
+            Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+            return false;
+        }
+
+        queue->Head = work->Next;
+        if(queue->Head == NULL)
+            queue->Tail = NULL;
+        queue->Depth--;
+
+        // cleared before running, so the work can queue itself again
+        work->Pending = false;
+        queue->Stats.Executed++;
+        Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+
+        work->Function(work, work->Context);
+    }
+
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+    bool left = queue->Head != NULL;
+    if(left)
+        queue->Stats.Throttled++;
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+    return left;
+}
+
+static void WorkQueue_Worker(void* arg){
+    WorkQueue* queue = (WorkQueue*)arg;
+
+    for(;;){
+        // sleep until WorkQueue_Queue wakes us, unless work came in meanwhile
+        uint32_t flags = i686_irqsave();
+        while(queue->Head == NULL)
+            Scheduler_Block();
+        i686_irqrestore(flags);
+
+        queue->Stats.WorkerBatches++;
+
+        // between batches let threads of the same priority run
+        if(WorkQueue_RunBatch(queue))
+            Scheduler_Yield();
+    }
+}
+
+// Interrupt exit hook, entered with interrupts disabled. Still counts as
+// interrupt context, so wakeups done by the work only switch threads once
+// the scheduler's own exit hook runs after us.
+static void WorkQueue_Softirq(){
+    if(g_SoftirqPending == 0 || g_InSoftirq || i686_PerCPU_GetId() != 0)
+        return;
+
+    PerCPU* cpu = i686_PerCPU_Get();
+    g_InSoftirq = true;
+    cpu->InterruptDepth++;
+    i686_sti();
+
+    uint32_t pending = g_SoftirqPending;
+    while(pending != 0){
+        WorkQueue* queue = g_SoftirqQueues[__builtin_ctz(pending)];
+        pending &= pending - 1;
+
+        queue->Stats.SoftirqBatches++;
+        if(WorkQueue_RunBatch(queue))
+            Scheduler_Wake(queue->Worker);
+    }
+
+    i686_cli();
+    cpu->InterruptDepth--;
+    g_InSoftirq = false;
+}
+
+void WorkQueue_Initialize(){
+    i686_ISR_RegisterExitHandler(WorkQueue_Softirq);
+}
+
+bool WorkQueue_Setup(WorkQueue* queue, const char* name, WORKQUEUE_TYPE type, uint32_t batchLimit, uint8_t priority){
+    queue->Name = name;
+    queue->Type = type;
+    queue->BatchLimit = batchLimit > 0 ? batchLimit : WORKQUEUE_DEFAULT_BATCH;
+    queue->Head = NULL;
+    queue->Tail = NULL;
+    queue->Depth = 0;
+    Spinlock_Initialize(&queue->Lock, name);
+
+    WorkQueueStats empty = {0};
+    queue->Stats = empty;
+
+    if(type == WORKQUEUE_SOFTIRQ){
+        if(g_SoftirqCount == WORKQUEUE_MAX_SOFTIRQ){
+            printf("[WORK] Run out of softirq queues!\r\n");
+            return false;
+        }
+        queue->SoftirqIndex = g_SoftirqCount;
+        g_SoftirqQueues[g_SoftirqCount++] = queue;
+    }
+
+    queue->Worker = Thread_Create(name, WorkQueue_Worker, queue, priority);
+    return queue->Worker != NULL;
+}
+
+void WorkQueue_GetStats(WorkQueue* queue, WorkQueueStats* stats){
+    uint32_t flags = Spinlock_AcquireIrqSave(&queue->Lock);
+    *stats = queue->Stats;
+    Spinlock_ReleaseIrqRestore(&queue->Lock, flags);
+}
+
+void WorkQueue_PrintStats(WorkQueue* queue){
+    WorkQueueStats stats;
+    WorkQueue_GetStats(queue, &stats);
+
+    printf("===== WORK %s =====\r\n", queue->Name);
+    printf("queued=%llu executed=%llu maxdepth=%u\r\n", stats.Queued, stats.Executed, stats.MaxDepth);
+    printf("softirq batches=%llu worker batches=%llu throttled=%llu\r\n",
+           stats.SoftirqBatches, stats.WorkerBatches, stats.Throttled);
+    printf("===================\r\n");
+}
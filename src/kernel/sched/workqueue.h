@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <util/spinlock.h>
+#include "thread.h"
+
+#define WORKQUEUE_MAX_SOFTIRQ       8
+#define WORKQUEUE_DEFAULT_BATCH     16
+
+typedef enum{
+    // drained at interrupt exit with interrupts enabled, the worker thread
+    // only takes over what is left when the batch limit is hit
+    WORKQUEUE_SOFTIRQ,
+    // only ever run by the queue's worker thread
+    WORKQUEUE_THREAD,
+} WORKQUEUE_TYPE;
+
+typedef struct Work Work;
+typedef void (*WorkFunction)(Work* work, void* context);
+
+struct Work{
+    Work*               Next;
+    WorkFunction        Function;
+    void*               Context;
+    volatile bool       Pending;
+};
+
+typedef struct{
+    uint64_t Queued;
+    uint64_t Executed;
+    uint64_t SoftirqBatches;        // drains at interrupt exit
+    uint64_t WorkerBatches;         // drains by the worker thread
+    uint64_t Throttled;             // batches cut short by the limit
+    uint32_t MaxDepth;
+} WorkQueueStats;
+
+typedef struct{
+    const char*         Name;
+    WORKQUEUE_TYPE      Type;
+    uint32_t            BatchLimit;
+    uint32_t            SoftirqIndex;
+    Spinlock            Lock;
+    Work*               Head;
+    Work*               Tail;
+    uint32_t            Depth;
+    Thread*             Worker;
+    WorkQueueStats      Stats;
+} WorkQueue;
+
+// Hooks the softirq drain into interrupt exit. Must run before
+// Scheduler_Initialize, so pending work runs before a preemption.
+void WorkQueue_Initialize();
+
+// Creates the worker thread, the scheduler must be running
+bool WorkQueue_Setup(WorkQueue* queue, const char* name, WORKQUEUE_TYPE type, uint32_t batchLimit, uint8_t priority);
+void Work_Setup(Work* work, WorkFunction function, void* context);
+
+// O(1), callable from interrupt handlers. Returns false if the work was
+// already pending; it will then only run once.
+bool WorkQueue_Queue(WorkQueue* queue, Work* work);
+
+void WorkQueue_GetStats(WorkQueue* queue, WorkQueueStats* stats);
+void WorkQueue_PrintStats(WorkQueue* queue);
@@ -0,0 +1,62 @@
+#include "clock.h"
+#include <arch/i686/io.h>
+#include <arch/i686/timer/i8254.h>
+#include <arch/generic/cpu.h>
+#include "stdio.h"
+
+#define CLOCK_CALIBRATION_MS        10
+#define CLOCK_CALIBRATION_RUNS      3
+
+static uint32_t g_TscKhz;
+static uint64_t g_TscBase;
+
+// Counts TSC cycles over a fixed PIT interval; the shortest of a few runs wins
+// because anything that interrupts the measurement only makes it longer.
+static uint64_t Clock_CalibrateTsc(){
+    uint64_t best = ~0ULL;
+
+    for(int i = 0; i < CLOCK_CALIBRATION_RUNS; i++){
+        uint64_t start = i686_rdtsc();
+        i8254_PollDelay(PIT_FREQUENCY / 1000 * CLOCK_CALIBRATION_MS);
+        uint64_t cycles = i686_rdtsc() - start;
+
+        if(cycles < best)
+            best = cycles;
+    }
+
+    return best / CLOCK_CALIBRATION_MS;
+}
+
+void Clock_Initialize(){
+    unsigned int eax, ebx, ecx, edx;
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    if(!(edx & CPUID_FEAT_EDX_TSC)){
+        printf("[CLOCK] No TSC, time keeping is unavailable!\r\n");
+        return;
+    }
+
+    g_TscKhz = Clock_CalibrateTsc();
+    g_TscBase = i686_rdtsc();
+
+    printf("[CLOCK] TSC running at %u kHz\r\n", g_TscKhz);
+}
+
+uint32_t Clock_GetTscKhz(){
+    return g_TscKhz;
+}
+
+uint64_t Clock_CyclesToNs(uint64_t cycles){
+    if(g_TscKhz == 0)
+        return 0;
+
+    // split to keep the intermediate product within 64 bits
+    return (cycles / g_TscKhz) * NS_PER_MS + (cycles % g_TscKhz) * NS_PER_MS / g_TscKhz;
+}
+
+uint64_t Clock_NsToCycles(uint64_t ns){
+    return (ns / NS_PER_MS) * g_TscKhz + (ns % NS_PER_MS) * g_TscKhz / NS_PER_MS;
+}
+
+uint64_t Clock_NowNs(){
+    return Clock_CyclesToNs(i686_rdtsc() - g_TscBase);
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+
+#define NS_PER_US                   1000ULL
+#define NS_PER_MS                   1000000ULL
+#define NS_PER_SEC                  1000000000ULL
+
+void Clock_Initialize();
+uint64_t Clock_NowNs();
+uint32_t Clock_GetTscKhz();
+uint64_t Clock_CyclesToNs(uint64_t cycles);
+uint64_t Clock_NsToCycles(uint64_t ns);
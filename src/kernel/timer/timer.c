@@ -0,0 +1,322 @@
+#include "timer.h"
+#include <arch/i686/timer/clockevent.h>
+#include <arch/i686/timer/lapic_timer.h>
+#include <arch/i686/timer/i8254.h>
+#include <arch/i686/io.h>
+#include <util/arrays.h>
+#include <stddef.h>
+#include "stdio.h"
+
+// Hierarchical timing wheel: level N has 64 slots of 64^N ticks each.
+// A timer is placed by how far away it is, so insertion and removal are O(1);
+// when level 0 wraps, the matching slot of the next level is cascaded down.
+#define TIMER_WHEEL_BITS            6
+#define TIMER_WHEEL_SLOTS           (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK            (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS          5
+#define TIMER_WHEEL_MAX_DELTA       ((1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+#define TIMER_LEVEL_DETACHED        0xFF
+#define TIMER_NONE                  (~0ULL)
+#define TIMER_MIN_DELTA_NS          (10 * NS_PER_US)
+
+typedef struct{
+    Timer*   Slots[TIMER_WHEEL_SLOTS];
+    uint64_t Pending;               // bit N set <=> Slots[N] is not empty
+} TimerWheelLevel;
+
+typedef struct{
+    TimerWheelLevel Levels[TIMER_WHEEL_LEVELS];
+    uint64_t        Current;        // next tick to be processed
+    uint64_t        ArmedTick;      // tick the hardware fires at, or TIMER_NONE
+    bool            Running;        // expired callbacks are being run
+    Registers*      Interrupted;    // what the interrupt preempted, while Running
+} TimerWheel;
+
+static TimerWheel g_Wheel;
+static TimerStats g_Stats;
+static const ClockEventDriver* g_Driver = NULL;
+
+static void Timer_Link(Timer** head, Timer* timer){
+    timer->Next = *head;
+    if(timer->Next != NULL)
+        timer->Next->PPrev = &timer->Next;
+    timer->PPrev = head;
+    *head = timer;
+}
+
+static void Timer_Unlink(Timer* timer){
+    *timer->PPrev = timer->Next;
+    if(timer->Next != NULL)
+        timer->Next->PPrev = timer->PPrev;
+
+    if(timer->Level != TIMER_LEVEL_DETACHED){
+        TimerWheelLevel* level = &g_Wheel.Levels[timer->Level];
+        if(level->Slots[timer->Slot] == NULL)
+            level->Pending &= ~(1ULL << timer->Slot);
+    }
+
+    timer->Next = NULL;
+    timer->PPrev = NULL;
+}
+
+static void Timer_Enqueue(Timer* timer){
+    uint64_t expires = timer->Expires;
+
+    if(expires < g_Wheel.Current)
+        expires = g_Wheel.Current;
+    if(expires - g_Wheel.Current > TIMER_WHEEL_MAX_DELTA)
+        expires = g_Wheel.Current + TIMER_WHEEL_MAX_DELTA;
+
+    // the level is given by the highest bit that differs from the current tick
+    uint64_t delta = expires - g_Wheel.Current;
+    int level = (delta == 0) ? 0 : (63 - __builtin_clzll(delta)) / TIMER_WHEEL_BITS;
+
+    timer->Level = level;
+    timer->Slot = (expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+
+    Timer_Link(&g_Wheel.Levels[level].Slots[timer->Slot], timer);
+    g_Wheel.Levels[level].Pending |= 1ULL << timer->Slot;
+}
+
+static void Timer_Cascade(int level, uint32_t slot){
+    TimerWheelLevel* wheel = &g_Wheel.Levels[level];
+    Timer* list = wheel->Slots[slot];
+
+    wheel->Slots[slot] = NULL;
+    wheel->Pending &= ~(1ULL << slot);
+
+    while(list != NULL){
+        Timer* timer = list;
+        list = timer->Next;
+        Timer_Enqueue(timer);
+    }
+
+    g_Stats.Cascades++;
+}
+
+// Moves the wheel to 'tick', cascading upper levels whenever level 0 wraps
+static void Timer_Advance(uint64_t tick){
+    if(tick == g_Wheel.Current)
+        return;
+
+    g_Wheel.Current = tick;
+    if((tick & TIMER_WHEEL_MASK) != 0)
+        return;
+
+    for(int level = 1; level < TIMER_WHEEL_LEVELS; level++){
+        uint32_t slot = (tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+        if(g_Wheel.Levels[level].Pending & (1ULL << slot))
+            Timer_Cascade(level, slot);
+        if(slot != 0)
+            break;
+    }
+}
+
+static void Timer_RunSlot(uint32_t slot, uint64_t nowNs){
+    TimerWheelLevel* wheel = &g_Wheel.Levels[0];
+    Timer* expired = wheel->Slots[slot];
+
+    wheel->Slots[slot] = NULL;
+    wheel->Pending &= ~(1ULL << slot);
+
+    // keep the expired timers on a local list so callbacks can cancel them
+    expired->PPrev = &expired;
+    for(Timer* timer = expired; timer != NULL; timer = timer->Next)
+        timer->Level = TIMER_LEVEL_DETACHED;
+
+    uint64_t expiresNs = g_Wheel.Current * TIMER_TICK_NS;
+    Timer_Advance(g_Wheel.Current + 1);
+
+    while(expired != NULL){
+        Timer* timer = expired;
+        Timer_Unlink(timer);
+
+        uint64_t lateness = nowNs > expiresNs ? nowNs - expiresNs : 0;
+        g_Stats.TotalLatenessNs += lateness;
+        if(lateness > g_Stats.MaxLatenessNs)
+            g_Stats.MaxLatenessNs = lateness;
+        g_Stats.Expired++;
+
+        timer->Callback(timer, timer->Context);
+    }
+}
+
+static void Timer_RunExpired(uint64_t nowNs){
+    uint64_t now = nowNs / TIMER_TICK_NS;
+
+    g_Wheel.Running = true;
+    while(g_Wheel.Current <= now){
+        uint32_t index = g_Wheel.Current & TIMER_WHEEL_MASK;
+        uint64_t due = g_Wheel.Levels[0].Pending >> index;
+
+        // jump straight to the next non-empty slot, or to the next wrap
+        uint64_t next = (due != 0) ? g_Wheel.Current + __builtin_ctzll(due)
+                                   : (g_Wheel.Current | TIMER_WHEEL_MASK) + 1;
+        if(next > now){
+            Timer_Advance(now + 1);
+            break;
+        }
+
+        Timer_Advance(next);
+        if(due != 0)
+            Timer_RunSlot(next & TIMER_WHEEL_MASK, nowNs);
+    }
+    g_Wheel.Running = false;
+}
+
+// Earliest tick at which something has to happen: a level 0 slot expiring or
+// an upper level slot being cascaded.
+static uint64_t Timer_NextTick(){
+    uint64_t best = TIMER_NONE;
+
+    for(int level = 0; level < TIMER_WHEEL_LEVELS; level++){
+        uint64_t pending = g_Wheel.Levels[level].Pending;
+        if(pending == 0)
+            continue;
+
+        int shift = TIMER_WHEEL_BITS * level;
+        uint32_t index = (g_Wheel.Current >> shift) & TIMER_WHEEL_MASK;
+
+        // rotate so that bit 0 is the current slot
+        uint64_t rotated = (pending >> index) | (index ? pending << (TIMER_WHEEL_SLOTS - index) : 0);
+        uint32_t ahead = __builtin_ctzll(rotated);
+
+        uint64_t tick;
+        if(level == 0){
+            tick = g_Wheel.Current + ahead;
+        } else {
+            // the current slot of an upper level is only reached after a full round
+            if(ahead == 0)
+                ahead = TIMER_WHEEL_SLOTS;
+            tick = ((g_Wheel.Current >> shift) + ahead) << shift;
+        }
+
+        if(tick < best)
+            best = tick;
+    }
+
+    return best;
+}
+
+static void Timer_Reprogram(){
+    uint64_t next = Timer_NextTick();
+    if(next == TIMER_NONE){
+        // nothing pending: leave the hardware idle
+        g_Wheel.ArmedTick = TIMER_NONE;
+        return;
+    }
+
+    uint64_t now = Clock_NowNs();
+    uint64_t deadline = next * TIMER_TICK_NS;
+    uint64_t delta = deadline > now ? deadline - now : TIMER_MIN_DELTA_NS;
+    uint64_t maxDelta = g_Driver->MaxDeltaNs();
+
+    if(delta > maxDelta){
+        delta = maxDelta;
+        next = (now + delta) / TIMER_TICK_NS;
+    }
+
+    g_Wheel.ArmedTick = next;
+    g_Driver->SetNextEvent(delta);
+    g_Stats.Reprograms++;
+}
+
+static void Timer_Interrupt(Registers* regs){
+    g_Stats.Interrupts++;
+    g_Wheel.Interrupted = regs;
+    Timer_RunExpired(Clock_NowNs());
+    g_Wheel.Interrupted = NULL;
+    Timer_Reprogram();
+}
+
+void Timer_Initialize(){
+    const ClockEventDriver* drivers[] = {
+        i686_LAPICTimer_GetDriver(),
+        i8254_GetDriver(),
+    };
+
+    for(int i = 0; i < SIZE(drivers); i++){
+        if(drivers[i]->Probe()){
+            g_Driver = drivers[i];
+            break;
+        }
+    }
+
+    g_Wheel.Current = Clock_NowNs() / TIMER_TICK_NS;
+    g_Wheel.ArmedTick = TIMER_NONE;
+
+    printf("[TIMER] Using %s as clock event device\r\n", g_Driver->Name);
+    g_Driver->Initialize(Timer_Interrupt);
+}
+
+void Timer_Setup(Timer* timer, TimerCallback callback, void* context){
+    timer->Next = NULL;
+    timer->PPrev = NULL;
+    timer->Callback = callback;
+    timer->Context = context;
+}
+
+bool Timer_IsPending(Timer* timer){
+    return timer->PPrev != NULL;
+}
+
+Registers* Timer_GetInterrupted(){
+    return g_Wheel.Running ? g_Wheel.Interrupted : NULL;
+}
+
+bool Timer_Modify(Timer* timer, uint64_t delayNs){
+    uint32_t flags = i686_irqsave();
+
+    bool pending = Timer_IsPending(timer);
+    if(pending)
+        Timer_Unlink(timer);
+
+    timer->Expires = (Clock_NowNs() + delayNs + TIMER_TICK_NS - 1) / TIMER_TICK_NS;
+    Timer_Enqueue(timer);
+
+    // only an earlier expiry needs the hardware to be re-armed; from inside the
+    // interrupt it is re-armed anyway once all callbacks have run
+    if(!g_Wheel.Running && timer->Expires < g_Wheel.ArmedTick)
+        Timer_Reprogram();
+
+    i686_irqrestore(flags);
+    return pending;
+}
+
+void Timer_Add(Timer* timer, uint64_t delayNs){
+    Timer_Modify(timer, delayNs);
+}
+
+bool Timer_Cancel(Timer* timer){
+    uint32_t flags = i686_irqsave();
+
+    bool pending = Timer_IsPending(timer);
+    if(pending)
+        Timer_Unlink(timer);
+
+    i686_irqrestore(flags);
+    return pending;
+}
+
+void Timer_GetStats(TimerStats* stats){
+    uint32_t flags = i686_irqsave();
+    *stats = g_Stats;
+    i686_irqrestore(flags);
+}
+
+void Timer_PrintStats(){
+    TimerStats stats;
+    Timer_GetStats(&stats);
+
+    printf("===== TIMER STATS =====\r\n");
+    printf("interrupts=%llu\r\n", stats.Interrupts);
+    printf("expired=%llu\r\n", stats.Expired);
+    printf("cascades=%llu\r\n", stats.Cascades);
+    printf("reprograms=%llu\r\n", stats.Reprograms);
+    if(stats.Expired != 0)
+        printf("lateness avg=%lluus max=%lluus\r\n",
+               stats.TotalLatenessNs / stats.Expired / NS_PER_US,
+               stats.MaxLatenessNs / NS_PER_US);
+    printf("=======================\r\n");
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <arch/i686/interrupts/isr.h>
+
+#include "clock.h"
+
+// Resolution of the timer wheel. Expiry times are rounded up to a whole tick.
+#define TIMER_TICK_NS               NS_PER_MS
+
+typedef struct Timer Timer;
+typedef void (*TimerCallback)(Timer* timer, void* context);
+
+struct Timer{
+    Timer*          Next;
+    Timer**         PPrev;          // NULL while the timer is not pending
+    uint64_t        Expires;        // in ticks
+    uint8_t         Level;
+    uint8_t         Slot;
+    TimerCallback   Callback;
+    void*           Context;
+};
+
+typedef struct{
+    uint64_t Interrupts;            // hardware timer interrupts taken
+    uint64_t Expired;               // callbacks run
+    uint64_t Cascades;              // upper level slots redistributed
+    uint64_t Reprograms;            // times the hardware timer was armed
+    uint64_t TotalLatenessNs;       // sum of (callback time - expiry time)
+    uint64_t MaxLatenessNs;
+} TimerStats;
+
+void Timer_Initialize();
+void Timer_Setup(Timer* timer, TimerCallback callback, void* context);
+
+// Arms a timer 'delayNs' from now. Callbacks run from the timer interrupt.
+void Timer_Add(Timer* timer, uint64_t delayNs);
+// Re-arms a timer, pending or not. Returns whether it was pending.
+bool Timer_Modify(Timer* timer, uint64_t delayNs);
+// Returns whether the timer was pending.
+bool Timer_Cancel(Timer* timer);
+bool Timer_IsPending(Timer* timer);
+
+// The context the timer interrupt preempted, for callbacks that want to
+// look at it (the profiler); NULL when not called from a callback.
+Registers* Timer_GetInterrupted();
+
+void Timer_GetStats(TimerStats* stats);
+void Timer_PrintStats();
@@ -0,0 +1,135 @@
+#include "lockfree_bench.h"
+#include "spsc.h"
+#include "mpsc.h"
+#include "percpu_counter.h"
+#include <arch/i686/smp/smp.h>
+#include <arch/i686/io.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define BENCH_ITEMS                 200000
+#define BENCH_RING_CAPACITY         1024
+
+static SPSCRing g_Ring;
+static uint32_t g_RingBuffer[BENCH_RING_CAPACITY];
+
+static MPSCQueue g_Queue;
+static MPSCCell g_QueueCells[BENCH_RING_CAPACITY];
+
+static PerCPUCounter g_Counter;
+
+static void Bench_Print(const char* name, uint64_t items, uint64_t cycles, bool ok){
+    uint64_t ns = Clock_CyclesToNs(cycles);
+    printf("[BENCH] %s: %s, %llu items in %lluus, %lluns/item, %llu items/s\r\n",
+           name, ok ? "PASS" : "FAIL", items, ns / NS_PER_US,
+           ns / items, ns ? items * NS_PER_SEC / ns : 0);
+}
+
+// SPSC: CPU 1 produces, we consume and check the order
+static void Bench_SPSCProducer(void* arg){
+    for(uint32_t i = 0; i < BENCH_ITEMS; i++){
+        while(!SPSCRing_Push(&g_Ring, &i))
+            i686_pause();
+    }
+}
+
+static void Bench_SPSC(){
+    SPSCRing_Initialize(&g_Ring, g_RingBuffer, sizeof(uint32_t), BENCH_RING_CAPACITY);
+
+    uint64_t start = i686_rdtsc();
+    if(!i686_SMP_Call(1, Bench_SPSCProducer, NULL)){
+        printf("[BENCH] spsc ring: SKIP, CPU 1 did not take the producer\r\n");
+        return;
+    }
+
+    bool ok = true;
+    for(uint32_t expected = 0; expected < BENCH_ITEMS; expected++){
+        uint32_t value;
+        while(!SPSCRing_Pop(&g_Ring, &value))
+            i686_pause();
+        ok = ok && value == expected;
+    }
+
+    Bench_Print("spsc ring", BENCH_ITEMS, i686_rdtsc() - start, ok);
+    i686_SMP_Wait(1);
+}
+
+// MPSC: every other CPU that takes the work produces, we consume and check
+// the total
+static void Bench_MPSCProducer(void* arg){
+    for(uint32_t i = 1; i <= BENCH_ITEMS; i++){
+        while(!MPSCQueue_Push(&g_Queue, (void*)i))
+            i686_pause();
+    }
+}
+
+static void Bench_MPSC(){
+    bool called[CPU_MAX] = { false };
+    uint32_t producers = 0;
+    MPSCQueue_Initialize(&g_Queue, g_QueueCells, BENCH_RING_CAPACITY);
+
+    uint64_t start = i686_rdtsc();
+    for(uint32_t cpu = 1; cpu < i686_SMP_GetCPUCount(); cpu++){
+        called[cpu] = i686_SMP_Call(cpu, Bench_MPSCProducer, NULL);
+        if(called[cpu]) producers++;
+    }
+    if(producers == 0){
+        printf("[BENCH] mpsc queue: SKIP, no CPU took a producer\r\n");
+        return;
+    }
+
+    uint64_t sum = 0;
+    uint64_t items = (uint64_t)BENCH_ITEMS * producers;
+    for(uint64_t i = 0; i < items; i++){
+        void* value;
+        while(!MPSCQueue_Pop(&g_Queue, &value))
+            i686_pause();
+        sum += (uint32_t)value;
+    }
+    uint64_t cycles = i686_rdtsc() - start;
+
+    for(uint32_t cpu = 1; cpu < CPU_MAX; cpu++){
+        if(called[cpu]) i686_SMP_Wait(cpu);
+    }
+
+    uint64_t expected = (uint64_t)BENCH_ITEMS * (BENCH_ITEMS + 1) / 2 * producers;
+    Bench_Print("mpsc queue", items, cycles, sum == expected);
+}
+
+// Counter: every CPU that takes the work increments, the result must be exact once all stopped
+static void Bench_CounterWorker(void* arg){
+    for(uint32_t i = 0; i < BENCH_ITEMS; i++)
+        PerCPUCounter_Add(&g_Counter, 1);
+}
+
+static void Bench_Counter(){
+    bool called[CPU_MAX] = { false };
+    uint32_t cpus = 1;
+    PerCPUCounter_Initialize(&g_Counter, "bench-counter");
+
+    uint64_t start = i686_rdtsc();
+    for(uint32_t cpu = 1; cpu < i686_SMP_GetCPUCount(); cpu++){
+        called[cpu] = i686_SMP_Call(cpu, Bench_CounterWorker, NULL);
+        if(called[cpu]) cpus++;
+    }
+    Bench_CounterWorker(NULL);
+    for(uint32_t cpu = 1; cpu < CPU_MAX; cpu++){
+        if(called[cpu]) i686_SMP_Wait(cpu);
+    }
+    uint64_t cycles = i686_rdtsc() - start;
+
+    uint64_t items = (uint64_t)BENCH_ITEMS * cpus;
+    Bench_Print("percpu counter", items, cycles, PerCPUCounter_Read(&g_Counter) == (int64_t)items);
+}
+
+void LockFree_RunBenchmarks(){
+    if(i686_SMP_GetCPUCount() < 2){
+        printf("[BENCH] lock-free benchmarks need at least 2 CPUs\r\n");
+        return;
+    }
+
+    Bench_SPSC();
+    Bench_MPSC();
+    Bench_Counter();
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Throughput of the SPSC ring, the MPSC queue and the per-CPU counters,
+// with the other CPUs as producers. Needs i686_SMP_Initialize to have run.
+void LockFree_RunBenchmarks();
@@ -0,0 +1,89 @@
+#include "lockstat.h"
+
+#if CONFIG_LOCKSTAT
+
+#include <arch/i686/io.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+static LockClass g_Classes[LOCKSTAT_MAX_CLASSES];
+static uint32_t g_ClassCount = 0;
+static volatile uint32_t g_ClassesLocked = 0;
+
+static bool LockStat_SameName(const char* a, const char* b){
+    while(*a && *a == *b){
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+LockClass* LockStat_GetClass(const char* name){
+    // cannot use a Spinlock here, it would need a class itself
+    uint32_t flags = i686_irqsave();
+    while(__atomic_exchange_n(&g_ClassesLocked, 1, __ATOMIC_ACQUIRE))
+        i686_pause();
+
+    LockClass* lockClass = NULL;
+    for(uint32_t i = 0; i < g_ClassCount && lockClass == NULL; i++){
+        if(LockStat_SameName(g_Classes[i].Name, name))
+            lockClass = &g_Classes[i];
+    }
+
+    if(lockClass == NULL && g_ClassCount < LOCKSTAT_MAX_CLASSES){
+        lockClass = &g_Classes[g_ClassCount++];
+        lockClass->Name = name;
+    }
+
+    __atomic_store_n(&g_ClassesLocked, 0, __ATOMIC_RELEASE);
+    i686_irqrestore(flags);
+
+    if(lockClass == NULL)
+        printf("[LOCKSTAT] Run out of lock classes, %s is not tracked\r\n", name);
+    return lockClass;
+}
+
+void LockStat_Acquired(LockClass* lockClass){
+    if(lockClass != NULL)
+        lockClass->Stats[i686_PerCPU_GetId()].Acquisitions++;
+}
+
+void LockStat_Contended(LockClass* lockClass, uint64_t waitCycles){
+    if(lockClass == NULL)
+        return;
+
+    LockStats* stats = &lockClass->Stats[i686_PerCPU_GetId()];
+    stats->Acquisitions++;
+    stats->Contended++;
+    stats->WaitCycles += waitCycles;
+}
+
+// The sum is not a snapshot, other CPUs may be counting meanwhile
+void LockStat_GetStats(LockClass* lockClass, LockStats* stats){
+    stats->Acquisitions = 0;
+    stats->Contended = 0;
+    stats->WaitCycles = 0;
+
+    for(int cpu = 0; cpu < CPU_MAX; cpu++){
+        stats->Acquisitions += lockClass->Stats[cpu].Acquisitions;
+        stats->Contended += lockClass->Stats[cpu].Contended;
+        stats->WaitCycles += lockClass->Stats[cpu].WaitCycles;
+    }
+}
+
+void LockStat_PrintStats(){
+    printf("===== LOCK STATS =====\r\n");
+    for(uint32_t i = 0; i < g_ClassCount; i++){
+        LockStats stats;
+        LockStat_GetStats(&g_Classes[i], &stats);
+
+        printf("%s: acquisitions=%llu contended=%llu wait=%lluus avgwait=%lluns\r\n",
+               g_Classes[i].Name, stats.Acquisitions, stats.Contended,
+               Clock_CyclesToNs(stats.WaitCycles) / NS_PER_US,
+               stats.Contended ? Clock_CyclesToNs(stats.WaitCycles / stats.Contended) : 0);
+    }
+    printf("======================\r\n");
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch/i686/smp/percpu.h>
+#include "config.h"
+
+#define LOCKSTAT_MAX_CLASSES        64
+
+typedef struct{
+    uint64_t Acquisitions;
+    uint64_t Contended;             // acquisitions that had to wait
+    uint64_t WaitCycles;
+} LockStats;
+
+// All locks initialized with the same name share one class. The counters
+// are kept per CPU so recording them needs no atomic operations.
+typedef struct{
+    const char* Name;
+    LockStats   Stats[CPU_MAX];
+} LockClass;
+
+#if CONFIG_LOCKSTAT
+
+LockClass* LockStat_GetClass(const char* name);
+void LockStat_Acquired(LockClass* lockClass);
+void LockStat_Contended(LockClass* lockClass, uint64_t waitCycles);
+void LockStat_GetStats(LockClass* lockClass, LockStats* stats);
+void LockStat_PrintStats();
+
+#endif
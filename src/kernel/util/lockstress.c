@@ -0,0 +1,143 @@
+#include "lockstress.h"
+#include "spinlock.h"
+#include <arch/i686/smp/smp.h>
+#include <arch/i686/io.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define STRESS_ROUNDS               100000
+#define STRESS_WRITE_EVERY          8           // rwlock: one write every N reads
+
+typedef enum{
+    STRESS_SPINLOCK,
+    STRESS_TICKETLOCK,
+    STRESS_RWLOCK,
+} STRESS_LOCK;
+
+static const char* const g_LockNames[] = {
+    "spinlock",
+    "ticketlock",
+    "rwlock",
+};
+
+static Spinlock g_Spinlock;
+static TicketLock g_TicketLock;
+static RWLock g_RWLock;
+
+static STRESS_LOCK g_Type;
+static volatile uint32_t g_Started;
+static volatile bool g_Go;
+static volatile uint32_t g_Errors;
+
+// Updated non atomically under the lock, a lost update shows up in the sum.
+// The rwlock readers check that they never see the two halves differ.
+static volatile uint32_t g_Counter;
+static volatile uint32_t g_Shadow;
+
+static void Stress_Increment(){
+    uint32_t value = g_Counter;
+    g_Counter = value + 1;
+    g_Shadow = value + 1;
+}
+
+static void Stress_Worker(void* arg){
+    uint32_t writes = 0;
+
+    // wait for everyone, so the CPUs really run at the same time
+    __atomic_fetch_add(&g_Started, 1, __ATOMIC_RELAXED);
+    while(!g_Go)
+        i686_pause();
+
+    for(uint32_t i = 0; i < STRESS_ROUNDS; i++){
+        uint32_t flags;
+
+        switch(g_Type){
+        case STRESS_SPINLOCK:
+            flags = Spinlock_AcquireIrqSave(&g_Spinlock);
+            Stress_Increment();
+            Spinlock_ReleaseIrqRestore(&g_Spinlock, flags);
+            break;
+
+        case STRESS_TICKETLOCK:
+            flags = TicketLock_AcquireIrqSave(&g_TicketLock);
+            Stress_Increment();
+            TicketLock_ReleaseIrqRestore(&g_TicketLock, flags);
+            break;
+
+        case STRESS_RWLOCK:
+            if(i % STRESS_WRITE_EVERY == 0){
+                flags = RWLock_AcquireWriteIrqSave(&g_RWLock);
+                Stress_Increment();
+                RWLock_ReleaseWriteIrqRestore(&g_RWLock, flags);
+                writes++;
+            } else {
+                flags = RWLock_AcquireReadIrqSave(&g_RWLock);
+                if(g_Counter != g_Shadow)
+                    __atomic_fetch_add(&g_Errors, 1, __ATOMIC_RELAXED);
+                RWLock_ReleaseReadIrqRestore(&g_RWLock, flags);
+            }
+            break;
+        }
+    }
+}
+
+static void Stress_Run(STRESS_LOCK type){
+    bool called[CPU_MAX] = { false };
+    uint32_t workers = 0;
+
+    g_Type = type;
+    g_Counter = 0;
+    g_Shadow = 0;
+    g_Errors = 0;
+    g_Started = 0;
+    g_Go = false;
+
+    // a CPU that cannot take the work is left out rather than waited for
+    for(uint32_t cpu = 1; cpu < i686_SMP_GetCPUCount(); cpu++){
+        called[cpu] = i686_SMP_Call(cpu, Stress_Worker, NULL);
+        if(called[cpu])
+            workers++;
+    }
+
+    // the BSP takes part as well
+    uint32_t cpus = workers + 1;
+    while(g_Started != workers)
+        i686_pause();
+
+    uint64_t start = i686_rdtsc();
+    g_Go = true;
+    __atomic_fetch_add(&g_Started, 1, __ATOMIC_RELAXED);
+    Stress_Worker(NULL);
+
+    for(uint32_t cpu = 1; cpu < CPU_MAX; cpu++){
+        if(called[cpu])
+            i686_SMP_Wait(cpu);
+    }
+    uint64_t ns = Clock_CyclesToNs(i686_rdtsc() - start);
+
+    uint32_t rounds = type == STRESS_RWLOCK
+        ? (STRESS_ROUNDS + STRESS_WRITE_EVERY - 1) / STRESS_WRITE_EVERY
+        : STRESS_ROUNDS;
+    uint32_t expected = rounds * cpus;
+    uint64_t operations = (uint64_t)STRESS_ROUNDS * cpus;
+
+    printf("[LOCK] %s on %u CPUs: %s (counter=%u expected=%u torn reads=%u), %lluns/op\r\n",
+           g_LockNames[type], cpus,
+           g_Counter == expected && g_Errors == 0 ? "PASS" : "FAIL",
+           g_Counter, expected, g_Errors, ns / operations);
+}
+
+void Lock_RunStressTest(){
+    Spinlock_Initialize(&g_Spinlock, "stress-spinlock");
+    TicketLock_Initialize(&g_TicketLock, "stress-ticketlock");
+    RWLock_Initialize(&g_RWLock, "stress-rwlock");
+
+    Stress_Run(STRESS_SPINLOCK);
+    Stress_Run(STRESS_TICKETLOCK);
+    Stress_Run(STRESS_RWLOCK);
+
+#if CONFIG_LOCKSTAT
+    LockStat_PrintStats();
+#endif
+}
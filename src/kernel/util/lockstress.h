@@ -0,0 +1,5 @@
+#pragma once
+
+// Hammers every lock type from all online CPUs and checks that no update
+// was lost. Needs i686_SMP_Initialize to have run.
+void Lock_RunStressTest();
@@ -0,0 +1,60 @@
+#include "mpsc.h"
+#include <stddef.h>
+
+bool MPSCQueue_Initialize(MPSCQueue* queue, MPSCCell* cells, uint32_t capacity){
+    if(capacity == 0 || (capacity & (capacity - 1)) != 0)
+        return false;
+
+    for(uint32_t i = 0; i < capacity; i++){
+        cells[i].Sequence = i;
+        cells[i].Value = NULL;
+    }
+
+    queue->Tail = 0;
+    queue->Head = 0;
+    queue->Cells = cells;
+    queue->Mask = capacity - 1;
+    return true;
+}
+
+bool MPSCQueue_Push(MPSCQueue* queue, void* value){
+    uint32_t position = __atomic_load_n(&queue->Tail, __ATOMIC_RELAXED);
+    MPSCCell* cell;
+
+    for(;;){
+        cell = &queue->Cells[position & queue->Mask];
+        int32_t difference = (int32_t)(__atomic_load_n(&cell->Sequence, __ATOMIC_ACQUIRE) - position);
+
+        if(difference == 0){
+            // on failure position is reloaded with the current tail
+            if(__atomic_compare_exchange_n(&queue->Tail, &position, position + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if(difference < 0){
+            // the consumer has not emptied this cell yet, queue full
+            return false;
+        } else {
+            position = __atomic_load_n(&queue->Tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->Value = value;
+    __atomic_store_n(&cell->Sequence, position + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Consumer only. A producer that claimed a cell but has not filled it yet
+// makes the queue look empty until it is done.
+bool MPSCQueue_Pop(MPSCQueue* queue, void** value){
+    uint32_t position = queue->Head;
+    MPSCCell* cell = &queue->Cells[position & queue->Mask];
+
+    if(__atomic_load_n(&cell->Sequence, __ATOMIC_ACQUIRE) != position + 1)
+        return false;
+
+    *value = cell->Value;
+    // hand the cell to the producers of the next lap
+    __atomic_store_n(&cell->Sequence, position + queue->Mask + 1, __ATOMIC_RELEASE);
+    queue->Head = position + 1;
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch/i686/smp/percpu.h>
+
+// Slot of an MPSCQueue. Sequence says whose turn it is: equal to the
+// position when free for a producer, position + 1 once filled.
+typedef struct{
+    volatile uint32_t   Sequence;
+    void*               Value;
+} MPSCCell;
+
+// Bounded queue of pointers with any number of producers (CPUs, interrupt
+// handlers) and a single consumer. Producers claim a position with one
+// compare-and-swap and never wait for each other.
+typedef struct{
+    volatile uint32_t   Tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t            Head __attribute__((aligned(CACHE_LINE_SIZE)));
+    MPSCCell*           Cells;
+    uint32_t            Mask;
+} MPSCQueue;
+
+// capacity must be a power of two
+bool MPSCQueue_Initialize(MPSCQueue* queue, MPSCCell* cells, uint32_t capacity);
+bool MPSCQueue_Push(MPSCQueue* queue, void* value);
+bool MPSCQueue_Pop(MPSCQueue* queue, void** value);
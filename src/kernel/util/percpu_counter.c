@@ -0,0 +1,40 @@
+#include "percpu_counter.h"
+#include <arch/i686/io.h>
+
+void PerCPUCounter_Initialize(PerCPUCounter* counter, const char* name){
+    for(int i = 0; i < CPU_MAX; i++)
+        counter->Slots[i].Value = 0;
+
+    Spinlock_Initialize(&counter->Lock, name);
+    counter->Total = 0;
+}
+
+void PerCPUCounter_Add(PerCPUCounter* counter, int32_t amount){
+    // keeps an interrupt on this CPU from splitting the read-modify-write
+    uint32_t flags = i686_irqsave();
+
+    PerCPUCounterSlot* slot = &counter->Slots[i686_PerCPU_GetId()];
+    int32_t value = slot->Value + amount;
+
+    if(value >= PERCPU_COUNTER_BATCH || value <= -PERCPU_COUNTER_BATCH){
+        Spinlock_Acquire(&counter->Lock);
+        counter->Total += value;
+        slot->Value = 0;
+        Spinlock_Release(&counter->Lock);
+    } else {
+        slot->Value = value;
+    }
+
+    i686_irqrestore(flags);
+}
+
+int64_t PerCPUCounter_Read(PerCPUCounter* counter){
+    uint32_t flags = Spinlock_AcquireIrqSave(&counter->Lock);
+
+    int64_t sum = counter->Total;
+    for(int i = 0; i < CPU_MAX; i++)
+        sum += counter->Slots[i].Value;
+
+    Spinlock_ReleaseIrqRestore(&counter->Lock, flags);
+    return sum;
+}
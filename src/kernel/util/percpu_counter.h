@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <arch/i686/smp/percpu.h>
+#include <util/spinlock.h>
+
+#define PERCPU_COUNTER_BATCH        1024
+
+typedef struct{
+    volatile int32_t Value;
+} __attribute__((aligned(CACHE_LINE_SIZE))) PerCPUCounterSlot;
+
+// Event counter that every CPU updates in its own cache line. Local counts
+// are folded into Total once they reach PERCPU_COUNTER_BATCH, so the lock is
+// taken once per batch instead of once per event. Reading sums everything
+// and may miss updates still in flight on other CPUs.
+typedef struct{
+    PerCPUCounterSlot   Slots[CPU_MAX];
+    Spinlock            Lock;
+    int64_t             Total;
+} PerCPUCounter;
+
+void PerCPUCounter_Initialize(PerCPUCounter* counter, const char* name);
+// Safe from interrupt handlers
+void PerCPUCounter_Add(PerCPUCounter* counter, int32_t amount);
+int64_t PerCPUCounter_Read(PerCPUCounter* counter);
@@ -0,0 +1,178 @@
+#include "profiler.h"
+
+#if CONFIG_PROFILER
+
+#include <arch/i686/io.h>
+#include <arch/i686/apic/lapic.h>
+#include <arch/i686/smp/smp.h>
+#include <sched/thread.h>
+#include <timer/timer.h>
+#include <stddef.h>
+#include "stdio.h"
+
+// A frame bigger than this is taken for garbage and ends the walk
+#define PROFILER_MAX_FRAME_SIZE     0x4000
+
+typedef struct{
+    ProfilerSample  Samples[CONFIG_PROFILER_SAMPLES];
+    uint32_t        Count;
+    uint64_t        Dropped;
+} ProfilerBuffer;
+
+extern uint8_t __entry_start;
+extern uint8_t __data_start;
+
+// Each CPU only ever writes its own buffer, from its own interrupt
+static ProfilerBuffer g_Buffers[CPU_MAX];
+static Timer g_Timer;
+static uint64_t g_PeriodNs;
+static bool g_CallStacks;
+static volatile bool g_Running = false;
+
+static bool Profiler_IsKernelText(uint32_t address){
+    return address >= (uint32_t)&__entry_start && address < (uint32_t)&__data_start;
+}
+
+// The stack the interrupted code ran on: an application processor only
+// runs work on its own stack, the bootstrap processor runs the threads
+static void Profiler_GetStack(uintptr_t* bottom, uintptr_t* top){
+    PerCPU* cpu = i686_PerCPU_Get();
+    if(cpu->Id != 0){
+        *top = (uintptr_t)cpu->StackTop;
+        *bottom = *top - CPU_STACK_SIZE;
+        return;
+    }
+
+    Thread_GetStack(Thread_GetCurrent(), bottom, top);
+}
+
+// Follows the saved frame pointers: [ebp] is the caller's ebp, [ebp + 4]
+// the return address into the caller. Needs -fno-omit-frame-pointer, and
+// stops at anything that does not look like a kernel frame or leaves the
+// interrupted stack, such as the loader's frames below the first kernel one.
+static uint32_t Profiler_WalkStack(uint32_t ebp, uint32_t* stack){
+    uintptr_t bottom, top;
+    Profiler_GetStack(&bottom, &top);
+
+    uint32_t depth = 0;
+    while(depth < PROFILER_MAX_DEPTH && (ebp & 3) == 0 && ebp >= bottom && ebp + 8 <= top){
+        const uint32_t* frame = (const uint32_t*)ebp;
+        if(!Profiler_IsKernelText(frame[1]))
+            break;
+
+        stack[depth++] = frame[1];
+
+        // the stack grows down, callers' frames are above
+        uint32_t next = frame[0];
+        if(next <= ebp || next - ebp > PROFILER_MAX_FRAME_SIZE)
+            break;
+        ebp = next;
+    }
+
+    return depth;
+}
+
+// Runs on the application processors, raised by Profiler_Tick
+static void Profiler_Interrupt(Registers* regs){
+    i686_LAPIC_SendEOI();
+    Profiler_Sample(regs);
+}
+
+// The timers all run on the bootstrap processor, which samples the others
+// by interrupting them before sampling itself
+static void Profiler_Tick(Timer* timer, void* context){
+    for(uint32_t cpu = 1; cpu < i686_SMP_GetCPUCount(); cpu++)
+        i686_SMP_SendInterrupt(cpu, LAPIC_VECTOR_PROFILE);
+
+    Registers* regs = Timer_GetInterrupted();
+    if(regs != NULL)
+        Profiler_Sample(regs);
+
+    if(g_Running)
+        Timer_Add(timer, g_PeriodNs);
+}
+
+void Profiler_Sample(Registers* regs){
+    if(!g_Running)
+        return;
+
+    ProfilerBuffer* buffer = &g_Buffers[i686_PerCPU_GetId()];
+    if(buffer->Count == CONFIG_PROFILER_SAMPLES){
+        buffer->Dropped++;
+        return;
+    }
+
+    ProfilerSample* sample = &buffer->Samples[buffer->Count];
+    sample->Eip = regs->eip;
+    sample->Depth = g_CallStacks ? Profiler_WalkStack(regs->ebp, sample->Stack) : 0;
+    buffer->Count++;
+}
+
+void Profiler_Start(uint32_t periodUs, bool callStacks){
+    Profiler_Stop();
+
+    for(int cpu = 0; cpu < CPU_MAX; cpu++){
+        g_Buffers[cpu].Count = 0;
+        g_Buffers[cpu].Dropped = 0;
+    }
+
+    g_PeriodNs = periodUs * NS_PER_US;
+    g_CallStacks = callStacks;
+    g_Running = true;
+
+    i686_ISR_RegisterHandler(LAPIC_VECTOR_PROFILE, Profiler_Interrupt);
+    Timer_Setup(&g_Timer, Profiler_Tick, NULL);
+    Timer_Add(&g_Timer, g_PeriodNs);
+}
+
+void Profiler_Stop(){
+    g_Running = false;
+    Timer_Cancel(&g_Timer);
+}
+
+bool Profiler_IsRunning(){
+    return g_Running;
+}
+
+// One line per sample: the CPU, the interrupted eip and the return
+// addresses, all in hex, innermost first
+void Profiler_Dump(){
+    Profiler_Stop();
+
+    printf("===== PROFILER SAMPLES =====\r\n");
+    printf("period=%lluus callstacks=%u\r\n", g_PeriodNs / NS_PER_US, g_CallStacks ? 1 : 0);
+    for(uint32_t cpu = 0; cpu < CPU_MAX; cpu++){
+        ProfilerBuffer* buffer = &g_Buffers[cpu];
+        for(uint32_t i = 0; i < buffer->Count; i++){
+            ProfilerSample* sample = &buffer->Samples[i];
+            printf("%u %x", cpu, sample->Eip);
+            for(uint32_t j = 0; j < sample->Depth; j++)
+                printf(" %x", sample->Stack[j]);
+            printf("\r\n");
+        }
+    }
+    printf("============================\r\n");
+}
+
+// Not a snapshot while running, the interrupts may be adding samples
+void Profiler_GetStats(ProfilerStats* stats){
+    stats->Samples = 0;
+    stats->Dropped = 0;
+
+    for(int cpu = 0; cpu < CPU_MAX; cpu++){
+        stats->Samples += g_Buffers[cpu].Count;
+        stats->Dropped += g_Buffers[cpu].Dropped;
+    }
+}
+
+void Profiler_PrintStats(){
+    ProfilerStats stats;
+    Profiler_GetStats(&stats);
+
+    printf("===== PROFILER STATS =====\r\n");
+    printf("running=%u period=%lluus\r\n", g_Running ? 1 : 0, g_PeriodNs / NS_PER_US);
+    printf("samples=%llu dropped=%llu\r\n", stats.Samples, stats.Dropped);
+    printf("==========================\r\n");
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch/i686/interrupts/isr.h>
+#include <arch/i686/smp/percpu.h>
+#include "config.h"
+
+#define PROFILER_MAX_DEPTH          8
+#define PROFILER_DEFAULT_PERIOD_US  1000
+
+// One profiler interrupt: where it hit and, when call stacks are on, the return
+// addresses found by following the saved frame pointers, innermost first
+typedef struct{
+    uint32_t Eip;
+    uint32_t Depth;
+    uint32_t Stack[PROFILER_MAX_DEPTH];
+} ProfilerSample;
+
+typedef struct{
+    uint64_t Samples;
+    uint64_t Dropped;               // taken while the CPU's buffer was full
+} ProfilerStats;
+
+#if CONFIG_PROFILER
+
+// Samples every online CPU every 'periodUs', rounded to the timer tick: the
+// bootstrap processor from its timer, the others from an IPI it sends them.
+// Starting again throws the previous samples away.
+void Profiler_Start(uint32_t periodUs, bool callStacks);
+void Profiler_Stop();
+bool Profiler_IsRunning();
+
+// Records one sample for the calling CPU, from an interrupt with the
+// interrupted context
+void Profiler_Sample(Registers* regs);
+
+// Prints the samples over debugcon for scripts/profile.py to symbolize
+void Profiler_Dump();
+void Profiler_GetStats(ProfilerStats* stats);
+void Profiler_PrintStats();
+
+#endif
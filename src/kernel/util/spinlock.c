@@ -0,0 +1,191 @@
+#include "spinlock.h"
+#include <arch/i686/io.h>
+#include <stddef.h>
+
+#define RWLOCK_WRITER               0x80000000u
+#define RWLOCK_WRITER_WAITING       0x40000000u
+#define RWLOCK_READERS              0x3FFFFFFFu
+
+// Lockstat only costs a counter increment on the uncontended path, the TSC
+// is read once we know we have to wait.
+#if CONFIG_LOCKSTAT
+#define LOCK_INITIALIZE(lock, name)     (lock)->Class = LockStat_GetClass(name)
+#define LOCK_WAIT_START()               uint64_t waitStart = i686_rdtsc()
+#define LOCK_ACQUIRED(lock)             LockStat_Acquired((lock)->Class)
+#define LOCK_CONTENDED(lock)            LockStat_Contended((lock)->Class, i686_rdtsc() - waitStart)
+#else
+#define LOCK_INITIALIZE(lock, name)
+#define LOCK_WAIT_START()
+#define LOCK_ACQUIRED(lock)
+#define LOCK_CONTENDED(lock)
+#endif
+
+//
+// Spinlock
+//
+
+void Spinlock_Initialize(Spinlock* lock, const char* name){
+    lock->Locked = 0;
+    LOCK_INITIALIZE(lock, name);
+}
+
+bool Spinlock_TryAcquire(Spinlock* lock){
+    return __atomic_exchange_n(&lock->Locked, 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+void Spinlock_Acquire(Spinlock* lock){
+    if(Spinlock_TryAcquire(lock)){
+        LOCK_ACQUIRED(lock);
+        return;
+    }
+
+    LOCK_WAIT_START();
+    do{
+        while(__atomic_load_n(&lock->Locked, __ATOMIC_RELAXED))
+            i686_pause();
+    } while(!Spinlock_TryAcquire(lock));
+    LOCK_CONTENDED(lock);
+}
+
+void Spinlock_Release(Spinlock* lock){
+    __atomic_store_n(&lock->Locked, 0, __ATOMIC_RELEASE);
+}
+
+uint32_t Spinlock_AcquireIrqSave(Spinlock* lock){
+    uint32_t flags = i686_irqsave();
+    Spinlock_Acquire(lock);
+    return flags;
+}
+
+void Spinlock_ReleaseIrqRestore(Spinlock* lock, uint32_t flags){
+    Spinlock_Release(lock);
+    i686_irqrestore(flags);
+}
+
+//
+// TicketLock
+//
+
+void TicketLock_Initialize(TicketLock* lock, const char* name){
+    lock->Owner = 0;
+    lock->Next = 0;
+    LOCK_INITIALIZE(lock, name);
+}
+
+void TicketLock_Acquire(TicketLock* lock){
+    uint16_t ticket = __atomic_fetch_add(&lock->Next, 1, __ATOMIC_RELAXED);
+
+    if(__atomic_load_n(&lock->Owner, __ATOMIC_ACQUIRE) == ticket){
+        LOCK_ACQUIRED(lock);
+        return;
+    }
+
+    LOCK_WAIT_START();
+    while(__atomic_load_n(&lock->Owner, __ATOMIC_ACQUIRE) != ticket)
+        i686_pause();
+    LOCK_CONTENDED(lock);
+}
+
+void TicketLock_Release(TicketLock* lock){
+    // only the holder writes Owner, no read-modify-write needed
+    __atomic_store_n(&lock->Owner, (uint16_t)(lock->Owner + 1), __ATOMIC_RELEASE);
+}
+
+uint32_t TicketLock_AcquireIrqSave(TicketLock* lock){
+    uint32_t flags = i686_irqsave();
+    TicketLock_Acquire(lock);
+    return flags;
+}
+
+void TicketLock_ReleaseIrqRestore(TicketLock* lock, uint32_t flags){
+    TicketLock_Release(lock);
+    i686_irqrestore(flags);
+}
+
+//
+// RWLock
+//
+
+void RWLock_Initialize(RWLock* lock, const char* name){
+    lock->State = 0;
+    LOCK_INITIALIZE(lock, name);
+}
+
+static bool RWLock_TryAcquireRead(RWLock* lock){
+    uint32_t state = __atomic_load_n(&lock->State, __ATOMIC_RELAXED);
+    if(state & (RWLOCK_WRITER | RWLOCK_WRITER_WAITING))
+        return false;
+
+    return __atomic_compare_exchange_n(&lock->State, &state, state + 1, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void RWLock_AcquireRead(RWLock* lock){
+    if(RWLock_TryAcquireRead(lock)){
+        LOCK_ACQUIRED(lock);
+        return;
+    }
+
+    LOCK_WAIT_START();
+    while(!RWLock_TryAcquireRead(lock))
+        i686_pause();
+    LOCK_CONTENDED(lock);
+}
+
+void RWLock_ReleaseRead(RWLock* lock){
+    __atomic_fetch_sub(&lock->State, 1, __ATOMIC_RELEASE);
+}
+
+// Takes the lock if nobody holds it, otherwise announces the writer so no
+// new reader gets in
+static bool RWLock_TryAcquireWrite(RWLock* lock){
+    uint32_t state = __atomic_load_n(&lock->State, __ATOMIC_RELAXED);
+
+    if((state & (RWLOCK_WRITER | RWLOCK_READERS)) == 0)
+        return __atomic_compare_exchange_n(&lock->State, &state, RWLOCK_WRITER, false,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+
+    if(!(state & RWLOCK_WRITER_WAITING))
+        __atomic_compare_exchange_n(&lock->State, &state, state | RWLOCK_WRITER_WAITING, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    return false;
+}
+
+void RWLock_AcquireWrite(RWLock* lock){
+    if(RWLock_TryAcquireWrite(lock)){
+        LOCK_ACQUIRED(lock);
+        return;
+    }
+
+    LOCK_WAIT_START();
+    while(!RWLock_TryAcquireWrite(lock))
+        i686_pause();
+    LOCK_CONTENDED(lock);
+}
+
+void RWLock_ReleaseWrite(RWLock* lock){
+    // also clears the waiting flag, writers still waiting set it again
+    __atomic_store_n(&lock->State, 0, __ATOMIC_RELEASE);
+}
+
+uint32_t RWLock_AcquireReadIrqSave(RWLock* lock){
+    uint32_t flags = i686_irqsave();
+    RWLock_AcquireRead(lock);
+    return flags;
+}
+
+void RWLock_ReleaseReadIrqRestore(RWLock* lock, uint32_t flags){
+    RWLock_ReleaseRead(lock);
+    i686_irqrestore(flags);
+}
+
+uint32_t RWLock_AcquireWriteIrqSave(RWLock* lock){
+    uint32_t flags = i686_irqsave();
+    RWLock_AcquireWrite(lock);
+    return flags;
+}
+
+void RWLock_ReleaseWriteIrqRestore(RWLock* lock, uint32_t flags){
+    RWLock_ReleaseWrite(lock);
+    i686_irqrestore(flags);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <util/lockstat.h>
+#include "config.h"
+
+// Test-and-test-and-set lock: waiters spin on a plain read, so the cache
+// line is only fought over when the lock looks free.
+typedef struct{
+    volatile uint32_t   Locked;
+#if CONFIG_LOCKSTAT
+    LockClass*          Class;
+#endif
+} Spinlock;
+
+// FIFO lock: every CPU takes a ticket and waits for its turn, so nobody
+// starves under contention.
+typedef struct{
+    volatile uint16_t   Owner;
+    volatile uint16_t   Next;
+#if CONFIG_LOCKSTAT
+    LockClass*          Class;
+#endif
+} TicketLock;
+
+// Many readers or one writer. A waiting writer blocks new readers.
+typedef struct{
+    volatile uint32_t   State;
+#if CONFIG_LOCKSTAT
+    LockClass*          Class;
+#endif
+} RWLock;
+
+// The name selects the lockstat class, it must outlive the lock
+void Spinlock_Initialize(Spinlock* lock, const char* name);
+void Spinlock_Acquire(Spinlock* lock);
+bool Spinlock_TryAcquire(Spinlock* lock);
+void Spinlock_Release(Spinlock* lock);
+// Also disable interrupts on this CPU, for locks taken by interrupt handlers
+uint32_t Spinlock_AcquireIrqSave(Spinlock* lock);
+void Spinlock_ReleaseIrqRestore(Spinlock* lock, uint32_t flags);
+
+void TicketLock_Initialize(TicketLock* lock, const char* name);
+void TicketLock_Acquire(TicketLock* lock);
+void TicketLock_Release(TicketLock* lock);
+uint32_t TicketLock_AcquireIrqSave(TicketLock* lock);
+void TicketLock_ReleaseIrqRestore(TicketLock* lock, uint32_t flags);
+
+void RWLock_Initialize(RWLock* lock, const char* name);
+void RWLock_AcquireRead(RWLock* lock);
+void RWLock_ReleaseRead(RWLock* lock);
+void RWLock_AcquireWrite(RWLock* lock);
+void RWLock_ReleaseWrite(RWLock* lock);
+uint32_t RWLock_AcquireReadIrqSave(RWLock* lock);
+void RWLock_ReleaseReadIrqRestore(RWLock* lock, uint32_t flags);
+uint32_t RWLock_AcquireWriteIrqSave(RWLock* lock);
+void RWLock_ReleaseWriteIrqRestore(RWLock* lock, uint32_t flags);
@@ -0,0 +1,52 @@
+#include "spsc.h"
+#include <stddef.h>
+#include "memory.h"
+
+bool SPSCRing_Initialize(SPSCRing* ring, void* buffer, uint32_t elementSize, uint32_t capacity){
+    if(capacity == 0 || (capacity & (capacity - 1)) != 0)
+        return false;
+
+    ring->Head = 0;
+    ring->CachedTail = 0;
+    ring->Tail = 0;
+    ring->CachedHead = 0;
+    ring->Buffer = (uint8_t*)buffer;
+    ring->Mask = capacity - 1;
+    ring->ElementSize = elementSize;
+    return true;
+}
+
+// Producer only
+bool SPSCRing_Push(SPSCRing* ring, const void* element){
+    uint32_t tail = __atomic_load_n(&ring->Tail, __ATOMIC_RELAXED);
+
+    if(tail - ring->CachedHead > ring->Mask){
+        ring->CachedHead = __atomic_load_n(&ring->Head, __ATOMIC_ACQUIRE);
+        if(tail - ring->CachedHead > ring->Mask)
+            return false;
+    }
+
+    memcpy(ring->Buffer + (tail & ring->Mask) * ring->ElementSize, element, ring->ElementSize);
+    __atomic_store_n(&ring->Tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Consumer only
+bool SPSCRing_Pop(SPSCRing* ring, void* element){
+    uint32_t head = __atomic_load_n(&ring->Head, __ATOMIC_RELAXED);
+
+    if(head == ring->CachedTail){
+        ring->CachedTail = __atomic_load_n(&ring->Tail, __ATOMIC_ACQUIRE);
+        if(head == ring->CachedTail)
+            return false;
+    }
+
+    memcpy(element, ring->Buffer + (head & ring->Mask) * ring->ElementSize, ring->ElementSize);
+    __atomic_store_n(&ring->Head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Only a hint when called while the other side is running
+uint32_t SPSCRing_Count(SPSCRing* ring){
+    return __atomic_load_n(&ring->Tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->Head, __ATOMIC_ACQUIRE);
+}
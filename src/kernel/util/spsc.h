@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch/i686/smp/percpu.h>
+
+// Single producer, single consumer ring of fixed size elements, e.g. from
+// an interrupt handler to a thread. Head and Tail are free running counters
+// on their own cache lines; each side also keeps a copy of the other side's
+// counter so it only touches the shared line when the ring looks full or
+// empty.
+typedef struct{
+    // consumer side
+    volatile uint32_t   Head __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t            CachedTail;
+
+    // producer side
+    volatile uint32_t   Tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t            CachedHead;
+
+    // read only after initialization
+    uint8_t*            Buffer __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t            Mask;
+    uint32_t            ElementSize;
+} SPSCRing;
+
+// buffer holds capacity * elementSize bytes; capacity must be a power of two
+bool SPSCRing_Initialize(SPSCRing* ring, void* buffer, uint32_t elementSize, uint32_t capacity);
+bool SPSCRing_Push(SPSCRing* ring, const void* element);
+bool SPSCRing_Pop(SPSCRing* ring, void* element);
+uint32_t SPSCRing_Count(SPSCRing* ring);
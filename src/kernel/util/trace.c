@@ -0,0 +1,119 @@
+#include "trace.h"
+
+#if CONFIG_TRACE
+
+#include <arch/i686/io.h>
+#include <timer/clock.h>
+#include <stddef.h>
+#include "stdio.h"
+
+#define TRACE_RING_MASK             (CONFIG_TRACE_RECORDS - 1)
+
+#if (CONFIG_TRACE_RECORDS & TRACE_RING_MASK) != 0
+#error CONFIG_TRACE_RECORDS must be a power of two
+#endif
+
+typedef struct{
+    TraceRecord         Records[CONFIG_TRACE_RECORDS];
+    volatile uint32_t   Head;           // records ever written, the next slot is Head % size
+} TraceRing;
+
+// How an event is shown: the Chrome trace phase ('B'/'E' nest on the CPU,
+// 'b'/'e' pair up by their first argument, across CPUs), a category and
+// the names of the arguments, NULL where unused
+typedef struct{
+    const char* Name;
+    char        Phase;
+    const char* Category;
+    const char* Arg0;
+    const char* Arg1;
+} TraceEventInfo;
+
+static const TraceEventInfo g_Events[TRACE_EVENT_COUNT] = {
+    [TRACE_IRQ_ENTRY]       = { "irq",          'B', "irq",   "irq",     NULL      },
+    [TRACE_IRQ_EXIT]        = { "irq",          'E', "irq",   NULL,      NULL      },
+    [TRACE_ISR_ENTRY]       = { "isr",          'B', "irq",   "vector",  NULL      },
+    [TRACE_ISR_EXIT]        = { "isr",          'E', "irq",   NULL,      NULL      },
+    [TRACE_BLOCK_SUBMIT]    = { "disk_request", 'b', "block", "request", "sectors" },
+    [TRACE_BLOCK_COMPLETE]  = { "disk_request", 'e', "block", "request", "success" },
+    [TRACE_FAT_READ_BEGIN]  = { "fat_read",     'b', "fs",    "cluster", "clusters" },
+    [TRACE_FAT_READ_END]    = { "fat_read",     'e', "fs",    "cluster", NULL      },
+};
+
+volatile bool g_TraceEnabled = false;
+static TraceRing g_Rings[CPU_MAX];
+
+void Trace_Record(TraceEvent event, uint32_t arg0, uint32_t arg1){
+    TraceRing* ring = &g_Rings[i686_PerCPU_GetId()];
+
+    // a locked add, so that an interrupt tracing in between, or another
+    // CPU after this thread migrated, gets a slot of its own
+    uint32_t slot = __atomic_fetch_add(&ring->Head, 1, __ATOMIC_RELAXED) & TRACE_RING_MASK;
+
+    TraceRecord* record = &ring->Records[slot];
+    record->Timestamp = i686_rdtsc();
+    record->Event = event;
+    record->Arg0 = arg0;
+    record->Arg1 = arg1;
+}
+
+void Trace_Start(){
+    g_TraceEnabled = false;
+    for(int cpu = 0; cpu < CPU_MAX; cpu++)
+        g_Rings[cpu].Head = 0;
+    g_TraceEnabled = true;
+}
+
+void Trace_Stop(){
+    g_TraceEnabled = false;
+}
+
+// One line per record: the CPU, the TSC in hex, the phase, category and
+// name of the event and its arguments as name=hex
+void Trace_Dump(){
+    Trace_Stop();
+
+    printf("===== TRACE RECORDS =====\r\n");
+    printf("tsc_khz=%u\r\n", Clock_GetTscKhz());
+    for(uint32_t cpu = 0; cpu < CPU_MAX; cpu++){
+        TraceRing* ring = &g_Rings[cpu];
+        uint32_t count = ring->Head < CONFIG_TRACE_RECORDS ? ring->Head : CONFIG_TRACE_RECORDS;
+
+        for(uint32_t i = ring->Head - count; i != ring->Head; i++){
+            TraceRecord* record = &ring->Records[i & TRACE_RING_MASK];
+            const TraceEventInfo* info = &g_Events[record->Event];
+
+            printf("%u %llx %c %s %s", cpu, record->Timestamp, info->Phase, info->Category, info->Name);
+            if(info->Arg0 != NULL)
+                printf(" %s=%x", info->Arg0, record->Arg0);
+            if(info->Arg1 != NULL)
+                printf(" %s=%x", info->Arg1, record->Arg1);
+            printf("\r\n");
+        }
+    }
+    printf("=========================\r\n");
+}
+
+void Trace_GetStats(TraceStats* stats){
+    stats->Recorded = 0;
+    stats->Overwritten = 0;
+
+    for(int cpu = 0; cpu < CPU_MAX; cpu++){
+        uint32_t head = g_Rings[cpu].Head;
+        stats->Recorded += head;
+        if(head > CONFIG_TRACE_RECORDS)
+            stats->Overwritten += head - CONFIG_TRACE_RECORDS;
+    }
+}
+
+void Trace_PrintStats(){
+    TraceStats stats;
+    Trace_GetStats(&stats);
+
+    printf("===== TRACE STATS =====\r\n");
+    printf("enabled=%u\r\n", g_TraceEnabled ? 1 : 0);
+    printf("recorded=%llu overwritten=%llu\r\n", stats.Recorded, stats.Overwritten);
+    printf("=======================\r\n");
+}
+
+#endif
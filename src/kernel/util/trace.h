@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch/i686/smp/percpu.h>
+#include "config.h"
+
+typedef enum{
+    TRACE_IRQ_ENTRY,                // irq
+    TRACE_IRQ_EXIT,
+    TRACE_ISR_ENTRY,                // vector
+    TRACE_ISR_EXIT,
+    TRACE_BLOCK_SUBMIT,             // request, sectors
+    TRACE_BLOCK_COMPLETE,           // request, success
+    TRACE_FAT_READ_BEGIN,           // first cluster, clusters
+    TRACE_FAT_READ_END,             // first cluster
+
+    TRACE_EVENT_COUNT
+} TraceEvent;
+
+// One tracepoint hit. The second argument is truncated to 16 bits.
+typedef struct{
+    uint64_t Timestamp;             // TSC of the CPU that recorded it
+    uint16_t Event;
+    uint16_t Arg1;
+    uint32_t Arg0;
+} TraceRecord;
+
+typedef struct{
+    uint64_t Recorded;
+    uint64_t Overwritten;           // lost to the rings wrapping around
+} TraceStats;
+
+#if CONFIG_TRACE
+
+extern volatile bool g_TraceEnabled;
+
+void Trace_Record(TraceEvent event, uint32_t arg0, uint32_t arg1);
+
+// With tracing off a tracepoint costs one load and a not taken branch
+#define TRACE(event, arg0, arg1)                                    \
+    do{                                                             \
+        if(__builtin_expect(g_TraceEnabled, 0))                     \
+            Trace_Record((event), (uint32_t)(arg0), (uint32_t)(arg1)); \
+    }while(0)
+
+// Starting again empties the rings
+void Trace_Start();
+void Trace_Stop();
+
+// Prints the rings over debugcon, oldest record first, for
+// scripts/trace2json.py to turn into a Chrome trace
+void Trace_Dump();
+void Trace_GetStats(TraceStats* stats);
+void Trace_PrintStats();
+
+#else
+
+#define TRACE(event, arg0, arg1)    do{ }while(0)
+
+#endif
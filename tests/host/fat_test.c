@@ -0,0 +1,373 @@
+#include <fs/fat/fat.h>
+#include <block/buffer_cache.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "image.h"
+
+// Tests of the FAT driver on an image fresh from mkfs.fat, formatted with
+// the flags of image/SConscript: writes files and directories, reads them
+// back through a second mount and checks the FATs and FSInfo on disk.
+// `scons test` runs it on a FAT12, 16 and 32 image and fsck.fat after it.
+
+#define TEST_SMALL_FILES            150     // grows even a 4 KiB cluster directory
+#define TEST_CHUNKS                 4
+
+static int g_Failures = 0;
+
+#define CHECK(condition)                                                    \
+    do{                                                                     \
+        if(!(condition)){                                                   \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);   \
+            g_Failures++;                                                   \
+        }                                                                   \
+    }while(0)
+
+// What the boot sector says, read independently of the driver
+typedef struct{
+    uint32_t Type;
+    uint32_t ClusterSize;
+    uint32_t ClusterCount;
+    uint32_t FatStart;
+    uint32_t FatCount;
+    uint32_t SectorsPerFat;
+    uint32_t FSInfoSector;
+} TestLayout;
+
+static FileSystem* g_Fs;
+static BlockDevice* g_Device;
+static TestLayout g_Layout;
+static uint8_t* g_Data;
+static uint8_t* g_ReadBack;
+
+static uint16_t Test_Get16(const uint8_t* bytes){
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static uint32_t Test_Get32(const uint8_t* bytes){
+    return Test_Get16(bytes) | ((uint32_t)Test_Get16(bytes + 2) << 16);
+}
+
+static bool Test_ReadLayout(TestLayout* layout){
+    uint8_t boot[BLOCK_SECTOR_SIZE];
+    if(!BufferCache_ReadSectors(g_Device, 0, 1, boot))
+        return false;
+
+    uint32_t sectorsPerCluster = boot[13];
+    uint32_t rootEntries = Test_Get16(boot + 17);
+    uint32_t totalSectors = Test_Get16(boot + 19) != 0 ? Test_Get16(boot + 19) : Test_Get32(boot + 32);
+    uint32_t sectorsPerFat16 = Test_Get16(boot + 22);
+
+    layout->ClusterSize = sectorsPerCluster * BLOCK_SECTOR_SIZE;
+    layout->FatStart = Test_Get16(boot + 14);
+    layout->FatCount = boot[16];
+    layout->SectorsPerFat = sectorsPerFat16 != 0 ? sectorsPerFat16 : Test_Get32(boot + 36);
+    layout->FSInfoSector = sectorsPerFat16 != 0 ? 0 : Test_Get16(boot + 48);
+
+    uint32_t dataStart = layout->FatStart + layout->FatCount * layout->SectorsPerFat +
+                         (rootEntries * 32 + BLOCK_SECTOR_SIZE - 1) / BLOCK_SECTOR_SIZE;
+    layout->ClusterCount = (totalSectors - dataStart) / sectorsPerCluster;
+    if(sectorsPerFat16 == 0)
+        layout->Type = 32;
+    else
+        layout->Type = layout->ClusterCount < 4085 ? 12 : 16;
+    return true;
+}
+
+// The bytes a file holds, different for every file
+static void Test_Fill(uint8_t* data, uint32_t seed, uint64_t offset, uint32_t count){
+    for(uint32_t i = 0; i < count; i++){
+        uint64_t position = offset + i;
+        data[i] = (uint8_t)(seed * 31 + position * 7 + (position >> 9));
+    }
+}
+
+//
+// Through the driver, as the VFS would call it
+//
+
+static Vnode* Test_Vnode(Vnode* dir){
+    Vnode* vnode = calloc(1, sizeof(Vnode));
+    vnode->Mount = dir->Mount;
+    return vnode;
+}
+
+static void Test_Put(Vnode* vnode){
+    g_Fs->Release(vnode);
+    free(vnode);
+}
+
+static Vnode* Test_Create(Vnode* dir, const char* name, VnodeType type){
+    Vnode* vnode = Test_Vnode(dir);
+    VfsStatus status = g_Fs->Create(dir, name, type, vnode);
+    CHECK(status == VFS_OK);
+    if(status != VFS_OK){
+        free(vnode);
+        return NULL;
+    }
+    return vnode;
+}
+
+static Vnode* Test_Lookup(Vnode* dir, const char* name){
+    Vnode* vnode = Test_Vnode(dir);
+    VfsStatus status = g_Fs->Lookup(dir, name, vnode);
+    CHECK(status == VFS_OK);
+    if(status != VFS_OK){
+        free(vnode);
+        return NULL;
+    }
+    return vnode;
+}
+
+static void Test_Write(Vnode* file, uint32_t seed, uint64_t offset, uint32_t count){
+    uint32_t done;
+    Test_Fill(g_Data, seed, offset, count);
+    CHECK(g_Fs->Write(file, offset, g_Data, count, &done) == VFS_OK);
+    CHECK(done == count);
+}
+
+// The file holds size bytes of its pattern, zeroes in [gapStart, gapEnd)
+static void Test_Verify(Vnode* file, uint32_t seed, uint64_t size, uint64_t gapStart, uint64_t gapEnd){
+    CHECK(file->Size == size);
+
+    // the VFS clips reads to the size, the driver reads what is allocated
+    uint32_t done;
+    CHECK(g_Fs->Read(file, 0, g_ReadBack, size, &done) == VFS_OK);
+    CHECK(done == size);
+
+    Test_Fill(g_Data, seed, 0, size);
+    if(gapEnd > gapStart)
+        memset(g_Data + gapStart, 0, gapEnd - gapStart);
+    CHECK(memcmp(g_Data, g_ReadBack, size) == 0);
+}
+
+static void Test_Name(char* name, uint32_t number){
+    sprintf(name, "f%u.txt", number);
+}
+
+//
+// The tests
+//
+
+typedef struct{
+    uint64_t BigSize;
+    uint64_t FragmentedSize;
+    uint64_t TruncatedSize;
+    uint64_t GapOffset;
+} TestSizes;
+
+static void Test_WriteFiles(Vnode* root, TestSizes* sizes){
+    uint32_t cluster = g_Layout.ClusterSize;
+    FATStats before, after;
+    FAT_GetStats(&before);
+
+    // one write, then appends right behind it that should stay in place
+    Vnode* big = Test_Create(root, "BIG.BIN", VNODE_FILE);
+    if(big == NULL)
+        return;
+    sizes->BigSize = 5 * cluster + 123;
+    Test_Write(big, 1, 0, sizes->BigSize);
+    for(uint32_t i = 0; i < TEST_CHUNKS; i++){
+        Test_Write(big, 1, sizes->BigSize, cluster);
+        sizes->BigSize += cluster;
+    }
+
+    // appends to two files in turn take turns on the disk as well
+    Vnode* a = Test_Create(root, "A.BIN", VNODE_FILE);
+    Vnode* b = Test_Create(root, "B.BIN", VNODE_FILE);
+    if(a == NULL || b == NULL)
+        return;
+    sizes->FragmentedSize = 0;
+    for(uint32_t i = 0; i < TEST_CHUNKS; i++){
+        Test_Write(a, 2, sizes->FragmentedSize, cluster);
+        Test_Write(b, 3, sizes->FragmentedSize, cluster);
+        sizes->FragmentedSize += cluster;
+    }
+
+    // shrinking frees the tail of the chain
+    sizes->TruncatedSize = cluster + cluster / 2;
+    CHECK(g_Fs->Truncate(b, sizes->TruncatedSize) == VFS_OK);
+    CHECK(b->Size == sizes->TruncatedSize);
+
+    // writing past the end zeroes the gap
+    Vnode* gap = Test_Create(root, "gap.bin", VNODE_FILE);
+    if(gap == NULL)
+        return;
+    sizes->GapOffset = 3 * cluster + 17;
+    Test_Write(gap, 4, sizes->GapOffset, 100);
+
+    FAT_GetStats(&after);
+    CHECK(after.Contiguous > before.Contiguous);
+    CHECK(after.Fragments > before.Fragments);
+    CHECK(after.Freed > before.Freed);
+    CHECK(after.FatFlushes > before.FatFlushes);
+
+    Test_Verify(big, 1, sizes->BigSize, 0, 0);
+    Test_Verify(a, 2, sizes->FragmentedSize, 0, 0);
+    Test_Verify(b, 3, sizes->TruncatedSize, 0, 0);
+    Test_Verify(gap, 4, sizes->GapOffset + 100, 0, sizes->GapOffset);
+
+    Test_Put(big);
+    Test_Put(a);
+    Test_Put(b);
+    Test_Put(gap);
+}
+
+// Enough entries that the directory needs more than one cluster
+static void Test_WriteDirectory(Vnode* root){
+    Vnode* dir = Test_Create(root, "SUB", VNODE_DIRECTORY);
+    if(dir == NULL)
+        return;
+
+    char name[16];
+    for(uint32_t i = 0; i < TEST_SMALL_FILES; i++){
+        Test_Name(name, i);
+        Vnode* file = Test_Create(dir, name, VNODE_FILE);
+        if(file == NULL)
+            break;
+        Test_Write(file, 100 + i, 0, 10 + i);
+        Test_Put(file);
+    }
+
+    Test_Put(dir);
+}
+
+// Everything again, through a second mount that knows only the disk
+static void Test_ReadBack(Vnode* root, const TestSizes* sizes){
+    Vnode* file = Test_Lookup(root, "BIG.BIN");
+    if(file != NULL){
+        Test_Verify(file, 1, sizes->BigSize, 0, 0);
+        Test_Put(file);
+    }
+    if((file = Test_Lookup(root, "a.bin")) != NULL){
+        Test_Verify(file, 2, sizes->FragmentedSize, 0, 0);
+        Test_Put(file);
+    }
+    if((file = Test_Lookup(root, "B.BIN")) != NULL){
+        Test_Verify(file, 3, sizes->TruncatedSize, 0, 0);
+        Test_Put(file);
+    }
+    if((file = Test_Lookup(root, "gap.bin")) != NULL){
+        Test_Verify(file, 4, sizes->GapOffset + 100, 0, sizes->GapOffset);
+        Test_Put(file);
+    }
+
+    Vnode* dir = Test_Lookup(root, "SUB");
+    if(dir == NULL)
+        return;
+    CHECK(dir->Type == VNODE_DIRECTORY);
+
+    char name[16];
+    for(uint32_t i = 0; i < TEST_SMALL_FILES; i++){
+        Test_Name(name, i);
+        if((file = Test_Lookup(dir, name)) != NULL){
+            Test_Verify(file, 100 + i, 10 + i, 0, 0);
+            Test_Put(file);
+        }
+    }
+
+    // lower case names come back as they were written
+    uint64_t cookie = 0;
+    uint32_t entries = 0;
+    bool lowerCase = true;
+    VfsDirEntry entry;
+    while(g_Fs->ReadDir(dir, &cookie, &entry) == VFS_OK){
+        entries++;
+        lowerCase = lowerCase && entry.Name[0] == 'f';
+    }
+    CHECK(entries == TEST_SMALL_FILES);
+    CHECK(lowerCase);
+    Test_Put(dir);
+}
+
+// The copies of the FAT match, and FSInfo counts the free clusters right
+static void Test_CheckDisk(){
+    uint32_t bytes = g_Layout.SectorsPerFat * BLOCK_SECTOR_SIZE;
+    uint8_t* first = malloc(bytes);
+    uint8_t* copy = malloc(bytes);
+
+    CHECK(BufferCache_ReadSectors(g_Device, g_Layout.FatStart, g_Layout.SectorsPerFat, first));
+    for(uint32_t i = 1; i < g_Layout.FatCount; i++){
+        CHECK(BufferCache_ReadSectors(g_Device, g_Layout.FatStart + i * g_Layout.SectorsPerFat, g_Layout.SectorsPerFat, copy));
+        CHECK(memcmp(first, copy, bytes) == 0);
+    }
+
+    uint32_t freeClusters = 0;
+    for(uint32_t cluster = 2; cluster < g_Layout.ClusterCount + 2; cluster++){
+        uint32_t value;
+        if(g_Layout.Type == 12){
+            value = Test_Get16(first + cluster + cluster / 2);
+            value = (cluster & 1) ? value >> 4 : value & 0x0FFF;
+        } else if(g_Layout.Type == 16){
+            value = Test_Get16(first + cluster * 2);
+        } else {
+            value = Test_Get32(first + cluster * 4) & 0x0FFFFFFF;
+        }
+        if(value == 0)
+            freeClusters++;
+    }
+
+    if(g_Layout.FSInfoSector != 0){
+        uint8_t info[BLOCK_SECTOR_SIZE];
+        CHECK(BufferCache_ReadSectors(g_Device, g_Layout.FSInfoSector, 1, info));
+        CHECK(Test_Get32(info + 488) == freeClusters);
+    }
+
+    free(first);
+    free(copy);
+}
+
+static bool Test_Mount(Mount* mount, Vnode* root){
+    memset(mount, 0, sizeof(Mount));
+    memset(root, 0, sizeof(Vnode));
+    mount->Fs = g_Fs;
+    mount->Device = g_Device;
+    root->Mount = mount;
+
+    VfsStatus status = g_Fs->Mount(mount, root);
+    CHECK(status == VFS_OK);
+    return status == VFS_OK;
+}
+
+int main(int argc, char** argv){
+    if(argc != 2){
+        printf("usage: %s <FAT image>\n", argv[0]);
+        return 2;
+    }
+
+    FAT_Initialize();
+    g_Fs = Host_GetFileSystem("fat");
+    g_Device = Host_OpenImage(argv[1]);
+    if(g_Fs == NULL || g_Device == NULL || !Test_ReadLayout(&g_Layout))
+        return 2;
+
+    uint32_t bufferSize = 16 * g_Layout.ClusterSize;
+    g_Data = malloc(bufferSize);
+    g_ReadBack = malloc(bufferSize);
+
+    Mount mount, remount;
+    Vnode root, reroot;
+    TestSizes sizes;
+    if(Test_Mount(&mount, &root)){
+        Test_WriteFiles(&root, &sizes);
+        Test_WriteDirectory(&root);
+        CHECK(g_Fs->Sync(&mount) == VFS_OK);
+        CHECK(Host_SyncImage(g_Device));
+
+        Test_CheckDisk();
+        if(Test_Mount(&remount, &reroot))
+            Test_ReadBack(&reroot, &sizes);
+    }
+
+    FAT_PrintStats();
+    Host_CloseImage(g_Device);
+
+    if(g_Failures != 0){
+        printf("FAT%u tests: %d checks failed\n", g_Layout.Type, g_Failures);
+        return 1;
+    }
+
+    printf("FAT%u tests: passed\n", g_Layout.Type);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <util/spsc.h>
+#include <util/mpsc.h>
+#include <util/percpu_counter.h>
+#include <arch/i686/io.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "host.h"
+
+// Host counterpart of src/kernel/util/lockfree_bench.c: the same three
+// benchmarks, with threads as the producers. Run by `scons bench-host`;
+// the numbers only compare versions of the code on one machine, the
+// kernel's own run is what counts.
+
+#define BENCH_ITEMS                 2000000
+#define BENCH_RING_CAPACITY         1024
+#define BENCH_THREADS               4
+
+static SPSCRing g_Ring;
+static uint32_t g_RingBuffer[BENCH_RING_CAPACITY];
+
+static MPSCQueue g_Queue;
+static MPSCCell g_QueueCells[BENCH_RING_CAPACITY];
+
+static PerCPUCounter g_Counter;
+
+static void Bench_Print(const char* name, uint64_t items, uint64_t ns, bool ok){
+    printf("[BENCH] %s: %s, %llu items in %lluus, %lluns/item, %llu items/s\n",
+           name, ok ? "PASS" : "FAIL", (unsigned long long)items,
+           (unsigned long long)(ns / 1000), (unsigned long long)(ns / items),
+           (unsigned long long)(ns ? items * 1000000000ull / ns : 0));
+}
+
+static void* Bench_SPSCProducer(void* arg){
+    Host_SetCPU(1);
+    for(uint32_t i = 0; i < BENCH_ITEMS; i++){
+        while(!SPSCRing_Push(&g_Ring, &i))
+            i686_pause();
+    }
+    return NULL;
+}
+
+static bool Bench_SPSC(){
+    SPSCRing_Initialize(&g_Ring, g_RingBuffer, sizeof(uint32_t), BENCH_RING_CAPACITY);
+
+    uint64_t start = Host_GetNs();
+    pthread_t producer;
+    if(pthread_create(&producer, NULL, Bench_SPSCProducer, NULL) != 0){
+        printf("[BENCH] spsc ring: could not start the producer\n");
+        return false;
+    }
+
+    bool ok = true;
+    for(uint32_t expected = 0; expected < BENCH_ITEMS; expected++){
+        uint32_t value;
+        while(!SPSCRing_Pop(&g_Ring, &value))
+            i686_pause();
+        ok = ok && value == expected;
+    }
+
+    Bench_Print("spsc ring", BENCH_ITEMS, Host_GetNs() - start, ok);
+    pthread_join(producer, NULL);
+    return ok;
+}
+
+static void* Bench_MPSCProducer(void* arg){
+    Host_SetCPU((uintptr_t)arg);
+    for(uintptr_t i = 1; i <= BENCH_ITEMS; i++){
+        while(!MPSCQueue_Push(&g_Queue, (void*)i))
+            i686_pause();
+    }
+    return NULL;
+}
+
+static bool Bench_MPSC(){
+    MPSCQueue_Initialize(&g_Queue, g_QueueCells, BENCH_RING_CAPACITY);
+
+    uint64_t start = Host_GetNs();
+    pthread_t producers[BENCH_THREADS];
+    uint32_t started = 0;
+    for(uintptr_t i = 0; i < BENCH_THREADS; i++){
+        if(pthread_create(&producers[started], NULL, Bench_MPSCProducer, (void*)(i + 1)) == 0)
+            started++;
+    }
+    if(started == 0){
+        printf("[BENCH] mpsc queue: could not start any producer\n");
+        return false;
+    }
+
+    uint64_t sum = 0;
+    uint64_t items = (uint64_t)BENCH_ITEMS * started;
+    for(uint64_t i = 0; i < items; i++){
+        void* value;
+        while(!MPSCQueue_Pop(&g_Queue, &value))
+            i686_pause();
+        sum += (uintptr_t)value;
+    }
+    uint64_t ns = Host_GetNs() - start;
+
+    for(uint32_t i = 0; i < started; i++)
+        pthread_join(producers[i], NULL);
+
+    uint64_t expected = (uint64_t)BENCH_ITEMS * (BENCH_ITEMS + 1) / 2 * started;
+    Bench_Print("mpsc queue", items, ns, sum == expected);
+    return sum == expected;
+}
+
+static void* Bench_CounterWorker(void* arg){
+    Host_SetCPU((uintptr_t)arg);
+    for(uint32_t i = 0; i < BENCH_ITEMS; i++)
+        PerCPUCounter_Add(&g_Counter, 1);
+    return NULL;
+}
+
+static bool Bench_Counter(){
+    PerCPUCounter_Initialize(&g_Counter, "bench-counter");
+
+    uint64_t start = Host_GetNs();
+    pthread_t workers[BENCH_THREADS];
+    uint32_t started = 0;
+    for(uintptr_t i = 0; i < BENCH_THREADS; i++){
+        if(pthread_create(&workers[started], NULL, Bench_CounterWorker, (void*)(i + 1)) == 0)
+            started++;
+    }
+    Bench_CounterWorker(0);
+    for(uint32_t i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    uint64_t ns = Host_GetNs() - start;
+
+    uint64_t items = (uint64_t)BENCH_ITEMS * (started + 1);
+    bool ok = PerCPUCounter_Read(&g_Counter) == (int64_t)items;
+    Bench_Print("percpu counter", items, ns, ok);
+    return ok;
+}
+
+int main(){
+    bool ok = Bench_SPSC();
+    ok = Bench_MPSC() && ok;
+    ok = Bench_Counter() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+#include <util/spsc.h>
+#include <util/mpsc.h>
+#include <util/percpu_counter.h>
+#include <arch/i686/io.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "host.h"
+
+// Unit tests of the SPSC ring, the MPSC queue and the per-CPU counters,
+// with threads standing in for CPUs. Run by `scons test`.
+
+#define TEST_ITEMS                  200000
+#define TEST_CAPACITY               64
+
+static int g_Failures = 0;
+
+#define CHECK(condition)                                                    \
+    do{                                                                     \
+        if(!(condition)){                                                   \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);   \
+            g_Failures++;                                                   \
+        }                                                                   \
+    }while(0)
+
+//
+// SPSC ring
+//
+
+static SPSCRing g_Ring;
+static uint32_t g_RingBuffer[TEST_CAPACITY];
+
+static void Test_SPSCSingleThread(){
+    uint32_t buffer[6];
+    CHECK(!SPSCRing_Initialize(&g_Ring, buffer, sizeof(uint32_t), 6));
+    CHECK(!SPSCRing_Initialize(&g_Ring, buffer, sizeof(uint32_t), 0));
+    CHECK(SPSCRing_Initialize(&g_Ring, buffer, sizeof(uint32_t), 4));
+
+    uint32_t value;
+    CHECK(!SPSCRing_Pop(&g_Ring, &value));
+
+    // wrap around a few times, filling the ring every time
+    uint32_t next = 0, expected = 0;
+    for(int round = 0; round < 5; round++){
+        for(int i = 0; i < 4; i++){
+            CHECK(SPSCRing_Push(&g_Ring, &next));
+            next++;
+        }
+        CHECK(!SPSCRing_Push(&g_Ring, &next));
+        CHECK(SPSCRing_Count(&g_Ring) == 4);
+
+        for(int i = 0; i < 4; i++){
+            CHECK(SPSCRing_Pop(&g_Ring, &value));
+            CHECK(value == expected);
+            expected++;
+        }
+        CHECK(!SPSCRing_Pop(&g_Ring, &value));
+        CHECK(SPSCRing_Count(&g_Ring) == 0);
+    }
+}
+
+static void Test_SPSCElementSize(){
+    typedef struct{ uint8_t Bytes[3]; } Element;
+    Element buffer[8];
+    CHECK(SPSCRing_Initialize(&g_Ring, buffer, sizeof(Element), 8));
+
+    for(uint8_t i = 0; i < 8; i++){
+        Element element = {{ i, (uint8_t)(i + 1), (uint8_t)(i + 2) }};
+        CHECK(SPSCRing_Push(&g_Ring, &element));
+    }
+    for(uint8_t i = 0; i < 8; i++){
+        Element element;
+        CHECK(SPSCRing_Pop(&g_Ring, &element));
+        CHECK(element.Bytes[0] == i && element.Bytes[1] == i + 1 && element.Bytes[2] == i + 2);
+    }
+}
+
+static void* Test_SPSCProducer(void* arg){
+    Host_SetCPU(1);
+    for(uint32_t i = 0; i < TEST_ITEMS; i++){
+        while(!SPSCRing_Push(&g_Ring, &i))
+            i686_pause();
+    }
+    return NULL;
+}
+
+static void Test_SPSCThreads(){
+    SPSCRing_Initialize(&g_Ring, g_RingBuffer, sizeof(uint32_t), TEST_CAPACITY);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, Test_SPSCProducer, NULL);
+
+    bool ordered = true;
+    for(uint32_t expected = 0; expected < TEST_ITEMS; expected++){
+        uint32_t value;
+        while(!SPSCRing_Pop(&g_Ring, &value))
+            i686_pause();
+        ordered = ordered && value == expected;
+    }
+
+    pthread_join(producer, NULL);
+    CHECK(ordered);
+    CHECK(SPSCRing_Count(&g_Ring) == 0);
+}
+
+//
+// MPSC queue
+//
+
+#define TEST_PRODUCERS              (CPU_MAX - 1)
+
+static MPSCQueue g_Queue;
+static MPSCCell g_QueueCells[TEST_CAPACITY];
+
+static void Test_MPSCSingleThread(){
+    MPSCCell cells[4];
+    CHECK(!MPSCQueue_Initialize(&g_Queue, cells, 3));
+    CHECK(MPSCQueue_Initialize(&g_Queue, cells, 4));
+
+    void* value;
+    CHECK(!MPSCQueue_Pop(&g_Queue, &value));
+
+    uintptr_t next = 1, expected = 1;
+    for(int round = 0; round < 5; round++){
+        for(int i = 0; i < 4; i++)
+            CHECK(MPSCQueue_Push(&g_Queue, (void*)next++));
+        CHECK(!MPSCQueue_Push(&g_Queue, (void*)next));
+
+        for(int i = 0; i < 4; i++){
+            CHECK(MPSCQueue_Pop(&g_Queue, &value));
+            CHECK((uintptr_t)value == expected++);
+        }
+        CHECK(!MPSCQueue_Pop(&g_Queue, &value));
+    }
+}
+
+// Values carry the producer in the top byte and a sequence number below,
+// so the consumer can check that every producer's items stay in order
+static void* Test_MPSCProducer(void* arg){
+    uintptr_t producer = (uintptr_t)arg;
+    Host_SetCPU(producer);
+    for(uintptr_t i = 1; i <= TEST_ITEMS; i++){
+        while(!MPSCQueue_Push(&g_Queue, (void*)(producer << 24 | i)))
+            i686_pause();
+    }
+    return NULL;
+}
+
+static void Test_MPSCThreads(){
+    MPSCQueue_Initialize(&g_Queue, g_QueueCells, TEST_CAPACITY);
+
+    pthread_t producers[TEST_PRODUCERS];
+    for(uintptr_t i = 0; i < TEST_PRODUCERS; i++)
+        pthread_create(&producers[i], NULL, Test_MPSCProducer, (void*)(i + 1));
+
+    uint32_t last[TEST_PRODUCERS + 1] = { 0 };
+    bool ordered = true;
+    for(uint32_t i = 0; i < TEST_ITEMS * TEST_PRODUCERS; i++){
+        void* value;
+        while(!MPSCQueue_Pop(&g_Queue, &value))
+            i686_pause();
+
+        uintptr_t producer = (uintptr_t)value >> 24;
+        uint32_t sequence = (uintptr_t)value & 0xFFFFFF;
+        if(producer < 1 || producer > TEST_PRODUCERS || sequence != last[producer] + 1){
+            ordered = false;
+            continue;
+        }
+        last[producer] = sequence;
+    }
+
+    for(int i = 0; i < TEST_PRODUCERS; i++)
+        pthread_join(producers[i], NULL);
+
+    CHECK(ordered);
+    for(int producer = 1; producer <= TEST_PRODUCERS; producer++)
+        CHECK(last[producer] == TEST_ITEMS);
+
+    void* value;
+    CHECK(!MPSCQueue_Pop(&g_Queue, &value));
+}
+
+//
+// Per-CPU counter
+//
+
+static PerCPUCounter g_Counter;
+
+static void Test_CounterSingleThread(){
+    PerCPUCounter_Initialize(&g_Counter, "test-counter");
+    CHECK(PerCPUCounter_Read(&g_Counter) == 0);
+
+    // below the batch everything stays in the slot
+    PerCPUCounter_Add(&g_Counter, PERCPU_COUNTER_BATCH - 1);
+    CHECK(g_Counter.Total == 0);
+    CHECK(PerCPUCounter_Read(&g_Counter) == PERCPU_COUNTER_BATCH - 1);
+
+    // reaching it folds the slot into the total
+    PerCPUCounter_Add(&g_Counter, 1);
+    CHECK(g_Counter.Total == PERCPU_COUNTER_BATCH);
+    CHECK(g_Counter.Slots[0].Value == 0);
+
+    // and so does going as far the other way
+    PerCPUCounter_Add(&g_Counter, -3 * PERCPU_COUNTER_BATCH);
+    CHECK(g_Counter.Total == -2 * PERCPU_COUNTER_BATCH);
+    CHECK(PerCPUCounter_Read(&g_Counter) == -2 * PERCPU_COUNTER_BATCH);
+}
+
+static void* Test_CounterWorker(void* arg){
+    Host_SetCPU((uintptr_t)arg);
+    for(uint32_t i = 0; i < TEST_ITEMS; i++)
+        PerCPUCounter_Add(&g_Counter, (i & 1) ? 3 : -1);
+    return NULL;
+}
+
+static void Test_CounterThreads(){
+    PerCPUCounter_Initialize(&g_Counter, "test-counter");
+
+    pthread_t workers[CPU_MAX];
+    for(uintptr_t cpu = 0; cpu < CPU_MAX; cpu++)
+        pthread_create(&workers[cpu], NULL, Test_CounterWorker, (void*)cpu);
+    for(int cpu = 0; cpu < CPU_MAX; cpu++)
+        pthread_join(workers[cpu], NULL);
+
+    // every pair of adds nets 2
+    CHECK(PerCPUCounter_Read(&g_Counter) == (int64_t)TEST_ITEMS * CPU_MAX);
+}
+
+int main(){
+    Test_SPSCSingleThread();
+    Test_SPSCElementSize();
+    Test_SPSCThreads();
+    Test_MPSCSingleThread();
+    Test_MPSCThreads();
+    Test_CounterSingleThread();
+    Test_CounterThreads();
+
+    if(g_Failures != 0){
+        printf("lockfree tests: %d checks failed\n", g_Failures);
+        return 1;
+    }
+
+    printf("lockfree tests: passed\n");
+    return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include <sched.h>
+
+// Stands in for the kernel's arch/i686/io.h when the lock-free code is built
+// for the host: threads take the place of CPUs and there are no interrupts
+// to mask, so only the instructions the spin loops use are left.
+
+static inline uint32_t i686_irqsave(){
+    return 0;
+}
+
+static inline void i686_irqrestore(uint32_t flags){
+    (void)flags;
+}
+
+// The threads may outnumber the host's CPUs, a spinning one would then
+// burn its whole time slice waiting for a thread that is not running
+static inline void i686_pause(){
+    __builtin_ia32_pause();
+    sched_yield();
+}
+
+static inline uint64_t i686_rdtsc(){
+    return __builtin_ia32_rdtsc();
+}
@@ -0,0 +1,18 @@
+#include "host.h"
+#include <time.h>
+
+static __thread uint32_t g_CPU = 0;
+
+void Host_SetCPU(uint32_t cpu){
+    g_CPU = cpu;
+}
+
+uint32_t i686_PerCPU_GetId(){
+    return g_CPU;
+}
+
+uint64_t Host_GetNs(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+#include <arch/i686/smp/percpu.h>
+
+// The calling thread plays CPU cpu (< CPU_MAX) from now on; threads that
+// never call it are CPU 0
+void Host_SetCPU(uint32_t cpu);
+
+// Monotonic clock in nanoseconds
+uint64_t Host_GetNs();
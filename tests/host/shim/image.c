@@ -0,0 +1,172 @@
+#include "image.h"
+#include <block/buffer_cache.h>
+#include <util/trace.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef struct{
+    int Fd;
+    Buffer* Buffers;                        // linked through HashNext
+} HostImage;
+
+static FileSystem* g_FileSystems[VFS_MAX_FILESYSTEMS];
+
+BlockDevice* Host_OpenImage(const char* path){
+    int fd = open(path, O_RDWR);
+    struct stat info;
+    if(fd < 0 || fstat(fd, &info) != 0){
+        perror(path);
+        return NULL;
+    }
+
+    BlockDevice* device = calloc(1, sizeof(BlockDevice));
+    HostImage* image = calloc(1, sizeof(HostImage));
+    image->Fd = fd;
+
+    snprintf(device->Name, sizeof(device->Name), "image");
+    device->SectorCount = info.st_size / BLOCK_SECTOR_SIZE;
+    device->DriverData = image;
+    return device;
+}
+
+static bool Host_WriteBuffer(HostImage* image, Buffer* buffer){
+    buffer->Flags &= ~BUFFER_DIRTY;
+    off_t offset = (off_t)buffer->Block * BCACHE_BLOCK_SIZE;
+    return pwrite(image->Fd, buffer->Data, BCACHE_BLOCK_SIZE, offset) == BCACHE_BLOCK_SIZE;
+}
+
+bool Host_SyncImage(BlockDevice* device){
+    HostImage* image = device->DriverData;
+    bool success = true;
+
+    Buffer** link = &image->Buffers;
+    while(*link != NULL){
+        Buffer* buffer = *link;
+        if((buffer->Flags & BUFFER_DIRTY) && !Host_WriteBuffer(image, buffer))
+            success = false;
+
+        if(buffer->RefCount == 0){
+            *link = buffer->HashNext;
+            free(buffer->Data);
+            free(buffer);
+        } else {
+            link = &buffer->HashNext;
+        }
+    }
+    return fsync(image->Fd) == 0 && success;
+}
+
+void Host_CloseImage(BlockDevice* device){
+    HostImage* image = device->DriverData;
+    Host_SyncImage(device);
+    close(image->Fd);
+    free(image);
+    free(device);
+}
+
+FileSystem* Host_GetFileSystem(const char* name){
+    for(int i = 0; i < VFS_MAX_FILESYSTEMS; i++){
+        if(g_FileSystems[i] != NULL && strcmp(g_FileSystems[i]->Name, name) == 0)
+            return g_FileSystems[i];
+    }
+    return NULL;
+}
+
+//
+// What the kernel code calls
+//
+
+bool VFS_RegisterFileSystem(FileSystem* fs){
+    for(int i = 0; i < VFS_MAX_FILESYSTEMS; i++){
+        if(g_FileSystems[i] == NULL){
+            g_FileSystems[i] = fs;
+            return true;
+        }
+    }
+    return false;
+}
+
+Buffer* BufferCache_Get(BlockDevice* device, uint64_t block){
+    HostImage* image = device->DriverData;
+    for(Buffer* buffer = image->Buffers; buffer != NULL; buffer = buffer->HashNext){
+        if(buffer->Block == block){
+            buffer->RefCount++;
+            return buffer;
+        }
+    }
+
+    if(block >= device->SectorCount / BCACHE_BLOCK_SECTORS + (device->SectorCount % BCACHE_BLOCK_SECTORS != 0))
+        return NULL;
+
+    // the tail of a last, partial block reads as zeroes
+    Buffer* buffer = calloc(1, sizeof(Buffer));
+    buffer->Data = calloc(1, BCACHE_BLOCK_SIZE);
+    if(pread(image->Fd, buffer->Data, BCACHE_BLOCK_SIZE, (off_t)block * BCACHE_BLOCK_SIZE) < 0){
+        free(buffer->Data);
+        free(buffer);
+        return NULL;
+    }
+
+    buffer->Device = device;
+    buffer->Block = block;
+    buffer->Flags = BUFFER_VALID;
+    buffer->RefCount = 1;
+    buffer->HashNext = image->Buffers;
+    image->Buffers = buffer;
+    return buffer;
+}
+
+void BufferCache_Release(Buffer* buffer){
+    buffer->RefCount--;
+}
+
+void BufferCache_MarkDirty(Buffer* buffer){
+    buffer->Flags |= BUFFER_DIRTY;
+}
+
+static bool Host_TransferSectors(BlockDevice* device, uint64_t lba, uint32_t count, uint8_t* data, bool write){
+    uint64_t offset = lba * BLOCK_SECTOR_SIZE;
+    uint64_t length = (uint64_t)count * BLOCK_SECTOR_SIZE;
+
+    while(length > 0){
+        uint32_t inBlock = offset % BCACHE_BLOCK_SIZE;
+        uint32_t chunk = BCACHE_BLOCK_SIZE - inBlock < length ? BCACHE_BLOCK_SIZE - inBlock : length;
+        Buffer* buffer = BufferCache_Get(device, offset / BCACHE_BLOCK_SIZE);
+        if(buffer == NULL)
+            return false;
+
+        if(write){
+            memcpy(buffer->Data + inBlock, data, chunk);
+            BufferCache_MarkDirty(buffer);
+        } else {
+            memcpy(data, buffer->Data + inBlock, chunk);
+        }
+        BufferCache_Release(buffer);
+
+        offset += chunk;
+        length -= chunk;
+        data += chunk;
+    }
+    return true;
+}
+
+bool BufferCache_ReadSectors(BlockDevice* device, uint64_t lba, uint32_t count, void* buffer){
+    return Host_TransferSectors(device, lba, count, buffer, false);
+}
+
+bool BufferCache_WriteSectors(BlockDevice* device, uint64_t lba, uint32_t count, const void* buffer){
+    return Host_TransferSectors(device, lba, count, (uint8_t*)buffer, true);
+}
+
+#if CONFIG_TRACE
+
+volatile bool g_TraceEnabled = false;
+
+void Trace_Record(TraceEvent event, uint32_t arg0, uint32_t arg1){
+}
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <block/block.h>
+#include <fs/vfs.h>
+
+// A disk image file standing in for a block device, read and written
+// through a buffer cache that keeps every block it was asked for
+BlockDevice* Host_OpenImage(const char* path);
+// Writes the dirty blocks back and drops the unused ones, so the next
+// access reads the file again
+bool Host_SyncImage(BlockDevice* device);
+void Host_CloseImage(BlockDevice* device);
+
+// The filesystem a driver handed to VFS_RegisterFileSystem, NULL if none
+FileSystem* Host_GetFileSystem(const char* name);